@@ -0,0 +1,1036 @@
+/*
+Benchmark of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for measuring the simulation hot paths, the matrix functions and the output sinks.
+And this code is written in C++11.
+
+Usage information:
+Run the program from a folder with write access; it prints the results as JSON so that versions can be compared.
+--------------------------
+
+Command line:
+	Benchmark [--quick] [--repetitions N] [--warmup N] [--threads N] [--output file.json]
+	--quick           //sensor sizes up to 1024x1280, PixelInterval 1 and 4, 3 repetitions
+	--repetitions N   //timed runs of every measurement (default 7)
+	--warmup N        //untimed runs before the timed ones (default 2)
+	--threads N       //size of the thread pool of the parallel measurements (default every hardware thread)
+	--output file     //write the JSON to a file instead of the standard output
+
+
+Measurements:
+	"simulation"      //"CameraSimulationFrame()" of the attitude of main.cpp for every sensor size, PixelInterval and
+	                  //supported kernel type, and "CameraSimulationFrameParallel()" with the widest kernel.
+	                  //RAYLEIGH_KERNEL_SCALAR is the simulation of "CameraSimulation()" without its text output.
+	"matrix"          //every function of MatrixFunction.h with the 3x3 and 3x1 shapes of the simulation and a 4x4 shape.
+	"sink"            //cost of writing one 1024x1280 frame: none, text, parallel text, binary double and binary float,
+	                  //and "legacy" (scalar simulation and text, the work of one "CameraSimulation()" call).
+	"mosaic"          //"CameraSimulationMosaic()" of one 1024x1280 raw frame with the default sensor, for every
+	                  //noise kernel and over the thread pool.
+	"demosaic"        //"CameraDemosaic()" of one 1024x1280 raw frame into float planes, for both methods, every
+	                  //supported kernel type and over the thread pool.
+	"lens"            //"CameraSimulationFrame()" of one 1024x1280 frame in double and single precision with the widest
+	                  //kernel, through every projection of CameraLens.h (180 degree field of view for the fisheyes).
+	"sky"             //"CameraSimulationFrame()" of one 1024x1280 frame in double and single precision with the widest
+	                  //kernel, for the Rayleigh, Berry and tabulated (1 degree grid) sky models of SkyModel.h.
+	"stream"          //16 frames of 1024x1280 over the thread pool written to a binary frame file, with
+	                  //"CameraSimulationBatch()" (simulation, then writing) and "CameraSimulationStream()" (both
+	                  //overlapped by the background writer).
+	"tiles"           //one 1024x1280 frame in single precision over the thread pool written to disk, as a whole frame
+	                  //with "FrameWriterWrite()" and as 256x256 tiles with "CameraSimulationTiled()" (bounded memory).
+	"montecarlo"      //"CameraSimulationMonteCarlo()" of 256 samples of a 64x80 camera with the attitude solver, for
+	                  //every noise model, on the calling thread and over the thread pool ("items" are samples).
+	"image"           //"CameraImageWrite()" of the DOP and AOP images of one 1024x1280 frame in every format, on the
+	                  //calling thread and over the thread pool.
+	"rig"             //four cameras of a rig (two 1024x1280, a 512x640 and a 512x512 fisheye) in single precision over
+	                  //the thread pool: one "CameraSimulationFrameRotation()" per camera after the other ("cameras")
+	                  //and "CameraSimulationRig()" with the row bands of every camera in one parallel loop ("rig").
+	"reduce"          //statistics of one 1024x1280 frame with the defaults of "ReduceSettingsDefault()": the frame
+	                  //simulated and then reduced with "CameraFrameReduce()" ("frame"), and "CameraSimulationReduce()"
+	                  //without the frame ("fused"), on the calling thread and over the thread pool.
+	"server"          //frames of a frame server on a thread of the benchmark with the threads of the pool, through its
+	                  //socket and shared slots: one 1024x1280 frame per round trip ("frame"), one 64x80 frame per
+	                  //round trip ("small", mostly the latency of a request) and 16 pipelined 64x80 frames ("pipelined",
+	                  //simulated as one batch). Not measured on Windows.
+	Every measurement runs the warm-up runs first and reports the minimum, median and mean of the timed runs.
+	Progress goes to the standard error, so the standard output only holds the JSON.
+
+
+Output:
+	{
+	  "benchmark": "HypotheticalPolarizationCamera",
+	  "format": 1,                         //BENCHMARK_FORMAT, increased when fields change meaning
+	  "compiler": "...", "kernel_auto": "avx2", "threads": 8, "warmup": 2, "repetitions": 7,
+	  "results": [
+	    {"group": "simulation", "name": "scalar", "n_x": 1024, "n_z": 1280, "PixelInterval": 1, "threads": 1,
+	     "items": 1310720, "min_ns": ..., "median_ns": ..., "mean_ns": ..., "ns_per_item": ..., "items_per_second": ...},
+	    ...
+	  ]
+	}
+	"items" is the number of simulated pixels (simulation, sink) or of calls (matrix) per run, and ns_per_item and
+	items_per_second are taken from the median run.
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include "PolarizationCamera.h"
+#include "MatrixFunction.h"
+#include "RayleighKernel.h"
+#include "FrameIO.h"
+#include "CameraMosaic.h"
+#include "CameraDemosaic.h"
+#include "CameraStream.h"
+#include "CameraTiles.h"
+#include "MonteCarlo.h"
+#include "CameraImage.h"
+#include "CameraRig.h"
+#include "CameraReduce.h"
+#include "FrameServer.h"
+#include "MatrixTemplate.h"
+#include "ThreadPool.h"
+#ifndef _WIN32
+#include <thread>
+#include <unistd.h>
+#endif
+
+//version of the JSON layout
+#define BENCHMARK_FORMAT            1
+//calls of a matrix function per run
+#define BENCHMARK_MATRIX_CALLS      1000000
+//temporary files of the sink measurements
+#define BENCHMARK_TEXT_FILE         "benchmark.txt.tmp"
+#define BENCHMARK_BINARY_FILE       "benchmark.hpcf.tmp"
+#define BENCHMARK_TILE_FILE         "benchmark.hpct.tmp"
+#define BENCHMARK_DOP_IMAGE_FILE    "benchmark-dop.img.tmp"
+#define BENCHMARK_AOP_IMAGE_FILE    "benchmark-aop.img.tmp"
+//frames of the stream measurements
+#define BENCHMARK_STREAM_FRAMES     16
+//samples of the Monte Carlo measurements
+#define BENCHMARK_MONTE_CARLO_SAMPLES   256
+
+const double pi = 3.141592653589793;
+
+//options of the command line
+typedef struct BenchmarkOptions
+{
+	int     Quick;          //1 for the reduced set of --quick
+	int     Repetitions;    //timed runs of every measurement
+	int     Warmup;         //untimed runs before the timed ones
+	int     Threads;        //size of the thread pool, 0 for every hardware thread
+	const char *  Output;   //JSON file, NULL for the standard output
+}
+BenchmarkOptions;
+
+//timings of one measurement
+typedef struct BenchmarkResult
+{
+	std::string   Group;    //"simulation", "matrix" or "sink"
+	std::string   Name;     //kernel, function or sink
+	std::string   Shape;    //additional JSON members describing the measurement
+	double  Items;          //pixels or calls per run
+	double  Min;            //fastest run (unit is nanosecond)
+	double  Median;         //median run (unit is nanosecond)
+	double  Mean;           //mean run (unit is nanosecond)
+}
+BenchmarkResult;
+
+
+
+//Time a task: warm-up runs first, then the timed runs.
+static BenchmarkResult Measure(
+	const BenchmarkOptions *	options,  //warm-up and repetitions
+	const char *  group,                  //group of the measurement
+	const std::string &	name,             //name of the measurement
+	const std::string &	shape,            //JSON members describing the measurement
+	const double  items,                  //pixels or calls per run
+	const std::function<void()> &	task  //one run
+	){
+	for(int k=0; k<options->Warmup; k++){
+		task();
+	}
+	std::vector<double> time(options->Repetitions);
+	for(int k=0; k<options->Repetitions; k++){
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		task();
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		time[k] = std::chrono::duration<double,std::nano>(end-begin).count();
+	}
+	std::sort(time.begin(),time.end());
+
+	BenchmarkResult result;
+	result.Group = group;
+	result.Name = name;
+	result.Shape = shape;
+	result.Items = items;
+	result.Min = time[0];
+	result.Median = options->Repetitions%2 ? time[options->Repetitions/2]
+		: 0.5*(time[options->Repetitions/2-1]+time[options->Repetitions/2]);
+	result.Mean = 0.0;
+	for(int k=0; k<options->Repetitions; k++){
+		result.Mean += time[k]/options->Repetitions;
+	}
+	fprintf(stderr,"%-10s %-24s %-48s %12.3f ms %10.3f ns/item\n",
+		group,name.c_str(),shape.c_str(),result.Median*1e-6,result.Median/items);
+	return result;
+}
+
+
+
+//JSON members of a sensor size and pixel interval.
+static std::string SensorShape(
+	const CameraParameters *	parm,  //camera parameters
+	const int     threads              //threads of the measurement
+	){
+	char text[128];
+	sprintf(text,"\"n_x\": %d, \"n_z\": %d, \"PixelInterval\": %d, \"threads\": %d",
+		parm->n_x,parm->n_z,parm->PixelInterval,threads);
+	return text;
+}
+
+
+
+//Simulated pixels of the camera parameters.
+static double FramePixels(
+	const CameraParameters *	parm  //camera parameters
+	){
+	int n_x,n_z;
+	CameraFrameSize(parm,n_x,n_z);
+	return (double)n_x*n_z;
+}
+
+
+
+//"CameraSimulationFrame()" for every sensor size, pixel interval and supported kernel type.
+static void SimulationBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the parallel measurement
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	//sensor sizes with the 5.2 micrometer cells and 4 millimeter focus of main.cpp
+	static const int size[][2] = {{256,320},{512,640},{1024,1280},{2048,2560}};
+	static const int interval[] = {1,2,4,8};
+	int sizes = options->Quick ? 3 : 4;
+
+	//Three Euler angles of main.cpp (unit is degree)
+	double psa = 78.9*pi/180.0;
+	double afa = -65.2*pi/180.0;
+	double beta = 278.3*pi/180.0;
+
+	for(int s=0; s<sizes; s++){
+		for(int i=0; i<4; i++){
+			if(options->Quick && interval[i]!=1 && interval[i]!=4){
+				continue;
+			}
+			CameraParameters * parm = CameraParametersInit(5.2,5.2,size[s][0],size[s][1],4.0,interval[i]);
+			CameraFrame * frame = CameraFrameInit(parm);
+			if(parm==NULL || frame==NULL){
+				CameraFrameFree(frame);
+				CameraParametersFree(parm);
+				continue;
+			}
+			double pixels = FramePixels(parm);
+			for(int type=RAYLEIGH_KERNEL_SCALAR; type<=RAYLEIGH_KERNEL_CLOSED_FORM; type++){
+				if(RayleighKernelResolve(type)!=type){
+					continue;
+				}
+				parm->Kernel = type;
+				results.push_back(Measure(options,"simulation",RayleighKernelName(type),SensorShape(parm,1),pixels,[&](){
+					CameraSimulationFrame(psa,afa,beta,parm,frame);
+				}));
+			}
+			parm->Kernel = RAYLEIGH_KERNEL_AUTO;
+			results.push_back(Measure(options,"simulation",std::string(RayleighKernelName(RayleighKernelResolve(RAYLEIGH_KERNEL_AUTO)))+"-parallel",
+				SensorShape(parm,pool->Size()),pixels,[&](){
+				CameraSimulationFrameParallel(psa,afa,beta,parm,frame,pool);
+			}));
+			CameraFrameFree(frame);
+			CameraParametersFree(parm);
+		}
+	}
+}
+
+
+
+//Every function of MatrixFunction.h with the shapes of the simulation and a 4x4 shape.
+static void MatrixBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	static const int shape[][3] = {{3,3,3},{3,3,1},{4,4,4}};	//{m,p,n} of MatrixMultiply, {m,n} of the others
+	double a[16],b[16],c[16],norm;
+	for(int k=0; k<16; k++){
+		a[k] = 0.1*(k+1);
+		b[k] = 1.0-0.05*k;
+	}
+	//The inputs change every call so that no call can be skipped, and the results are checked once at the end.
+	double check = 0.0;
+	for(int s=0; s<3; s++){
+		int m = shape[s][0];
+		int p = shape[s][1];
+		int n = shape[s][2];
+		char text[64];
+		sprintf(text,"\"m\": %d, \"n\": %d",m,n);
+		std::string mn = text;
+		sprintf(text,"\"m\": %d, \"p\": %d, \"n\": %d",m,p,n);
+		std::string mpn = text;
+
+		results.push_back(Measure(options,"matrix","MatrixTrans",mn,BENCHMARK_MATRIX_CALLS,[&](){
+			for(int k=0; k<BENCHMARK_MATRIX_CALLS; k++){
+				a[0] = k;
+				MatrixTrans(m,n,a,c);
+			}
+			check += c[0];
+		}));
+		results.push_back(Measure(options,"matrix","MatrixMultiply",mpn,BENCHMARK_MATRIX_CALLS,[&](){
+			for(int k=0; k<BENCHMARK_MATRIX_CALLS; k++){
+				a[0] = k;
+				MatrixMultiply(m,p,n,a,b,c);
+			}
+			check += c[0];
+		}));
+		results.push_back(Measure(options,"matrix","MatrixAdd",mn,BENCHMARK_MATRIX_CALLS,[&](){
+			for(int k=0; k<BENCHMARK_MATRIX_CALLS; k++){
+				a[0] = k;
+				MatrixAdd(m,n,a,b,c);
+			}
+			check += c[0];
+		}));
+		results.push_back(Measure(options,"matrix","MatrixNorm",mn,BENCHMARK_MATRIX_CALLS,[&](){
+			for(int k=0; k<BENCHMARK_MATRIX_CALLS; k++){
+				a[0] = k;
+				MatrixNorm(m,n,a,norm);
+			}
+			check += norm;
+		}));
+		results.push_back(Measure(options,"matrix","MatrixScalarMultiply",mn,BENCHMARK_MATRIX_CALLS,[&](){
+			for(int k=0; k<BENCHMARK_MATRIX_CALLS; k++){
+				MatrixScalarMultiply(m,n,a,k,c);
+			}
+			check += c[0];
+		}));
+	}
+	if(check!=check){
+		fprintf(stderr,"matrix results are not finite\n");
+	}
+}
+
+
+
+//Cost of the output sinks for one 1024x1280 frame.
+static void SinkBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the parallel text measurement
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	CameraFrame * frame = CameraFrameInit(parm);
+	CameraFrameFloat * FrameFloat = CameraFrameFloatInit(parm);
+	FILE * text = fopen(BENCHMARK_TEXT_FILE,"wb");
+	if(parm==NULL || frame==NULL || FrameFloat==NULL || text==NULL){
+		fprintf(stderr,"sink measurements skipped\n");
+	}
+	else{
+		double psa = 78.9*pi/180.0;
+		double afa = -65.2*pi/180.0;
+		double beta = 278.3*pi/180.0;
+		CameraSimulationFrame(psa,afa,beta,parm,frame);
+		CameraSimulationFrame(psa,afa,beta,parm,FrameFloat);
+		double pixels = FramePixels(parm);
+		std::string shape = SensorShape(parm,1);
+
+		//Every run rewrites the same file, so only the formatting and the write are measured.
+		results.push_back(Measure(options,"sink","none",shape,pixels,[&](){
+			CameraSimulationFrame(psa,afa,beta,parm,frame);
+		}));
+		results.push_back(Measure(options,"sink","text",shape,pixels,[&](){
+			rewind(text);
+			CameraFrameWriteText(frame,text);
+			fflush(text);
+		}));
+		results.push_back(Measure(options,"sink","text-parallel",SensorShape(parm,pool->Size()),pixels,[&](){
+			rewind(text);
+			CameraFrameWriteTextParallel(frame,text,pool);
+			fflush(text);
+		}));
+		results.push_back(Measure(options,"sink","binary-double",shape,pixels,[&](){
+			FrameWriter * writer = FrameWriterOpen(BENCHMARK_BINARY_FILE,FRAME_SCALAR_DOUBLE);
+			if(writer!=NULL){
+				FrameWriterWrite(writer,frame,parm);
+				FrameWriterClose(writer);
+			}
+		}));
+		results.push_back(Measure(options,"sink","binary-float",shape,pixels,[&](){
+			FrameWriter * writer = FrameWriterOpen(BENCHMARK_BINARY_FILE,FRAME_SCALAR_FLOAT);
+			if(writer!=NULL){
+				FrameWriterWrite(writer,FrameFloat,parm);
+				FrameWriterClose(writer);
+			}
+		}));
+		//the work of one "CameraSimulation()" call, which itself would keep appending to HypotheticalImages.txt
+		results.push_back(Measure(options,"sink","legacy",shape,pixels,[&](){
+			int kernel = parm->Kernel;
+			parm->Kernel = RAYLEIGH_KERNEL_SCALAR;
+			CameraSimulationFrame(psa,afa,beta,parm,frame);
+			parm->Kernel = kernel;
+			rewind(text);
+			CameraFrameWriteText(frame,text);
+			fflush(text);
+		}));
+	}
+	if(text!=NULL){
+		fclose(text);
+		remove(BENCHMARK_TEXT_FILE);
+	}
+	remove(BENCHMARK_BINARY_FILE);
+	CameraFrameFree(frame);
+	CameraFrameFree(FrameFloat);
+	CameraParametersFree(parm);
+}
+
+
+
+//"CameraSimulationMosaic()" of one 1024x1280 raw frame for every noise kernel.
+static void MosaicBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the parallel measurement
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	if(parm==NULL){
+		return;
+	}
+	std::vector<uint16_t> raw((size_t)FramePixels(parm));
+	MosaicParameters mosaic;
+	MosaicParametersDefault(&mosaic);
+	double psa = 78.9*pi/180.0;
+	double afa = -65.2*pi/180.0;
+	double beta = 278.3*pi/180.0;
+	double pixels = FramePixels(parm);
+
+	//the noise kernels are scalar or AVX2, the other kernel types select one of them
+	static const int type[] = {RAYLEIGH_KERNEL_SCALAR,RAYLEIGH_KERNEL_AVX2};
+	for(int k=0; k<2; k++){
+		if(RayleighKernelResolve(type[k])!=type[k]){
+			continue;
+		}
+		parm->Kernel = type[k];
+		results.push_back(Measure(options,"mosaic",RayleighKernelName(type[k]),SensorShape(parm,1),pixels,[&](){
+			mosaic.FrameIndex++;
+			CameraSimulationMosaic(psa,afa,beta,parm,&mosaic,&raw[0],NULL);
+		}));
+	}
+	parm->Kernel = RAYLEIGH_KERNEL_AUTO;
+	results.push_back(Measure(options,"mosaic",std::string(RayleighKernelName(RayleighKernelResolve(RAYLEIGH_KERNEL_AUTO)))+"-parallel",
+		SensorShape(parm,pool->Size()),pixels,[&](){
+		mosaic.FrameIndex++;
+		CameraSimulationMosaic(psa,afa,beta,parm,&mosaic,&raw[0],pool);
+	}));
+	CameraParametersFree(parm);
+}
+
+
+
+
+//"CameraDemosaic()" of one 1024x1280 raw frame into float planes for both methods and every kernel type.
+static void DemosaicBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the parallel measurement
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	if(parm==NULL){
+		return;
+	}
+	CameraFrameFloat * frame = CameraFrameFloatInit(parm);
+	if(frame==NULL){
+		CameraParametersFree(parm);
+		return;
+	}
+	std::vector<uint16_t> raw((size_t)FramePixels(parm));
+	MosaicParameters mosaic;
+	MosaicParametersDefault(&mosaic);
+	CameraSimulationMosaic(78.9*pi/180.0,-65.2*pi/180.0,278.3*pi/180.0,parm,&mosaic,&raw[0],pool);
+	double pixels = FramePixels(parm);
+
+	static const char * method[] = {"bilinear","gradient"};
+	for(int m=DEMOSAIC_BILINEAR; m<=DEMOSAIC_GRADIENT; m++){
+		for(int type=RAYLEIGH_KERNEL_SCALAR; type<=RAYLEIGH_KERNEL_AVX512; type++){
+			if(RayleighKernelResolve(type)!=type){
+				continue;
+			}
+			results.push_back(Measure(options,"demosaic",std::string(method[m])+"-"+RayleighKernelName(type),SensorShape(parm,1),pixels,[&](){
+				CameraDemosaic(&raw[0],&mosaic,m,type,frame,NULL,NULL,NULL,NULL);
+			}));
+		}
+		results.push_back(Measure(options,"demosaic",std::string(method[m])+"-"+RayleighKernelName(RayleighKernelResolve(RAYLEIGH_KERNEL_AUTO))+"-parallel",
+			SensorShape(parm,pool->Size()),pixels,[&](){
+			CameraDemosaic(&raw[0],&mosaic,m,RAYLEIGH_KERNEL_AUTO,frame,NULL,NULL,NULL,pool);
+		}));
+	}
+	CameraFrameFree(frame);
+	CameraParametersFree(parm);
+}
+
+
+//"CameraSimulationFrame()" of one 1024x1280 frame through every projection of CameraLens.h.
+static void LensBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	static const char * name[] = {"pinhole","equidistant","equisolid","stereographic"};
+	double psa = 78.9*pi/180.0;
+	double afa = -65.2*pi/180.0;
+	double beta = 278.3*pi/180.0;
+	for(int projection=CAMERA_PROJECTION_PINHOLE; projection<=CAMERA_PROJECTION_STEREOGRAPHIC; projection++){
+		//a 1.8 mm fisheye fills the sensor with its 180 degree image circle
+		CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,projection==CAMERA_PROJECTION_PINHOLE ? 4.0 : 1.8,1);
+		if(parm==NULL){
+			continue;
+		}
+		CameraLens lens;
+		CameraLensDefault(&lens);
+		lens.Projection = projection;
+		lens.FieldOfView = projection==CAMERA_PROJECTION_PINHOLE ? 0.0 : 180.0;
+		CameraParametersSetLens(parm,&lens);
+		CameraFrame * frame = CameraFrameInit(parm);
+		CameraFrameFloat * FrameFloat = CameraFrameFloatInit(parm);
+		if(frame!=NULL && FrameFloat!=NULL){
+			double pixels = FramePixels(parm);
+			results.push_back(Measure(options,"lens",name[projection],SensorShape(parm,1),pixels,[&](){
+				CameraSimulationFrame(psa,afa,beta,parm,frame);
+			}));
+			results.push_back(Measure(options,"lens",std::string(name[projection])+"-float",SensorShape(parm,1),pixels,[&](){
+				CameraSimulationFrame(psa,afa,beta,parm,FrameFloat);
+			}));
+		}
+		CameraFrameFree(frame);
+		CameraFrameFree(FrameFloat);
+		CameraParametersFree(parm);
+	}
+}
+
+
+//"CameraSimulationFrame()" of one 1024x1280 frame under every sky model of SkyModel.h.
+static void SkyBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	static const char * name[] = {"rayleigh","berry","table"};
+	double psa = 78.9*pi/180.0;
+	double afa = -65.2*pi/180.0;
+	double beta = 278.3*pi/180.0;
+	//a measured sky is stood in for by the Berry sky sampled every degree
+	SkyModel berry;
+	SkyModelBerry(&berry,0.8,20.0);
+	SkyTable * table = SkyTableSample(&berry,181,360);
+	for(int model=SKY_MODEL_RAYLEIGH; model<=SKY_MODEL_TABLE; model++){
+		if(model==SKY_MODEL_TABLE && table==NULL){
+			continue;
+		}
+		CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+		if(parm==NULL){
+			continue;
+		}
+		if(model==SKY_MODEL_RAYLEIGH){
+			SkyModelRayleigh(&parm->Sky,0.8);
+		}
+		else if(model==SKY_MODEL_BERRY){
+			parm->Sky = berry;
+		}
+		else{
+			SkyModelTabulated(&parm->Sky,table);
+		}
+		CameraFrame * frame = CameraFrameInit(parm);
+		CameraFrameFloat * FrameFloat = CameraFrameFloatInit(parm);
+		if(frame!=NULL && FrameFloat!=NULL){
+			double pixels = FramePixels(parm);
+			results.push_back(Measure(options,"sky",name[model],SensorShape(parm,1),pixels,[&](){
+				CameraSimulationFrame(psa,afa,beta,parm,frame);
+			}));
+			results.push_back(Measure(options,"sky",std::string(name[model])+"-float",SensorShape(parm,1),pixels,[&](){
+				CameraSimulationFrame(psa,afa,beta,parm,FrameFloat);
+			}));
+		}
+		CameraFrameFree(frame);
+		CameraFrameFree(FrameFloat);
+		CameraParametersFree(parm);
+	}
+	SkyTableFree(table);
+}
+
+
+//A replay of 1024x1280 frames written to a binary frame file, one after the other and with the background writer.
+static void StreamBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the simulation
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	if(parm==NULL){
+		return;
+	}
+	//a camera at the zenith turning once around in BENCHMARK_STREAM_FRAMES frames of 0.1 s over Nanjing
+	CameraTrajectoryPoint path[2] = {{0.0,0.0,0.5*pi,0.0},{0.1*(BENCHMARK_STREAM_FRAMES-1),1.9*pi,0.5*pi,0.0}};
+	CameraStreamSettings settings = {{32.03,118.85},{2019,10,23,4,30,0.0},0.1*(BENCHMARK_STREAM_FRAMES-1),0.1,path,2};
+	int count = CameraStreamFrameCount(&settings);
+	std::vector<CameraAttitude> attitude(count);
+	for(int n=0; n<count; n++){
+		double Azimuth, Elevation;
+		CameraStreamAttitude(&settings,n,&attitude[n],Azimuth,Elevation);
+	}
+	double pixels = FramePixels(parm)*count;
+	std::string shape = SensorShape(parm,pool->Size());
+
+	results.push_back(Measure(options,"stream","batch-binary",shape,pixels,[&](){
+		FrameWriter * writer = FrameWriterOpen(BENCHMARK_BINARY_FILE,FRAME_SCALAR_DOUBLE);
+		if(writer!=NULL){
+			CameraSimulationBatch(&attitude[0],count,parm,pool,CameraFrameSinkBinary,writer);
+			FrameWriterClose(writer);
+		}
+	}));
+	results.push_back(Measure(options,"stream","stream-binary",shape,pixels,[&](){
+		FrameWriter * writer = FrameWriterOpen(BENCHMARK_BINARY_FILE,FRAME_SCALAR_DOUBLE);
+		if(writer!=NULL){
+			CameraSimulationStream(&settings,parm,pool,CameraFrameSinkBinary,writer);
+			FrameWriterClose(writer);
+		}
+	}));
+	remove(BENCHMARK_BINARY_FILE);
+	CameraParametersFree(parm);
+}
+
+//One 1024x1280 frame written to disk as a whole frame and as tiles of bounded memory.
+static void TileBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the simulation
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	CameraFrameFloat * frame = CameraFrameFloatInit(parm);
+	if(parm==NULL || frame==NULL){
+		fprintf(stderr,"tile measurements skipped\n");
+	}
+	else{
+		double psa = 78.9*pi/180.0;
+		double afa = -65.2*pi/180.0;
+		double beta = 278.3*pi/180.0;
+		double pixels = FramePixels(parm);
+		std::string shape = SensorShape(parm,pool->Size());
+
+		results.push_back(Measure(options,"tiles","frame-binary",shape,pixels,[&](){
+			CameraSimulationFrameParallel(psa,afa,beta,parm,frame,pool);
+			FrameWriter * writer = FrameWriterOpen(BENCHMARK_BINARY_FILE,FRAME_SCALAR_FLOAT);
+			if(writer!=NULL){
+				FrameWriterWrite(writer,frame,parm);
+				FrameWriterClose(writer);
+			}
+		}));
+		results.push_back(Measure(options,"tiles","tiled",shape,pixels,[&](){
+			CameraSimulationTiled(psa,afa,beta,parm,0,0,FRAME_SCALAR_FLOAT,0,pool,BENCHMARK_TILE_FILE);
+		}));
+	}
+	remove(BENCHMARK_BINARY_FILE);
+	remove(BENCHMARK_TILE_FILE);
+	CameraFrameFree(frame);
+	CameraParametersFree(parm);
+}
+
+
+
+//Monte Carlo runs of the attitude solver on a small camera, serial and over the thread pool.
+static void MonteCarloBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the parallel measurements
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,64,80,4.0,1);
+	MonteCarloResult * result = (MonteCarloResult *)malloc(sizeof(MonteCarloResult));
+	if(parm==NULL || result==NULL){
+		fprintf(stderr,"Monte Carlo measurements skipped\n");
+	}
+	else{
+		MonteCarloSettings settings;
+		MonteCarloSettingsDefault(&settings);
+		settings.Samples = BENCHMARK_MONTE_CARLO_SAMPLES;
+		MonteCarloEstimator estimator;
+		MonteCarloEstimatorAttitude(&estimator);
+		const char * name[3] = {"none","frame","mosaic"};
+		const int noise[3] = {MONTE_CARLO_NOISE_NONE,MONTE_CARLO_NOISE_FRAME,MONTE_CARLO_NOISE_MOSAIC};
+		for(int k=0; k<3; k++){
+			settings.Noise = noise[k];
+			results.push_back(Measure(options,"montecarlo",name[k],SensorShape(parm,1),settings.Samples,[&](){
+				CameraSimulationMonteCarlo(&settings,parm,&estimator,NULL,result);
+			}));
+			results.push_back(Measure(options,"montecarlo",std::string(name[k])+"-parallel",SensorShape(parm,pool->Size()),
+				settings.Samples,[&](){
+				CameraSimulationMonteCarlo(&settings,parm,&estimator,pool,result);
+			}));
+		}
+	}
+	free(result);
+	CameraParametersFree(parm);
+}
+
+
+
+//DOP and AOP images of a frame in every format, serial and over the thread pool.
+static void ImageBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the parallel measurements
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	CameraFrame * frame = CameraFrameInit(parm);
+	if(parm==NULL || frame==NULL){
+		fprintf(stderr,"image measurements skipped\n");
+	}
+	else{
+		CameraSimulationFrame(78.9*pi/180.0,-65.2*pi/180.0,278.3*pi/180.0,parm,frame);
+		double pixels = FramePixels(parm);
+		ImageSettings settings;
+		ImageSettingsDefault(&settings);
+		const char * name[3] = {"png","ppm","tiff16"};
+		const int format[3] = {IMAGE_FORMAT_PNG,IMAGE_FORMAT_PPM,IMAGE_FORMAT_TIFF16};
+		for(int k=0; k<3; k++){
+			settings.Format = format[k];
+			results.push_back(Measure(options,"image",name[k],SensorShape(parm,1),pixels,[&](){
+				CameraImageWrite(frame,&settings,NULL,BENCHMARK_DOP_IMAGE_FILE,BENCHMARK_AOP_IMAGE_FILE);
+			}));
+			results.push_back(Measure(options,"image",std::string(name[k])+"-parallel",SensorShape(parm,pool->Size()),
+				pixels,[&](){
+				CameraImageWrite(frame,&settings,pool,BENCHMARK_DOP_IMAGE_FILE,BENCHMARK_AOP_IMAGE_FILE);
+			}));
+		}
+	}
+	remove(BENCHMARK_DOP_IMAGE_FILE);
+	remove(BENCHMARK_AOP_IMAGE_FILE);
+	CameraFrameFree(frame);
+	CameraParametersFree(parm);
+}
+
+
+
+//Cameras of a rig simulated one after the other and together.
+static void RigBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the parallel measurements
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	const int count = 4;
+	CameraParameters * parm[count] = {
+		CameraParametersInit(5.2,5.2,1024,1280,4.0,1),
+		CameraParametersInit(5.2,5.2,1024,1280,4.0,1),
+		CameraParametersInit(5.2,5.2,512,640,4.0,1),
+		CameraParametersInit(3.45,3.45,512,512,1.8,1)
+	};
+	const double mount[count][3] = {{0.0,0.0,0.0},{pi/2,0.0,0.0},{pi,0.0,0.0},{0.0,pi/2,0.0}};
+	CameraRig * rig = CameraRigInit(FRAME_SCALAR_FLOAT);
+	CameraFrameFloat * frame[count] = {NULL,NULL,NULL,NULL};
+	int ready = rig!=NULL;
+	for(int k=0; k<count; k++){
+		if(parm[k]==NULL){
+			ready = 0;
+			continue;
+		}
+		frame[k] = CameraFrameFloatInit(parm[k]);
+		double Mount[3][3];
+		CameraMountRotation(mount[k][0],mount[k][1],mount[k][2],Mount);
+		ready = ready && frame[k]!=NULL && CameraRigAddCamera(rig,parm[k],Mount)==k;
+	}
+	if(!ready){
+		fprintf(stderr,"rig measurements skipped\n");
+	}
+	else{
+		CameraLens fisheye = {CAMERA_PROJECTION_EQUIDISTANT,180.0,0.0,0.0,0.0,0.0,0.0};
+		CameraParametersSetLens(parm[3],&fisheye);
+		const double psa = 78.9*pi/180.0, afa = -65.2*pi/180.0, beta = 278.3*pi/180.0;
+		double pixels = 0.0;
+		for(int k=0; k<count; k++){
+			pixels += FramePixels(parm[k]);
+		}
+		results.push_back(Measure(options,"rig","cameras",SensorShape(parm[0],pool->Size()),pixels,[&](){
+			double C_vTb[3][3], C_vTc[3][3], C_cTv[3][3];
+			MatrixEulerRotation(psa,afa,beta,C_vTb);
+			for(int k=0; k<count; k++){
+				MatrixMultiply(rig->Camera[k].Mount,C_vTb,C_vTc);
+				MatrixTrans(C_vTc,C_cTv);
+				CameraSimulationFrameRotation(C_vTc,C_cTv,parm[k],frame[k],pool);
+			}
+		}));
+		results.push_back(Measure(options,"rig","rig",SensorShape(parm[0],pool->Size()),pixels,[&](){
+			CameraSimulationRig(psa,afa,beta,rig,pool);
+		}));
+	}
+	CameraRigFree(rig);
+	for(int k=0; k<count; k++){
+		CameraFrameFree(frame[k]);
+		CameraParametersFree(parm[k]);
+	}
+}
+
+
+
+//Statistics of a frame, reduced after the simulation and fused into it.
+static void ReduceBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool of the parallel measurements
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	CameraFrame * frame = CameraFrameInit(parm);
+	ReduceResult * result = (ReduceResult *)malloc(sizeof(ReduceResult));
+	if(parm==NULL || frame==NULL || result==NULL){
+		fprintf(stderr,"reduce measurements skipped\n");
+	}
+	else{
+		const double psa = 78.9*pi/180.0, afa = -65.2*pi/180.0, beta = 278.3*pi/180.0;
+		double pixels = FramePixels(parm);
+		ReduceSettings settings;
+		ReduceSettingsDefault(&settings);
+		for(int parallel=0; parallel<2; parallel++){
+			ThreadPool * threads = parallel ? pool : NULL;
+			std::string suffix = parallel ? "-parallel" : "";
+			results.push_back(Measure(options,"reduce","frame"+suffix,SensorShape(parm,parallel ? pool->Size() : 1),pixels,[&](){
+				CameraSimulationFrameParallel(psa,afa,beta,parm,frame,threads);
+				CameraFrameReduce(frame,&settings,threads,result);
+			}));
+			results.push_back(Measure(options,"reduce","fused"+suffix,SensorShape(parm,parallel ? pool->Size() : 1),pixels,[&](){
+				CameraSimulationReduce(psa,afa,beta,parm,&settings,threads,result);
+			}));
+		}
+	}
+	free(result);
+	CameraFrameFree(frame);
+	CameraParametersFree(parm);
+}
+
+
+
+//Measure the frame server.
+static void ServerBenchmark(
+	const BenchmarkOptions *	options,     //command line options
+	ThreadPool *	pool,                    //thread pool, whose size the server uses
+	std::vector<BenchmarkResult> &	results  //measurements
+	){
+#ifndef _WIN32
+	char path[128];
+	sprintf(path,"/tmp/hpcamera-benchmark-%d.sock",(int)getpid());
+	FrameServer * server = FrameServerInit(path,pool->Size());
+	if(server==NULL){
+		fprintf(stderr,"server measurements skipped\n");
+		return;
+	}
+	std::thread serving([server](){ FrameServerRun(server); });
+	const double psa = 78.9*pi/180.0, afa = -65.2*pi/180.0, beta = 278.3*pi/180.0;
+	FrameServerCamera camera;
+	FrameServerCameraDefault(&camera);
+	camera.Slots = 16;
+	FrameClient * large = FrameClientConnect(path,&camera);
+	camera.n_x = 64;
+	camera.n_z = 80;
+	FrameClient * small = FrameClientConnect(path,&camera);
+	CameraParameters * LargeParm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	CameraParameters * SmallParm = CameraParametersInit(5.2,5.2,64,80,4.0,1);
+	if(large==NULL || small==NULL || LargeParm==NULL || SmallParm==NULL){
+		fprintf(stderr,"server measurements skipped\n");
+	}
+	else{
+		results.push_back(Measure(options,"server","frame",SensorShape(LargeParm,pool->Size()),FramePixels(LargeParm),[&](){
+			FrameClientFrame(large,0,psa,afa,beta,NULL);
+		}));
+		results.push_back(Measure(options,"server","small",SensorShape(SmallParm,pool->Size()),FramePixels(SmallParm),[&](){
+			FrameClientFrame(small,0,psa,afa,beta,NULL);
+		}));
+		results.push_back(Measure(options,"server","pipelined",SensorShape(SmallParm,pool->Size()),16*FramePixels(SmallParm),[&](){
+			FrameServerReply reply;
+			for(int k=0; k<16; k++){
+				FrameClientSubmit(small,k,k,psa+0.01*k,afa,beta);
+			}
+			for(int k=0; k<16; k++){
+				FrameClientReceive(small,&reply);
+			}
+		}));
+	}
+	FrameServerStop(server);
+	serving.join();
+	FrameClientClose(large);
+	FrameClientClose(small);
+	FrameServerFree(server);
+	CameraParametersFree(LargeParm);
+	CameraParametersFree(SmallParm);
+#else
+	(void)options;
+	(void)pool;
+	(void)results;
+#endif
+}
+
+
+
+//Name and version of the compiler.
+static std::string CompilerName(){
+	char text[128];
+#if defined(_MSC_VER)
+	sprintf(text,"msvc %d",_MSC_VER);
+#elif defined(__clang__)
+	sprintf(text,"clang %d.%d.%d",__clang_major__,__clang_minor__,__clang_patchlevel__);
+#elif defined(__GNUC__)
+	sprintf(text,"gcc %d.%d.%d",__GNUC__,__GNUC_MINOR__,__GNUC_PATCHLEVEL__);
+#else
+	sprintf(text,"unknown");
+#endif
+	return text;
+}
+
+
+
+//Write the measurements as JSON.
+static int WriteJson(
+	const BenchmarkOptions *	options,            //command line options
+	const int     threads,                          //size of the thread pool
+	const std::vector<BenchmarkResult> &	results,//measurements
+	FILE *	file                                    //opened file
+	){
+	fprintf(file,"{\n");
+	fprintf(file,"  \"benchmark\": \"HypotheticalPolarizationCamera\",\n");
+	fprintf(file,"  \"format\": %d,\n",BENCHMARK_FORMAT);
+	fprintf(file,"  \"compiler\": \"%s\",\n",CompilerName().c_str());
+	fprintf(file,"  \"kernel_auto\": \"%s\",\n",RayleighKernelName(RayleighKernelResolve(RAYLEIGH_KERNEL_AUTO)));
+	fprintf(file,"  \"threads\": %d,\n",threads);
+	fprintf(file,"  \"warmup\": %d,\n",options->Warmup);
+	fprintf(file,"  \"repetitions\": %d,\n",options->Repetitions);
+	fprintf(file,"  \"results\": [\n");
+	for(size_t k=0; k<results.size(); k++){
+		const BenchmarkResult & r = results[k];
+		fprintf(file,"    {\"group\": \"%s\", \"name\": \"%s\", %s, \"items\": %.0f, "
+			"\"min_ns\": %.1f, \"median_ns\": %.1f, \"mean_ns\": %.1f, \"ns_per_item\": %.4f, \"items_per_second\": %.6g}%s\n",
+			r.Group.c_str(),r.Name.c_str(),r.Shape.c_str(),r.Items,
+			r.Min,r.Median,r.Mean,r.Median/r.Items,r.Items*1e9/r.Median,k+1<results.size() ? "," : "");
+	}
+	fprintf(file,"  ]\n");
+	fprintf(file,"}\n");
+	return ferror(file) ? -1 : 0;
+}
+
+
+
+int main(int argc, char ** argv){
+	BenchmarkOptions options;
+	options.Quick = 0;
+	options.Repetitions = 7;
+	options.Warmup = 2;
+	options.Threads = 0;
+	options.Output = NULL;
+	for(int k=1; k<argc; k++){
+		if(strcmp(argv[k],"--quick")==0){
+			options.Quick = 1;
+			options.Repetitions = 3;
+		}
+		else if(strcmp(argv[k],"--repetitions")==0 && k+1<argc){
+			options.Repetitions = atoi(argv[++k]);
+		}
+		else if(strcmp(argv[k],"--warmup")==0 && k+1<argc){
+			options.Warmup = atoi(argv[++k]);
+		}
+		else if(strcmp(argv[k],"--threads")==0 && k+1<argc){
+			options.Threads = atoi(argv[++k]);
+		}
+		else if(strcmp(argv[k],"--output")==0 && k+1<argc){
+			options.Output = argv[++k];
+		}
+		else{
+			fprintf(stderr,"usage: %s [--quick] [--repetitions N] [--warmup N] [--threads N] [--output file.json]\n",argv[0]);
+			return 1;
+		}
+	}
+	if(options.Repetitions<1){
+		options.Repetitions = 1;
+	}
+	if(options.Warmup<0){
+		options.Warmup = 0;
+	}
+
+	ThreadPool pool(options.Threads);
+	std::vector<BenchmarkResult> results;
+	SimulationBenchmark(&options,&pool,results);
+	MatrixBenchmark(&options,results);
+	SinkBenchmark(&options,&pool,results);
+	MosaicBenchmark(&options,&pool,results);
+	DemosaicBenchmark(&options,&pool,results);
+	LensBenchmark(&options,results);
+	SkyBenchmark(&options,results);
+	StreamBenchmark(&options,&pool,results);
+	TileBenchmark(&options,&pool,results);
+	MonteCarloBenchmark(&options,&pool,results);
+	ImageBenchmark(&options,&pool,results);
+	RigBenchmark(&options,&pool,results);
+	ReduceBenchmark(&options,&pool,results);
+	ServerBenchmark(&options,&pool,results);
+
+	FILE * file = options.Output==NULL ? stdout : fopen(options.Output,"w");
+	if(file==NULL){
+		fprintf(stderr,"cannot create %s\n",options.Output);
+		return 1;
+	}
+	int status = WriteJson(&options,pool.Size(),results,file);
+	if(file!=stdout){
+		fclose(file);
+	}
+	return status==0 ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+#ifndef _ALIGNEDMEMORY_H_
+#define _ALIGNEDMEMORY_H_
+
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#define CACHE_LINE_SIZE             64      //alignment of planes and tables (unit is byte)
+
+//Allocate size bytes aligned to a cache line, NULL on failure.
+inline void * AlignedAlloc(const size_t size)
+{
+#ifdef _WIN32
+	return _aligned_malloc(size>0 ? size : 1,CACHE_LINE_SIZE);
+#else
+	void * p = NULL;
+	return posix_memalign(&p,CACHE_LINE_SIZE,size>0 ? size : 1)==0 ? p : NULL;
+#endif
+}
+
+//Release memory of AlignedAlloc().
+inline void AlignedFree(void * p)
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+#endif
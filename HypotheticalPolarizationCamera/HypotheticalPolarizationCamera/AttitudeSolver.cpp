@@ -0,0 +1,1123 @@
+/*
+"AttitudeSolver" functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for recovering the attitude of the camera from DOP and AOP, the inverse of "CameraSimulation()".
+And this code is written in C++11.
+
+Usage information:
+Build a solver once per camera with "AttitudeSolverInit()", then call "AttitudeSolveFrame()" or "AttitudeSolvePixels()" for every measured frame.
+--------------------------
+
+Observability:
+	In the Rayleigh sky model DOP and AOP of a pixel only depend on its shooting direction r and on the sun vector
+	s=(-sin(beta)*cos(afa), sin(afa), cos(beta)*cos(afa)) in body coordinates, the third column of C_vTb:
+	DOP=(1-c*c)/(1+c*c) with c=s.r, and AOP=atan(E_x/E_z) with the E-vector E=s x r. So only afa and beta are
+	recovered. The yaw angle psa turns the camera about the sun vector and leaves the frames unchanged; it is copied
+	from the hint (0 without one). s and -s give identical frames as well, so every solution has an alternative
+	(afa'=-afa, beta'=beta+pi). The solver returns the one nearer to the hint, or the one with s_z>=0.
+	DOP_max of the sky model of the camera parameters scales the predicted DOP. Skies that are not symmetric about
+	the sun vector (SKY_MODEL_BERRY, SKY_MODEL_TABLE) make psa observable: the neutral points of a Berry sky lie on
+	the x axis of the solar vector coordinate system, so psa is recovered modulo 180 degrees (the one nearer to the
+	hint), and the opposite sun vector only gives the same frames in a Berry sky.
+
+Method:
+	1. Coarse lookup: DOP, cos(2*AOP) and sin(2*AOP) of ATTITUDE_LUT_SIZE sun vectors spread evenly over the half
+	   sphere are precomputed at an 8x8 grid of frame pixels. A frame is compared with every entry at the grid;
+	   a sparse set of pixels is compared with predictions of the entries at up to 64 of its pixels.
+	2. Refinement: Levenberg-Marquardt on the sun vector (two angles in its tangent plane) over up to
+	   ATTITUDE_MAX_PIXELS pixels of a frame or all given pixels, starting from the ATTITUDE_COARSE_STARTS best
+	   distinct lookup entries. The residuals are the DOP difference and the difference of (cos(2*AOP),sin(2*AOP))
+	   weighted by the measured DOP, so AOP wraps at 180 degrees and pixels next to the sun count little.
+	3. Skies that are not symmetric about the sun vector: the refined sun vector of the Rayleigh sky with the same
+	   DOP_max is turned about itself in ATTITUDE_SPIN_STEPS steps (and reversed), and the best attitude is
+	   refined by Levenberg-Marquardt on a rotation vector of all three angles, predicting DOP and AOP with
+	   "SkyModelStokes()", the reference code of the kernels.
+	With a hint (the attitude of the previous frame) the refinement starts from the hint, and the lookup is only
+	used when the residuals stay above ATTITUDE_TRACK_DOP_RMS or ATTITUDE_TRACK_AOP_RMS.
+	A solver keeps scratch buffers, so every thread needs its own solver.
+
+
+Function 1: "AttitudeSolverInit()" 
+
+    //Precompute the coarse attitude lookup for frames of the camera parameters.
+	AttitudeSolver * AttitudeSolverInit(
+		const CameraParameters *	parm,
+		const int     LUTSize
+	);
+	--------------input----------------
+	const CameraParameters *	parm,  //camera parameters (D_x, D_z, n_x, n_z, f, PixelInterval, Lens and Sky; the
+	                                   //grid of a SKY_MODEL_TABLE sky has to outlive the solver)
+	const int     LUTSize              //number of candidate sun vectors, 0 for ATTITUDE_LUT_SIZE
+	-----------------------------------
+	-------------output----------------
+	AttitudeSolver *                   //solver, NULL if it could not be allocated (free with "AttitudeSolverFree()")
+	-----------------------------------
+
+
+Function 2: "AttitudeSolverFree()" 
+
+    //Release a solver returned by "AttitudeSolverInit()".
+	void AttitudeSolverFree(
+		AttitudeSolver *	solver
+	);
+
+
+Function 3: "AttitudeSolveFrame()" 
+
+    //Recover the attitude from a DOP and AOP frame.
+	int AttitudeSolveFrame(
+		AttitudeSolver *	solver,
+		const CameraFrame *	frame,
+		const CameraAttitude *	hint,
+		AttitudeSolution *	solution
+	);
+	--------------input----------------
+	AttitudeSolver *	solver,         //attitude solver of the camera parameters of the frame
+	const CameraFrame *	frame,          //measured DOP and AOP frame (NaN pixels are skipped)
+	const CameraAttitude *	hint,       //attitude of the previous frame, NULL if unknown
+	-----------------------------------
+	-------------output----------------
+	AttitudeSolution *	solution        //recovered attitude and residuals
+	int                                 //0 on success, -1 if the frame does not match the solver or has too few pixels
+	-----------------------------------
+
+
+Function 4: "AttitudeSolvePixels()" 
+
+    //Recover the attitude from a sparse set of pixels.
+	int AttitudeSolvePixels(
+		AttitudeSolver *	solver,
+		const AttitudePixel *	pixel,
+		const int     count,
+		const CameraAttitude *	hint,
+		AttitudeSolution *	solution
+	);
+	--------------input----------------
+	AttitudeSolver *	solver,         //attitude solver of the camera parameters
+	const AttitudePixel *	pixel,      //measured pixels (i_x, j_z, DOP, AOP in degree)
+	const int     count,                //number of pixels, at least 3 spread over the image
+	const CameraAttitude *	hint,       //attitude of the previous frame, NULL if unknown
+	-----------------------------------
+	-------------output----------------
+	AttitudeSolution *	solution        //recovered attitude and residuals
+	int                                 //0 on success, -1 on too few valid pixels or allocation failure
+	-----------------------------------
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include "AttitudeSolver.h"
+#include "MatrixTemplate.h"
+
+#ifndef ALLOC
+#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
+#endif
+const static double pi = 3.141592653589793;
+
+//grid pixels of a sparse set compared with the lookup
+#define ATTITUDE_PIXEL_SAMPLES      64
+//minimum angle between the lookup entries refined (unit is radian)
+#define ATTITUDE_START_SEPARATION   (10.0*pi/180.0)
+
+
+
+//Unit shooting direction of a pixel in body coordinate system through the lens; returns -1 if it sees no sky.
+static int PixelRay(
+	const AttitudeSolver *	solver,  //attitude solver
+	const int     i_x,               //column coordinate in pixel coordinate system
+	const int     j_z,               //raw coordinate in pixel coordinate system
+	double *	r                    //unit shooting direction
+	){
+	double P_x = solver->D_x*(i_x-(solver->Camera_n_x+1)/2);
+	double P_z = solver->D_z*(j_z-(solver->Camera_n_z+1)/2);
+	double Ray[3];
+	int status = CameraLensRay(&solver->Lens,solver->f,P_x,P_z,Ray);
+	r[0] = Ray[0];
+	r[1] = Ray[1];
+	r[2] = Ray[2];
+	return status;
+}
+
+
+
+//DOP, cos(2*AOP) and sin(2*AOP) of a shooting direction for a sun vector in a Rayleigh sky; returns E_x^2+E_z^2
+//(0 if AOP is undefined).
+static double Predict(
+	const double *	s,      //unit sun vector in body coordinate system
+	const double *	r,      //unit shooting direction in body coordinate system
+	const double  DOP_max,  //maximum DOP in the sky
+	double &	DOP,        //DOP
+	double &	Cos,        //cos(2*AOP)
+	double &	Sin         //sin(2*AOP)
+	){
+	double c = s[0]*r[0]+s[1]*r[1]+s[2]*r[2];
+	DOP = DOP_max*(1.0-c*c)/(1.0+c*c);
+	double E_x = s[1]*r[2]-s[2]*r[1];
+	double E_z = s[0]*r[1]-s[1]*r[0];
+	double Q = E_x*E_x+E_z*E_z;
+	if(Q>0.0){
+		Cos = (E_z*E_z-E_x*E_x)/Q;
+		Sin = 2.0*E_x*E_z/Q;
+	}
+	else{
+		Cos = 1.0;
+		Sin = 0.0;
+	}
+	return Q;
+}
+
+
+
+//Sun vector of pitch and roll angles.
+static void SunVector(
+	const double  afa,  //pitch angle (unit is radian)
+	const double  beta, //roll angle (unit is radian)
+	double *	s       //unit sun vector in body coordinate system
+	){
+	s[0] = -sin(beta)*cos(afa);
+	s[1] = sin(afa);
+	s[2] = cos(beta)*cos(afa);
+}
+
+
+
+//Grow the scratch of the used pixels.
+static int Reserve(
+	AttitudeSolver *	solver,  //attitude solver
+	const int     count          //number of pixels
+	){
+	if(count<=solver->Capacity){
+		return 0;
+	}
+	double * Ray = (double *)realloc(solver->Ray,(size_t)count*3*sizeof(double));
+	if(Ray!=NULL){
+		solver->Ray = Ray;
+	}
+	double * DOP = (double *)realloc(solver->DOP,(size_t)count*sizeof(double));
+	if(DOP!=NULL){
+		solver->DOP = DOP;
+	}
+	double * Cos = (double *)realloc(solver->Cos,(size_t)count*sizeof(double));
+	if(Cos!=NULL){
+		solver->Cos = Cos;
+	}
+	double * Sin = (double *)realloc(solver->Sin,(size_t)count*sizeof(double));
+	if(Sin!=NULL){
+		solver->Sin = Sin;
+	}
+	if(Ray==NULL || DOP==NULL || Cos==NULL || Sin==NULL){
+		return -1;
+	}
+	solver->Capacity = count;
+	return 0;
+}
+
+
+
+//Store a measured pixel in the scratch; NaN pixels are skipped.
+static void AddPixel(
+	AttitudeSolver *	solver,  //attitude solver
+	int &	count,               //number of stored pixels
+	const int     i_x,           //column coordinate in pixel coordinate system
+	const int     j_z,           //raw coordinate in pixel coordinate system
+	const double  DOP,           //measured DOP
+	const double  AOP            //measured AOP (unit is degree)
+	){
+	if(DOP!=DOP || AOP!=AOP || PixelRay(solver,i_x,j_z,solver->Ray+3*count)!=0){
+		return;
+	}
+	solver->DOP[count] = DOP;
+	solver->Cos[count] = cos(2.0*AOP*pi/180.0);
+	solver->Sin[count] = sin(2.0*AOP*pi/180.0);
+	count++;
+}
+
+
+
+//Sum of squared residuals at a sun vector, with the Gauss-Newton normal equations in the tangent basis t1, t2.
+static double Residuals(
+	const AttitudeSolver *	solver,  //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	const double *	s,               //unit sun vector
+	const double *	t1,              //first tangent direction, NULL for the cost only
+	const double *	t2,              //second tangent direction
+	double *	A,                   //J'J as {a11,a12,a22}
+	double *	g                    //J'r
+	){
+	double cost = 0.0;
+	if(t1!=NULL){
+		A[0] = A[1] = A[2] = 0.0;
+		g[0] = g[1] = 0.0;
+	}
+	for(int i=0; i<count; i++){
+		const double * r = solver->Ray+3*i;
+		double DOP,Cos,Sin;
+		double Q = Predict(s,r,solver->Sky.DOP_max,DOP,Cos,Sin);
+		double w = solver->DOP[i]>0.0 ? solver->DOP[i] : 0.0;	//weight of AOP
+		double res[3] = {DOP-solver->DOP[i],w*(Cos-solver->Cos[i]),w*(Sin-solver->Sin[i])};
+		if(Q<=0.0){
+			res[1] = res[2] = 0.0;
+		}
+		cost += res[0]*res[0]+res[1]*res[1]+res[2]*res[2];
+		if(t1==NULL){
+			continue;
+		}
+
+		double c = s[0]*r[0]+s[1]*r[1]+s[2]*r[2];
+		double E_x = s[1]*r[2]-s[2]*r[1];
+		double E_z = s[0]*r[1]-s[1]*r[0];
+		double J[2][3];
+		const double * t[2] = {t1,t2};
+		for(int k=0; k<2; k++){
+			double dc = t[k][0]*r[0]+t[k][1]*r[1]+t[k][2]*r[2];
+			J[k][0] = -4.0*solver->Sky.DOP_max*c/((1.0+c*c)*(1.0+c*c))*dc;
+			J[k][1] = J[k][2] = 0.0;
+			if(Q>0.0){
+				double dE_x = t[k][1]*r[2]-t[k][2]*r[1];
+				double dE_z = t[k][0]*r[1]-t[k][1]*r[0];
+				double dAOP = (E_z*dE_x-E_x*dE_z)/Q;
+				J[k][1] = -2.0*w*Sin*dAOP;
+				J[k][2] = 2.0*w*Cos*dAOP;
+			}
+		}
+		for(int m=0; m<3; m++){
+			A[0] += J[0][m]*J[0][m];
+			A[1] += J[0][m]*J[1][m];
+			A[2] += J[1][m]*J[1][m];
+			g[0] += J[0][m]*res[m];
+			g[1] += J[1][m]*res[m];
+		}
+	}
+	return cost;
+}
+
+
+
+//Tangent basis of a unit vector.
+static void Tangent(
+	const double *	s,   //unit vector
+	double *	t1,      //first unit tangent
+	double *	t2       //second unit tangent, s x t1
+	){
+	//cross with the axis least aligned with s
+	double a[3] = {0.0,0.0,0.0};
+	int k = fabs(s[0])<fabs(s[1]) ? (fabs(s[0])<fabs(s[2]) ? 0 : 2) : (fabs(s[1])<fabs(s[2]) ? 1 : 2);
+	a[k] = 1.0;
+	t1[0] = s[1]*a[2]-s[2]*a[1];
+	t1[1] = s[2]*a[0]-s[0]*a[2];
+	t1[2] = s[0]*a[1]-s[1]*a[0];
+	double norm = sqrt(t1[0]*t1[0]+t1[1]*t1[1]+t1[2]*t1[2]);
+	for(int i=0; i<3; i++){
+		t1[i] /= norm;
+	}
+	t2[0] = s[1]*t1[2]-s[2]*t1[1];
+	t2[1] = s[2]*t1[0]-s[0]*t1[2];
+	t2[2] = s[0]*t1[1]-s[1]*t1[0];
+}
+
+
+
+//Levenberg-Marquardt refinement of the sun vector; returns the final cost.
+static double Refine(
+	const AttitudeSolver *	solver,  //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	double *	s,                   //unit sun vector, refined in place
+	int &	iterations,              //iterations done
+	double *	A                    //J'J at the solution as {a11,a12,a22}
+	){
+	double t1[3],t2[3],g[2];
+	Tangent(s,t1,t2);
+	double cost = Residuals(solver,count,s,t1,t2,A,g);
+	double mu = 1e-3;
+	for(iterations=0; iterations<ATTITUDE_MAX_ITERATIONS; iterations++){
+		//(J'J+mu*diag(J'J))d=-J'r
+		double a11 = A[0]*(1.0+mu);
+		double a22 = A[2]*(1.0+mu);
+		double det = a11*a22-A[1]*A[1];
+		if(!(det>0.0)){
+			break;
+		}
+		double d1 = -(a22*g[0]-A[1]*g[1])/det;
+		double d2 = -(a11*g[1]-A[1]*g[0])/det;
+
+		double trial[3];
+		for(int i=0; i<3; i++){
+			trial[i] = s[i]+d1*t1[i]+d2*t2[i];
+		}
+		double norm = sqrt(trial[0]*trial[0]+trial[1]*trial[1]+trial[2]*trial[2]);
+		for(int i=0; i<3; i++){
+			trial[i] /= norm;
+		}
+		double TrialCost = Residuals(solver,count,trial,NULL,NULL,NULL,NULL);
+		if(TrialCost<=cost){
+			for(int i=0; i<3; i++){
+				s[i] = trial[i];
+			}
+			Tangent(s,t1,t2);
+			cost = Residuals(solver,count,s,t1,t2,A,g);
+			mu = mu*0.1>1e-12 ? mu*0.1 : 1e-12;
+			if(d1*d1+d2*d2<1e-24){
+				break;
+			}
+		}
+		else{
+			mu *= 10.0;
+			if(mu>1e12){
+				break;
+			}
+		}
+	}
+	return cost;
+}
+
+
+
+//Refine the best distinct lookup entries; returns the cost of the best refined sun vector.
+static double Lookup(
+	const AttitudeSolver *	solver,  //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	const std::vector<double> &	LUTCost,//cost of every lookup entry
+	double *	best,                //best refined sun vector
+	int &	iterations,              //iterations of its refinement
+	double *	A                    //J'J at it as {a11,a12,a22}
+	){
+	std::vector<int> order(LUTCost.size());
+	for(size_t k=0; k<order.size(); k++){
+		order[k] = (int)k;
+	}
+	std::sort(order.begin(),order.end(),[&](int a, int b){return LUTCost[a]<LUTCost[b];});
+	std::vector<int> start;
+	for(size_t k=0; k<order.size() && (int)start.size()<ATTITUDE_COARSE_STARTS; k++){
+		const double * s = solver->LUTSun+3*order[k];
+		bool distinct = true;
+		for(size_t m=0; m<start.size(); m++){
+			const double * t = solver->LUTSun+3*start[m];
+			if(fabs(s[0]*t[0]+s[1]*t[1]+s[2]*t[2])>cos(ATTITUDE_START_SEPARATION)){
+				distinct = false;
+				break;
+			}
+		}
+		if(distinct){
+			start.push_back(order[k]);
+		}
+	}
+	double BestCost = HUGE_VAL;
+	for(size_t m=0; m<start.size(); m++){
+		double s[3] = {solver->LUTSun[3*start[m]],solver->LUTSun[3*start[m]+1],solver->LUTSun[3*start[m]+2]};
+		double a[3];
+		int it;
+		double cost = Refine(solver,count,s,it,a);
+		if(cost<BestCost){
+			BestCost = cost;
+			iterations = it;
+			for(int i=0; i<3; i++){
+				best[i] = s[i];
+				A[i] = a[i];
+			}
+		}
+	}
+	return BestCost;
+}
+
+
+
+//DOP, cos(2*AOP) and sin(2*AOP) of a shooting direction through the sky model of the solver; returns 0 if AOP is
+//undefined.
+static int PredictSky(
+	const AttitudeSolver *	solver,  //attitude solver
+	const double  (&C_vTb)[3][3],    //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],    //rotation matrix from body to solar vector coordinate system
+	const double *	r,               //unit shooting direction in body coordinate system
+	double &	DOP,                 //DOP
+	double &	Cos,                 //cos(2*AOP)
+	double &	Sin                  //sin(2*AOP)
+	){
+	double Ray[3] = {r[0],r[1],r[2]};
+	double S1, S2;
+	SkyModelStokes(&solver->Sky,C_vTb,C_bTv,Ray,S1,S2);
+	DOP = sqrt(S1*S1+S2*S2);
+	if(DOP>0.0){
+		Cos = S1/DOP;
+		Sin = S2/DOP;
+		return 1;
+	}
+	Cos = 1.0;
+	Sin = 0.0;
+	return 0;
+}
+
+
+
+//Sum of squared residuals of an attitude in the sky model of the solver, with the residuals of every pixel.
+static double SkyResiduals(
+	const AttitudeSolver *	solver,  //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	const double  (&C_vTb)[3][3],    //rotation matrix from solar vector to body coordinate system
+	double *	res                  //3 residuals per pixel, NULL for the cost only
+	){
+	double C_bTv[3][3];
+	for(int i=0; i<3; i++){
+		for(int j=0; j<3; j++){
+			C_bTv[i][j] = C_vTb[j][i];
+		}
+	}
+	double cost = 0.0;
+	for(int i=0; i<count; i++){
+		double DOP,Cos,Sin;
+		int defined = PredictSky(solver,C_vTb,C_bTv,solver->Ray+3*i,DOP,Cos,Sin);
+		double w = solver->DOP[i]>0.0 && defined ? solver->DOP[i] : 0.0;	//weight of AOP
+		double r[3] = {DOP-solver->DOP[i],w*(Cos-solver->Cos[i]),w*(Sin-solver->Sin[i])};
+		cost += r[0]*r[0]+r[1]*r[1]+r[2]*r[2];
+		if(res!=NULL){
+			res[3*i] = r[0];
+			res[3*i+1] = r[1];
+			res[3*i+2] = r[2];
+		}
+	}
+	return cost;
+}
+
+
+
+//Attitude turned by a small rotation vector in solar vector coordinate system: d_x and d_y tilt the sun vector,
+//d_z turns the attitude about it.
+static void Rotate(
+	const double  (&C_vTb)[3][3],    //rotation matrix from solar vector to body coordinate system
+	const double *	d,               //rotation vector (unit is radian)
+	double  (&Turned)[3][3]          //C_vTb*exp([d]x)
+	){
+	double angle = sqrt(d[0]*d[0]+d[1]*d[1]+d[2]*d[2]);
+	double R[3][3] = {{1.0,0.0,0.0},{0.0,1.0,0.0},{0.0,0.0,1.0}};
+	if(angle>0.0){
+		double k[3] = {d[0]/angle,d[1]/angle,d[2]/angle};
+		double K[3][3] = {{0.0,-k[2],k[1]},{k[2],0.0,-k[0]},{-k[1],k[0],0.0}};
+		double a = sin(angle);
+		double b = 1.0-cos(angle);
+		for(int i=0; i<3; i++){
+			for(int j=0; j<3; j++){
+				double KK = K[i][0]*K[0][j]+K[i][1]*K[1][j]+K[i][2]*K[2][j];
+				R[i][j] += a*K[i][j]+b*KK;
+			}
+		}
+	}
+	for(int i=0; i<3; i++){
+		for(int j=0; j<3; j++){
+			Turned[i][j] = C_vTb[i][0]*R[0][j]+C_vTb[i][1]*R[1][j]+C_vTb[i][2]*R[2][j];
+		}
+	}
+}
+
+
+
+//Cost of an attitude with the Gauss-Newton normal equations of its rotation vector (central differences).
+static double SkyNormal(
+	const AttitudeSolver *	solver,  //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	const double  (&C_vTb)[3][3],    //rotation matrix from solar vector to body coordinate system
+	std::vector<double> &	res,     //scratch of 9 values per pixel
+	double  (&A)[3][3],              //J'J
+	double *	g                    //J'r
+	){
+	const double h = 1e-6;
+	double * r = &res[0];
+	double * plus = r+3*count;
+	double * minus = plus+3*count;
+	double cost = SkyResiduals(solver,count,C_vTb,r);
+	for(int k=0; k<3; k++){
+		g[k] = 0.0;
+		for(int m=0; m<3; m++){
+			A[k][m] = 0.0;
+		}
+	}
+	std::vector<double> J(9*(size_t)count);
+	for(int k=0; k<3; k++){
+		double d[3] = {0.0,0.0,0.0};
+		double Turned[3][3];
+		d[k] = h;
+		Rotate(C_vTb,d,Turned);
+		SkyResiduals(solver,count,Turned,plus);
+		d[k] = -h;
+		Rotate(C_vTb,d,Turned);
+		SkyResiduals(solver,count,Turned,minus);
+		for(int n=0; n<3*count; n++){
+			J[(size_t)k*3*count+n] = (plus[n]-minus[n])/(2.0*h);
+		}
+	}
+	for(int n=0; n<3*count; n++){
+		for(int k=0; k<3; k++){
+			double J_k = J[(size_t)k*3*count+n];
+			g[k] += J_k*r[n];
+			for(int m=k; m<3; m++){
+				A[k][m] += J_k*J[(size_t)m*3*count+n];
+			}
+		}
+	}
+	A[1][0] = A[0][1];
+	A[2][0] = A[0][2];
+	A[2][1] = A[1][2];
+	return cost;
+}
+
+
+
+//Determinant of a 3x3 matrix.
+static double Determinant(
+	const double  (&M)[3][3]         //matrix
+	){
+	return M[0][0]*(M[1][1]*M[2][2]-M[1][2]*M[2][1])-M[0][1]*(M[1][0]*M[2][2]-M[1][2]*M[2][0])
+		+M[0][2]*(M[1][0]*M[2][1]-M[1][1]*M[2][0]);
+}
+
+
+
+//Levenberg-Marquardt refinement of the whole attitude in the sky model of the solver; returns the final cost.
+static double RefineRotation(
+	const AttitudeSolver *	solver,  //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	double  (&C_vTb)[3][3],          //rotation matrix from solar vector to body coordinate system, refined in place
+	int &	iterations,              //iterations done
+	double  (&A)[3][3]               //J'J at the solution
+	){
+	std::vector<double> res(9*(size_t)count);
+	double g[3];
+	double cost = SkyNormal(solver,count,C_vTb,res,A,g);
+	double mu = 1e-3;
+	for(iterations=0; iterations<ATTITUDE_MAX_ITERATIONS; iterations++){
+		//(J'J+mu*diag(J'J))d=-J'r by Cramer's rule
+		double M[3][3];
+		for(int k=0; k<3; k++){
+			for(int m=0; m<3; m++){
+				M[k][m] = A[k][m]*(k==m ? 1.0+mu : 1.0);
+			}
+		}
+		double det = Determinant(M);
+		if(!(det>0.0)){
+			break;
+		}
+		double d[3];
+		for(int k=0; k<3; k++){
+			double Mk[3][3];
+			for(int i=0; i<3; i++){
+				for(int m=0; m<3; m++){
+					Mk[i][m] = m==k ? -g[i] : M[i][m];
+				}
+			}
+			d[k] = Determinant(Mk)/det;
+		}
+
+		double trial[3][3];
+		Rotate(C_vTb,d,trial);
+		double TrialCost = SkyResiduals(solver,count,trial,NULL);
+		if(TrialCost<=cost){
+			for(int i=0; i<3; i++){
+				for(int j=0; j<3; j++){
+					C_vTb[i][j] = trial[i][j];
+				}
+			}
+			cost = SkyNormal(solver,count,C_vTb,res,A,g);
+			mu = mu*0.1>1e-12 ? mu*0.1 : 1e-12;
+			if(d[0]*d[0]+d[1]*d[1]+d[2]*d[2]<1e-24){
+				break;
+			}
+		}
+		else{
+			mu *= 10.0;
+			if(mu>1e12){
+				break;
+			}
+		}
+	}
+	return cost;
+}
+
+
+
+//RMS DOP and AOP residuals of an attitude in the sky model of the solver.
+static void SkyStatistics(
+	const AttitudeSolver *	solver,  //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	const double  (&C_vTb)[3][3],    //rotation matrix from solar vector to body coordinate system
+	double &	DOPResidual,         //RMS DOP difference
+	double &	AOPResidual          //RMS AOP difference modulo 180 degrees, weighted by the measured DOP (unit is degree)
+	){
+	double C_bTv[3][3];
+	for(int i=0; i<3; i++){
+		for(int j=0; j<3; j++){
+			C_bTv[i][j] = C_vTb[j][i];
+		}
+	}
+	double DOPSum = 0.0;
+	double AOPSum = 0.0;
+	double WeightSum = 0.0;
+	for(int i=0; i<count; i++){
+		double DOP,Cos,Sin;
+		int defined = PredictSky(solver,C_vTb,C_bTv,solver->Ray+3*i,DOP,Cos,Sin);
+		DOPSum += (DOP-solver->DOP[i])*(DOP-solver->DOP[i]);
+		if(defined){
+			double dAOP = 0.5*atan2(Sin*solver->Cos[i]-Cos*solver->Sin[i],Cos*solver->Cos[i]+Sin*solver->Sin[i]);
+			double w = solver->DOP[i]>0.0 ? solver->DOP[i] : 0.0;
+			AOPSum += w*w*dAOP*dAOP;
+			WeightSum += w*w;
+		}
+	}
+	DOPResidual = sqrt(DOPSum/count);
+	AOPResidual = WeightSum>0.0 ? sqrt(AOPSum/WeightSum)*180.0/pi : 0.0;
+}
+
+
+
+//Refine the whole attitude in a sky that is not symmetric about the sun vector and fill the solution.
+static int SolveSky(
+	AttitudeSolver *	solver,      //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	const std::vector<double> &	LUTCost,//cost of every lookup entry, empty if only the hint is refined
+	const CameraAttitude *	hint,    //attitude of the previous frame, NULL if unknown
+	AttitudeSolution *	solution     //recovered attitude and residuals
+	){
+	double C_vTb[3][3] = {{1.0,0.0,0.0},{0.0,1.0,0.0},{0.0,0.0,1.0}};
+	double A[3][3] = {{0.0,0.0,0.0},{0.0,0.0,0.0},{0.0,0.0,0.0}};
+	double BestCost = HUGE_VAL;
+	int iterations = 0;
+	double DOPResidual = HUGE_VAL;
+	double AOPResidual = HUGE_VAL;
+	solution->Tracked = 0;
+
+	double HintSun[3] = {0.0,0.0,1.0};
+	if(hint!=NULL){
+		SunVector(hint->afa,hint->beta,HintSun);
+		MatrixEulerRotation(hint->psa,hint->afa,hint->beta,C_vTb);
+		BestCost = RefineRotation(solver,count,C_vTb,iterations,A);
+		SkyStatistics(solver,count,C_vTb,DOPResidual,AOPResidual);
+		solution->Tracked = 1;
+	}
+	if(hint==NULL || (!LUTCost.empty() && (DOPResidual>ATTITUDE_TRACK_DOP_RMS || AOPResidual>ATTITUDE_TRACK_AOP_RMS))){
+		//sun vector of the Rayleigh sky with the same DOP_max, then the best yaw angle about either sign of it
+		double s[3] = {0.0,0.0,1.0};
+		double a[3];
+		int it = 0;
+		Lookup(solver,count,LUTCost,s,it,a);
+		double start[3][3];
+		double StartCost = HUGE_VAL;
+		for(int sign=1; sign>=-1; sign-=2){
+			double afa = asin(sign*s[1]>1.0 ? 1.0 : (sign*s[1]<-1.0 ? -1.0 : sign*s[1]));
+			double beta = atan2(-sign*s[0],sign*s[2]);
+			for(int k=0; k<ATTITUDE_SPIN_STEPS; k++){
+				double trial[3][3];
+				MatrixEulerRotation(2.0*pi*k/ATTITUDE_SPIN_STEPS,afa,beta,trial);
+				double cost = SkyResiduals(solver,count,trial,NULL);
+				if(cost<StartCost){
+					StartCost = cost;
+					for(int i=0; i<3; i++){
+						for(int j=0; j<3; j++){
+							start[i][j] = trial[i][j];
+						}
+					}
+				}
+			}
+		}
+		double StartA[3][3];
+		double cost = RefineRotation(solver,count,start,it,StartA);
+		if(cost<BestCost){
+			BestCost = cost;
+			iterations = it;
+			for(int i=0; i<3; i++){
+				for(int j=0; j<3; j++){
+					C_vTb[i][j] = start[i][j];
+					A[i][j] = StartA[i][j];
+				}
+			}
+		}
+		SkyStatistics(solver,count,C_vTb,DOPResidual,AOPResidual);
+		solution->Tracked = 0;
+	}
+	solution->DOPResidual = DOPResidual;
+	solution->AOPResidual = AOPResidual;
+
+	//in a Berry sky the opposite sun vector with the attitude turned by pi about the x axis of the solar vector
+	//coordinate system gives the same frames: keep the one nearer to the hint, or the one with s_z>=0
+	double Opposite[3][3];
+	for(int i=0; i<3; i++){
+		Opposite[i][0] = C_vTb[i][0];
+		Opposite[i][1] = -C_vTb[i][1];
+		Opposite[i][2] = -C_vTb[i][2];
+	}
+	if(solver->Sky.Model==SKY_MODEL_BERRY){
+		bool flip = hint!=NULL ? C_vTb[0][2]*HintSun[0]+C_vTb[1][2]*HintSun[1]+C_vTb[2][2]*HintSun[2]<0.0
+			: (C_vTb[2][2]<0.0 || (C_vTb[2][2]==0.0 && C_vTb[1][2]<0.0));
+		for(int i=0; i<3 && flip; i++){
+			for(int j=0; j<3; j++){
+				double t = C_vTb[i][j];
+				C_vTb[i][j] = Opposite[i][j];
+				Opposite[i][j] = t;
+			}
+		}
+	}
+	for(int i=0; i<3; i++){
+		solution->Sun[i] = C_vTb[i][2];
+	}
+	MatrixEulerAngles(C_vTb,solution->psa,solution->afa,solution->beta);
+	if(solver->Sky.Model==SKY_MODEL_BERRY){
+		double psa;
+		MatrixEulerAngles(Opposite,psa,solution->AlternativeAfa,solution->AlternativeBeta);
+	}
+	else{
+		solution->AlternativeAfa = solution->afa;
+		solution->AlternativeBeta = solution->beta;
+	}
+
+	//1-sigma uncertainty from the covariance sigma^2*(J'J)^-1 of the two angles that tilt the sun vector
+	double det = Determinant(A);
+	int dof = 3*count-3;
+	double trace = (A[1][1]*A[2][2]-A[1][2]*A[2][1]+A[0][0]*A[2][2]-A[0][2]*A[2][0])/det;
+	solution->SunError = det>0.0 && dof>0 ? sqrt(BestCost/dof*trace)*180.0/pi : HUGE_VAL;
+	solution->Pixels = count;
+	solution->Iterations = iterations;
+	return 0;
+}
+
+
+
+//Refine the best distinct lookup entries (or the hint) and fill the solution.
+static int Solve(
+	AttitudeSolver *	solver,      //attitude solver with the used pixels
+	const int     count,             //number of used pixels
+	const std::vector<double> &	LUTCost,//cost of every lookup entry, empty if only the hint is refined
+	const CameraAttitude *	hint,    //attitude of the previous frame, NULL if unknown
+	AttitudeSolution *	solution     //recovered attitude and residuals
+	){
+	if(solver->Sky.Model!=SKY_MODEL_RAYLEIGH){
+		return SolveSky(solver,count,LUTCost,hint,solution);
+	}
+	double best[3] = {0.0,0.0,1.0};
+	double BestCost = HUGE_VAL;
+	double A[3] = {0.0,0.0,0.0};
+	int iterations = 0;
+	solution->Tracked = 0;
+
+	double HintSun[3] = {0.0,0.0,1.0};
+	if(hint!=NULL){
+		SunVector(hint->afa,hint->beta,HintSun);
+		double s[3] = {HintSun[0],HintSun[1],HintSun[2]};
+		BestCost = Refine(solver,count,s,iterations,A);
+		for(int i=0; i<3; i++){
+			best[i] = s[i];
+		}
+	}
+
+	//residuals of the best sun vector
+	double DOPSum = 0.0;
+	double AOPSum = 0.0;
+	double WeightSum = 0.0;
+	for(bool lookup=(hint==NULL); ; lookup=true){
+		if(lookup){
+			double s[3], a[3];
+			int it = 0;
+			double cost = Lookup(solver,count,LUTCost,s,it,a);
+			if(cost<BestCost){
+				BestCost = cost;
+				iterations = it;
+				for(int i=0; i<3; i++){
+					best[i] = s[i];
+					A[i] = a[i];
+				}
+			}
+		}
+
+		DOPSum = AOPSum = WeightSum = 0.0;
+		for(int i=0; i<count; i++){
+			double DOP,Cos,Sin;
+			double Q = Predict(best,solver->Ray+3*i,solver->Sky.DOP_max,DOP,Cos,Sin);
+			DOPSum += (DOP-solver->DOP[i])*(DOP-solver->DOP[i]);
+			if(Q>0.0){
+				//half the difference of the doubled angles wraps AOP at 180 degrees
+				double dAOP = 0.5*atan2(Sin*solver->Cos[i]-Cos*solver->Sin[i],Cos*solver->Cos[i]+Sin*solver->Sin[i]);
+				double w = solver->DOP[i]>0.0 ? solver->DOP[i] : 0.0;
+				AOPSum += w*w*dAOP*dAOP;
+				WeightSum += w*w;
+			}
+		}
+		double DOPResidual = sqrt(DOPSum/count);
+		double AOPResidual = WeightSum>0.0 ? sqrt(AOPSum/WeightSum)*180.0/pi : 0.0;
+		if(lookup || LUTCost.empty() || (DOPResidual<=ATTITUDE_TRACK_DOP_RMS && AOPResidual<=ATTITUDE_TRACK_AOP_RMS)){
+			solution->Tracked = lookup ? 0 : 1;
+			solution->DOPResidual = DOPResidual;
+			solution->AOPResidual = AOPResidual;
+			break;
+		}
+	}
+	//the opposite sun vector gives the same frames: keep the one nearer to the hint, or the one with s_z>=0
+	bool flip = hint!=NULL ? best[0]*HintSun[0]+best[1]*HintSun[1]+best[2]*HintSun[2]<0.0
+		: (best[2]<0.0 || (best[2]==0.0 && best[1]<0.0));
+	if(flip){
+		for(int i=0; i<3; i++){
+			best[i] = -best[i];
+		}
+	}
+	for(int i=0; i<3; i++){
+		solution->Sun[i] = best[i];
+	}
+	solution->psa = hint!=NULL ? hint->psa : 0.0;
+	solution->afa = asin(best[1]>1.0 ? 1.0 : (best[1]<-1.0 ? -1.0 : best[1]));
+	solution->beta = atan2(-best[0],best[2]);
+	solution->AlternativeAfa = -solution->afa;
+	solution->AlternativeBeta = solution->beta>0.0 ? solution->beta-pi : solution->beta+pi;
+
+	//1-sigma uncertainty from the covariance sigma^2*(J'J)^-1 of the two tangent angles
+	double det = A[0]*A[2]-A[1]*A[1];
+	int dof = 3*count-2;
+	solution->SunError = det>0.0 && dof>0 ? sqrt(BestCost/dof*(A[0]+A[2])/det)*180.0/pi : HUGE_VAL;
+	solution->Pixels = count;
+	solution->Iterations = iterations;
+	return 0;
+}
+
+
+
+//Precompute the coarse attitude lookup for frames of the camera parameters.
+AttitudeSolver * AttitudeSolverInit(
+	const CameraParameters *	parm,  //camera parameters
+	const int     LUTSize              //number of candidate sun vectors, 0 for ATTITUDE_LUT_SIZE
+	){
+	AttitudeSolver * solver = ALLOC(AttitudeSolver);
+	if(solver==NULL){
+		return NULL;
+	}
+	solver->D_x = parm->D_x;
+	solver->D_z = parm->D_z;
+	solver->f = parm->f;
+	solver->Lens = parm->Lens;
+	solver->Sky = parm->Sky;
+	solver->Camera_n_x = parm->n_x;
+	solver->Camera_n_z = parm->n_z;
+	solver->PixelInterval = parm->PixelInterval;
+	CameraFrameSize(parm,solver->n_x,solver->n_z);
+
+	int grid_x = solver->n_x<ATTITUDE_LUT_GRID ? solver->n_x : ATTITUDE_LUT_GRID;
+	int grid_z = solver->n_z<ATTITUDE_LUT_GRID ? solver->n_z : ATTITUDE_LUT_GRID;
+	solver->LUTSize = LUTSize>0 ? LUTSize : ATTITUDE_LUT_SIZE;
+	solver->Samples = grid_x*grid_z;
+	size_t entries = (size_t)solver->LUTSize*solver->Samples;
+	solver->LUTSun = (double *)malloc((size_t)solver->LUTSize*3*sizeof(double));
+	solver->SampleIndex = (int *)malloc(solver->Samples*sizeof(int));
+	solver->LUTDOP = (float *)malloc(entries*sizeof(float));
+	solver->LUTCos = (float *)malloc(entries*sizeof(float));
+	solver->LUTSin = (float *)malloc(entries*sizeof(float));
+	solver->Capacity = 0;
+	solver->Ray = NULL;
+	solver->DOP = NULL;
+	solver->Cos = NULL;
+	solver->Sin = NULL;
+	if(solver->LUTSun==NULL || solver->SampleIndex==NULL || solver->LUTDOP==NULL || solver->LUTCos==NULL
+		|| solver->LUTSin==NULL || Reserve(solver,ATTITUDE_MAX_PIXELS)!=0){
+		AttitudeSolverFree(solver);
+		return NULL;
+	}
+
+	//sun vectors on a Fibonacci lattice of the half sphere s_z>=0, the other half gives the same frames
+	const double golden = pi*(3.0-sqrt(5.0));
+	for(int k=0; k<solver->LUTSize; k++){
+		double z = (k+0.5)/solver->LUTSize;
+		double rho = sqrt(1.0-z*z);
+		solver->LUTSun[3*k] = rho*cos(golden*k);
+		solver->LUTSun[3*k+1] = rho*sin(golden*k);
+		solver->LUTSun[3*k+2] = z;
+	}
+
+	//grid pixels at the centres of grid_x*grid_z cells of the frame
+	std::vector<double> ray(3*solver->Samples);
+	for(int a=0; a<grid_x; a++){
+		for(int b=0; b<grid_z; b++){
+			int i = (2*a+1)*solver->n_x/(2*grid_x);
+			int j = (2*b+1)*solver->n_z/(2*grid_z);
+			int m = a*grid_z+b;
+			solver->SampleIndex[m] = i*solver->n_z+j;
+			if(PixelRay(solver,1+i*solver->PixelInterval,1+j*solver->PixelInterval,&ray[3*m])!=0){
+				solver->SampleIndex[m] = -1;	//outside the image circle of the lens
+				ray[3*m] = ray[3*m+1] = ray[3*m+2] = 0.0;
+			}
+		}
+	}
+	for(int k=0; k<solver->LUTSize; k++){
+		for(int m=0; m<solver->Samples; m++){
+			double DOP,Cos,Sin;
+			Predict(solver->LUTSun+3*k,&ray[3*m],solver->Sky.DOP_max,DOP,Cos,Sin);
+			solver->LUTDOP[(size_t)k*solver->Samples+m] = (float)DOP;
+			solver->LUTCos[(size_t)k*solver->Samples+m] = (float)Cos;
+			solver->LUTSin[(size_t)k*solver->Samples+m] = (float)Sin;
+		}
+	}
+	return solver;
+}
+
+
+
+//Release a solver returned by "AttitudeSolverInit()".
+void AttitudeSolverFree(
+	AttitudeSolver *	solver  //attitude solver
+	){
+	if(solver==NULL){
+		return;
+	}
+	free(solver->LUTSun);
+	free(solver->SampleIndex);
+	free(solver->LUTDOP);
+	free(solver->LUTCos);
+	free(solver->LUTSin);
+	free(solver->Ray);
+	free(solver->DOP);
+	free(solver->Cos);
+	free(solver->Sin);
+	free(solver);
+}
+
+
+
+//Recover the attitude from a DOP and AOP frame.
+int AttitudeSolveFrame(
+	AttitudeSolver *	solver,         //attitude solver of the camera parameters of the frame
+	const CameraFrame *	frame,          //measured DOP and AOP frame
+	const CameraAttitude *	hint,       //attitude of the previous frame, NULL if unknown
+	AttitudeSolution *	solution        //recovered attitude and residuals
+	){
+	if(frame->n_x!=solver->n_x || frame->n_z!=solver->n_z || frame->PixelInterval!=solver->PixelInterval){
+		return -1;
+	}
+
+	//every stride-th pixel in both directions, at most ATTITUDE_MAX_PIXELS pixels
+	int stride = 1;
+	while((size_t)((frame->n_x+stride-1)/stride)*((frame->n_z+stride-1)/stride)>ATTITUDE_MAX_PIXELS){
+		stride++;
+	}
+	int count = 0;
+	for(int i=stride/2; i<frame->n_x; i+=stride){
+		for(int j=stride/2; j<frame->n_z; j+=stride){
+			size_t index = (size_t)i*frame->n_z+j;
+			AddPixel(solver,count,1+i*frame->PixelInterval,1+j*frame->PixelInterval,frame->DOP[index],frame->AOP[index]);
+		}
+	}
+	if(count<3){
+		return -1;
+	}
+
+	//compare the grid pixels of the frame with every lookup entry
+	std::vector<double> LUTCost(solver->LUTSize,0.0);
+	std::vector<float> DOP(solver->Samples),Cos(solver->Samples),Sin(solver->Samples),w(solver->Samples);
+	for(int m=0; m<solver->Samples; m++){
+		int index = solver->SampleIndex[m];
+		double d = index>=0 ? frame->DOP[index] : 0.0;
+		double a = index>=0 ? frame->AOP[index]*pi/90.0 : 0.0;
+		bool valid = index>=0 && d==d && a==a;
+		DOP[m] = valid ? (float)d : 0.0f;
+		Cos[m] = valid ? (float)cos(a) : 0.0f;
+		Sin[m] = valid ? (float)sin(a) : 0.0f;
+		w[m] = valid ? (float)(d*d) : -1.0f;	//negative weight marks a NaN pixel
+	}
+	for(int k=0; k<solver->LUTSize; k++){
+		const float * LUTDOP = solver->LUTDOP+(size_t)k*solver->Samples;
+		const float * LUTCos = solver->LUTCos+(size_t)k*solver->Samples;
+		const float * LUTSin = solver->LUTSin+(size_t)k*solver->Samples;
+		float cost = 0.0f;
+		for(int m=0; m<solver->Samples; m++){
+			if(w[m]<0.0f){
+				continue;
+			}
+			float dd = LUTDOP[m]-DOP[m];
+			float dc = LUTCos[m]-Cos[m];
+			float ds = LUTSin[m]-Sin[m];
+			cost += dd*dd+w[m]*(dc*dc+ds*ds);
+		}
+		LUTCost[k] = cost;
+	}
+	return Solve(solver,count,LUTCost,hint,solution);
+}
+
+
+
+//Recover the attitude from a sparse set of pixels.
+int AttitudeSolvePixels(
+	AttitudeSolver *	solver,         //attitude solver of the camera parameters
+	const AttitudePixel *	pixel,      //measured pixels
+	const int     count,                //number of pixels
+	const CameraAttitude *	hint,       //attitude of the previous frame, NULL if unknown
+	AttitudeSolution *	solution        //recovered attitude and residuals
+	){
+	if(Reserve(solver,count)!=0){
+		return -1;
+	}
+	int used = 0;
+	for(int i=0; i<count; i++){
+		AddPixel(solver,used,pixel[i].i_x,pixel[i].j_z,pixel[i].DOP,pixel[i].AOP);
+	}
+	if(used<3){
+		return -1;
+	}
+
+	//compare up to ATTITUDE_PIXEL_SAMPLES pixels with predictions of every lookup entry
+	int step = (used+ATTITUDE_PIXEL_SAMPLES-1)/ATTITUDE_PIXEL_SAMPLES;
+	std::vector<double> LUTCost(solver->LUTSize,0.0);
+	for(int k=0; k<solver->LUTSize; k++){
+		double cost = 0.0;
+		for(int i=0; i<used; i+=step){
+			double DOP,Cos,Sin;
+			Predict(solver->LUTSun+3*k,solver->Ray+3*i,solver->Sky.DOP_max,DOP,Cos,Sin);
+			double w = solver->DOP[i]*solver->DOP[i];
+			cost += (DOP-solver->DOP[i])*(DOP-solver->DOP[i])
+				+w*((Cos-solver->Cos[i])*(Cos-solver->Cos[i])+(Sin-solver->Sin[i])*(Sin-solver->Sin[i]));
+		}
+		LUTCost[k] = cost;
+	}
+	return Solve(solver,used,LUTCost,hint,solution);
+}
@@ -0,0 +1,105 @@
+#ifndef _ATTITUDESOLVER_H_
+#define _ATTITUDESOLVER_H_
+
+#include "PolarizationCamera.h"
+#include "CameraBatch.h"
+
+#define ATTITUDE_LUT_SIZE           4096    //candidate sun vectors of the coarse lookup (half sphere, about 2.3 degrees apart)
+#define ATTITUDE_LUT_GRID           8       //the lookup is evaluated on a grid of 8x8 pixels of the frame
+#define ATTITUDE_MAX_PIXELS         1024    //pixels of a frame used by the refinement
+#define ATTITUDE_MAX_ITERATIONS     30      //Levenberg-Marquardt iterations
+#define ATTITUDE_COARSE_STARTS      3       //best distinct lookup entries refined (at least 10 degrees apart)
+#define ATTITUDE_TRACK_DOP_RMS      0.02    //a refinement from the hint is accepted below this DOP residual
+#define ATTITUDE_TRACK_AOP_RMS      2.0     //and below this AOP residual (unit is degree)
+#define ATTITUDE_SPIN_STEPS         36      //yaw angles tried about the sun vector in skies that are not symmetric about it
+
+//a measured pixel
+typedef struct AttitudePixel
+{
+	int     i_x;            //column coordinate in pixel coordinate system
+	int     j_z;            //raw coordinate in pixel coordinate system
+	double  DOP;            //DOP (degree of polarization)
+	double  AOP;            //AOP (unit is degree)
+}
+AttitudePixel;
+
+//attitude recovered from DOP and AOP
+typedef struct AttitudeSolution
+{
+	double  psa;            //yaw angle (unit is radian), copied from the hint in a Rayleigh sky: it is not observable
+	double  afa;            //pitch angle (unit is radian)
+	double  beta;           //roll angle (unit is radian)
+	double  AlternativeAfa; //pitch angle of the opposite sun vector, which gives the same DOP and AOP (unit is radian);
+	                        //afa itself in a SKY_MODEL_TABLE sky, which has no such symmetry
+	double  AlternativeBeta;//roll angle of the opposite sun vector (unit is radian)
+
+	double  Sun[3];         //unit sun vector in body coordinate system, the third column of C_vTb
+	double  SunError;       //1-sigma uncertainty of the sun vector estimated from the residuals (unit is degree)
+	double  DOPResidual;    //RMS DOP difference of the used pixels
+	double  AOPResidual;    //RMS AOP difference modulo 180 degrees of the used pixels (unit is degree)
+
+	int     Pixels;         //pixels used by the refinement
+	int     Iterations;     //Levenberg-Marquardt iterations
+	int     Tracked;        //1 if the refinement from the hint was accepted without the lookup
+}
+AttitudeSolution;
+
+//precomputed lookup and scratch of the attitude solver
+typedef struct AttitudeSolver
+{
+	double  D_x;            //camera geometry of the frames (see CameraParameters)
+	double  D_z;
+	double  f;
+	int     Camera_n_x;
+	int     Camera_n_z;
+	int     PixelInterval;
+	int     n_x;            //frame size (see "CameraFrameSize()")
+	int     n_z;
+	CameraLens  Lens;       //lens of the camera
+	SkyModel  Sky;          //sky model of the camera, the grid of SKY_MODEL_TABLE is owned by the caller
+
+	int     LUTSize;        //number of candidate sun vectors
+	int     Samples;        //number of grid pixels of the lookup
+	double *LUTSun;         //candidate sun vectors, LUTSun[3*k+i]
+	int *   SampleIndex;    //frame index of every grid pixel, -1 if it sees no sky through the lens
+	float * LUTDOP;         //DOP of candidate k at grid pixel j, LUTDOP[k*Samples+j]
+	float * LUTCos;         //cos(2*AOP) of candidate k at grid pixel j
+	float * LUTSin;         //sin(2*AOP) of candidate k at grid pixel j
+
+	int     Capacity;       //number of pixels the scratch holds
+	double *Ray;            //unit shooting directions of the used pixels, Ray[3*i+k]
+	double *DOP;            //measured DOP of the used pixels
+	double *Cos;            //measured cos(2*AOP) of the used pixels
+	double *Sin;            //measured sin(2*AOP) of the used pixels
+}
+AttitudeSolver;
+
+//Precompute the coarse attitude lookup for frames of the camera parameters.
+AttitudeSolver * AttitudeSolverInit(
+	const CameraParameters *	parm,  //camera parameters
+	const int     LUTSize              //number of candidate sun vectors, 0 for ATTITUDE_LUT_SIZE
+	);
+
+//Release a solver returned by "AttitudeSolverInit()".
+void AttitudeSolverFree(
+	AttitudeSolver *	solver  //attitude solver
+	);
+
+//Recover the attitude from a DOP and AOP frame.
+int AttitudeSolveFrame(
+	AttitudeSolver *	solver,         //attitude solver of the camera parameters of the frame
+	const CameraFrame *	frame,          //measured DOP and AOP frame
+	const CameraAttitude *	hint,       //attitude of the previous frame, NULL if unknown
+	AttitudeSolution *	solution        //recovered attitude and residuals
+	);
+
+//Recover the attitude from a sparse set of pixels.
+int AttitudeSolvePixels(
+	AttitudeSolver *	solver,         //attitude solver of the camera parameters
+	const AttitudePixel *	pixel,      //measured pixels
+	const int     count,                //number of pixels
+	const CameraAttitude *	hint,       //attitude of the previous frame, NULL if unknown
+	AttitudeSolution *	solution        //recovered attitude and residuals
+	);
+
+#endif
@@ -0,0 +1,520 @@
+/*
+C interface of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for calling the simulation from C, Python (ctypes) and other languages through a shared library with a stable C interface.
+And this code is written in C++11.
+
+Usage information:
+Create a camera with "HpcCameraCreate()", simulate with "HpcCameraSimulate()" and read the planes of "HpcCameraPlane()" in the layout of "HpcCameraLayout()".
+--------------------------
+
+C interface:
+	The C++ interface passes references, overloads and templates, which neither a C compiler nor ctypes can call.
+	CameraAPI.h wraps the simulation of a camera into plain C functions with the prefix "Hpc" and an opaque HpcCamera
+	handle that owns the camera parameters, the frame and the thread pool, so "HpcCameraDestroy()" releases everything
+	"CameraParametersInit()" and "CameraFrameInit()" allocated. No C++ exception leaves the library; the functions
+	return 0 or -1, or NULL. Build it as a shared library with the CMakeLists.txt of the repository (libhpcamera.so,
+	hpcamera.dll with HPC_BUILD_SHARED) and call it from Python with Python/hpcamera.py.
+
+Zero-copy frames:
+	"HpcCameraLayout()" describes the planes like the buffer protocol and NumPy do: shape Rows x Cols (n_x x n_z),
+	the value type and the byte strides. "HpcCameraSimulate()" simulates into the frame of the camera, whose planes
+	"HpcCameraPlane()" returns; a consumer wraps them without copying and reads them until the next simulation.
+	"HpcCameraSimulateInto()" writes into buffers of the caller instead, e.g. rows of a preallocated NumPy stack, with
+	any row stride. Both split the frame into row bands over the thread pool of the camera and give the same values
+	as "CameraSimulationFrameParallel()".
+
+
+Function 1: "HpcApiVersion()" 
+
+    //Version of the interface of the library.
+	int HpcApiVersion(void);
+	-------------output----------------
+	int                         //HPC_API_VERSION of the build of the library
+	-----------------------------------
+
+
+Function 2: "HpcCameraCreate()" 
+
+    //Create a camera.
+	HpcCamera * HpcCameraCreate(
+		double   D_x,
+		double   D_z,
+		int      n_x,
+		int      n_z,
+		double   f,
+		int      PixelInterval,
+		int      DType,
+		int      Threads
+	);
+	--------------input----------------
+	double   D_x,               //Unit cell size of CCD or COMS (unit is micrometer)
+	double   D_z,               //Unit cell size of CCD or COMS (unit is micrometer)
+	int      n_x,               //Image pixel size (unit is pixel)
+	int      n_z,               //Image pixel size (unit is pixel)
+	double   f,                 //Focus of the camera (unit is millimeter)
+	int      PixelInterval,     //Pixel interval of the simulation (unit is pixel)
+	int      DType,             //HPC_DTYPE_FLOAT64 or HPC_DTYPE_FLOAT32
+	int      Threads            //threads of the simulation, 1 for the calling thread only, 0 for every hardware thread
+	-----------------------------------
+	-------------output----------------
+	HpcCamera *                 //pinhole camera with the Rayleigh sky and RAYLEIGH_KERNEL_AUTO,
+	                            //NULL if the arguments are invalid or memory or threads run out
+	-----------------------------------
+
+
+Function 3: "HpcCameraDestroy()" 
+
+    //Destroy a camera and its frame.
+	void HpcCameraDestroy(
+		HpcCamera *	camera
+	);
+	--------------input----------------
+	HpcCamera *	camera          //camera, may be NULL
+	-----------------------------------
+
+
+Function 4: "HpcCameraSetKernel()", "HpcCameraSetLens()" and "HpcCameraSetSky()" 
+
+    //Select the kernel type, the lens and the sky polarization model of the camera.
+	int HpcCameraSetKernel(HpcCamera * camera, int Kernel);
+	int HpcCameraSetLens(HpcCamera * camera, int Projection, double FieldOfView,
+		double k1, double k2, double k3, double p1, double p2);
+	int HpcCameraSetSky(HpcCamera * camera, int Model, double DOP_max, double NeutralPoint);
+	--------------input----------------
+	the fields of CameraParameters::Kernel, CameraLens and SkyModel (SKY_MODEL_TABLE needs a caller-owned table and is
+	not available through the C interface)
+	-----------------------------------
+	-------------output----------------
+	int                         //0, or -1 if a value is out of range or the ray table cannot be rebuilt
+	-----------------------------------
+
+
+Function 5: "HpcCameraLayout()" 
+
+    //Layout of the planes of the camera.
+	int HpcCameraLayout(
+		const HpcCamera *	camera,
+		HpcFrameLayout *	layout
+	);
+	--------------input----------------
+	const HpcCamera *	camera  //camera
+	-----------------------------------
+	-------------output----------------
+	HpcFrameLayout *	layout  //Rows, Cols, DType, ItemSize and the strides of the planes of "HpcCameraPlane()"
+	int                         //0, or -1 for a NULL argument
+	-----------------------------------
+
+
+Function 6: "HpcCameraSimulate()" 
+
+    //Simulate the frame of the camera.
+	int HpcCameraSimulate(
+		HpcCamera *	camera,
+		double   psa,
+		double   afa,
+		double   beta
+	);
+	--------------input----------------
+	HpcCamera *	camera,         //camera
+	double   psa,               //yaw angle (unit is radian)
+	double   afa,               //pitch angle (unit is radian)
+	double   beta               //roll angle (unit is radian)
+	-----------------------------------
+	-------------output----------------
+	int                         //0, or -1 for a NULL camera
+	-----------------------------------
+
+
+Function 7: "HpcCameraPlane()" 
+
+    //Plane of the frame of the camera.
+	const void * HpcCameraPlane(
+		const HpcCamera *	camera,
+		int      Plane
+	);
+	--------------input----------------
+	const HpcCamera *	camera, //camera
+	int      Plane              //HPC_PLANE_DOP or HPC_PLANE_AOP
+	-----------------------------------
+	-------------output----------------
+	const void *                //first value of the plane in the layout of "HpcCameraLayout()", valid until the camera
+	                            //is destroyed and overwritten by "HpcCameraSimulate()"; NULL for invalid arguments
+	-----------------------------------
+
+
+Function 8: "HpcCameraSimulateInto()" 
+
+    //Simulate a frame into caller buffers of the type of the camera.
+	int HpcCameraSimulateInto(
+		HpcCamera *	camera,
+		double   psa,
+		double   afa,
+		double   beta,
+		void *	DOP,
+		void *	AOP,
+		int64_t  RowStride
+	);
+	--------------input----------------
+	HpcCamera *	camera,         //camera
+	double   psa,               //yaw angle (unit is radian)
+	double   afa,               //pitch angle (unit is radian)
+	double   beta,              //roll angle (unit is radian)
+	int64_t  RowStride          //bytes from a row of DOP and AOP to the next, a multiple of ItemSize, at least Cols*ItemSize
+	-----------------------------------
+	-------------output----------------
+	void *	DOP,                //Rows rows of DOP, aligned to ItemSize
+	void *	AOP,                //Rows rows of AOP (unit is degree)
+	int                         //0, or -1 if the arguments are invalid
+	-----------------------------------
+
+Example:
+
+	HpcCamera * camera = HpcCameraCreate(5.2,5.2,1024,1280,4.0,1,HPC_DTYPE_FLOAT32,0);
+	HpcFrameLayout layout;
+	HpcCameraLayout(camera,&layout);
+	HpcCameraSimulate(camera,78.9*pi/180.0,-65.2*pi/180.0,278.3*pi/180.0);
+	const float * DOP = (const float *)HpcCameraPlane(camera,HPC_PLANE_DOP);	//DOP[i*layout.Cols+j]
+	HpcCameraDestroy(camera);
+
+	# Python, see Python/hpcamera.py
+	with hpcamera.Camera(dtype="float32") as camera:
+		DOP, AOP = camera.simulate(psa, afa, beta)	# NumPy arrays over the frame of the camera, no copy
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <stdlib.h>
+#include <new>
+#include "CameraAPI.h"
+#include "PolarizationCamera.h"
+#include "RayleighKernel.h"
+#include "ThreadPool.h"
+
+
+typedef char HpcFrameLayoutSizeCheck[sizeof(HpcFrameLayout)==64 ? 1 : -1];
+
+//camera behind the opaque handle
+struct HpcCamera
+{
+	CameraParameters *	parm;       //camera parameters
+	ThreadPool *	pool;           //thread pool, NULL for the calling thread only
+	int       DType;                //HPC_DTYPE_FLOAT64 or HPC_DTYPE_FLOAT32
+	CameraFrame *	frame;          //frame of HPC_DTYPE_FLOAT64, NULL otherwise
+	CameraFrameFloat *	FrameFloat; //frame of HPC_DTYPE_FLOAT32, NULL otherwise
+};
+
+
+
+//Version of the interface of the library, HPC_API_VERSION of its build.
+int HpcApiVersion(void){
+	return HPC_API_VERSION;
+}
+
+
+
+//Create a camera, NULL if the arguments are invalid or memory runs out.
+HpcCamera * HpcCameraCreate(
+	double   D_x,               //Unit cell size of CCD or COMS (unit is micrometer)
+	double   D_z,               //Unit cell size of CCD or COMS (unit is micrometer)
+	int      n_x,               //Image pixel size (unit is pixel)
+	int      n_z,               //Image pixel size (unit is pixel)
+	double   f,                 //Focus of the camera (unit is millimeter)
+	int      PixelInterval,     //Pixel interval of the simulation (unit is pixel)
+	int      DType,             //HPC_DTYPE_FLOAT64 or HPC_DTYPE_FLOAT32
+	int      Threads            //threads of the simulation, 1 for the calling thread only, 0 for every hardware thread
+	){
+	if(!(D_x>0.0) || !(D_z>0.0) || !(f>0.0) || n_x<1 || n_z<1 || PixelInterval<1 || Threads<0
+		|| (DType!=HPC_DTYPE_FLOAT64 && DType!=HPC_DTYPE_FLOAT32)){
+		return NULL;
+	}
+	HpcCamera * camera = (HpcCamera *)calloc(1,sizeof(HpcCamera));
+	if(camera==NULL){
+		return NULL;
+	}
+	camera->DType = DType;
+	camera->parm = CameraParametersInit(D_x,D_z,n_x,n_z,f,PixelInterval);
+	if(camera->parm!=NULL){
+		if(DType==HPC_DTYPE_FLOAT64){
+			camera->frame = CameraFrameInit(camera->parm);
+		}
+		else{
+			camera->FrameFloat = CameraFrameFloatInit(camera->parm);
+		}
+	}
+	if(camera->frame==NULL && camera->FrameFloat==NULL){
+		HpcCameraDestroy(camera);
+		return NULL;
+	}
+	if(Threads!=1){
+		//exceptions must not cross the C interface
+		try{
+			camera->pool = new ThreadPool(Threads);
+		}
+		catch(...){
+			HpcCameraDestroy(camera);
+			return NULL;
+		}
+	}
+	return camera;
+}
+
+
+
+//Destroy a camera and its frame.
+void HpcCameraDestroy(
+	HpcCamera *	camera          //camera, may be NULL
+	){
+	if(camera==NULL){
+		return;
+	}
+	delete camera->pool;
+	CameraFrameFree(camera->frame);
+	CameraFrameFree(camera->FrameFloat);
+	CameraParametersFree(camera->parm);
+	free(camera);
+}
+
+
+
+//Select the kernel type of the camera.
+int HpcCameraSetKernel(
+	HpcCamera *	camera,         //camera
+	int      Kernel             //RAYLEIGH_KERNEL_AUTO (0) to RAYLEIGH_KERNEL_CLOSED_FORM (5), see RayleighKernel.h
+	){
+	if(camera==NULL || Kernel<RAYLEIGH_KERNEL_AUTO || Kernel>RAYLEIGH_KERNEL_CLOSED_FORM){
+		return -1;
+	}
+	camera->parm->Kernel = Kernel;
+	return 0;
+}
+
+
+
+//Set the lens of the camera.
+int HpcCameraSetLens(
+	HpcCamera *	camera,         //camera
+	int      Projection,        //CAMERA_PROJECTION_PINHOLE (0) to CAMERA_PROJECTION_STEREOGRAPHIC (3), see CameraLens.h
+	double   FieldOfView,       //full field of view (unit is degree), 0 for no limit
+	double   k1,                //radial distortion coefficients
+	double   k2,
+	double   k3,
+	double   p1,                //tangential distortion coefficients
+	double   p2
+	){
+	if(camera==NULL || Projection<CAMERA_PROJECTION_PINHOLE || Projection>CAMERA_PROJECTION_STEREOGRAPHIC
+		|| !(FieldOfView>=0.0)){
+		return -1;
+	}
+	CameraLens lens;
+	CameraLensDefault(&lens);
+	lens.Projection = Projection;
+	lens.FieldOfView = FieldOfView;
+	lens.k1 = k1;
+	lens.k2 = k2;
+	lens.k3 = k3;
+	lens.p1 = p1;
+	lens.p2 = p2;
+	return CameraParametersSetLens(camera->parm,&lens)==0 ? 0 : -1;
+}
+
+
+
+//Set the sky polarization model of the camera.
+int HpcCameraSetSky(
+	HpcCamera *	camera,         //camera
+	int      Model,             //SKY_MODEL_RAYLEIGH (0) or SKY_MODEL_BERRY (1), see SkyModel.h
+	double   DOP_max,           //maximum DOP in the sky
+	double   NeutralPoint       //angle of the neutral points from the sun and the anti-sun (unit is degree, SKY_MODEL_BERRY)
+	){
+	if(camera==NULL || !(DOP_max>=0.0 && DOP_max<=1.0)){
+		return -1;
+	}
+	if(Model==SKY_MODEL_RAYLEIGH){
+		SkyModelRayleigh(&camera->parm->Sky,DOP_max);
+	}
+	else if(Model==SKY_MODEL_BERRY && NeutralPoint>=0.0 && NeutralPoint<90.0){
+		SkyModelBerry(&camera->parm->Sky,DOP_max,NeutralPoint);
+	}
+	else{
+		return -1;
+	}
+	return 0;
+}
+
+
+
+//Layout of the planes of the camera.
+int HpcCameraLayout(
+	const HpcCamera *	camera, //camera
+	HpcFrameLayout *	layout  //shape, type and strides
+	){
+	if(camera==NULL || layout==NULL){
+		return -1;
+	}
+	int n_x, n_z;
+	CameraFrameSize(camera->parm,n_x,n_z);
+	layout->Rows = n_x;
+	layout->Cols = n_z;
+	layout->DType = camera->DType;
+	layout->ItemSize = camera->DType==HPC_DTYPE_FLOAT64 ? (int32_t)sizeof(double) : (int32_t)sizeof(float);
+	layout->ColStride = layout->ItemSize;
+	layout->RowStride = (int64_t)n_z*layout->ItemSize;
+	layout->PixelInterval = camera->parm->PixelInterval;
+	layout->Padding = 0;
+	layout->Reserved[0] = 0;
+	layout->Reserved[1] = 0;
+	layout->Reserved[2] = 0;
+	return 0;
+}
+
+
+
+//Simulate the frame of the camera.
+int HpcCameraSimulate(
+	HpcCamera *	camera,         //camera
+	double   psa,               //yaw angle (unit is radian)
+	double   afa,               //pitch angle (unit is radian)
+	double   beta               //roll angle (unit is radian)
+	){
+	if(camera==NULL){
+		return -1;
+	}
+	double C_vTb[3][3];//rotation matrix from solar vector to body coordinate system
+	double C_bTv[3][3];//rotation matrix from body to solar vector coordinate system
+	CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+	if(camera->DType==HPC_DTYPE_FLOAT64){
+		CameraSimulationFrameRotation(C_vTb,C_bTv,camera->parm,camera->frame,camera->pool);
+	}
+	else{
+		CameraSimulationFrameRotation(C_vTb,C_bTv,camera->parm,camera->FrameFloat,camera->pool);
+	}
+	return 0;
+}
+
+
+
+//Plane of the frame of the camera, valid until the camera is destroyed.
+const void * HpcCameraPlane(
+	const HpcCamera *	camera, //camera
+	int      Plane              //HPC_PLANE_DOP or HPC_PLANE_AOP
+	){
+	if(camera==NULL || (Plane!=HPC_PLANE_DOP && Plane!=HPC_PLANE_AOP)){
+		return NULL;
+	}
+	if(camera->DType==HPC_DTYPE_FLOAT64){
+		return Plane==HPC_PLANE_DOP ? (const void *)camera->frame->DOP : (const void *)camera->frame->AOP;
+	}
+	return Plane==HPC_PLANE_DOP ? (const void *)camera->FrameFloat->DOP : (const void *)camera->FrameFloat->AOP;
+}
+
+
+
+//Simulate the frame into caller planes of rows pitch values apart, in row bands over the thread pool.
+template <class S>
+static void SimulateBlocks(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const HpcCamera *	camera,        //camera
+	S *	DOP,                           //DOP plane
+	S *	AOP,                           //AOP plane (unit is degree)
+	const size_t  pitch                //values from a row to the next
+	){
+	int n_x, n_z;
+	CameraFrameSize(camera->parm,n_x,n_z);
+	auto task = [&](int begin, int end){
+		CameraBlock block;
+		block.i = begin;
+		block.j = 0;
+		block.n_x = end-begin;
+		block.n_z = n_z;
+		CameraSimulationBlock(C_vTb,C_bTv,camera->parm,&block,DOP+(size_t)begin*pitch,AOP+(size_t)begin*pitch,pitch);
+	};
+	if(camera->pool==NULL){
+		task(0,n_x);
+	}
+	else{
+		int rows = n_x/(8*camera->pool->Size());     //the bands of "CameraSimulationFrameParallel()"
+		camera->pool->ParallelFor(n_x,rows>0 ? rows : 1,task);
+	}
+}
+
+
+
+//Simulate a frame into caller buffers of the type of the camera.
+int HpcCameraSimulateInto(
+	HpcCamera *	camera,         //camera
+	double   psa,               //yaw angle (unit is radian)
+	double   afa,               //pitch angle (unit is radian)
+	double   beta,              //roll angle (unit is radian)
+	void *	DOP,                //Rows rows of DOP
+	void *	AOP,                //Rows rows of AOP (unit is degree)
+	int64_t  RowStride          //bytes from a row of DOP and AOP to the next, a multiple of ItemSize, at least Cols*ItemSize
+	){
+	HpcFrameLayout layout;
+	if(HpcCameraLayout(camera,&layout)!=0 || DOP==NULL || AOP==NULL
+		|| RowStride<layout.RowStride || RowStride%layout.ItemSize!=0
+		|| (uintptr_t)DOP%layout.ItemSize!=0 || (uintptr_t)AOP%layout.ItemSize!=0){
+		return -1;
+	}
+	double C_vTb[3][3];//rotation matrix from solar vector to body coordinate system
+	double C_bTv[3][3];//rotation matrix from body to solar vector coordinate system
+	CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+	size_t pitch = (size_t)(RowStride/layout.ItemSize);
+	if(camera->DType==HPC_DTYPE_FLOAT64){
+		SimulateBlocks(C_vTb,C_bTv,camera,(double *)DOP,(double *)AOP,pitch);
+	}
+	else{
+		SimulateBlocks(C_vTb,C_bTv,camera,(float *)DOP,(float *)AOP,pitch);
+	}
+	return 0;
+}
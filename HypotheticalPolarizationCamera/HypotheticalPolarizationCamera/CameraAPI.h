@@ -0,0 +1,134 @@
+#ifndef _CAMERAAPI_H_
+#define _CAMERAAPI_H_
+
+//C interface of the hypothetical polarization camera for shared libraries and foreign function interfaces.
+//Only C types cross it; a camera is an opaque handle. This header is also valid C.
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(HPC_BUILD_SHARED)
+#define HPC_API __declspec(dllexport)
+#elif defined(HPC_USE_SHARED)
+#define HPC_API __declspec(dllimport)
+#else
+#define HPC_API
+#endif
+#elif defined(__GNUC__)
+#define HPC_API __attribute__((visibility("default")))
+#else
+#define HPC_API
+#endif
+
+#define HPC_API_VERSION             1       //increased when a function or HpcFrameLayout changes
+
+#define HPC_DTYPE_FLOAT64           0       //planes of double (FRAME_SCALAR_DOUBLE)
+#define HPC_DTYPE_FLOAT32           1       //planes of float (FRAME_SCALAR_FLOAT)
+
+#define HPC_PLANE_DOP               0       //DOP plane
+#define HPC_PLANE_AOP               1       //AOP plane (unit is degree)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//camera with its frame and thread pool
+typedef struct HpcCamera HpcCamera;
+
+//layout of the DOP and AOP planes of a camera (64 bytes)
+typedef struct HpcFrameLayout
+{
+	int32_t  Rows;              //Number of simulated pixels along i_x, the first index of a plane
+	int32_t  Cols;              //Number of simulated pixels along j_z, the second index of a plane
+	int32_t  DType;             //HPC_DTYPE_FLOAT64 or HPC_DTYPE_FLOAT32
+	int32_t  ItemSize;          //bytes of a value
+	int64_t  RowStride;         //bytes from a row of the frame of the camera to the next
+	int64_t  ColStride;         //bytes from a column to the next
+	int32_t  PixelInterval;     //Pixel interval of the simulation (unit is pixel)
+	int32_t  Padding;
+	int64_t  Reserved[3];
+}
+HpcFrameLayout;
+
+//Version of the interface of the library, HPC_API_VERSION of its build.
+HPC_API int HpcApiVersion(void);
+
+//Create a camera, NULL if the arguments are invalid or memory runs out.
+HPC_API HpcCamera * HpcCameraCreate(
+	double   D_x,               //Unit cell size of CCD or COMS (unit is micrometer)
+	double   D_z,               //Unit cell size of CCD or COMS (unit is micrometer)
+	int      n_x,               //Image pixel size (unit is pixel)
+	int      n_z,               //Image pixel size (unit is pixel)
+	double   f,                 //Focus of the camera (unit is millimeter)
+	int      PixelInterval,     //Pixel interval of the simulation (unit is pixel)
+	int      DType,             //HPC_DTYPE_FLOAT64 or HPC_DTYPE_FLOAT32
+	int      Threads            //threads of the simulation, 1 for the calling thread only, 0 for every hardware thread
+	);
+
+//Destroy a camera and its frame.
+HPC_API void HpcCameraDestroy(
+	HpcCamera *	camera          //camera, may be NULL
+	);
+
+//Select the kernel type of the camera.
+HPC_API int HpcCameraSetKernel(
+	HpcCamera *	camera,         //camera
+	int      Kernel             //RAYLEIGH_KERNEL_AUTO (0) to RAYLEIGH_KERNEL_CLOSED_FORM (5), see RayleighKernel.h
+	);
+
+//Set the lens of the camera.
+HPC_API int HpcCameraSetLens(
+	HpcCamera *	camera,         //camera
+	int      Projection,        //CAMERA_PROJECTION_PINHOLE (0) to CAMERA_PROJECTION_STEREOGRAPHIC (3), see CameraLens.h
+	double   FieldOfView,       //full field of view (unit is degree), 0 for no limit
+	double   k1,                //radial distortion coefficients
+	double   k2,
+	double   k3,
+	double   p1,                //tangential distortion coefficients
+	double   p2
+	);
+
+//Set the sky polarization model of the camera.
+HPC_API int HpcCameraSetSky(
+	HpcCamera *	camera,         //camera
+	int      Model,             //SKY_MODEL_RAYLEIGH (0) or SKY_MODEL_BERRY (1), see SkyModel.h
+	double   DOP_max,           //maximum DOP in the sky
+	double   NeutralPoint       //angle of the neutral points from the sun and the anti-sun (unit is degree, SKY_MODEL_BERRY)
+	);
+
+//Layout of the planes of the camera.
+HPC_API int HpcCameraLayout(
+	const HpcCamera *	camera, //camera
+	HpcFrameLayout *	layout  //shape, type and strides
+	);
+
+//Simulate the frame of the camera.
+HPC_API int HpcCameraSimulate(
+	HpcCamera *	camera,         //camera
+	double   psa,               //yaw angle (unit is radian)
+	double   afa,               //pitch angle (unit is radian)
+	double   beta               //roll angle (unit is radian)
+	);
+
+//Plane of the frame of the camera, valid until the camera is destroyed.
+HPC_API const void * HpcCameraPlane(
+	const HpcCamera *	camera, //camera
+	int      Plane              //HPC_PLANE_DOP or HPC_PLANE_AOP
+	);
+
+//Simulate a frame into caller buffers of the type of the camera.
+HPC_API int HpcCameraSimulateInto(
+	HpcCamera *	camera,         //camera
+	double   psa,               //yaw angle (unit is radian)
+	double   afa,               //pitch angle (unit is radian)
+	double   beta,              //roll angle (unit is radian)
+	void *	DOP,                //Rows rows of DOP
+	void *	AOP,                //Rows rows of AOP (unit is degree)
+	int64_t  RowStride          //bytes from a row of DOP and AOP to the next, a multiple of ItemSize, at least Cols*ItemSize
+	);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,255 @@
+/*
+Batch simulation functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for simulating a sequence of camera attitudes.
+And this code is written in C++11.
+
+Usage information:
+Using the code to simulate sweeps of attitudes (a flight path or a grid) with one call instead of one "CameraSimulation()" per attitude.
+--------------------------
+
+Batch processing:
+	The rotation matrices of all attitudes of a group are built once, the frames and the ray table of the camera
+	are reused for the whole batch, and the frames are handed to the sink one by one in the order of the attitudes.
+	Small frames are simulated several at once (one frame per thread), large frames are split into row bands.
+	Frame N is complete and delivered before frame N+1; the binary sink writes one header per frame and the text
+	sink writes the frames one after another in the format of HypotheticalImages.txt, each after a line
+	"# frame N psa afa beta" with the index and the attitude of the frame (unit is radian). "output/ImageDarwing.m"
+	skips these lines and draws the first frame; the single frame of "CameraSimulation()" has no such line.
+
+
+Function 1: "CameraSimulationBatch()" 
+
+    //Hypothetical polarization camera simulation of a sequence of attitudes, streaming the frames in order to a sink.
+	int CameraSimulationBatch(
+		const CameraAttitude *	attitude,
+		const int     count,
+		CameraParameters *	parm,
+		ThreadPool *	pool,
+		CameraFrameSink	sink,
+		void *	context
+	);
+	--------------input----------------
+	const CameraAttitude *	attitude,  //attitudes of the frames (unit is radian)
+	const int     count,               //number of attitudes
+	CameraParameters *	parm,          //camera parameters (psa, afa and beta are set to the attitude of each frame)
+	ThreadPool *	pool,              //thread pool, NULL runs on the calling thread
+	CameraFrameSink	sink,              //called once per frame in the order of the attitudes
+	void *	context                    //passed to the sink
+	-----------------------------------
+	-------------output----------------
+	int                                //0 on success, -1 if the frames cannot be allocated, or the nonzero value of the sink
+	-----------------------------------
+
+
+Function 2: "CameraFrameSinkBinary()" 
+
+    //Sink appending every frame of a batch to a binary frame file.
+	int CameraFrameSinkBinary(
+		void *	context,
+		const int     FrameIndex,
+		const CameraFrame *	frame,
+		const CameraParameters *	parm
+	);
+	--------------input----------------
+	void *	context                    //FrameWriter * of "FrameWriterOpen()"
+	-----------------------------------
+	-------------output----------------
+	int                                //0 on success, -1 if writing failed
+	-----------------------------------
+
+
+Function 3: "CameraFrameSinkText()" 
+
+    //Sink appending every frame of a batch to a text file in the format of HypotheticalImages.txt.
+	int CameraFrameSinkText(
+		void *	context,
+		const int     FrameIndex,
+		const CameraFrame *	frame,
+		const CameraParameters *	parm
+	);
+	--------------input----------------
+	void *	context                    //opened FILE *
+	const int     FrameIndex,          //index of the attitude of the frame
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	-----------------------------------
+	-------------output----------------
+	int                                //0 on success, -1 if writing failed
+	-----------------------------------
+	Every frame starts with the line "# frame FrameIndex psa afa beta" (unit is radian), so that the frames of a
+	batch can be told apart.
+
+Example:
+
+	CameraAttitude attitude[3] = {{0.1,-0.2,0.3},{0.1,-0.2,0.4},{0.1,-0.2,0.5}};
+	FrameWriter * writer = FrameWriterOpen("output/sweep.hpcf",FRAME_SCALAR_DOUBLE);
+	ThreadPool pool(0);
+	CameraSimulationBatch(attitude,3,Camera_paremeters,&pool,CameraFrameSinkBinary,writer);
+	FrameWriterClose(writer);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include"CameraBatch.h"
+#include"FrameIO.h"
+#include"ThreadPool.h"
+
+//Frames with fewer simulated pixels are simulated one frame per thread (unit is pixel)
+#define BATCH_SMALL_FRAME           (1<<16)
+//Number of small frames simulated at once per thread of the pool
+#define BATCH_FRAMES_PER_THREAD     2
+
+//rotation matrices of one attitude
+typedef struct BatchRotation
+{
+	double  C_vTb[3][3];    //rotation matrix from solar vector to body coordinate system
+	double  C_bTv[3][3];    //rotation matrix from body to solar vector coordinate system
+}
+BatchRotation;
+
+
+
+//Hypothetical polarization camera simulation of a sequence of attitudes, streaming the frames in order to a sink.
+int CameraSimulationBatch(
+	const CameraAttitude *	attitude,  //attitudes of the frames
+	const int     count,               //number of attitudes
+	CameraParameters *	parm,          //camera parameters
+	ThreadPool *	pool,              //thread pool, NULL runs on the calling thread
+	CameraFrameSink	sink,              //called once per frame in the order of the attitudes
+	void *	context                    //passed to the sink
+	){
+	int n_x, n_z;
+	CameraFrameSize(parm,n_x,n_z);
+
+	//Small frames are simulated a group at a time, large frames one at a time over row bands.
+	bool small = pool!=NULL && pool->Size()>1 && (size_t)n_x*n_z<BATCH_SMALL_FRAME;
+	int group = small ? pool->Size()*BATCH_FRAMES_PER_THREAD : 1;
+	if(group>count){
+		group = count>0 ? count : 1;
+	}
+
+	std::vector<CameraFrame *> frame(group,(CameraFrame *)NULL);
+	std::vector<BatchRotation> rotation(group);	//rotation matrices of the group
+	int status = 0;
+	for(int k=0; k<group; k++){
+		frame[k] = CameraFrameInit(parm);
+		if(frame[k]==NULL){
+			status = -1;
+		}
+	}
+
+	const CameraParameters * camera = parm;
+	for(int first=0; first<count && status==0; first+=group){
+		int frames = count-first<group ? count-first : group;
+		for(int k=0; k<frames; k++){
+			const CameraAttitude * a = attitude+first+k;
+			CameraRotationMatrix(a->psa,a->afa,a->beta,rotation[k].C_vTb,rotation[k].C_bTv);
+		}
+
+		if(small){
+			pool->ParallelFor(frames,1,[&](int begin, int end){
+				for(int k=begin; k<end; k++){
+					CameraSimulationFrameRotation(rotation[k].C_vTb,rotation[k].C_bTv,camera,frame[k],NULL);
+				}
+			});
+		}
+		else{
+			CameraSimulationFrameRotation(rotation[0].C_vTb,rotation[0].C_bTv,camera,frame[0],pool);
+		}
+
+		//Deliver the frames in the order of the attitudes.
+		for(int k=0; k<frames && status==0; k++){
+			parm->psa = attitude[first+k].psa;
+			parm->afa = attitude[first+k].afa;
+			parm->beta = attitude[first+k].beta;
+			status = sink(context,first+k,frame[k],parm);
+		}
+	}
+
+	for(int k=0; k<group; k++){
+		CameraFrameFree(frame[k]);
+	}
+	return status;
+}
+
+
+
+//Sink appending every frame of a batch to a binary frame file.
+int CameraFrameSinkBinary(
+	void *	context,                   //FrameWriter *
+	const int     FrameIndex,          //index of the attitude of the frame
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	){
+	(void)FrameIndex;
+	return FrameWriterWrite((FrameWriter *)context,frame,parm);
+}
+
+
+
+//Sink appending every frame of a batch to a text file in the format of HypotheticalImages.txt, after a frame line.
+int CameraFrameSinkText(
+	void *	context,                   //FILE *
+	const int     FrameIndex,          //index of the attitude of the frame
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	){
+	FILE * file = (FILE *)context;
+	if(fprintf(file,"# frame %d psa %.17g afa %.17g beta %.17g\n",FrameIndex,parm->psa,parm->afa,parm->beta)<0){
+		return -1;
+	}
+	return CameraFrameWriteText(frame,file);
+}
@@ -0,0 +1,51 @@
+#ifndef _CAMERABATCH_H_
+#define _CAMERABATCH_H_
+
+#include "PolarizationCamera.h"
+
+//three Euler angles of camera (from body to solar vector coordinate system)
+typedef struct CameraAttitude
+{
+	double  psa;            //yaw angle (unit is radian)
+	double  afa;            //pitch angle (unit is radian)
+	double  beta;           //roll angle (unit is radian)
+}
+CameraAttitude;
+
+//Receive the frame FrameIndex of a batch. parm->psa, parm->afa and parm->beta hold the attitude of the frame.
+//The frame is reused after the sink returns. A nonzero return value stops the batch.
+typedef int (*CameraFrameSink)(
+	void *	context,                   //context given to "CameraSimulationBatch()"
+	const int     FrameIndex,          //index of the attitude of the frame
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	);
+
+//Hypothetical polarization camera simulation of a sequence of attitudes, streaming the frames in order to a sink.
+int CameraSimulationBatch(
+	const CameraAttitude *	attitude,  //attitudes of the frames
+	const int     count,               //number of attitudes
+	CameraParameters *	parm,          //camera parameters
+	ThreadPool *	pool,              //thread pool, NULL runs on the calling thread
+	CameraFrameSink	sink,              //called once per frame in the order of the attitudes
+	void *	context                    //passed to the sink
+	);
+
+//Sink appending every frame of a batch to a binary frame file (context is a FrameWriter *, see "FrameIO.h").
+int CameraFrameSinkBinary(
+	void *	context,                   //FrameWriter *
+	const int     FrameIndex,          //index of the attitude of the frame
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	);
+
+//Sink appending every frame of a batch to a text file in the format of HypotheticalImages.txt (context is a FILE *),
+//each after a line "# frame FrameIndex psa afa beta" (unit is radian).
+int CameraFrameSinkText(
+	void *	context,                   //FILE *
+	const int     FrameIndex,          //index of the attitude of the frame
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	);
+
+#endif
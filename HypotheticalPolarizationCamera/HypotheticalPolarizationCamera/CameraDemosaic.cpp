@@ -0,0 +1,426 @@
+/*
+"CameraDemosaic" functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for recovering S0, S1, S2, DOP and AOP from the raw mosaic of a division-of-focal-plane polarization camera, the inverse of "CameraSimulationMosaic()".
+And this code is written in C++11.
+
+Usage information:
+Call "CameraDemosaic()" with the raw frame and the MosaicParameters of the sensor; the frame can be compared with the one of "CameraSimulationFrame()".
+--------------------------
+
+Method:
+	The frame is processed in bands of DEMOSAIC_BAND_ROWS rows. The raw values of a band minus the black level are
+	converted to float once, with 2 mirrored pixels on every side (mirroring keeps the polarizer of every pixel),
+	and every row of the band is then interpolated and reduced to Stokes components in one pass of a kernel:
+		DEMOSAIC_BILINEAR   each missing channel is the mean of its 2 (along i_x or j_z) or 4 (diagonal) nearest pixels.
+		DEMOSAIC_GRADIENT   every neighbour is weighted by 1/(e+|g|), g the difference between the pixel and the pixel
+		                    of its own channel 2 steps towards the neighbour and e=1+|pixel|/20, so that values are
+		                    not averaged across the edges of S0 (horizon, terrain); on smooth sky it is bilinear.
+	The Stokes components are the least squares fit of the four channels to Malus's law of "CameraSimulationMosaic()",
+		Raw_k-Offset = S0/2+Efficiency*(S1*cos(2*theta_k)+S2*sin(2*theta_k))/2,
+	so S0=(I0+I45+I90+I135)/2, S1=(I0-I90)/Efficiency and S2=(I45-I135)/Efficiency for the usual angles. Then
+		DOP = sqrt(S1^2+S2^2)/S0     (0 if S0<=0; noise can make it exceed 1)
+		AOP = atan(S2/(S1+sqrt(S1^2+S2^2)))  in degree, half of the angle of (S1,S2)
+	AOP has the convention of "CameraSimulation()": from the j_z axis towards i_x, between -90 and 90 degrees,
+	and 0 where DOP is 0. The kernels compute in single precision.
+
+
+Function 1: "CameraDemosaic()" 
+
+    //Recover S0, S1, S2, DOP and AOP from a raw polarizer mosaic.
+	int CameraDemosaic(
+		const uint16_t *	Raw,
+		const MosaicParameters *	mosaic,
+		const int     Method,
+		const int     type,
+		CameraFrame *	frame,
+		double *	S0,
+		double *	S1,
+		double *	S2,
+		ThreadPool *	pool
+	);
+	--------------input----------------
+	const uint16_t *	Raw,            //raw mosaic of frame->n_x*frame->n_z pixels in the layout of CameraFrame
+	const MosaicParameters *	mosaic, //sensor: Angle, Efficiency and Offset are used
+	const int     Method,               //DEMOSAIC_BILINEAR or DEMOSAIC_GRADIENT
+	const int     type,                 //kernel type of "DemosaicKernel()"
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	CameraFrame *	frame,              //DOP and AOP (unit is degree) of every pixel, frame->PixelInterval must be 1
+	double *	S0,                     //S0 of every pixel (unit is digital number), NULL if not needed
+	double *	S1,                     //S1 of every pixel, NULL if not needed
+	double *	S2,                     //S2 of every pixel, NULL if not needed
+	int                                 //0, or -1 if the frame is smaller than 4x4 pixels, has PixelInterval>1,
+	                                    //the polarizer angles do not determine S1 and S2, or memory runs out
+	-----------------------------------
+	A CameraFrameFloat overload writes float planes.
+
+
+Function 2: "DemosaicKernel()" 
+
+    //Demosaic kernel of a kernel type.
+	DemosaicRowFunction DemosaicKernel(
+		const int     type
+	);
+	--------------input----------------
+	const int     type          //RAYLEIGH_KERNEL_SSE2, RAYLEIGH_KERNEL_AVX2 or RAYLEIGH_KERNEL_AVX512 (see RayleighKernel.h),
+	                            //every other type gives the scalar kernel
+	-----------------------------------
+	-------------output----------------
+	DemosaicRowFunction         //kernel of a frame row
+	-----------------------------------
+
+
+Function 3: "DemosaicRowScalar()" 
+
+    //Interpolation, Stokes components, DOP and AOP of a frame row, one pixel at a time.
+	void DemosaicRowScalar(
+		const DemosaicRow *	row
+	);
+	--------------input----------------
+	const DemosaicRow *	row      //padded band rows, weights and outputs of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP, row->S0, row->S1, row->S2   //row->count values each
+	-----------------------------------
+	The SSE2, AVX2 and AVX512 kernels run the same code ("CameraDemosaicSimd.h") on 4, 8 and 16 pixels at a time.
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <atomic>
+#include "CameraDemosaic.h"
+#include "RayleighKernel.h"
+#include "ThreadPool.h"
+
+const static double pi = 3.141592653589793;
+
+//float elements after every padded band row, so that the widest kernel may load past the row
+#define DEMOSAIC_ROW_SLACK          16
+
+namespace {
+
+//one float as a vector of width 1, for the scalar kernel
+struct VectorScalarFloat
+{
+	typedef float S;
+	typedef float T;
+	typedef bool M;
+	enum { Width = 1 };
+
+	static T Set(double a)                 { return (float)a; }
+	static T Load(const float * p)         { return *p; }
+	static void Store(float * p, T a)      { *p = a; }
+	static T Index()                       { return 0.0f; }
+	static T Add(T a, T b)                 { return a+b; }
+	static T Sub(T a, T b)                 { return a-b; }
+	static T Mul(T a, T b)                 { return a*b; }
+	static T Div(T a, T b)                 { return a/b; }
+	static T Sqrt(T a)                     { return sqrtf(a); }
+	static T Abs(T a)                      { return fabsf(a); }
+	static T Sign(T a)                     { return a<0.0f || (a==0.0f && 1.0f/a<0.0f) ? -0.0f : 0.0f; }
+	static T Xor(T a, T b)                 { uint32_t x,y; memcpy(&x,&a,4); memcpy(&y,&b,4); x ^= y; memcpy(&a,&x,4); return a; }
+	static M CmpGT(T a, T b)               { return a>b; }
+	static M CmpEQ(T a, T b)               { return a==b; }
+	static T Select(T a, T b, M m)         { return m ? b : a; }
+};
+
+#include "RayleighKernelSimd.h"
+#include "CameraDemosaicSimd.h"
+
+}
+
+
+
+//Interpolation, Stokes components, DOP and AOP of a frame row, one pixel at a time.
+void DemosaicRowScalar(
+	const DemosaicRow *	row     //padded band rows, weights and outputs of a frame row
+	){
+	VectorDemosaic<VectorScalarFloat>(row);
+}
+
+
+
+//Demosaic kernel of a kernel type.
+DemosaicRowFunction DemosaicKernel(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	){
+	switch(RayleighKernelResolve(type)){
+#ifdef RAYLEIGH_KERNEL_X86
+	case RAYLEIGH_KERNEL_SSE2:   return DemosaicRowSSE2;
+	case RAYLEIGH_KERNEL_AVX2:   return DemosaicRowAVX2;
+	case RAYLEIGH_KERNEL_AVX512: return DemosaicRowAVX512;
+#endif
+	}
+	return DemosaicRowScalar;
+}
+
+
+
+//Least squares matrix from the four channels to S0, S1 and S2; returns -1 if the angles do not determine them.
+static int StokesMatrix(
+	const MosaicParameters *	mosaic,  //sensor
+	double  (&M)[3][4]                   //Stokes components of the channels
+	){
+	//Raw_k-Offset = A[k]*{S0,S1,S2}
+	double A[4][3];
+	for(int k=0; k<4; k++){
+		A[k][0] = 0.5;
+		A[k][1] = 0.5*mosaic->Efficiency*cos(2.0*mosaic->Angle[k]*pi/180.0);
+		A[k][2] = 0.5*mosaic->Efficiency*sin(2.0*mosaic->Angle[k]*pi/180.0);
+	}
+	double N[3][3];
+	for(int i=0; i<3; i++){
+		for(int j=0; j<3; j++){
+			N[i][j] = 0.0;
+			for(int k=0; k<4; k++){
+				N[i][j] += A[k][i]*A[k][j];
+			}
+		}
+	}
+	//inverse of the normal matrix by cofactors
+	double Inv[3][3];
+	Inv[0][0] = N[1][1]*N[2][2]-N[1][2]*N[2][1];
+	Inv[0][1] = N[0][2]*N[2][1]-N[0][1]*N[2][2];
+	Inv[0][2] = N[0][1]*N[1][2]-N[0][2]*N[1][1];
+	Inv[1][0] = N[1][2]*N[2][0]-N[1][0]*N[2][2];
+	Inv[1][1] = N[0][0]*N[2][2]-N[0][2]*N[2][0];
+	Inv[1][2] = N[0][2]*N[1][0]-N[0][0]*N[1][2];
+	Inv[2][0] = N[1][0]*N[2][1]-N[1][1]*N[2][0];
+	Inv[2][1] = N[0][1]*N[2][0]-N[0][0]*N[2][1];
+	Inv[2][2] = N[0][0]*N[1][1]-N[0][1]*N[1][0];
+	double det = N[0][0]*Inv[0][0]+N[0][1]*Inv[1][0]+N[0][2]*Inv[2][0];
+	if(!(fabs(det)>1e-12)){
+		return -1;
+	}
+	for(int i=0; i<3; i++){
+		for(int k=0; k<4; k++){
+			M[i][k] = 0.0;
+			for(int j=0; j<3; j++){
+				M[i][k] += Inv[i][j]*A[k][j]/det;
+			}
+		}
+	}
+	return 0;
+}
+
+
+
+//Row of a frame edge reflected back into the frame, keeping its parity.
+static int Mirror(
+	const int     i,    //row, -2 to n+1
+	const int     n     //number of rows
+	){
+	return i<0 ? -i : (i>=n ? 2*(n-1)-i : i);
+}
+
+
+
+//Copy float kernel output to a plane of scalar type S.
+template <class S>
+static void StoreRow(
+	const float *	row,    //kernel output
+	S *	plane,              //plane, NULL if not needed
+	const int     count     //number of values
+	){
+	if(plane!=NULL && (const void *)plane!=(const void *)row){
+		for(int j=0; j<count; j++){
+			plane[j] = (S)row[j];
+		}
+	}
+}
+
+
+
+//Kernel output of a plane row: the plane itself for float planes, the scratch otherwise.
+static float * OutputRow(float * plane, float * ) { return plane; }
+static float * OutputRow(double * plane, float * scratch) { return plane==NULL ? NULL : scratch; }
+
+
+
+//Demosaic a raw mosaic into planes of scalar type S.
+template <class S>
+static int Demosaic(
+	const uint16_t *	Raw,            //raw mosaic
+	const MosaicParameters *	mosaic, //sensor
+	const int     Method,               //DEMOSAIC_BILINEAR or DEMOSAIC_GRADIENT
+	const int     type,                 //kernel type
+	CameraFrameOf<S> *	frame,          //DOP and AOP of every pixel
+	S *	S0,                             //S0 of every pixel, NULL if not needed
+	S *	S1,                             //S1 of every pixel, NULL if not needed
+	S *	S2,                             //S2 of every pixel, NULL if not needed
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	){
+	const int n_x = frame->n_x;
+	const int n_z = frame->n_z;
+	double M[3][4];
+	if(n_x<4 || n_z<4 || frame->PixelInterval!=1 || StokesMatrix(mosaic,M)!=0){
+		return -1;
+	}
+
+	//weights of the cases C, H, V and D for even and odd i (frame row) and j
+	//pixel (i,j) is behind channel 2*(j%2)+i%2; H changes the parity of j, V that of i, D both
+	DemosaicRow RowTemplate[2];
+	for(int pi_x=0; pi_x<2; pi_x++){
+		DemosaicRow & row = RowTemplate[pi_x];
+		row.count = n_z;
+		row.Method = Method;
+		for(int pj=0; pj<2; pj++){
+			const int channel[4] = {2*pj+pi_x,2*(1-pj)+pi_x,2*pj+1-pi_x,2*(1-pj)+1-pi_x};
+			for(int m=0; m<3; m++){
+				for(int c=0; c<4; c++){
+					row.Weight[m][c][pj] = (float)M[m][channel[c]];
+				}
+			}
+		}
+	}
+
+	DemosaicRowFunction kernel = DemosaicKernel(type);
+	const int stride = n_z+4+DEMOSAIC_ROW_SLACK;
+	const float Offset = (float)mosaic->Offset;
+	const int bands = (n_x+DEMOSAIC_BAND_ROWS-1)/DEMOSAIC_BAND_ROWS;
+	std::atomic<int> status(0);    //set by any thread of the pool that runs out of memory
+	auto task = [&](int begin, int end){
+		std::vector<float> band;
+		std::vector<float> scratch;
+		try{
+			band.assign((size_t)(DEMOSAIC_BAND_ROWS+4)*stride,0.0f);
+			scratch.assign((size_t)5*n_z,0.0f);
+		}
+		catch(...){
+			status = -1;
+			return;
+		}
+		for(int b=begin; b<end; b++){
+			int first = b*DEMOSAIC_BAND_ROWS;
+			int rows = n_x-first<DEMOSAIC_BAND_ROWS ? n_x-first : DEMOSAIC_BAND_ROWS;
+
+			//raw rows first-2 to first+rows+1 minus the black level, mirrored at the edges of the frame
+			for(int r=-2; r<rows+2; r++){
+				const uint16_t * src = Raw+(size_t)Mirror(first+r,n_x)*n_z;
+				float * dst = &band[(size_t)(r+2)*stride+2];
+				for(int j=0; j<n_z; j++){
+					dst[j] = (float)src[j]-Offset;
+				}
+				dst[-1] = dst[1];
+				dst[-2] = dst[2];
+				dst[n_z] = dst[n_z-2];
+				dst[n_z+1] = dst[n_z-3];
+			}
+
+			for(int r=0; r<rows; r++){
+				int i = first+r;
+				size_t offset = (size_t)i*n_z;
+				DemosaicRow row = RowTemplate[i&1];
+				for(int t=0; t<5; t++){
+					row.Band[t] = &band[(size_t)(r+t)*stride];
+				}
+				row.DOP = OutputRow(frame->DOP+offset,&scratch[0]);
+				row.AOP = OutputRow(frame->AOP+offset,&scratch[n_z]);
+				row.S0 = OutputRow(S0==NULL ? NULL : S0+offset,&scratch[2*n_z]);
+				row.S1 = OutputRow(S1==NULL ? NULL : S1+offset,&scratch[3*n_z]);
+				row.S2 = OutputRow(S2==NULL ? NULL : S2+offset,&scratch[4*n_z]);
+				kernel(&row);
+				StoreRow(row.DOP,frame->DOP+offset,n_z);
+				StoreRow(row.AOP,frame->AOP+offset,n_z);
+				StoreRow(row.S0,S0==NULL ? NULL : S0+offset,n_z);
+				StoreRow(row.S1,S1==NULL ? NULL : S1+offset,n_z);
+				StoreRow(row.S2,S2==NULL ? NULL : S2+offset,n_z);
+			}
+		}
+	};
+	if(pool==NULL){
+		task(0,bands);
+	}
+	else{
+		pool->ParallelFor(bands,1,task);
+	}
+	return status.load();
+}
+
+
+
+//Recover S0, S1, S2, DOP and AOP from a raw polarizer mosaic.
+int CameraDemosaic(
+	const uint16_t *	Raw,            //raw mosaic
+	const MosaicParameters *	mosaic, //sensor
+	const int     Method,               //DEMOSAIC_BILINEAR or DEMOSAIC_GRADIENT
+	const int     type,                 //kernel type
+	CameraFrame *	frame,              //DOP and AOP of every pixel
+	double *	S0,                     //S0 of every pixel, NULL if not needed
+	double *	S1,                     //S1 of every pixel, NULL if not needed
+	double *	S2,                     //S2 of every pixel, NULL if not needed
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	){
+	return Demosaic(Raw,mosaic,Method,type,frame,S0,S1,S2,pool);
+}
+
+
+
+//Recover S0, S1, S2, DOP and AOP from a raw polarizer mosaic into single precision planes.
+int CameraDemosaic(
+	const uint16_t *	Raw,            //raw mosaic
+	const MosaicParameters *	mosaic, //sensor
+	const int     Method,               //DEMOSAIC_BILINEAR or DEMOSAIC_GRADIENT
+	const int     type,                 //kernel type
+	CameraFrameFloat *	frame,          //DOP and AOP of every pixel
+	float *	S0,                         //S0 of every pixel, NULL if not needed
+	float *	S1,                         //S1 of every pixel, NULL if not needed
+	float *	S2,                         //S2 of every pixel, NULL if not needed
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	){
+	return Demosaic(Raw,mosaic,Method,type,frame,S0,S1,S2,pool);
+}
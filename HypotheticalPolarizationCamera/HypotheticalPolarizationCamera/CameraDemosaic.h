@@ -0,0 +1,74 @@
+#ifndef _CAMERADEMOSAIC_H_
+#define _CAMERADEMOSAIC_H_
+
+#include <stdint.h>
+#include "PolarizationCamera.h"
+#include "CameraMosaic.h"
+
+//interpolation of the missing polarizer channels
+#define DEMOSAIC_BILINEAR           0       //mean of the 2 or 4 nearest pixels of the channel
+#define DEMOSAIC_GRADIENT           1       //neighbours weighted against edges by the gradient of the pixel's own channel
+
+#define DEMOSAIC_BAND_ROWS          16      //frame rows converted and demosaicked together (cache blocking)
+
+//one frame row for a demosaic kernel
+//The band holds the raw values minus the black level as float, padded by mirroring 2 pixels on every side.
+//Every pixel combines its own value (case C), the mean of its neighbours along j_z (H), along i_x (V) and on the
+//diagonals (D), one case per polarizer channel; the Stokes components are weighted sums of the four cases.
+typedef struct DemosaicRow
+{
+	const float *	Band[5];    //padded band rows i-2 to i+2, pixel j of a row at index j+2
+	int       count;            //number of pixels of the row
+	int       Method;           //DEMOSAIC_BILINEAR or DEMOSAIC_GRADIENT
+	float     Weight[3][4][2];  //weight of S0, S1, S2 for the cases C, H, V, D at even and odd j
+
+	float *	S0;                 //total intensity (unit is digital number), NULL if not needed
+	float *	S1;                 //Stokes component S1, NULL if not needed
+	float *	S2;                 //Stokes component S2, NULL if not needed
+	float *	DOP;                //DOP
+	float *	AOP;                //AOP (unit is degree)
+}
+DemosaicRow;
+
+typedef void (*DemosaicRowFunction)(const DemosaicRow * row);
+
+//Recover S0, S1, S2, DOP and AOP from a raw polarizer mosaic.
+int CameraDemosaic(
+	const uint16_t *	Raw,            //raw mosaic in the layout of CameraFrame (see "CameraSimulationMosaic()")
+	const MosaicParameters *	mosaic, //sensor: polarizer angles, efficiency and black level
+	const int     Method,               //DEMOSAIC_BILINEAR or DEMOSAIC_GRADIENT
+	const int     type,                 //kernel type (see RayleighKernel.h)
+	CameraFrame *	frame,              //DOP and AOP of every pixel, PixelInterval 1
+	double *	S0,                     //total intensity of every pixel in the layout of frame, NULL if not needed
+	double *	S1,                     //S1 of every pixel, NULL if not needed
+	double *	S2,                     //S2 of every pixel, NULL if not needed
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	);
+
+//Recover S0, S1, S2, DOP and AOP from a raw polarizer mosaic into single precision planes.
+int CameraDemosaic(
+	const uint16_t *	Raw,            //raw mosaic in the layout of CameraFrame (see "CameraSimulationMosaic()")
+	const MosaicParameters *	mosaic, //sensor: polarizer angles, efficiency and black level
+	const int     Method,               //DEMOSAIC_BILINEAR or DEMOSAIC_GRADIENT
+	const int     type,                 //kernel type (see RayleighKernel.h)
+	CameraFrameFloat *	frame,          //DOP and AOP of every pixel, PixelInterval 1
+	float *	S0,                         //total intensity of every pixel in the layout of frame, NULL if not needed
+	float *	S1,                         //S1 of every pixel, NULL if not needed
+	float *	S2,                         //S2 of every pixel, NULL if not needed
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	);
+
+//Demosaic kernel of a kernel type.
+DemosaicRowFunction DemosaicKernel(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	);
+
+//scalar and vectorized demosaic kernels
+void DemosaicRowScalar(const DemosaicRow * row);
+#ifdef RAYLEIGH_KERNEL_X86
+void DemosaicRowSSE2(const DemosaicRow * row);
+void DemosaicRowAVX2(const DemosaicRow * row);
+void DemosaicRowAVX512(const DemosaicRow * row);
+#endif
+
+#endif
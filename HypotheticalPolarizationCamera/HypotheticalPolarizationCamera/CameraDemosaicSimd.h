@@ -0,0 +1,101 @@
+#ifndef _CAMERADEMOSAICSIMD_H_
+#define _CAMERADEMOSAICSIMD_H_
+
+//Vectorized demosaic kernel shared by CameraDemosaic.cpp (scalar), RayleighKernelSSE2.cpp, RayleighKernelAVX2.cpp
+//and RayleighKernelAVX512.cpp. It is included after RayleighKernelSimd.h, inside the same unnamed namespace, and
+//uses the single precision vector types V described there together with "VectorAtan()" and "VectorStore()".
+
+//Interpolation, Stokes components, DOP and AOP of a frame row of a raw polarizer mosaic.
+template <class V>
+inline void VectorDemosaic(
+	const DemosaicRow *	row     //padded band rows and outputs of the frame row
+	)
+{
+	typedef typename V::T T;
+	const int W = V::Width;
+	const T zero = V::Set(0.0);
+	const T half = V::Set(0.5);
+	const T quarter = V::Set(0.25);
+	const T one = V::Set(1.0);
+
+	//weights of the lanes for a first pixel at even and at odd j
+	T weight[2][3][4];
+	for(int start=0; start<2; start++){
+		for(int m=0; m<3; m++){
+			for(int c=0; c<4; c++){
+				float lane[V::Width];
+				for(int l=0; l<W; l++){
+					lane[l] = row->Weight[m][c][(start+l)&1];
+				}
+				weight[start][m][c] = V::Load(lane);
+			}
+		}
+	}
+
+	const float * r0 = row->Band[0]+2;
+	const float * r1 = row->Band[1]+2;
+	const float * r2 = row->Band[2]+2;
+	const float * r3 = row->Band[3]+2;
+	const float * r4 = row->Band[4]+2;
+	for(int k=0; k<row->count; k+=W){
+		//the own value, and the neighbours along j_z, along i_x and on the diagonals
+		T C = V::Load(r2+k);
+		T H = V::Mul(half,V::Add(V::Load(r2+k-1),V::Load(r2+k+1)));
+		T Vert = V::Mul(half,V::Add(V::Load(r1+k),V::Load(r3+k)));
+		T d1 = V::Load(r1+k-1);
+		T d2 = V::Load(r3+k+1);
+		T d3 = V::Load(r1+k+1);
+		T d4 = V::Load(r3+k-1);
+		T D;
+		if(row->Method==DEMOSAIC_GRADIENT){
+			//every neighbour weighted by the inverse of the change of the own channel towards it, so that values are
+			//not averaged across an edge; changes below a twentieth of the value count as smooth
+			T e = V::Add(V::Mul(V::Set(0.05),V::Abs(C)),one);
+			T wl = V::Div(one,V::Add(e,V::Abs(V::Sub(C,V::Load(r2+k-2)))));
+			T wr = V::Div(one,V::Add(e,V::Abs(V::Sub(C,V::Load(r2+k+2)))));
+			H = V::Div(V::Add(V::Mul(wl,V::Load(r2+k-1)),V::Mul(wr,V::Load(r2+k+1))),V::Add(wl,wr));
+			T wu = V::Div(one,V::Add(e,V::Abs(V::Sub(C,V::Load(r0+k)))));
+			T wd = V::Div(one,V::Add(e,V::Abs(V::Sub(C,V::Load(r4+k)))));
+			Vert = V::Div(V::Add(V::Mul(wu,V::Load(r1+k)),V::Mul(wd,V::Load(r3+k))),V::Add(wu,wd));
+			T w1 = V::Div(one,V::Add(e,V::Abs(V::Sub(C,V::Load(r0+k-2)))));
+			T w2 = V::Div(one,V::Add(e,V::Abs(V::Sub(C,V::Load(r4+k+2)))));
+			T w3 = V::Div(one,V::Add(e,V::Abs(V::Sub(C,V::Load(r0+k+2)))));
+			T w4 = V::Div(one,V::Add(e,V::Abs(V::Sub(C,V::Load(r4+k-2)))));
+			D = V::Div(V::Add(V::Add(V::Mul(w1,d1),V::Mul(w2,d2)),V::Add(V::Mul(w3,d3),V::Mul(w4,d4))),
+				V::Add(V::Add(w1,w2),V::Add(w3,w4)));
+		}
+		else{
+			D = V::Mul(quarter,V::Add(V::Add(d1,d2),V::Add(d3,d4)));
+		}
+
+		//Stokes components as weighted sums of the four cases
+		const T (*w)[4] = weight[k&1];
+		T S[3];
+		for(int m=0; m<3; m++){
+			S[m] = V::Add(V::Add(V::Mul(w[m][0],C),V::Mul(w[m][1],H)),V::Add(V::Mul(w[m][2],Vert),V::Mul(w[m][3],D)));
+		}
+
+		//DOP=sqrt(S1^2+S2^2)/S0 and AOP=atan(S2/(S1+sqrt(S1^2+S2^2))), half of the angle of (S1,S2)
+		T P = V::Sqrt(V::Add(V::Mul(S[1],S[1]),V::Mul(S[2],S[2])));
+		T dop = V::Select(zero,V::Div(P,S[0]),V::CmpGT(S[0],zero));
+		T den = V::Add(S[1],P);
+		T angle = VectorAtan<V>(V::Div(S[2],den));
+		angle = V::Select(angle,V::Set(3.141592653589793/2),V::CmpEQ(den,zero));
+		angle = V::Select(angle,zero,V::CmpEQ(dop,zero));	//Elimination of invalid solution
+		T aop = V::Mul(angle,V::Set(180.0/3.141592653589793));
+
+		VectorStore<V>(row->DOP+k,dop,row->count-k);
+		VectorStore<V>(row->AOP+k,aop,row->count-k);
+		if(row->S0!=NULL){
+			VectorStore<V>(row->S0+k,S[0],row->count-k);
+		}
+		if(row->S1!=NULL){
+			VectorStore<V>(row->S1+k,S[1],row->count-k);
+		}
+		if(row->S2!=NULL){
+			VectorStore<V>(row->S2+k,S[2],row->count-k);
+		}
+	}
+}
+
+#endif
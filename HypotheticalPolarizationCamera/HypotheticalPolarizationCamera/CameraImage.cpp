@@ -0,0 +1,1102 @@
+/*
+DOP and AOP images of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for writing DOP and AOP frames as PNG, PPM or 16-bit TIFF images with the colormaps of output/ImageDarwing.m, without MATLAB.
+And this code is written in C++11.
+
+Usage information:
+Fill ImageSettings with "ImageSettingsDefault()", then write frames with "CameraImageWrite()" or a batch with "CameraFrameSinkImage()".
+--------------------------
+
+Images:
+	"output/ImageDarwing.m" draws a frame with "pcolor()", the colormap [cool;spring] over [0,1] for DOP and jet over
+	[-90,90] for AOP, and "view(90,-90)", which shows i_x from left to right and j_z from bottom to top.
+	"ImageColormapDOP()" and "ImageColormapAOP()" build the same 64-entry tables as MATLAB once, and a value picks its
+	entry with one multiplication, exactly as "caxis()" does, so every pixel of a PNG or PPM has the color MATLAB
+	paints it with. IMAGE_ORIENTATION_MATLAB gives the picture of "ImageDarwing.m" without its axes and colorbar:
+	an image of n_x columns and n_z rows. IMAGE_ORIENTATION_FRAME writes the frame rows as image rows instead.
+	A PNG stores the entry of every pixel with the colormap as its palette (NaN is a white entry after the colormap),
+	and an IMAGE_FORMAT_TIFF16 file the value itself, mapped linearly from [Min,Max] to 0 to 65535 (NaN is 0).
+
+Parallel encoding:
+	The image is cut into bands of IMAGE_BAND_ROWS rows. A parallel loop converts the bands, reading a band of frame
+	columns of IMAGE_ORIENTATION_MATLAB row by row, and a second loop compresses them. Sky images are smooth, so the
+	compressor of a PNG only looks for repeats of the previous pixel and of the pixel above and codes them with the
+	fixed Huffman codes of deflate; every band ends on a byte boundary with an empty stored block, and the bands
+	are written one after another as one zlib stream. The bands do not depend on the number of threads, so the
+	files are the same on any pool. "CameraFrameSinkImage()" encodes the frames of "CameraSimulationBatch()" with
+	the pool of the batch, and "FrameFileToImages()" renders a binary frame file one frame per thread, which keeps
+	every thread busy on thousands of small frames.
+
+
+Function 1: "ImageColormapDOP()" 
+
+    //Colormap of DOP images.
+	void ImageColormapDOP(
+		ImageColormap *	map
+	);
+	-------------output----------------
+	ImageColormap *	map         //[cool;spring] of MATLAB (128 entries) over [0,1]
+	-----------------------------------
+
+
+Function 2: "ImageColormapAOP()" 
+
+    //Colormap of AOP images.
+	void ImageColormapAOP(
+		ImageColormap *	map
+	);
+	-------------output----------------
+	ImageColormap *	map         //jet of MATLAB (64 entries) over [-90,90]
+	-----------------------------------
+
+
+Function 3: "ImageSettingsDefault()" 
+
+    //Default settings.
+	void ImageSettingsDefault(
+		ImageSettings *	settings
+	);
+	-------------output----------------
+	ImageSettings *	settings    //IMAGE_FORMAT_PNG, IMAGE_ORIENTATION_MATLAB, "ImageColormapDOP()" and "ImageColormapAOP()"
+	-----------------------------------
+
+
+Function 4: "CameraImageWritePlane()" 
+
+    //Write a DOP or AOP plane as an image file.
+	int CameraImageWritePlane(
+		const double *	plane,
+		const int     n_x,
+		const int     n_z,
+		const ImageColormap *	map,
+		const ImageSettings *	settings,
+		ThreadPool *	pool,
+		const char *  path
+	);
+	--------------input----------------
+	const double *	plane,              //n_x*n_z values in the layout of CameraFrame (or const float *)
+	const int     n_x,                  //Number of simulated pixels along i_x (unit is pixel)
+	const int     n_z,                  //Number of simulated pixels along j_z (unit is pixel)
+	const ImageColormap *	map,        //colormap and range of the values
+	const ImageSettings *	settings,   //format and orientation, the colormaps of the settings are not used
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  path                  //file name
+	-----------------------------------
+	-------------output----------------
+	int                                 //0 on success, -1 if the arguments are invalid or the file cannot be written
+	-----------------------------------
+
+
+Function 5: "CameraImageWrite()" 
+
+    //Write the DOP and AOP images of a frame.
+	int CameraImageWrite(
+		const CameraFrame *	frame,
+		const ImageSettings *	settings,
+		ThreadPool *	pool,
+		const char *  DOPPath,
+		const char *  AOPPath
+	);
+	--------------input----------------
+	const CameraFrame *	frame,          //DOP and AOP frame (or const CameraFrameFloat *)
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPath,              //file name of the DOP image, NULL writes none
+	const char *  AOPPath               //file name of the AOP image, NULL writes none
+	-----------------------------------
+	-------------output----------------
+	int                                 //0 on success, -1 if an image cannot be written
+	-----------------------------------
+
+
+Function 6: "CameraFrameSinkImage()" 
+
+    //Sink writing the DOP and AOP images of every frame of a batch.
+	int CameraFrameSinkImage(
+		void *	context,
+		const int     FrameIndex,
+		const CameraFrame *	frame,
+		const CameraParameters *	parm
+	);
+	--------------input----------------
+	void *	context,                   //ImageSink *
+	const int     FrameIndex,          //index of the attitude of the frame, the %d of the file names
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	-----------------------------------
+	-------------output----------------
+	int                                //0 on success, -1 if an image cannot be written
+	-----------------------------------
+	The sink of "CameraSimulationStream()" runs beside the simulation of the next frame; give it a NULL pool, or a
+	pool of its own, since a pool runs one parallel loop at a time.
+
+
+Function 7: "FrameFileToImages()" 
+
+    //Write the DOP and AOP images of every frame of a binary frame file, one frame per thread.
+	int FrameFileToImages(
+		const char *  BinaryPath,
+		const ImageSettings *	settings,
+		ThreadPool *	pool,
+		const char *  DOPPattern,
+		const char *  AOPPattern
+	);
+	--------------input----------------
+	const char *  BinaryPath,           //binary frame file (see FrameIO.h)
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPattern,           //file name of the DOP images with one %d for the frame index, NULL writes none
+	const char *  AOPPattern            //file name of the AOP images with one %d for the frame index, NULL writes none
+	-----------------------------------
+	-------------output----------------
+	int                                 //0 on success, -1 if the file cannot be mapped or an image cannot be written
+	-----------------------------------
+
+Example:
+
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	CameraFrame * frame = CameraFrameInit(parm);
+	CameraSimulationFrame(78.9*pi/180.0,-65.2*pi/180.0,278.3*pi/180.0,parm,frame);
+	ImageSettings settings;
+	ImageSettingsDefault(&settings);
+	ThreadPool pool(0);
+	CameraImageWrite(frame,&settings,&pool,"output/DOP.png","output/AOP.png");	//without MATLAB
+
+	FrameFileToImages("output/batch.hpcf",&settings,&pool,"output/DOP_%06d.png","output/AOP_%06d.png");
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "CameraImage.h"
+#include "FrameIO.h"
+#include "ThreadPool.h"
+#include "CameraStats.h"
+
+
+#define PNG_MAX_DISTANCE            32768   //farthest match of deflate (unit is byte)
+#define PNG_MAX_MATCH               258     //longest match of deflate (unit is byte)
+#define PNG_MIN_MATCH               3       //shortest match of deflate (unit is byte)
+
+//base lengths and extra bits of the length codes 257 to 285 of deflate
+const static int LengthBase[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+const static int LengthExtra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+//base distances and extra bits of the distance codes 0 to 29 of deflate
+const static int DistanceBase[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,
+	6145,8193,12289,16385,24577};
+const static int DistanceExtra[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+
+//layout of an image file
+typedef struct ImageLayout
+{
+	int       Width;            //image columns (unit is pixel)
+	int       Height;           //image rows (unit is pixel)
+	size_t    RowBytes;         //bytes of an image row in the raster
+	size_t    Offset;           //bytes before the first pixel of a row (the filter type of PNG)
+}
+ImageLayout;
+
+//lookup table of CRC-32
+struct CrcTable
+{
+	uint32_t  value[256];
+
+	CrcTable(){
+		for(uint32_t k=0; k<256; k++){
+			uint32_t c = k;
+			for(int b=0; b<8; b++){
+				c = (c&1) ? 0xEDB88320u^(c>>1) : c>>1;
+			}
+			value[k] = c;
+		}
+	}
+};
+
+//deflate bit stream, least significant bit first
+typedef struct BitWriter
+{
+	std::vector<uint8_t> *	out;
+	uint64_t  bits;             //pending bits
+	int       count;            //number of pending bits
+}
+BitWriter;
+
+
+
+//Color of an entry of a MATLAB colormap
+static void ColormapEntry(
+	ImageColormap *	map,        //colormap
+	const int     k,            //entry
+	const double  r,            //red, 0 to 1
+	const double  g,            //green, 0 to 1
+	const double  b             //blue, 0 to 1
+	){
+	map->RGB[k][0] = (uint8_t)floor(r*255.0+0.5);
+	map->RGB[k][1] = (uint8_t)floor(g*255.0+0.5);
+	map->RGB[k][2] = (uint8_t)floor(b*255.0+0.5);
+}
+
+
+
+//Colormap of DOP images: [cool;spring] over [0,1].
+void ImageColormapDOP(
+	ImageColormap *	map         //colormap
+	){
+	const int m = IMAGE_COLORMAP_SIZE;
+	memset(map,0,sizeof(ImageColormap));
+	map->Size = 2*m;
+	map->Min = 0.0;
+	map->Max = 1.0;
+	for(int k=0; k<m; k++){
+		double t = (double)k/(m-1);
+		ColormapEntry(map,k,t,1.0-t,1.0);       //cool
+		ColormapEntry(map,m+k,1.0,t,1.0-t);     //spring
+	}
+}
+
+
+
+//Colormap of AOP images: jet over [-90,90].
+void ImageColormapAOP(
+	ImageColormap *	map         //colormap
+	){
+	const int m = IMAGE_COLORMAP_SIZE;
+	memset(map,0,sizeof(ImageColormap));
+	map->Size = m;
+	map->Min = -90.0;
+	map->Max = 90.0;
+
+	//jet.m of MATLAB: the ramp u is laid over the red, green and blue entries with offsets of n
+	int n = (m+3)/4;
+	int length = 3*n-1;
+	double u[3*IMAGE_COLORMAP_SIZE];
+	for(int k=0; k<length; k++){
+		u[k] = k<n ? (double)(k+1)/n : (k<2*n-1 ? 1.0 : (double)(3*n-1-k)/n);
+	}
+	int first = (n+1)/2-(m%4==1 ? 1 : 0);    //entry of u[0] in the green channel (1 based)
+	double rgb[IMAGE_COLORMAP_SIZE][3];
+	memset(rgb,0,sizeof(rgb));
+	for(int k=0; k<length; k++){
+		int g = first+k+1;
+		int r = g+n;
+		int b = g-n;
+		if(r<=m){
+			rgb[r-1][0] = u[k];
+		}
+		if(g<=m){
+			rgb[g-1][1] = u[k];
+		}
+		if(b>=1){
+			rgb[b-1][2] = u[k];
+		}
+	}
+	for(int k=0; k<m; k++){
+		ColormapEntry(map,k,rgb[k][0],rgb[k][1],rgb[k][2]);
+	}
+}
+
+
+
+//Default settings: PNG in the orientation of output/ImageDarwing.m with its colormaps.
+void ImageSettingsDefault(
+	ImageSettings *	settings    //settings
+	){
+	settings->Format = IMAGE_FORMAT_PNG;
+	settings->Orientation = IMAGE_ORIENTATION_MATLAB;
+	ImageColormapDOP(&settings->DOPMap);
+	ImageColormapAOP(&settings->AOPMap);
+}
+
+
+
+//Entry of a value in a colormap, Size for NaN
+static inline int ColorIndex(
+	const double  v,                //value
+	const ImageColormap &	map,    //colormap
+	const double  scale             //Size/(Max-Min)
+	){
+	if(v!=v){
+		return map.Size;
+	}
+	double t = (v-map.Min)*scale;
+	if(t<1.0){
+		return 0;
+	}
+	return t<map.Size ? (int)t : map.Size-1;
+}
+
+
+
+//16-bit gray value of a value, 0 for NaN
+static inline int GrayValue(
+	const double  v,                //value
+	const ImageColormap &	map,    //range of the values
+	const double  scale             //65535/(Max-Min)
+	){
+	if(v!=v){
+		return 0;
+	}
+	double t = (v-map.Min)*scale+0.5;
+	if(t<1.0){
+		return 0;
+	}
+	return t<65535.0 ? (int)t : 65535;
+}
+
+
+
+//Convert image rows [RowBegin,RowEnd) of a plane into the raster, pixel(v,dst) writing the bytes of a pixel.
+template <class S, size_t PixelBytes, class Pixel>
+static void ConvertRows(
+	const S *	plane,                  //n_x*n_z values in the layout of CameraFrame
+	const int     n_x,                  //Number of simulated pixels along i_x (unit is pixel)
+	const int     n_z,                  //Number of simulated pixels along j_z (unit is pixel)
+	const int     Orientation,          //IMAGE_ORIENTATION_MATLAB or IMAGE_ORIENTATION_FRAME
+	const ImageLayout &	layout,         //layout of the raster
+	const int     RowBegin,             //first image row
+	const int     RowEnd,               //image row after the last one
+	uint8_t *	raster,                 //Height*RowBytes bytes
+	const Pixel &	pixel               //conversion of a value
+	){
+	if(Orientation==IMAGE_ORIENTATION_MATLAB){
+		//image row r is the frame column n_z-1-r, read along the frame rows a band of columns at a time
+		for(int i=0; i<n_x; i++){
+			const S * column = plane+(size_t)i*n_z+(n_z-1);
+			uint8_t * dst = raster+layout.Offset+(size_t)i*PixelBytes;
+			for(int r=RowBegin; r<RowEnd; r++){
+				pixel(column[-r],dst+(size_t)r*layout.RowBytes);
+			}
+		}
+	}
+	else{
+		for(int r=RowBegin; r<RowEnd; r++){
+			const S * row = plane+(size_t)r*n_z;
+			uint8_t * dst = raster+(size_t)r*layout.RowBytes+layout.Offset;
+			for(int j=0; j<n_z; j++){
+				pixel(row[j],dst+(size_t)j*PixelBytes);
+			}
+		}
+	}
+}
+
+
+
+//Append bits to a deflate stream.
+static inline void PutBits(
+	BitWriter &	w,              //bit stream
+	const uint32_t  value,      //bits, least significant first
+	const int     n             //number of bits (at most 32)
+	){
+	w.bits |= (uint64_t)value<<w.count;
+	w.count += n;
+	while(w.count>=8){
+		w.out->push_back((uint8_t)w.bits);
+		w.bits >>= 8;
+		w.count -= 8;
+	}
+}
+
+
+
+//Append a Huffman code, which deflate stores most significant bit first.
+static inline void PutCode(
+	BitWriter &	w,              //bit stream
+	const uint32_t  code,       //Huffman code
+	const int     n             //length of the code
+	){
+	uint32_t reversed = 0;
+	for(int k=0; k<n; k++){
+		reversed |= ((code>>k)&1)<<(n-1-k);
+	}
+	PutBits(w,reversed,n);
+}
+
+
+
+//Append a literal or length symbol with the fixed Huffman codes of deflate.
+static inline void PutSymbol(
+	BitWriter &	w,              //bit stream
+	const int     symbol        //0 to 287
+	){
+	if(symbol<144){
+		PutCode(w,0x30+symbol,8);
+	}
+	else if(symbol<256){
+		PutCode(w,0x190+symbol-144,9);
+	}
+	else if(symbol<280){
+		PutCode(w,symbol-256,7);
+	}
+	else{
+		PutCode(w,0xC0+symbol-280,8);
+	}
+}
+
+
+
+//Append a match with the fixed Huffman codes of deflate.
+static void PutMatch(
+	BitWriter &	w,              //bit stream
+	const int     length,       //PNG_MIN_MATCH to PNG_MAX_MATCH
+	const int     distance      //1 to PNG_MAX_DISTANCE
+	){
+	int k = 28;
+	while(LengthBase[k]>length){
+		k--;
+	}
+	PutSymbol(w,257+k);
+	PutBits(w,(uint32_t)(length-LengthBase[k]),LengthExtra[k]);
+	int d = 29;
+	while(DistanceBase[d]>distance){
+		d--;
+	}
+	PutCode(w,(uint32_t)d,5);
+	PutBits(w,(uint32_t)(distance-DistanceBase[d]),DistanceExtra[d]);
+}
+
+
+
+//Length of the repeat of data[p..] at a distance, at most limit
+static inline int MatchLength(
+	const uint8_t *	data,       //raster
+	const size_t  p,            //position
+	const size_t  distance,     //distance of the repeat
+	const int     limit         //longest length
+	){
+	const uint8_t * a = data+p;
+	const uint8_t * b = a-distance;
+	int n = 0;
+	while(n<limit && a[n]==b[n]){
+		n++;
+	}
+	return n;
+}
+
+
+
+//Compress raster bytes [begin,end) into fixed Huffman deflate blocks ending on a byte boundary. Matches may
+//reach back into the bytes before begin, which the decoder has already inflated.
+static void DeflateBand(
+	const uint8_t *	data,       //raster
+	const size_t  begin,        //first byte of the band
+	const size_t  end,          //byte after the band
+	const size_t  RowBytes,     //bytes of a raster row, the distance of the pixel above
+	std::vector<uint8_t> &	out //compressed band
+	){
+	BitWriter w;
+	w.out = &out;
+	w.bits = 0;
+	w.count = 0;
+	out.clear();
+	out.reserve((end-begin)/8+64);
+
+	PutBits(w,0,1);     //not the last block
+	PutBits(w,1,2);     //fixed Huffman codes
+	size_t p = begin;
+	while(p<end){
+		int limit = end-p<PNG_MAX_MATCH ? (int)(end-p) : PNG_MAX_MATCH;
+		int length = 0;
+		int distance = 0;
+		if(p>=1){
+			length = MatchLength(data,p,1,limit);
+			distance = 1;
+		}
+		if(length<limit && RowBytes<=PNG_MAX_DISTANCE && p>=RowBytes){
+			int up = MatchLength(data,p,RowBytes,limit);
+			if(up>length){
+				length = up;
+				distance = (int)RowBytes;
+			}
+		}
+		if(length>=PNG_MIN_MATCH){
+			PutMatch(w,length,distance);
+			p += length;
+		}
+		else{
+			PutSymbol(w,data[p]);
+			p++;
+		}
+	}
+	PutSymbol(w,256);   //end of block
+
+	//an empty stored block pads the band to a byte boundary
+	PutBits(w,0,3);
+	if(w.count>0){
+		PutBits(w,0,8-w.count);
+	}
+	out.push_back(0x00);
+	out.push_back(0x00);
+	out.push_back(0xFF);
+	out.push_back(0xFF);
+}
+
+
+
+//CRC-32 of PNG chunks, continuing crc
+static uint32_t Crc32(
+	const uint32_t  crc,        //CRC of the bytes before
+	const uint8_t *	data,       //bytes
+	const size_t  size          //number of bytes
+	){
+	static const CrcTable table;    //built once, also when frames are encoded on several threads
+	uint32_t c = ~crc;
+	for(size_t k=0; k<size; k++){
+		c = table.value[(c^data[k])&0xFF]^(c>>8);
+	}
+	return ~c;
+}
+
+
+
+//Adler-32 of a zlib stream
+static uint32_t Adler32(
+	const uint8_t *	data,       //bytes
+	const size_t  size          //number of bytes
+	){
+	uint32_t a = 1;
+	uint32_t b = 0;
+	size_t k = 0;
+	while(k<size){
+		size_t n = size-k<5552 ? size-k : 5552;     //largest run without overflow of b
+		for(size_t e=k+n; k<e; k++){
+			a += data[k];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b<<16)|a;
+}
+
+
+
+//Store a 32-bit value most significant byte first.
+static void PutBigEndian(
+	uint8_t *	dst,            //4 bytes
+	const uint32_t  value       //value
+	){
+	dst[0] = (uint8_t)(value>>24);
+	dst[1] = (uint8_t)(value>>16);
+	dst[2] = (uint8_t)(value>>8);
+	dst[3] = (uint8_t)value;
+}
+
+
+
+//Write a PNG chunk of data in pieces, 0 on success.
+static int WriteChunk(
+	FILE *	file,                               //opened file
+	const char *  type,                         //chunk type
+	const std::vector<const uint8_t *> &	pieces, //data of the chunk
+	const std::vector<size_t> &	sizes           //sizes of the pieces
+	){
+	size_t length = 0;
+	for(size_t k=0; k<sizes.size(); k++){
+		length += sizes[k];
+	}
+	if(length>0x7FFFFFFFu){
+		return -1;
+	}
+	uint8_t head[8];
+	PutBigEndian(head,(uint32_t)length);
+	memcpy(head+4,type,4);
+	uint32_t crc = Crc32(0,head+4,4);
+	int status = fwrite(head,1,8,file)==8 ? 0 : -1;
+	for(size_t k=0; k<pieces.size() && status==0; k++){
+		crc = Crc32(crc,pieces[k],sizes[k]);
+		if(sizes[k]>0 && fwrite(pieces[k],1,sizes[k],file)!=sizes[k]){
+			status = -1;
+		}
+	}
+	uint8_t tail[4];
+	PutBigEndian(tail,crc);
+	if(status==0 && fwrite(tail,1,4,file)!=4){
+		status = -1;
+	}
+	return status;
+}
+
+
+
+//Write a PNG with the colormap as palette from a raster of entries with a filter type byte per row.
+static int WritePNG(
+	const uint8_t *	raster,         //Height*RowBytes bytes
+	const ImageLayout &	layout,     //layout of the raster
+	const ImageColormap &	map,    //palette
+	ThreadPool *	pool,           //thread pool, NULL runs on the calling thread
+	FILE *	file                    //opened file
+	){
+	int bands = (layout.Height+IMAGE_BAND_ROWS-1)/IMAGE_BAND_ROWS;
+	std::vector< std::vector<uint8_t> > band(bands);
+	auto task = [&](int begin, int end){
+		for(int k=begin; k<end; k++){
+			size_t first = (size_t)k*IMAGE_BAND_ROWS*layout.RowBytes;
+			size_t last = (size_t)(k+1)*IMAGE_BAND_ROWS*layout.RowBytes;
+			size_t size = (size_t)layout.Height*layout.RowBytes;
+			DeflateBand(raster,first,last<size ? last : size,layout.RowBytes,band[k]);
+		}
+	};
+	if(pool==NULL){
+		task(0,bands);
+	}
+	else{
+		pool->ParallelFor(bands,1,task);
+	}
+
+	const uint8_t signature[8] = {0x89,'P','N','G','\r','\n',0x1A,'\n'};
+	if(fwrite(signature,1,8,file)!=8){
+		return -1;
+	}
+
+	uint8_t header[13];
+	PutBigEndian(header,(uint32_t)layout.Width);
+	PutBigEndian(header+4,(uint32_t)layout.Height);
+	header[8] = 8;      //bit depth
+	header[9] = 3;      //palette
+	header[10] = 0;     //deflate
+	header[11] = 0;     //adaptive filtering, every row uses filter type 0
+	header[12] = 0;     //not interlaced
+	std::vector<const uint8_t *> pieces(1,header);
+	std::vector<size_t> sizes(1,sizeof(header));
+	if(WriteChunk(file,"IHDR",pieces,sizes)!=0){
+		return -1;
+	}
+
+	uint8_t palette[(IMAGE_COLORMAP_MAX+1)*3];
+	memcpy(palette,map.RGB,(size_t)map.Size*3);
+	memset(palette+map.Size*3,0xFF,3);      //NaN
+	pieces[0] = palette;
+	sizes[0] = (size_t)(map.Size+1)*3;
+	if(WriteChunk(file,"PLTE",pieces,sizes)!=0){
+		return -1;
+	}
+
+	//zlib stream: header, the bands, an empty last block and the Adler-32 of the raster
+	const uint8_t zlib[2] = {0x78,0x01};
+	const uint8_t last[5] = {0x01,0x00,0x00,0xFF,0xFF};
+	uint8_t adler[4];
+	PutBigEndian(adler,Adler32(raster,(size_t)layout.Height*layout.RowBytes));
+	pieces.assign(1,zlib);
+	sizes.assign(1,sizeof(zlib));
+	for(int k=0; k<bands; k++){
+		pieces.push_back(band[k].empty() ? NULL : &band[k][0]);
+		sizes.push_back(band[k].size());
+	}
+	pieces.push_back(last);
+	sizes.push_back(sizeof(last));
+	pieces.push_back(adler);
+	sizes.push_back(sizeof(adler));
+	if(WriteChunk(file,"IDAT",pieces,sizes)!=0){
+		return -1;
+	}
+
+	pieces.clear();
+	sizes.clear();
+	return WriteChunk(file,"IEND",pieces,sizes);
+}
+
+
+
+//Store a 16 or 32-bit value of a TIFF, least significant byte first.
+static void PutLittleEndian(
+	uint8_t *	dst,            //bytes
+	const uint32_t  value,      //value
+	const int     bytes         //2 or 4
+	){
+	for(int k=0; k<bytes; k++){
+		dst[k] = (uint8_t)(value>>(8*k));
+	}
+}
+
+
+
+//Write the header and the directory of an uncompressed 16-bit grayscale TIFF of one strip.
+static int WriteTIFFHeader(
+	const ImageLayout &	layout,     //layout of the raster
+	const uint32_t  DataOffset,     //offset of the strip (unit is byte)
+	FILE *	file                    //opened file
+	){
+	//tag, type (3 short, 4 long) and value of the entries, in increasing tag order
+	const uint32_t entry[9][3] = {
+		{256,4,(uint32_t)layout.Width},                         //ImageWidth
+		{257,4,(uint32_t)layout.Height},                        //ImageLength
+		{258,3,16},                                             //BitsPerSample
+		{259,3,1},                                              //Compression: none
+		{262,3,1},                                              //PhotometricInterpretation: black is zero
+		{273,4,DataOffset},                                     //StripOffsets
+		{277,3,1},                                              //SamplesPerPixel
+		{278,4,(uint32_t)layout.Height},                        //RowsPerStrip
+		{279,4,(uint32_t)(layout.Height*layout.RowBytes)}       //StripByteCounts
+	};
+	std::vector<uint8_t> header(DataOffset,0);
+	header[0] = 'I';
+	header[1] = 'I';
+	PutLittleEndian(&header[2],42,2);
+	PutLittleEndian(&header[4],8,4);        //offset of the directory
+	PutLittleEndian(&header[8],9,2);
+	for(int k=0; k<9; k++){
+		uint8_t * e = &header[10+12*k];
+		PutLittleEndian(e,entry[k][0],2);
+		PutLittleEndian(e+2,entry[k][1],2);
+		PutLittleEndian(e+4,1,4);
+		PutLittleEndian(e+8,entry[k][2],entry[k][1]==3 ? 2 : 4);
+	}
+	//the offset of the next directory after the entries stays 0
+	return fwrite(&header[0],1,header.size(),file)==header.size() ? 0 : -1;
+}
+
+
+
+//Write a DOP or AOP plane as an image file.
+template <class S>
+static int WritePlane(
+	const S *	plane,                  //n_x*n_z values in the layout of CameraFrame
+	const int     n_x,                  //Number of simulated pixels along i_x (unit is pixel)
+	const int     n_z,                  //Number of simulated pixels along j_z (unit is pixel)
+	const ImageColormap *	map,        //colormap and range of the values
+	const ImageSettings *	settings,   //format and orientation
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  path                  //file name
+	){
+	if(plane==NULL || n_x<=0 || n_z<=0 || map==NULL || settings==NULL || path==NULL){
+		return -1;
+	}
+	if(map->Size<1 || map->Size>IMAGE_COLORMAP_MAX || !(map->Max>map->Min)){
+		return -1;
+	}
+	int Format = settings->Format;
+	int Orientation = settings->Orientation;
+	if((Format!=IMAGE_FORMAT_PNG && Format!=IMAGE_FORMAT_PPM && Format!=IMAGE_FORMAT_TIFF16)
+		|| (Orientation!=IMAGE_ORIENTATION_MATLAB && Orientation!=IMAGE_ORIENTATION_FRAME)){
+		return -1;
+	}
+	STATS_CLOCK(tick);
+
+	ImageLayout layout;
+	layout.Width = Orientation==IMAGE_ORIENTATION_MATLAB ? n_x : n_z;
+	layout.Height = Orientation==IMAGE_ORIENTATION_MATLAB ? n_z : n_x;
+	size_t PixelBytes = Format==IMAGE_FORMAT_PNG ? 1 : (Format==IMAGE_FORMAT_PPM ? 3 : 2);
+	layout.Offset = Format==IMAGE_FORMAT_PNG ? 1 : 0;
+	layout.RowBytes = layout.Offset+(size_t)layout.Width*PixelBytes;
+	if(Format==IMAGE_FORMAT_TIFF16 && (double)layout.Height*layout.RowBytes>4.0e9){
+		return -1;
+	}
+	std::vector<uint8_t> raster((size_t)layout.Height*layout.RowBytes,0);     //PNG rows keep filter type 0
+	uint8_t * data = &raster[0];
+
+	const ImageColormap & m = *map;
+	double IndexScale = m.Size/(m.Max-m.Min);
+	double GrayScale = 65535.0/(m.Max-m.Min);
+	int bands = (layout.Height+IMAGE_BAND_ROWS-1)/IMAGE_BAND_ROWS;
+	auto task = [&](int begin, int end){
+		int RowBegin = begin*IMAGE_BAND_ROWS;
+		int RowEnd = end*IMAGE_BAND_ROWS<layout.Height ? end*IMAGE_BAND_ROWS : layout.Height;
+		if(Format==IMAGE_FORMAT_PNG){
+			ConvertRows<S,1>(plane,n_x,n_z,Orientation,layout,RowBegin,RowEnd,data,[&](S v, uint8_t * dst){
+				dst[0] = (uint8_t)ColorIndex(v,m,IndexScale);
+			});
+		}
+		else if(Format==IMAGE_FORMAT_PPM){
+			ConvertRows<S,3>(plane,n_x,n_z,Orientation,layout,RowBegin,RowEnd,data,[&](S v, uint8_t * dst){
+				int k = ColorIndex(v,m,IndexScale);
+				if(k<m.Size){
+					dst[0] = m.RGB[k][0];
+					dst[1] = m.RGB[k][1];
+					dst[2] = m.RGB[k][2];
+				}
+				else{
+					dst[0] = dst[1] = dst[2] = 0xFF;
+				}
+			});
+		}
+		else{
+			ConvertRows<S,2>(plane,n_x,n_z,Orientation,layout,RowBegin,RowEnd,data,[&](S v, uint8_t * dst){
+				int g = GrayValue(v,m,GrayScale);
+				dst[0] = (uint8_t)g;
+				dst[1] = (uint8_t)(g>>8);
+			});
+		}
+	};
+	if(pool==NULL){
+		task(0,bands);
+	}
+	else{
+		pool->ParallelFor(bands,1,task);
+	}
+
+	FILE * file = fopen(path,"wb");
+	if(file==NULL){
+		return -1;
+	}
+	int status;
+	if(Format==IMAGE_FORMAT_PNG){
+		status = WritePNG(data,layout,m,pool,file);
+	}
+	else{
+		if(Format==IMAGE_FORMAT_PPM){
+			status = fprintf(file,"P6\n%d %d\n255\n",layout.Width,layout.Height)>0 ? 0 : -1;
+		}
+		else{
+			status = WriteTIFFHeader(layout,128,file);
+		}
+		if(status==0 && fwrite(data,1,raster.size(),file)!=raster.size()){
+			status = -1;
+		}
+	}
+	long size = ftell(file);
+	if(fclose(file)!=0){
+		status = -1;
+	}
+	STATS_COUNT(BytesWritten,(uint64_t)(size>0 ? size : 0));
+	STATS_TRACE("image",tick,(uint64_t)n_x*n_z,(uint64_t)(size>0 ? size : 0));
+	(void)size;
+	return status;
+}
+
+
+
+//Write a DOP or AOP plane as an image file.
+int CameraImageWritePlane(
+	const double *	plane,              //n_x*n_z values in the layout of CameraFrame
+	const int     n_x,                  //Number of simulated pixels along i_x (unit is pixel)
+	const int     n_z,                  //Number of simulated pixels along j_z (unit is pixel)
+	const ImageColormap *	map,        //colormap and range of the values
+	const ImageSettings *	settings,   //format and orientation
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  path                  //file name
+	){
+	return WritePlane(plane,n_x,n_z,map,settings,pool,path);
+}
+
+
+
+//Write a single precision DOP or AOP plane as an image file.
+int CameraImageWritePlane(
+	const float *	plane,              //n_x*n_z values in the layout of CameraFrame
+	const int     n_x,                  //Number of simulated pixels along i_x (unit is pixel)
+	const int     n_z,                  //Number of simulated pixels along j_z (unit is pixel)
+	const ImageColormap *	map,        //colormap and range of the values
+	const ImageSettings *	settings,   //format and orientation
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  path                  //file name
+	){
+	return WritePlane(plane,n_x,n_z,map,settings,pool,path);
+}
+
+
+
+//Write the DOP and AOP images of a frame.
+template <class S>
+static int WriteFrame(
+	const CameraFrameOf<S> *	frame,  //DOP and AOP frame
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPath,              //file name of the DOP image, NULL writes none
+	const char *  AOPPath               //file name of the AOP image, NULL writes none
+	){
+	if(frame==NULL || settings==NULL){
+		return -1;
+	}
+	if(DOPPath!=NULL && WritePlane(frame->DOP,frame->n_x,frame->n_z,&settings->DOPMap,settings,pool,DOPPath)!=0){
+		return -1;
+	}
+	if(AOPPath!=NULL && WritePlane(frame->AOP,frame->n_x,frame->n_z,&settings->AOPMap,settings,pool,AOPPath)!=0){
+		return -1;
+	}
+	return 0;
+}
+
+
+
+//Write the DOP and AOP images of a frame.
+int CameraImageWrite(
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPath,              //file name of the DOP image, NULL writes none
+	const char *  AOPPath               //file name of the AOP image, NULL writes none
+	){
+	return WriteFrame(frame,settings,pool,DOPPath,AOPPath);
+}
+
+
+
+//Write the DOP and AOP images of a single precision frame.
+int CameraImageWrite(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPath,              //file name of the DOP image, NULL writes none
+	const char *  AOPPath               //file name of the AOP image, NULL writes none
+	){
+	return WriteFrame(frame,settings,pool,DOPPath,AOPPath);
+}
+
+
+
+//File name of a frame from a pattern with one %d, NULL for a NULL pattern
+static const char * FrameFileName(
+	const char *  pattern,      //file name with one %d
+	const int     FrameIndex,   //index of the frame
+	char *	name,               //buffer
+	const size_t  size          //size of the buffer
+	){
+	if(pattern==NULL){
+		return NULL;
+	}
+	int n = snprintf(name,size,pattern,FrameIndex);
+	return n>0 && (size_t)n<size ? name : NULL;
+}
+
+
+
+//Sink writing the DOP and AOP images of every frame of a batch.
+int CameraFrameSinkImage(
+	void *	context,                   //ImageSink *
+	const int     FrameIndex,          //index of the attitude of the frame
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	){
+	(void)parm;
+	ImageSink * sink = (ImageSink *)context;
+	char DOPName[1024];
+	char AOPName[1024];
+	const char * DOPPath = FrameFileName(sink->DOPPattern,FrameIndex,DOPName,sizeof(DOPName));
+	const char * AOPPath = FrameFileName(sink->AOPPattern,FrameIndex,AOPName,sizeof(AOPName));
+	if((sink->DOPPattern!=NULL && DOPPath==NULL) || (sink->AOPPattern!=NULL && AOPPath==NULL)){
+		return -1;
+	}
+	return WriteFrame(frame,&sink->settings,sink->pool,DOPPath,AOPPath);
+}
+
+
+
+//Write the images of a frame of a mapped frame file, planes of the scalar type S.
+template <class S>
+static int WriteFileFrame(
+	const FrameFileFrame &	frame,      //header and planes of the frame
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	const char *  DOPPath,              //file name of the DOP image, NULL writes none
+	const char *  AOPPath               //file name of the AOP image, NULL writes none
+	){
+	CameraFrameOf<S> planes;
+	planes.n_x = frame.header->n_x;
+	planes.n_z = frame.header->n_z;
+	planes.PixelInterval = frame.header->PixelInterval;
+	planes.DOP = (S *)frame.DOP;
+	planes.AOP = (S *)frame.AOP;
+	planes.Owner = 0;
+	return WriteFrame(&planes,settings,NULL,DOPPath,AOPPath);
+}
+
+
+
+//Write the DOP and AOP images of every frame of a binary frame file, one frame per thread.
+int FrameFileToImages(
+	const char *  BinaryPath,           //binary frame file
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPattern,           //file name of the DOP images with one %d for the frame index, NULL writes none
+	const char *  AOPPattern            //file name of the AOP images with one %d for the frame index, NULL writes none
+	){
+	if(settings==NULL){
+		return -1;
+	}
+	FrameFileView * view = FrameFileMap(BinaryPath);
+	if(view==NULL){
+		return -1;
+	}
+
+	std::vector<int> status(view->FrameCount,0);
+	auto task = [&](int begin, int end){
+		for(int k=begin; k<end; k++){
+			FrameFileFrame frame;
+			char DOPName[1024];
+			char AOPName[1024];
+			if(FrameFileGetFrame(view,k,&frame)!=0){
+				status[k] = -1;
+				continue;
+			}
+			int index = frame.header->FrameIndex;
+			const char * DOPPath = FrameFileName(DOPPattern,index,DOPName,sizeof(DOPName));
+			const char * AOPPath = FrameFileName(AOPPattern,index,AOPName,sizeof(AOPName));
+			if((DOPPattern!=NULL && DOPPath==NULL) || (AOPPattern!=NULL && AOPPath==NULL)){
+				status[k] = -1;
+			}
+			else if(frame.header->ScalarType==FRAME_SCALAR_FLOAT){
+				status[k] = WriteFileFrame<float>(frame,settings,DOPPath,AOPPath);
+			}
+			else{
+				status[k] = WriteFileFrame<double>(frame,settings,DOPPath,AOPPath);
+			}
+		}
+	};
+	if(pool==NULL){
+		task(0,view->FrameCount);
+	}
+	else{
+		pool->ParallelFor(view->FrameCount,1,task);
+	}
+	FrameFileUnmap(view);
+
+	for(size_t k=0; k<status.size(); k++){
+		if(status[k]!=0){
+			return -1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,121 @@
+#ifndef _CAMERAIMAGE_H_
+#define _CAMERAIMAGE_H_
+
+#include <stdint.h>
+#include "PolarizationCamera.h"
+#include "CameraBatch.h"
+
+#define IMAGE_FORMAT_PNG            0       //8-bit palette PNG, the colormap is the palette
+#define IMAGE_FORMAT_PPM            1       //binary 8-bit RGB PPM (P6)
+#define IMAGE_FORMAT_TIFF16         2       //uncompressed 16-bit grayscale TIFF, the colormap range mapped to 0 to 65535
+
+#define IMAGE_ORIENTATION_MATLAB    0       //as drawn by output/ImageDarwing.m: i_x from left to right, j_z from bottom to top
+#define IMAGE_ORIENTATION_FRAME     1       //image row i and column j are the frame pixel DOP[i*n_z+j]
+
+#define IMAGE_COLORMAP_SIZE         64      //entries of a MATLAB colormap (cool, spring and jet)
+#define IMAGE_COLORMAP_MAX          255     //entries of a colormap, the last palette entry of a PNG is kept for NaN
+#define IMAGE_BAND_ROWS             32      //image rows converted and compressed by one task
+
+//lookup table from a value to a color
+typedef struct ImageColormap
+{
+	int       Size;             //entries (1 to IMAGE_COLORMAP_MAX)
+	double    Min;              //a value v takes the entry floor((v-Min)/(Max-Min)*Size), clamped to 0 to Size-1,
+	double    Max;              //like "caxis([Min,Max])" of MATLAB; NaN is white
+	uint8_t   RGB[IMAGE_COLORMAP_MAX][3];   //red, green and blue of the entries
+}
+ImageColormap;
+
+//image files of a frame
+typedef struct ImageSettings
+{
+	int       Format;           //IMAGE_FORMAT_PNG, IMAGE_FORMAT_PPM or IMAGE_FORMAT_TIFF16
+	int       Orientation;      //IMAGE_ORIENTATION_MATLAB or IMAGE_ORIENTATION_FRAME
+	ImageColormap  DOPMap;      //colormap of the DOP image
+	ImageColormap  AOPMap;      //colormap of the AOP image
+}
+ImageSettings;
+
+//context of "CameraFrameSinkImage()"
+typedef struct ImageSink
+{
+	ImageSettings  settings;    //image files of every frame
+	ThreadPool *	pool;       //thread pool of the encoder, NULL encodes on the calling thread
+	const char *  DOPPattern;   //file name of the DOP image with one %d for the frame index, e.g. "DOP_%06d.png"; NULL writes none
+	const char *  AOPPattern;   //file name of the AOP image with one %d for the frame index, e.g. "AOP_%06d.png"; NULL writes none
+}
+ImageSink;
+
+//Colormap of DOP images: [cool;spring] over [0,1].
+void ImageColormapDOP(
+	ImageColormap *	map         //colormap
+	);
+
+//Colormap of AOP images: jet over [-90,90].
+void ImageColormapAOP(
+	ImageColormap *	map         //colormap
+	);
+
+//Default settings: PNG in the orientation of output/ImageDarwing.m with its colormaps.
+void ImageSettingsDefault(
+	ImageSettings *	settings    //settings
+	);
+
+//Write a DOP or AOP plane as an image file.
+int CameraImageWritePlane(
+	const double *	plane,              //n_x*n_z values in the layout of CameraFrame
+	const int     n_x,                  //Number of simulated pixels along i_x (unit is pixel)
+	const int     n_z,                  //Number of simulated pixels along j_z (unit is pixel)
+	const ImageColormap *	map,        //colormap and range of the values
+	const ImageSettings *	settings,   //format and orientation
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  path                  //file name
+	);
+
+//Write a single precision DOP or AOP plane as an image file.
+int CameraImageWritePlane(
+	const float *	plane,              //n_x*n_z values in the layout of CameraFrame
+	const int     n_x,                  //Number of simulated pixels along i_x (unit is pixel)
+	const int     n_z,                  //Number of simulated pixels along j_z (unit is pixel)
+	const ImageColormap *	map,        //colormap and range of the values
+	const ImageSettings *	settings,   //format and orientation
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  path                  //file name
+	);
+
+//Write the DOP and AOP images of a frame.
+int CameraImageWrite(
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPath,              //file name of the DOP image, NULL writes none
+	const char *  AOPPath               //file name of the AOP image, NULL writes none
+	);
+
+//Write the DOP and AOP images of a single precision frame.
+int CameraImageWrite(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPath,              //file name of the DOP image, NULL writes none
+	const char *  AOPPath               //file name of the AOP image, NULL writes none
+	);
+
+//Sink writing the DOP and AOP images of every frame of a batch (context is an ImageSink *).
+int CameraFrameSinkImage(
+	void *	context,                   //ImageSink *
+	const int     FrameIndex,          //index of the attitude of the frame
+	const CameraFrame *	frame,         //DOP and AOP frame
+	const CameraParameters *	parm   //camera parameters and attitude of the frame
+	);
+
+//Write the DOP and AOP images of every frame of a binary frame file, one frame per thread.
+int FrameFileToImages(
+	const char *  BinaryPath,           //binary frame file
+	const ImageSettings *	settings,   //format, orientation and colormaps
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	const char *  DOPPattern,           //file name of the DOP images with one %d for the frame index, NULL writes none
+	const char *  AOPPattern            //file name of the AOP images with one %d for the frame index, NULL writes none
+	);
+
+#endif
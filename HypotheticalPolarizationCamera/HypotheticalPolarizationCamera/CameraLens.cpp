@@ -0,0 +1,328 @@
+/*
+"CameraLens" functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for the projection of wide-angle and fisheye lenses: the shooting direction of every pixel of the camera, and the pixel of a shooting direction.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Set a CameraLens with "CameraParametersSetLens()" (PolarizationCamera.h); the lens is baked into the ray table, so every simulation function uses it.
+--------------------------
+
+Model:
+	A shooting direction at the angle theta from the optical axis (the y axis of the body coordinate system) is
+	imaged at the distance rho=f*g(theta) from the principal point, in the direction of its x and z components:
+		CAMERA_PROJECTION_PINHOLE       g = tan(theta)     field of view below 180 degree
+		CAMERA_PROJECTION_EQUIDISTANT   g = theta          field of view up to 360 degree
+		CAMERA_PROJECTION_EQUISOLID     g = 2*sin(theta/2) field of view up to 360 degree
+		CAMERA_PROJECTION_STEREOGRAPHIC g = 2*tan(theta/2) field of view below 360 degree
+	The Brown-Conrady distortion of CameraLens.h then moves the ideal image point. Going from a pixel to its
+	shooting direction inverts the distortion by Newton iterations; a pixel where they do not converge, or which
+	lies outside the image circle of the projection or the field of view of the lens, sees no sky and gets a NaN
+	shooting direction (and NaN DOP and AOP). The pinhole lens without distortion gives bit for bit the shooting
+	directions of "CameraSimulation()".
+
+
+Function 1: "CameraLensDefault()" 
+
+    //Pinhole lens without distortion, the lens of "CameraSimulation()".
+	void CameraLensDefault(
+		CameraLens *	lens
+	);
+	-------------output----------------
+	CameraLens *	lens    //lens
+	-----------------------------------
+
+
+Function 2: "CameraLensPinhole()" 
+
+    //1 if the lens is the pinhole of "CameraSimulation()" (no distortion and no field of view limit), 0 if not.
+	int CameraLensPinhole(
+		const CameraLens *	lens
+	);
+	--------------input----------------
+	const CameraLens *	lens    //lens
+	-----------------------------------
+	-------------output----------------
+	int                         //1 if the row kernels of RayleighKernel.h can generate the shooting directions
+	-----------------------------------
+
+
+Function 3: "CameraLensEqual()" 
+
+    //1 if two lenses give the same shooting directions, 0 if not.
+	int CameraLensEqual(
+		const CameraLens *	a,
+		const CameraLens *	b
+	);
+	--------------input----------------
+	const CameraLens *	a,      //lens
+	const CameraLens *	b       //lens
+	-----------------------------------
+	-------------output----------------
+	int                         //1 if every member is equal
+	-----------------------------------
+
+
+Function 4: "CameraLensRay()" 
+
+    //Unit shooting direction in body coordinate system of a location on the sensor.
+	int CameraLensRay(
+		const CameraLens *	lens,
+		const double  f,
+		const double  P_x,
+		const double  P_z,
+		double  (&Ray)[3]
+	);
+	--------------input----------------
+	const CameraLens *	lens,   //lens
+	const double  f,            //Focus of the camera (unit is millimeter)
+	const double  P_x,          //location along i_x from the principal point (unit is millimeter)
+	const double  P_z           //location along j_z from the principal point (unit is millimeter)
+	-----------------------------------
+	-------------output----------------
+	double  (&Ray)[3]           //unit shooting direction, NaN if the location sees no sky
+	int                         //0, or -1 if the location sees no sky
+	-----------------------------------
+
+
+Function 5: "CameraLensProject()" 
+
+    //Location on the sensor of a shooting direction in body coordinate system.
+	int CameraLensProject(
+		const CameraLens *	lens,
+		const double  f,
+		const double  (&Ray)[3],
+		double &	P_x,
+		double &	P_z
+	);
+	--------------input----------------
+	const CameraLens *	lens,   //lens
+	const double  f,            //Focus of the camera (unit is millimeter)
+	const double  (&Ray)[3]     //shooting direction (any length)
+	-----------------------------------
+	-------------output----------------
+	double &	P_x,            //location along i_x from the principal point (unit is millimeter)
+	double &	P_z             //location along j_z from the principal point (unit is millimeter)
+	int                         //0, or -1 if the direction is outside the field of view (P_x and P_z are NaN)
+	-----------------------------------
+	It is the inverse of "CameraLensRay()"; the pixel of the location is i_x=P_x/D_x+(n_x+1)/2 (integer division).
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <limits>
+#include "CameraLens.h"
+#include "MatrixTemplate.h"
+
+const static double pi = 3.141592653589793;
+const static double NaN = std::numeric_limits<double>::quiet_NaN();
+
+
+
+//Pinhole lens without distortion, the lens of "CameraSimulation()".
+void CameraLensDefault(
+	CameraLens *	lens    //lens
+	){
+	lens->Projection = CAMERA_PROJECTION_PINHOLE;
+	lens->FieldOfView = 0.0;
+	lens->k1 = 0.0;
+	lens->k2 = 0.0;
+	lens->k3 = 0.0;
+	lens->p1 = 0.0;
+	lens->p2 = 0.0;
+}
+
+
+
+//1 if the lens is the pinhole of "CameraSimulation()" (no distortion and no field of view limit), 0 if not.
+int CameraLensPinhole(
+	const CameraLens *	lens    //lens
+	){
+	return lens->Projection==CAMERA_PROJECTION_PINHOLE && lens->FieldOfView==0.0
+		&& lens->k1==0.0 && lens->k2==0.0 && lens->k3==0.0 && lens->p1==0.0 && lens->p2==0.0;
+}
+
+
+
+//1 if two lenses give the same shooting directions, 0 if not.
+int CameraLensEqual(
+	const CameraLens *	a,      //lens
+	const CameraLens *	b       //lens
+	){
+	return a->Projection==b->Projection && a->FieldOfView==b->FieldOfView
+		&& a->k1==b->k1 && a->k2==b->k2 && a->k3==b->k3 && a->p1==b->p1 && a->p2==b->p2;
+}
+
+
+
+//Brown-Conrady distortion of an ideal image point and its Jacobian.
+static void Distort(
+	const CameraLens *	lens,   //lens
+	const double  x,            //ideal image point divided by f
+	const double  z,
+	double &	x_d,            //distorted image point divided by f
+	double &	z_d,
+	double  (&J)[2][2]          //derivatives of (x_d, z_d) by (x, z)
+	){
+	double r2 = x*x+z*z;
+	double R = 1.0+r2*(lens->k1+r2*(lens->k2+r2*lens->k3));
+	double dR = lens->k1+r2*(2.0*lens->k2+3.0*r2*lens->k3);	//dR/d(r^2)
+	x_d = x*R+2.0*lens->p1*x*z+lens->p2*(r2+2.0*x*x);
+	z_d = z*R+lens->p1*(r2+2.0*z*z)+2.0*lens->p2*x*z;
+	J[0][0] = R+2.0*x*x*dR+2.0*lens->p1*z+6.0*lens->p2*x;
+	J[0][1] = 2.0*x*z*dR+2.0*lens->p1*x+2.0*lens->p2*z;
+	J[1][0] = J[0][1];
+	J[1][1] = R+2.0*z*z*dR+6.0*lens->p1*z+2.0*lens->p2*x;
+}
+
+
+
+//Unit shooting direction in body coordinate system of a location on the sensor.
+int CameraLensRay(
+	const CameraLens *	lens,   //lens
+	const double  f,            //Focus of the camera (unit is millimeter)
+	const double  P_x,          //location along i_x from the principal point (unit is millimeter)
+	const double  P_z,          //location along j_z from the principal point (unit is millimeter)
+	double  (&Ray)[3]           //unit shooting direction, NaN outside the image circle
+	){
+	if(CameraLensPinhole(lens)){
+		//shooting direction of pixel P in body coordinate system, as in "CameraSimulation()"
+		double Vector_b_PaF[3][1] = {P_x,f,P_z};
+		double Vector_b_PaF_Norm = 0.0;
+		MatrixNorm(Vector_b_PaF,Vector_b_PaF_Norm);
+		Ray[0] = Vector_b_PaF[0][0]/Vector_b_PaF_Norm;
+		Ray[1] = Vector_b_PaF[1][0]/Vector_b_PaF_Norm;
+		Ray[2] = Vector_b_PaF[2][0]/Vector_b_PaF_Norm;
+		return 0;
+	}
+	Ray[0] = Ray[1] = Ray[2] = NaN;
+
+	//ideal image point of the projection, by Newton iterations on the distortion
+	double x_d = P_x/f;
+	double z_d = P_z/f;
+	double x = x_d;
+	double z = z_d;
+	double X, Z, J[2][2];
+	for(int k=0; k<CAMERA_LENS_ITERATIONS; k++){
+		Distort(lens,x,z,X,Z,J);
+		double det = J[0][0]*J[1][1]-J[0][1]*J[1][0];
+		if(!(fabs(det)>1e-12)){
+			return -1;
+		}
+		double dx = (J[1][1]*(X-x_d)-J[0][1]*(Z-z_d))/det;
+		double dz = (J[0][0]*(Z-z_d)-J[1][0]*(X-x_d))/det;
+		x -= dx;
+		z -= dz;
+		if(fabs(dx)+fabs(dz)<1e-15){
+			break;
+		}
+	}
+	Distort(lens,x,z,X,Z,J);
+	if(!(fabs(X-x_d)+fabs(Z-z_d)<1e-9)){
+		return -1;	//the distortion does not reach this location
+	}
+
+	//angle to the optical axis
+	double q = sqrt(x*x+z*z);
+	double theta = NaN;
+	switch(lens->Projection){
+	case CAMERA_PROJECTION_PINHOLE:       theta = atan(q); break;
+	case CAMERA_PROJECTION_EQUIDISTANT:   theta = q; break;
+	case CAMERA_PROJECTION_EQUISOLID:     theta = q<=2.0 ? 2.0*asin(0.5*q) : NaN; break;
+	case CAMERA_PROJECTION_STEREOGRAPHIC: theta = 2.0*atan(0.5*q); break;
+	}
+	if(!(theta<=pi) || (lens->FieldOfView>0.0 && theta>lens->FieldOfView*pi/360.0)){
+		return -1;
+	}
+	double s = q>0.0 ? sin(theta)/q : 1.0;
+	Ray[0] = s*x;
+	Ray[1] = cos(theta);
+	Ray[2] = s*z;
+	return 0;
+}
+
+
+
+//Location on the sensor of a shooting direction in body coordinate system.
+int CameraLensProject(
+	const CameraLens *	lens,   //lens
+	const double  f,            //Focus of the camera (unit is millimeter)
+	const double  (&Ray)[3],    //shooting direction (any length)
+	double &	P_x,            //location along i_x from the principal point (unit is millimeter)
+	double &	P_z             //location along j_z from the principal point (unit is millimeter)
+	){
+	P_x = NaN;
+	P_z = NaN;
+	double side = sqrt(Ray[0]*Ray[0]+Ray[2]*Ray[2]);
+	double theta = atan2(side,Ray[1]);
+	if(lens->FieldOfView>0.0 && theta>lens->FieldOfView*pi/360.0){
+		return -1;
+	}
+	double q = NaN;
+	switch(lens->Projection){
+	case CAMERA_PROJECTION_PINHOLE:       q = theta<pi/2 ? tan(theta) : NaN; break;
+	case CAMERA_PROJECTION_EQUIDISTANT:   q = theta; break;
+	case CAMERA_PROJECTION_EQUISOLID:     q = 2.0*sin(0.5*theta); break;
+	case CAMERA_PROJECTION_STEREOGRAPHIC: q = theta<pi ? 2.0*tan(0.5*theta) : NaN; break;
+	}
+	if(q!=q){
+		return -1;
+	}
+	double x = side>0.0 ? q*Ray[0]/side : 0.0;
+	double z = side>0.0 ? q*Ray[2]/side : 0.0;
+	double X, Z, J[2][2];
+	Distort(lens,x,z,X,Z,J);
+	P_x = f*X;
+	P_z = f*Z;
+	return 0;
+}
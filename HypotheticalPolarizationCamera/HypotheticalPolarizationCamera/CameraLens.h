@@ -0,0 +1,63 @@
+#ifndef _CAMERALENS_H_
+#define _CAMERALENS_H_
+
+//projection of the lens, rho=|image point-principal point| and theta=angle of the shooting direction to the optical axis
+#define CAMERA_PROJECTION_PINHOLE       0       //rho = f*tan(theta), the model of "CameraSimulation()"
+#define CAMERA_PROJECTION_EQUIDISTANT   1       //rho = f*theta (f-theta fisheye)
+#define CAMERA_PROJECTION_EQUISOLID     2       //rho = 2*f*sin(theta/2) (equal-area fisheye)
+#define CAMERA_PROJECTION_STEREOGRAPHIC 3       //rho = 2*f*tan(theta/2)
+
+#define CAMERA_LENS_ITERATIONS      20      //Newton iterations of the inverse distortion
+
+//lens of the camera: projection and Brown-Conrady distortion
+//The distortion moves the ideal image point (x, z)/f of the projection to
+//	x_d = x*(1+k1*r^2+k2*r^4+k3*r^6)+2*p1*x*z+p2*(r^2+2*x^2)
+//	z_d = z*(1+k1*r^2+k2*r^4+k3*r^6)+p1*(r^2+2*z^2)+2*p2*x*z,   r^2 = x^2+z^2
+//with x along i_x and z along j_z of the pixel coordinate system.
+typedef struct CameraLens
+{
+	int     Projection;     //CAMERA_PROJECTION_PINHOLE, CAMERA_PROJECTION_EQUIDISTANT, ...
+	double  FieldOfView;    //full field of view (unit is degree), pixels outside it see no sky; 0 for no limit
+	double  k1;             //radial distortion coefficients
+	double  k2;
+	double  k3;
+	double  p1;             //tangential distortion coefficients
+	double  p2;
+}
+CameraLens;
+
+//Pinhole lens without distortion, the lens of "CameraSimulation()".
+void CameraLensDefault(
+	CameraLens *	lens    //lens
+	);
+
+//1 if the lens is the pinhole of "CameraSimulation()" (no distortion and no field of view limit), 0 if not.
+int CameraLensPinhole(
+	const CameraLens *	lens    //lens
+	);
+
+//1 if two lenses give the same shooting directions, 0 if not.
+int CameraLensEqual(
+	const CameraLens *	a,      //lens
+	const CameraLens *	b       //lens
+	);
+
+//Unit shooting direction in body coordinate system of a location on the sensor.
+int CameraLensRay(
+	const CameraLens *	lens,   //lens
+	const double  f,            //Focus of the camera (unit is millimeter)
+	const double  P_x,          //location along i_x from the principal point (unit is millimeter)
+	const double  P_z,          //location along j_z from the principal point (unit is millimeter)
+	double  (&Ray)[3]           //unit shooting direction, NaN outside the image circle
+	);
+
+//Location on the sensor of a shooting direction in body coordinate system.
+int CameraLensProject(
+	const CameraLens *	lens,   //lens
+	const double  f,            //Focus of the camera (unit is millimeter)
+	const double  (&Ray)[3],    //shooting direction (any length)
+	double &	P_x,            //location along i_x from the principal point (unit is millimeter)
+	double &	P_z             //location along j_z from the principal point (unit is millimeter)
+	);
+
+#endif
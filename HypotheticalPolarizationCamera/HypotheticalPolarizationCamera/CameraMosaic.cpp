@@ -0,0 +1,459 @@
+/*
+"CameraMosaic" functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for rendering the raw output of a division-of-focal-plane polarization camera (a 2x2 mosaic of 0, 45, 90 and 135 degree polarizers) instead of DOP and AOP.
+And this code is written in C++11.
+
+Usage information:
+Fill a MosaicParameters with "MosaicParametersDefault()", change the sensor, then call "CameraSimulationMosaic()" once per frame.
+--------------------------
+
+Model:
+	Every pixel sees the sky of CameraParameters::Sky through a linear polarizer of angle theta. By Malus's law its mean signal is
+		Electrons = Signal*(1+Efficiency*(S1*cos(2*theta)+S2*sin(2*theta)))
+	with the normalized Stokes components S1=DOP*cos(2*AOP) and S2=DOP*sin(2*AOP) of "CameraSimulationStokes()",
+	evaluated in closed form from the sun vector and the shooting direction for the Rayleigh sky and with
+	"SkyModelStokes()" for the other models of SkyModel.h. The sky radiance (S0) is uniform, as the sky models
+	only describe the polarization.
+	The raw value adds Gaussian noise with the variance Electrons (shot noise, if enabled) plus ReadNoise^2, then
+		Raw = clamp(round(Electrons/Gain+Offset), 0, 2^Bits-1).
+	The Gaussian shot noise is accurate for signals above about 20 electrons.
+
+Noise generator:
+	The noise of pixel p of the frame (index i*n_z+j in the layout of CameraFrame) comes from Philox4x32-10 with the
+	key Seed and the counter {g*8+l, (g*8+l)>>32, FrameIndex, FrameIndex>>32}, where g=p/32 is the group of the pixel,
+	and l=p%8 and k=(p%32)/8 select the counter and the output word of the group. Word k is mapped to a normal
+	deviate by the inverse error function of Giles (2010) with a polynomial logarithm, all in single precision.
+	So the raw frame only depends on the parameters and the attitude: not on the thread pool, the order of the tasks
+	or the kernel type. "MosaicNoiseAVX2()" evaluates 8 counters per instruction and gives the same raw values as
+	"MosaicNoiseScalar()" (both compile without fused multiply-add).
+
+
+Function 1: "MosaicParametersDefault()" 
+
+    //Sensor of the Sony IMX250MZR type: 90/45 over 135/0 degree cells, 12 bit ADC, no black level.
+	void MosaicParametersDefault(
+		MosaicParameters *	mosaic
+	);
+	-------------output----------------
+	MosaicParameters *	mosaic  //Angle {90,45,135,0}, Signal 5000, Efficiency of the extinction ratio 300, ReadNoise 2.3,
+	                            //ShotNoise 1, Gain 2.56 (full well 10500 electrons at 12 bit), Offset 0, Bits 12,
+	                            //Seed 0 and FrameIndex 0
+	-----------------------------------
+
+
+Function 2: "CameraSimulationMosaic()" 
+
+    //Raw 2x2 polarizer mosaic of the Rayleigh sky with shot noise, read noise and ADC quantization.
+	int CameraSimulationMosaic(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		CameraParameters *	parm,
+		const MosaicParameters *	mosaic,
+		uint16_t *	Raw,
+		ThreadPool *	pool
+	);
+	--------------input----------------
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters, parm->Kernel selects the noise kernel
+	const MosaicParameters *	mosaic,  //sensor, seed and frame counter of the noise
+	ThreadPool *	pool      //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	uint16_t *	Raw           //raw value of every simulated pixel, n_x*n_z values of "CameraFrameSize()" in the layout
+	                          //of CameraFrame (PixelInterval 1 gives the full mosaic)
+	int                       //0, or -1 if Bits is outside 1 to 16 or Gain is not positive
+	-----------------------------------
+
+
+Function 3: "MosaicNoiseKernel()" 
+
+    //Noise kernel of a kernel type; every type gives the same raw values.
+	MosaicNoiseFunction MosaicNoiseKernel(
+		const int     type
+	);
+	--------------input----------------
+	const int     type          //kernel type, RAYLEIGH_KERNEL_AVX2 and RAYLEIGH_KERNEL_AVX512 use "MosaicNoiseAVX2()"
+	-----------------------------------
+	-------------output----------------
+	MosaicNoiseFunction         //"MosaicNoiseAVX2()" or "MosaicNoiseScalar()"
+	-----------------------------------
+
+
+Function 4: "MosaicPhilox()" 
+
+    //Philox4x32-10 counter-based random numbers (Salmon et al., SC 2011).
+	void MosaicPhilox(
+		const uint32_t  (&counter)[4],
+		const uint32_t  (&key)[2],
+		uint32_t  (&random)[4]
+	);
+	--------------input----------------
+	const uint32_t  (&counter)[4],  //counter
+	const uint32_t  (&key)[2]       //key
+	-----------------------------------
+	-------------output----------------
+	uint32_t  (&random)[4]          //four random words, {0x6627e8d5,0xe169c58d,0xbc57ac4c,0x9b00dbd8} for zero counter and key
+	-----------------------------------
+
+
+Function 5: "MosaicNoiseScalar()" 
+
+    //Raw values of pixels from their noise-free signal.
+	void MosaicNoiseScalar(
+		const MosaicNoiseBlock *	block
+	);
+	--------------input----------------
+	const MosaicNoiseBlock *	block  //sensor, first pixel (a multiple of MOSAIC_GROUP_SIZE), count and signal
+	-----------------------------------
+	-------------output----------------
+	block->Raw                         //raw values of block->count pixels
+	-----------------------------------
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <string.h>
+#include "CameraMosaic.h"
+#include "ThreadPool.h"
+
+const static double pi = 3.141592653589793;
+
+//Philox4x32 multipliers and key increments
+#define PHILOX_M0                   0xD2511F53u
+#define PHILOX_M1                   0xCD9E8D57u
+#define PHILOX_W0                   0x9E3779B9u
+#define PHILOX_W1                   0xBB67AE85u
+
+
+
+//Sensor of the Sony IMX250MZR type: 90/45 over 135/0 degree cells, 12 bit ADC, no black level.
+void MosaicParametersDefault(
+	MosaicParameters *	mosaic  //sensor
+	){
+	mosaic->Angle[0] = 90.0;
+	mosaic->Angle[1] = 45.0;
+	mosaic->Angle[2] = 135.0;
+	mosaic->Angle[3] = 0.0;
+	mosaic->Signal = 5000.0;
+	mosaic->Efficiency = (300.0-1.0)/(300.0+1.0);
+	mosaic->ReadNoise = 2.3;
+	mosaic->ShotNoise = 1;
+	mosaic->Gain = 10500.0/4096.0;
+	mosaic->Offset = 0.0;
+	mosaic->Bits = 12;
+	mosaic->Seed = 0;
+	mosaic->FrameIndex = 0;
+}
+
+
+
+//Philox4x32-10 counter-based random numbers (Salmon et al., SC 2011).
+void MosaicPhilox(
+	const uint32_t  (&counter)[4],  //counter
+	const uint32_t  (&key)[2],      //key
+	uint32_t  (&random)[4]          //four random words
+	){
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for(int r=0; r<10; r++){
+		uint64_t p0 = (uint64_t)PHILOX_M0*c0;
+		uint64_t p1 = (uint64_t)PHILOX_M1*c2;
+		c0 = (uint32_t)(p1>>32)^c1^k0;
+		c1 = (uint32_t)p1;
+		c2 = (uint32_t)(p0>>32)^c3^k1;
+		c3 = (uint32_t)p0;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+	random[0] = c0;
+	random[1] = c1;
+	random[2] = c2;
+	random[3] = c3;
+}
+
+
+
+//Standard normal deviate of a random word: sqrt(2)*erfinv(x) of Giles (2010) with x uniform in (-1,1).
+//"MosaicNoiseAVX2()" repeats every operation in the same order.
+static float Normal(
+	const uint32_t  u   //random word
+	){
+	float x = (float)(int32_t)(2*(u>>9)+1)*(1.0f/8388608.0f)-1.0f;
+
+	//w=-log((1-x)*(1+x)) with a=m*2^e, sqrt(1/2)<=m<sqrt(2) and log(m)=2*atanh((m-1)/(m+1))
+	float a = (1.0f-x)*(1.0f+x);
+	int32_t bits;
+	memcpy(&bits,&a,sizeof(bits));
+	int32_t e = ((bits>>23)&0xff)-127;
+	bits = (bits&0x007fffff)|0x3f800000;
+	float m;
+	memcpy(&m,&bits,sizeof(m));
+	if(m>1.41421356f){
+		m = m*0.5f;
+		e = e+1;
+	}
+	float t = (m-1.0f)/(m+1.0f);
+	float t2 = t*t;
+	float s = 1.0f/9.0f;
+	s = s*t2+1.0f/7.0f;
+	s = s*t2+1.0f/5.0f;
+	s = s*t2+1.0f/3.0f;
+	s = s*t2+1.0f;
+	float w = -((2.0f*t)*s+(float)e*0.693147181f);
+
+	float p;
+	if(w<5.0f){
+		w = w-2.5f;
+		p = 2.81022636e-08f;
+		p = 3.43273939e-07f+p*w;
+		p = -3.5233877e-06f+p*w;
+		p = -4.39150654e-06f+p*w;
+		p = 0.00021858087f+p*w;
+		p = -0.00125372503f+p*w;
+		p = -0.00417768164f+p*w;
+		p = 0.246640727f+p*w;
+		p = 1.50140941f+p*w;
+	}
+	else{
+		w = sqrtf(w)-3.0f;
+		p = -0.000200214257f;
+		p = 0.000100950558f+p*w;
+		p = 0.00134934322f+p*w;
+		p = -0.00367342844f+p*w;
+		p = 0.00573950773f+p*w;
+		p = -0.0076224613f+p*w;
+		p = 0.00943887047f+p*w;
+		p = 1.00167406f+p*w;
+		p = 2.83297682f+p*w;
+	}
+	return 1.41421356f*(p*x);
+}
+
+
+
+//Raw values of pixels from their noise-free signal.
+void MosaicNoiseScalar(
+	const MosaicNoiseBlock *	block  //sensor, pixels and signal
+	){
+	const MosaicParameters * mosaic = block->mosaic;
+	const float shot = mosaic->ShotNoise ? 1.0f : 0.0f;
+	const float read = (float)(mosaic->ReadNoise*mosaic->ReadNoise);
+	const float InvGain = (float)(1.0/mosaic->Gain);
+	const float Offset = (float)mosaic->Offset;
+	const float Max = (float)((1<<mosaic->Bits)-1);
+	const bool noise = mosaic->ShotNoise || mosaic->ReadNoise>0.0;
+	const uint32_t key[2] = {(uint32_t)mosaic->Seed,(uint32_t)(mosaic->Seed>>32)};
+
+	for(int first=0; first<block->count; first+=MOSAIC_GROUP_SIZE){
+		uint32_t random[MOSAIC_GROUP_SIZE];
+		if(noise){
+			//word k of counter l of the group belongs to pixel 8*k+l
+			uint64_t group = (block->First+first)/MOSAIC_GROUP_SIZE;
+			for(int l=0; l<8; l++){
+				uint64_t c = group*8+l;
+				const uint32_t counter[4] = {(uint32_t)c,(uint32_t)(c>>32),(uint32_t)mosaic->FrameIndex,(uint32_t)(mosaic->FrameIndex>>32)};
+				uint32_t words[4];
+				MosaicPhilox(counter,key,words);
+				for(int k=0; k<4; k++){
+					random[8*k+l] = words[k];
+				}
+			}
+		}
+		int n = block->count-first<MOSAIC_GROUP_SIZE ? block->count-first : MOSAIC_GROUP_SIZE;
+		for(int q=0; q<n; q++){
+			float e = block->Electrons[first+q];
+			if(noise){
+				float variance = e*shot+read;
+				variance = variance>0.0f ? variance : 0.0f;
+				e = e+sqrtf(variance)*Normal(random[q]);
+			}
+			float dn = floorf((e*InvGain+Offset)+0.5f);
+			dn = dn>0.0f ? dn : 0.0f;
+			dn = dn<Max ? dn : Max;
+			block->Raw[first+q] = (uint16_t)(int32_t)dn;
+		}
+	}
+}
+
+
+
+//Noise kernel of a kernel type; every type gives the same raw values.
+MosaicNoiseFunction MosaicNoiseKernel(
+	const int     type          //kernel type
+	){
+	switch(RayleighKernelResolve(type)){
+#ifdef RAYLEIGH_KERNEL_X86
+	case RAYLEIGH_KERNEL_AVX2:
+	case RAYLEIGH_KERNEL_AVX512: return MosaicNoiseAVX2;
+#endif
+	}
+	return MosaicNoiseScalar;
+}
+
+
+
+//Noise-free signal of the pixels [first,first+count) of a frame by Malus's law.
+static void MosaicElectrons(
+	const CameraParameters *	parm,  //camera parameters
+	const MosaicParameters *	mosaic,//sensor
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const int     n_z,                 //number of simulated pixels along j_z
+	const uint64_t  first,             //frame index of the first pixel
+	const int     count,               //number of pixels
+	float *	Electrons                  //signal of the pixels (unit is electron)
+	){
+	double Cos2[4],Sin2[4];
+	for(int k=0; k<4; k++){
+		Cos2[k] = cos(2.0*mosaic->Angle[k]*pi/180.0);
+		Sin2[k] = sin(2.0*mosaic->Angle[k]*pi/180.0);
+	}
+	int i = (int)(first/n_z);
+	int j = (int)(first%n_z);
+	const double Sun[3] = {C_vTb[0][2],C_vTb[1][2],C_vTb[2][2]};	//third column of C_vTb
+	bool pinhole = CameraLensPinhole(&parm->Lens)!=0;
+	bool rayleigh = parm->Sky.Model==SKY_MODEL_RAYLEIGH;
+	for(int q=0; q<count; q++){
+		int i_x = 1+i*parm->PixelInterval;
+		int j_z = 1+j*parm->PixelInterval;
+		int cell = 2*((j_z-1)&1)+((i_x-1)&1);
+
+		//closed-form Stokes components of the shooting direction, see "CameraSimulationStokes()"
+		double r_x = parm->D_x*(i_x-(parm->n_x+1)/2);
+		double r_y = parm->f;
+		double r_z = parm->D_z*(j_z-(parm->n_z+1)/2);
+		bool sky = true;
+		if(!pinhole){
+			double Ray[3];
+			sky = CameraPixelRay(parm,i_x,j_z,Ray)==0;
+			r_x = Ray[0];
+			r_y = Ray[1];
+			r_z = Ray[2];
+		}
+		double S1 = 0.0, S2 = 0.0;	//the ray is undefined outside the image circle
+		if(sky && rayleigh){
+			double c = (Sun[0]*r_x+Sun[1]*r_y+Sun[2]*r_z)/sqrt(r_x*r_x+r_y*r_y+r_z*r_z);
+			double DOP = parm->Sky.DOP_max*(1.0-c*c)/(1.0+c*c);
+			double E_x = Sun[1]*r_z-Sun[2]*r_y;
+			double E_z = Sun[0]*r_y-Sun[1]*r_x;
+			double Q = E_x*E_x+E_z*E_z;
+			S1 = Q>0.0 ? DOP*(E_z*E_z-E_x*E_x)/Q : 0.0;
+			S2 = Q>0.0 ? DOP*2.0*E_x*E_z/Q : 0.0;
+		}
+		else if(sky){
+			double Ray[3] = {r_x,r_y,r_z};
+			SkyModelStokes(&parm->Sky,C_vTb,C_bTv,Ray,S1,S2);
+		}
+		Electrons[q] = sky ? (float)(mosaic->Signal*(1.0+mosaic->Efficiency*(S1*Cos2[cell]+S2*Sin2[cell]))) : 0.0f;	//no light outside the image circle
+
+		if(++j==n_z){
+			j = 0;
+			i++;
+		}
+	}
+}
+
+
+
+//Raw 2x2 polarizer mosaic of the Rayleigh sky with shot noise, read noise and ADC quantization.
+int CameraSimulationMosaic(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const MosaicParameters *	mosaic,  //sensor
+	uint16_t *	Raw,          //raw value of every simulated pixel
+	ThreadPool *	pool      //thread pool, NULL runs on the calling thread
+	){
+	if(mosaic->Bits<1 || mosaic->Bits>16 || !(mosaic->Gain>0.0)){
+		return -1;
+	}
+	parm->psa = psa;
+	parm->afa = afa;
+	parm->beta = beta;
+	double C_vTb[3][3];
+	double C_bTv[3][3];
+	CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+
+	int n_x,n_z;
+	CameraFrameSize(parm,n_x,n_z);
+	const uint64_t PixelNum = (uint64_t)n_x*n_z;
+	const int chunks = (int)((PixelNum+MOSAIC_CHUNK_SIZE-1)/MOSAIC_CHUNK_SIZE);
+	MosaicNoiseFunction NoiseKernel = MosaicNoiseKernel(parm->Kernel);
+	auto task = [&](int begin, int end){
+		float Electrons[MOSAIC_CHUNK_SIZE];
+		for(int k=begin; k<end; k++){
+			uint64_t first = (uint64_t)k*MOSAIC_CHUNK_SIZE;
+			int count = PixelNum-first<MOSAIC_CHUNK_SIZE ? (int)(PixelNum-first) : MOSAIC_CHUNK_SIZE;
+			MosaicElectrons(parm,mosaic,C_vTb,C_bTv,n_z,first,count,Electrons);
+			MosaicNoiseBlock block;
+			block.mosaic = mosaic;
+			block.First = first;
+			block.count = count;
+			block.Electrons = Electrons;
+			block.Raw = Raw+first;
+			NoiseKernel(&block);
+		}
+	};
+	if(pool==NULL){
+		task(0,chunks);
+	}
+	else{
+		pool->ParallelFor(chunks,1,task);
+	}
+	return 0;
+}
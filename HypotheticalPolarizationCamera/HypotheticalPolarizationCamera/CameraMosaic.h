@@ -0,0 +1,77 @@
+#ifndef _CAMERAMOSAIC_H_
+#define _CAMERAMOSAIC_H_
+
+#include <stdint.h>
+#include "PolarizationCamera.h"
+#include "RayleighKernel.h"
+
+#define MOSAIC_GROUP_SIZE           32      //pixels of one Philox counter group (8 counters of 4 words)
+#define MOSAIC_CHUNK_SIZE           4096    //pixels per task of the thread pool, a multiple of MOSAIC_GROUP_SIZE
+
+//division-of-focal-plane polarization sensor
+typedef struct MosaicParameters
+{
+	double  Angle[4];       //polarizer angles of the 2x2 cell (unit is degree, measured like AOP from the j_z axis towards i_x)
+	                        //pixel (i_x, j_z) is behind Angle[2*((j_z-1)%2)+(i_x-1)%2]
+	double  Signal;         //mean photo-electrons of a pixel for unpolarized sky light (unit is electron)
+	double  Efficiency;     //diattenuation of the polarizers, (ER-1)/(ER+1) for the extinction ratio ER, 1 if ideal
+	double  ReadNoise;      //RMS read noise (unit is electron), 0 for none
+	int     ShotNoise;      //1 adds photon shot noise (Gaussian with the variance of the signal), 0 for none
+	double  Gain;           //conversion gain (unit is electron per digital number)
+	double  Offset;         //black level (unit is digital number)
+	int     Bits;           //ADC resolution, raw values are rounded and clamped to [0,2^Bits-1] (1 to 16)
+
+	uint64_t  Seed;         //key of the noise generator
+	uint64_t  FrameIndex;   //counter of the noise generator, a different value per frame gives independent noise
+}
+MosaicParameters;
+
+//pixels of a frame for a noise kernel
+typedef struct MosaicNoiseBlock
+{
+	const MosaicParameters *	mosaic;  //sensor
+
+	uint64_t  First;        //frame index of the first pixel, a multiple of MOSAIC_GROUP_SIZE
+	int       count;        //number of pixels
+	const float *	Electrons;  //noise-free signal of the pixels (unit is electron)
+	uint16_t *	Raw;        //raw values of the pixels (unit is digital number)
+}
+MosaicNoiseBlock;
+
+typedef void (*MosaicNoiseFunction)(const MosaicNoiseBlock * block);
+
+//Sensor of the Sony IMX250MZR type: 90/45 over 135/0 degree cells, 12 bit ADC, no black level.
+void MosaicParametersDefault(
+	MosaicParameters *	mosaic  //sensor
+	);
+
+//Raw 2x2 polarizer mosaic of the Rayleigh sky with shot noise, read noise and ADC quantization.
+int CameraSimulationMosaic(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const MosaicParameters *	mosaic,  //sensor
+	uint16_t *	Raw,          //raw value of every simulated pixel, in the layout of CameraFrame
+	ThreadPool *	pool      //thread pool, NULL runs on the calling thread
+	);
+
+//Noise kernel of a kernel type; every type gives the same raw values.
+MosaicNoiseFunction MosaicNoiseKernel(
+	const int     type          //kernel type (see RayleighKernel.h)
+	);
+
+//Philox4x32-10 counter-based random numbers (Salmon et al., SC 2011).
+void MosaicPhilox(
+	const uint32_t  (&counter)[4],  //counter
+	const uint32_t  (&key)[2],      //key
+	uint32_t  (&random)[4]          //four random words
+	);
+
+//scalar and vectorized noise kernels
+void MosaicNoiseScalar(const MosaicNoiseBlock * block);
+#ifdef RAYLEIGH_KERNEL_X86
+void MosaicNoiseAVX2(const MosaicNoiseBlock * block);
+#endif
+
+#endif
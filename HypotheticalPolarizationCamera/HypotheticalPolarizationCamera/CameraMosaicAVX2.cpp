@@ -0,0 +1,238 @@
+/*
+AVX2 noise kernel of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for generating the mosaic noise for 8 Philox counters (32 pixels) per AVX2 instruction.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Using the code through "MosaicNoiseKernel()", which only returns it when the processor supports AVX2.
+--------------------------
+
+Function 1: "MosaicNoiseAVX2()" 
+
+    //Raw values of pixels from their noise-free signal, the same values as "MosaicNoiseScalar()".
+	void MosaicNoiseAVX2(
+		const MosaicNoiseBlock *	block
+	);
+	--------------input----------------
+	const MosaicNoiseBlock *	block  //sensor, first pixel (a multiple of MOSAIC_GROUP_SIZE), count and signal
+	-----------------------------------
+	-------------output----------------
+	block->Raw                         //raw values of block->count pixels
+	-----------------------------------
+
+--------------------------
+========================================================================== 
+*/
+#include "CameraMosaic.h"
+#ifdef RAYLEIGH_KERNEL_X86
+#include <immintrin.h>
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx2")
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace {
+
+//High and low 32 bits of the products of 8 words with a multiplier.
+inline void MulHiLo(
+	__m256i  a,         //8 words
+	__m256i  m,         //multiplier in every word
+	__m256i &	hi,     //high words of the products
+	__m256i &	lo      //low words of the products
+	){
+	__m256i even = _mm256_mul_epu32(a,m);
+	__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a,32),m);
+	lo = _mm256_blend_epi32(even,_mm256_slli_epi64(odd,32),0xAA);
+	hi = _mm256_blend_epi32(_mm256_srli_epi64(even,32),odd,0xAA);
+}
+
+
+
+//Standard normal deviates of 8 random words, the operations of "Normal()" in "CameraMosaic.cpp".
+inline __m256 Normal(
+	__m256i  u          //random words
+	){
+	const __m256 one = _mm256_set1_ps(1.0f);
+	__m256i odd = _mm256_or_si256(_mm256_slli_epi32(_mm256_srli_epi32(u,9),1),_mm256_set1_epi32(1));
+	__m256 x = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(odd),_mm256_set1_ps(1.0f/8388608.0f)),one);
+
+	//w=-log((1-x)*(1+x))
+	__m256 a = _mm256_mul_ps(_mm256_sub_ps(one,x),_mm256_add_ps(one,x));
+	__m256i bits = _mm256_castps_si256(a);
+	__m256i e = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits,23),_mm256_set1_epi32(0xff)),_mm256_set1_epi32(127));
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits,_mm256_set1_epi32(0x007fffff)),_mm256_set1_epi32(0x3f800000)));
+	__m256 large = _mm256_cmp_ps(m,_mm256_set1_ps(1.41421356f),_CMP_GT_OQ);
+	m = _mm256_blendv_ps(m,_mm256_mul_ps(m,_mm256_set1_ps(0.5f)),large);
+	e = _mm256_sub_epi32(e,_mm256_castps_si256(large));	//the mask is -1
+	__m256 t = _mm256_div_ps(_mm256_sub_ps(m,one),_mm256_add_ps(m,one));
+	__m256 t2 = _mm256_mul_ps(t,t);
+	__m256 s = _mm256_set1_ps(1.0f/9.0f);
+	s = _mm256_add_ps(_mm256_mul_ps(s,t2),_mm256_set1_ps(1.0f/7.0f));
+	s = _mm256_add_ps(_mm256_mul_ps(s,t2),_mm256_set1_ps(1.0f/5.0f));
+	s = _mm256_add_ps(_mm256_mul_ps(s,t2),_mm256_set1_ps(1.0f/3.0f));
+	s = _mm256_add_ps(_mm256_mul_ps(s,t2),one);
+	__m256 log = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(2.0f),t),s),
+		_mm256_mul_ps(_mm256_cvtepi32_ps(e),_mm256_set1_ps(0.693147181f)));
+	__m256 w = _mm256_sub_ps(_mm256_setzero_ps(),log);
+
+	//both branches of the inverse error function
+	__m256 central = _mm256_cmp_ps(w,_mm256_set1_ps(5.0f),_CMP_LT_OQ);
+	__m256 v = _mm256_sub_ps(w,_mm256_set1_ps(2.5f));
+	__m256 p = _mm256_set1_ps(2.81022636e-08f);
+	p = _mm256_add_ps(_mm256_set1_ps(3.43273939e-07f),_mm256_mul_ps(p,v));
+	p = _mm256_add_ps(_mm256_set1_ps(-3.5233877e-06f),_mm256_mul_ps(p,v));
+	p = _mm256_add_ps(_mm256_set1_ps(-4.39150654e-06f),_mm256_mul_ps(p,v));
+	p = _mm256_add_ps(_mm256_set1_ps(0.00021858087f),_mm256_mul_ps(p,v));
+	p = _mm256_add_ps(_mm256_set1_ps(-0.00125372503f),_mm256_mul_ps(p,v));
+	p = _mm256_add_ps(_mm256_set1_ps(-0.00417768164f),_mm256_mul_ps(p,v));
+	p = _mm256_add_ps(_mm256_set1_ps(0.246640727f),_mm256_mul_ps(p,v));
+	p = _mm256_add_ps(_mm256_set1_ps(1.50140941f),_mm256_mul_ps(p,v));
+	__m256 r = _mm256_sub_ps(_mm256_sqrt_ps(w),_mm256_set1_ps(3.0f));
+	__m256 q = _mm256_set1_ps(-0.000200214257f);
+	q = _mm256_add_ps(_mm256_set1_ps(0.000100950558f),_mm256_mul_ps(q,r));
+	q = _mm256_add_ps(_mm256_set1_ps(0.00134934322f),_mm256_mul_ps(q,r));
+	q = _mm256_add_ps(_mm256_set1_ps(-0.00367342844f),_mm256_mul_ps(q,r));
+	q = _mm256_add_ps(_mm256_set1_ps(0.00573950773f),_mm256_mul_ps(q,r));
+	q = _mm256_add_ps(_mm256_set1_ps(-0.0076224613f),_mm256_mul_ps(q,r));
+	q = _mm256_add_ps(_mm256_set1_ps(0.00943887047f),_mm256_mul_ps(q,r));
+	q = _mm256_add_ps(_mm256_set1_ps(1.00167406f),_mm256_mul_ps(q,r));
+	q = _mm256_add_ps(_mm256_set1_ps(2.83297682f),_mm256_mul_ps(q,r));
+	p = _mm256_blendv_ps(q,p,central);
+	return _mm256_mul_ps(_mm256_set1_ps(1.41421356f),_mm256_mul_ps(p,x));
+}
+
+}
+
+
+
+//Raw values of pixels from their noise-free signal, the same values as "MosaicNoiseScalar()".
+void MosaicNoiseAVX2(
+	const MosaicNoiseBlock *	block  //sensor, pixels and signal
+	){
+	const MosaicParameters * mosaic = block->mosaic;
+	const bool noise = mosaic->ShotNoise || mosaic->ReadNoise>0.0;
+	const __m256 shot = _mm256_set1_ps(mosaic->ShotNoise ? 1.0f : 0.0f);
+	const __m256 read = _mm256_set1_ps((float)(mosaic->ReadNoise*mosaic->ReadNoise));
+	const __m256 InvGain = _mm256_set1_ps((float)(1.0/mosaic->Gain));
+	const __m256 Offset = _mm256_set1_ps((float)mosaic->Offset);
+	const __m256 Max = _mm256_set1_ps((float)((1<<mosaic->Bits)-1));
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256i M0 = _mm256_set1_epi32((int)0xD2511F53u);
+	const __m256i M1 = _mm256_set1_epi32((int)0xCD9E8D57u);
+	const __m256i FrameLow = _mm256_set1_epi32((int)(uint32_t)mosaic->FrameIndex);
+	const __m256i FrameHigh = _mm256_set1_epi32((int)(uint32_t)(mosaic->FrameIndex>>32));
+
+	int full = block->count-block->count%MOSAIC_GROUP_SIZE;
+	for(int first=0; first<full; first+=MOSAIC_GROUP_SIZE){
+		__m256i random[4];
+		if(noise){
+			//counters group*8+l of the 8 lanes
+			uint64_t c = (block->First+first)/MOSAIC_GROUP_SIZE*8;
+			__m256i c0 = _mm256_add_epi32(_mm256_set1_epi32((int)(uint32_t)c),_mm256_set_epi32(7,6,5,4,3,2,1,0));
+			__m256i c1 = _mm256_set1_epi32((int)(uint32_t)(c>>32));
+			__m256i c2 = FrameLow;
+			__m256i c3 = FrameHigh;
+			uint32_t k0 = (uint32_t)mosaic->Seed;
+			uint32_t k1 = (uint32_t)(mosaic->Seed>>32);
+			for(int r=0; r<10; r++){
+				__m256i hi0,lo0,hi1,lo1;
+				MulHiLo(c0,M0,hi0,lo0);
+				MulHiLo(c2,M1,hi1,lo1);
+				c0 = _mm256_xor_si256(_mm256_xor_si256(hi1,c1),_mm256_set1_epi32((int)k0));
+				c1 = lo1;
+				c2 = _mm256_xor_si256(_mm256_xor_si256(hi0,c3),_mm256_set1_epi32((int)k1));
+				c3 = lo0;
+				k0 += 0x9E3779B9u;
+				k1 += 0xBB67AE85u;
+			}
+			random[0] = c0;
+			random[1] = c1;
+			random[2] = c2;
+			random[3] = c3;
+		}
+
+		//word k of the 8 counters belongs to pixels 8*k to 8*k+7 of the group
+		for(int k=0; k<4; k++){
+			__m256 e = _mm256_loadu_ps(block->Electrons+first+8*k);
+			if(noise){
+				__m256 variance = _mm256_add_ps(_mm256_mul_ps(e,shot),read);
+				variance = _mm256_max_ps(variance,_mm256_setzero_ps());
+				e = _mm256_add_ps(e,_mm256_mul_ps(_mm256_sqrt_ps(variance),Normal(random[k])));
+			}
+			__m256 dn = _mm256_floor_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e,InvGain),Offset),half));
+			dn = _mm256_min_ps(_mm256_max_ps(dn,_mm256_setzero_ps()),Max);
+			__m256i v = _mm256_cvttps_epi32(dn);
+			__m128i raw = _mm_packus_epi32(_mm256_castsi256_si128(v),_mm256_extracti128_si256(v,1));
+			_mm_storeu_si128((__m128i *)(block->Raw+first+8*k),raw);
+		}
+	}
+
+	//last partial group
+	if(full<block->count){
+		MosaicNoiseBlock tail = *block;
+		tail.First = block->First+full;
+		tail.count = block->count-full;
+		tail.Electrons = block->Electrons+full;
+		tail.Raw = block->Raw+full;
+		MosaicNoiseScalar(&tail);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,867 @@
+/*
+Fused frame statistics of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for gathering DOP histograms, AOP moments, the pixels near the solar meridian and the band of maximum DOP while the frame is simulated, without holding or writing the frame.
+And this code is written in C++11.
+
+Usage information:
+Fill ReduceSettings, then call "CameraSimulationReduce()" once per attitude. Other aggregates take a CameraReducer
+and "CameraSimulationReduceWith()".
+--------------------------
+
+Reduction:
+	A job that only needs aggregates of a frame does not have to write its pixels and reduce them elsewhere. The
+	frame is cut into blocks of at most REDUCE_BLOCK_PIXELS pixels (whole rows where they fit). A thread simulates a
+	block into its own buffer with "CameraSimulationBlock()", the kernels and ray table of the full frame, and
+	reduces it while it is still in the cache. The memory of a reduction does not grow with the size of the sensor,
+	and nothing is written. The camera parameters of "CameraParametersInit()"
+	hold a ray table of 24 bytes per pixel as well; "CameraParametersInitNoTable()" leaves it out.
+	The statistics are one reducer ("CameraReducer") of "CameraSimulationReduceWith()", which takes any other
+	reducer as well. A reducer keeps a partial state per block of a round of REDUCE_ROUND_BLOCKS blocks: a thread
+	clears the state of a block and accumulates the block into it, and after the round the states are merged into
+	the state of the frame on the calling thread in the order of the blocks. The memory is the two blocks of every
+	thread, the partial states of a round and the state of the frame, and since the floating point sums of every
+	reducer are added in the same order, its result is bit for bit the same on 1 or 64 threads and equal to
+	"CameraFrameReduceWith()" of the simulated frame. Partial states per block rather than per thread cost a clear
+	and a merge per block, little against the simulation of its 8192 pixels.
+	The statistics of ReduceSettings count valid pixels, the histogram, the meridian and band pixels, the
+	coordinate sums of the band and the peak with its frame index, sum DOP and AOP and their squares, and append the
+	meridian pixels of a block in frame order up to MeridianCapacity.
+
+	Pixels with a NaN DOP or AOP (outside the field of view of a lens) only count in Pixels. AOP is in (-90,90]
+	degrees like the frames, so its plain mean and standard deviation are those of the numbers; near the meridian,
+	where AOP jumps between 90 and -90, AOPAxialMean and AOPAxialLength describe the direction of polarization
+	instead. They take a sine and cosine per pixel (a polynomial, still about as much as the other statistics
+	together), so they are only gathered with ReduceSettings::Axial. The variance is (sum of squares -
+	sum*mean)/(n-1) like "CameraSimulationMonteCarlo()".
+
+
+Function 1: "ReduceSettingsDefault()" 
+
+    //Default settings.
+	void ReduceSettingsDefault(
+		ReduceSettings *	settings
+	);
+	-------------output----------------
+	ReduceSettings *	settings    //100 DOP bins over [0,1], pixels within 1 degree of the meridian counted but not
+	                                //stored, band of DOP>=0.9, no axial AOP statistics
+	-----------------------------------
+
+
+Function 2: "CameraSimulationReduce()" 
+
+    //Statistics of the frame of an attitude without holding the frame.
+	int CameraSimulationReduce(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		const CameraParameters *	parm,
+		const ReduceSettings *	settings,
+		ThreadPool *	pool,
+		ReduceResult *	result
+	);
+	--------------input----------------
+	const double  psa,              //yaw angle (unit is radian)
+	const double  afa,              //pitch angle (unit is radian)
+    const double  beta,             //roll angle (unit is radian)
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	ReduceResult *	result              //statistics, the same for every size of the pool
+	int                                 //0, or -1 if the settings are invalid or memory runs out
+	-----------------------------------
+
+
+Function 3: "CameraFrameReduce()" 
+
+    //Statistics of a simulated frame in double or single precision.
+	int CameraFrameReduce(
+		const CameraFrame *	frame,
+		const ReduceSettings *	settings,
+		ThreadPool *	pool,
+		ReduceResult *	result
+	);
+	--------------input----------------
+	const CameraFrame *	frame,          //DOP and AOP frame (or CameraFrameFloat)
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	ReduceResult *	result              //statistics, in the blocks and order of "CameraSimulationReduce()"
+	int                                 //0, or -1 if the settings are invalid or memory runs out
+	-----------------------------------
+	For frames read back from a binary frame file ("FrameFileOpen()") or simulated for other uses as well.
+
+
+Function 4: "ReduceWriteJson()" 
+
+    //Write the statistics of a frame as JSON.
+	int ReduceWriteJson(
+		const ReduceResult *	result,
+		const int     Histogram,
+		FILE *	file
+	);
+	--------------input----------------
+	const ReduceResult *	result,     //statistics
+	const int     Histogram,            //1 writes the histogram too
+	FILE *	file                        //opened file
+	-----------------------------------
+	-------------output----------------
+	int                                 //0, or -1 if writing failed
+	-----------------------------------
+	Statistics that are NaN (no valid pixels, no pixels in the band, the axial mean without ReduceSettings::Axial)
+	are written as null ("CameraStatsWriteNumber()").
+
+Function 5: "CameraSimulationReduceWith()" 
+
+    //Reduce the frame of an attitude with a reducer without holding the frame.
+	int CameraSimulationReduceWith(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		const CameraParameters *	parm,
+		const CameraReducer *	reducer,
+		ThreadPool *	pool,
+		void *	state
+	);
+	--------------input----------------
+	const double  psa,              //yaw angle (unit is radian)
+	const double  afa,              //pitch angle (unit is radian)
+    const double  beta,             //roll angle (unit is radian)
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const CameraReducer *	reducer,    //reducer
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	void *	state                       //state of the frame made by reducer->Create, cleared and then merged with
+	                                    //every block in frame order, the same for every size of the pool
+	int                                 //0, or -1 if the reducer lacks a function or memory runs out
+	-----------------------------------
+	reducer->Create is called once per block of a round (at most REDUCE_ROUND_BLOCKS times), reducer->Accumulate
+	on the threads of the pool, and reducer->Clear, Merge and Free on the calling thread except for the clear of a
+	block before it is accumulated.
+
+
+Function 6: "CameraFrameReduceWith()" 
+
+    //Reduce a simulated frame in double or single precision with a reducer.
+	int CameraFrameReduceWith(
+		const CameraFrame *	frame,
+		const CameraReducer *	reducer,
+		ThreadPool *	pool,
+		void *	state
+	);
+	--------------input----------------
+	const CameraFrame *	frame,          //DOP and AOP frame (or CameraFrameFloat, whose blocks are widened to double)
+	const CameraReducer *	reducer,    //reducer
+	ThreadPool *	pool                //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	void *	state                       //state of the frame made by reducer->Create, in the blocks and order of
+	                                    //"CameraSimulationReduceWith()"
+	int                                 //0, or -1 if the reducer lacks a function or memory runs out
+	-----------------------------------
+
+Example:
+
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	CameraPixel meridian[4096];
+	ReduceSettings settings;
+	ReduceSettingsDefault(&settings);
+	settings.Meridian = meridian;
+	settings.MeridianCapacity = 4096;
+	ReduceResult * result = ALLOC(ReduceResult);
+	ThreadPool pool(0);
+	CameraSimulationReduce(78.9*pi/180.0,-65.2*pi/180.0,278.3*pi/180.0,parm,&settings,&pool,result);
+	ReduceWriteJson(result,1,stdout);	//a few kilobytes instead of the 1310720 lines of HypotheticalImages.txt
+
+	//a reducer of its own: pixels with DOP of 0.5 and above
+	static void * CountCreate(void * context){ return calloc(1,sizeof(int64_t)); }
+	static void CountClear(void * context, void * state){ *(int64_t *)state = 0; }
+	static void CountAccumulate(void * context, void * state, const CameraBlock * block, const double * DOP,
+		const double * AOP, const size_t pitch){
+		for(int i=0; i<block->n_x; i++) for(int j=0; j<block->n_z; j++) *(int64_t *)state += DOP[i*pitch+j]>=0.5;
+	}
+	static void CountMerge(void * context, void * state, const void * from){ *(int64_t *)state += *(const int64_t *)from; }
+	static void CountFree(void * context, void * state){ free(state); }
+
+	CameraReducer count = {NULL,CountCreate,CountClear,CountAccumulate,CountMerge,CountFree};
+	int64_t bright;
+	CameraSimulationReduceWith(78.9*pi/180.0,-65.2*pi/180.0,278.3*pi/180.0,parm,&count,&pool,&bright);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <mutex>
+#include <new>
+#include "CameraReduce.h"
+#include "ThreadPool.h"
+#include "CameraStats.h"
+
+#ifndef ALLOC
+#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
+#endif
+
+const static double pi = 3.141592653589793;
+
+//floating point sums of a block
+#define REDUCE_SUMS                 6       //DOP, DOP^2, AOP, AOP^2, cos(2*AOP), sin(2*AOP)
+
+//simulation buffers of one thread
+typedef struct ReduceWorker
+{
+	double *	DOP;            //DOP of a block, NULL when reducing a double precision frame
+	double *	AOP;            //AOP of a block (unit is degree)
+}
+ReduceWorker;
+
+//partial state of the statistics of ReduceSettings
+typedef struct ReduceState
+{
+	int64_t   Valid;
+	int64_t   Histogram[REDUCE_BINS_MAX];
+	int64_t   Underflow;
+	int64_t   Overflow;
+	int64_t   MeridianCount;
+	double    Peak;             //maximum DOP and the smallest frame index with it
+	int64_t   PeakIndex;
+	int64_t   BandCount;
+	int64_t   Band_i;           //sums of the frame rows and columns of the band
+	int64_t   Band_j;
+	double    Sums[REDUCE_SUMS];
+	std::vector<CameraPixel>  Meridian;     //meridian pixels in frame order, at most MeridianCapacity
+}
+ReduceState;
+
+//context of the reducer of the statistics of ReduceSettings
+typedef struct ReduceContext
+{
+	const ReduceSettings *	settings;   //statistics to gather
+	int       n_z;                      //frame columns
+	int       PixelInterval;            //pixel interval of the frame
+	int64_t   Stored;                   //meridian pixels of the state of the frame, changed only by the merges
+}
+ReduceContext;
+
+
+
+//Default settings.
+void ReduceSettingsDefault(
+	ReduceSettings *	settings    //settings
+	){
+	settings->Bins = 100;
+	settings->DOPMin = 0.0;
+	settings->DOPMax = 1.0;
+	settings->MeridianTolerance = 1.0;
+	settings->BandThreshold = 0.9;
+	settings->Axial = 0;
+	settings->Meridian = NULL;
+	settings->MeridianCapacity = 0;
+}
+
+
+
+//Release a worker.
+static void WorkerFree(
+	ReduceWorker *	worker      //worker
+	){
+	if(worker==NULL){
+		return;
+	}
+	free(worker->DOP);
+	free(worker->AOP);
+	free(worker);
+}
+
+
+
+//Create a worker, with the buffers of a block if it simulates or converts.
+static ReduceWorker * WorkerInit(
+	const bool  Buffers         //true to allocate the DOP and AOP of a block
+	){
+	ReduceWorker * worker = ALLOC(ReduceWorker);
+	if(worker==NULL){
+		return NULL;
+	}
+	memset(worker,0,sizeof(ReduceWorker));
+	if(Buffers){
+		worker->DOP = (double *)malloc(REDUCE_BLOCK_PIXELS*sizeof(double));
+		worker->AOP = (double *)malloc(REDUCE_BLOCK_PIXELS*sizeof(double));
+		if(worker->DOP==NULL || worker->AOP==NULL){
+			WorkerFree(worker);
+			return NULL;
+		}
+	}
+	return worker;
+}
+
+
+
+//Reduce a frame of n_x*n_z pixels block by block; source(block,worker,DOP,AOP,pitch) points DOP and AOP at a block.
+template<typename Source>
+static int FrameReduction(
+	const int     n_x,                  //frame rows
+	const int     n_z,                  //frame columns
+	const bool  Buffers,                //true if the workers simulate or convert into buffers
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	Source  source,                     //DOP and AOP of a block
+	const CameraReducer *	reducer,    //reducer
+	void *	state                       //state of the frame
+	){
+	if(n_x<1 || n_z<1 || reducer==NULL || reducer->Create==NULL || reducer->Clear==NULL
+		|| reducer->Accumulate==NULL || reducer->Merge==NULL || reducer->Free==NULL || state==NULL){
+		return -1;
+	}
+
+	//blocks of whole rows, or of part of a row for very wide frames
+	const int cols = n_z<REDUCE_BLOCK_PIXELS ? n_z : REDUCE_BLOCK_PIXELS;
+	const int rows = REDUCE_BLOCK_PIXELS/cols;
+	const int64_t BlockRows = (n_x+rows-1)/rows;
+	const int64_t BlockCols = (n_z+cols-1)/cols;
+	const int64_t blocks = BlockRows*BlockCols;
+
+	//one worker per thread, lent out for a block at a time, and a partial state per block of a round
+	std::vector<ReduceWorker *> worker(pool==NULL ? 1 : pool->Size(),(ReduceWorker *)NULL);
+	std::vector<void *> partial((size_t)(blocks<REDUCE_ROUND_BLOCKS ? blocks : REDUCE_ROUND_BLOCKS),(void *)NULL);
+	std::vector<int> idle;
+	int status = 0;
+	for(size_t w=0; w<worker.size() && status==0; w++){
+		worker[w] = WorkerInit(Buffers);
+		status = worker[w]==NULL ? -1 : 0;
+		idle.push_back((int)w);
+	}
+	for(size_t b=0; b<partial.size() && status==0; b++){
+		partial[b] = reducer->Create(reducer->Context);
+		status = partial[b]==NULL ? -1 : 0;
+	}
+	std::mutex IdleMutex;
+
+	//blocks of a round reduced in parallel, then merged in the order of the blocks
+	if(status==0){
+		reducer->Clear(reducer->Context,state);
+	}
+	for(int64_t round=0; round<blocks && status==0; round+=REDUCE_ROUND_BLOCKS){
+		int count = (int)(blocks-round<REDUCE_ROUND_BLOCKS ? blocks-round : REDUCE_ROUND_BLOCKS);
+		auto task = [&](int begin, int end){
+			int w;
+			{
+				std::lock_guard<std::mutex> lock(IdleMutex);
+				w = idle.back();
+				idle.pop_back();
+			}
+			for(int b=begin; b<end; b++){
+				int64_t n = round+b;
+				CameraBlock block;
+				block.i = (int)(n/BlockCols)*rows;
+				block.j = (int)(n%BlockCols)*cols;
+				block.n_x = block.i+rows<n_x ? rows : n_x-block.i;
+				block.n_z = block.j+cols<n_z ? cols : n_z-block.j;
+				const double * DOP;
+				const double * AOP;
+				size_t pitch;
+				source(block,worker[w],DOP,AOP,pitch);
+				reducer->Clear(reducer->Context,partial[b]);
+				reducer->Accumulate(reducer->Context,partial[b],&block,DOP,AOP,pitch);
+			}
+			std::lock_guard<std::mutex> lock(IdleMutex);
+			idle.push_back(w);
+		};
+		if(pool==NULL){
+			task(0,count);
+		}
+		else{
+			pool->ParallelFor(count,1,task);
+		}
+		for(int b=0; b<count; b++){
+			reducer->Merge(reducer->Context,state,partial[b]);
+		}
+	}
+
+	for(size_t b=0; b<partial.size(); b++){
+		if(partial[b]!=NULL){
+			reducer->Free(reducer->Context,partial[b]);
+		}
+	}
+	for(size_t w=0; w<worker.size(); w++){
+		WorkerFree(worker[w]);
+	}
+	return status;
+}
+
+
+
+//Reduce the frame of an attitude with a reducer without holding the frame.
+int CameraSimulationReduceWith(
+	const double  psa,              //yaw angle (unit is radian)
+	const double  afa,              //pitch angle (unit is radian)
+    const double  beta,             //roll angle (unit is radian)
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const CameraReducer *	reducer,    //reducer
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	void *	state                       //state of the frame made by reducer->Create
+	){
+	STATS_CLOCK(tick);
+	double C_vTb[3][3];//rotation matrix from solar vector to body coordinate system
+	double C_bTv[3][3];//rotation matrix from body to solar vector coordinate system
+	CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+	int n_x, n_z;
+	CameraFrameSize(parm,n_x,n_z);
+	auto source = [&](const CameraBlock & block, ReduceWorker * worker, const double *& DOP, const double *& AOP,
+		size_t & pitch){
+		CameraSimulationBlock(C_vTb,C_bTv,parm,&block,worker->DOP,worker->AOP,(size_t)block.n_z);
+		DOP = worker->DOP;
+		AOP = worker->AOP;
+		pitch = (size_t)block.n_z;
+	};
+	int status = FrameReduction(n_x,n_z,true,pool,source,reducer,state);
+	STATS_COUNT(Frames,1);
+	STATS_TRACE("reduce",tick,(uint64_t)n_x*n_z,0);
+	return status;
+}
+
+
+
+//Reduce a simulated frame with a reducer.
+int CameraFrameReduceWith(
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const CameraReducer *	reducer,    //reducer
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	void *	state                       //state of the frame made by reducer->Create
+	){
+	auto source = [&](const CameraBlock & block, ReduceWorker * worker, const double *& DOP, const double *& AOP,
+		size_t & pitch){
+		(void)worker;
+		size_t first = (size_t)block.i*frame->n_z+block.j;
+		DOP = frame->DOP+first;
+		AOP = frame->AOP+first;
+		pitch = (size_t)frame->n_z;
+	};
+	return FrameReduction(frame->n_x,frame->n_z,false,pool,source,reducer,state);
+}
+
+
+
+//Reduce a simulated single precision frame with a reducer.
+int CameraFrameReduceWith(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	const CameraReducer *	reducer,    //reducer
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	void *	state                       //state of the frame made by reducer->Create
+	){
+	//blocks widened to double in the buffers of the worker, which is exact
+	auto source = [&](const CameraBlock & block, ReduceWorker * worker, const double *& DOP, const double *& AOP,
+		size_t & pitch){
+		for(int i=0; i<block.n_x; i++){
+			size_t first = (size_t)(block.i+i)*frame->n_z+block.j;
+			for(int j=0; j<block.n_z; j++){
+				worker->DOP[(size_t)i*block.n_z+j] = frame->DOP[first+j];
+				worker->AOP[(size_t)i*block.n_z+j] = frame->AOP[first+j];
+			}
+		}
+		DOP = worker->DOP;
+		AOP = worker->AOP;
+		pitch = (size_t)block.n_z;
+	};
+	return FrameReduction(frame->n_x,frame->n_z,true,pool,source,reducer,state);
+}
+
+
+
+//cos(2*AOP) and sin(2*AOP) of an AOP in [-90,90] degrees, within 2e-9 and without a call of the math library.
+static inline void AxisVector(
+	const double  AOP,          //AOP (unit is degree)
+	double &	c,              //cos(2*AOP)
+	double &	s               //sin(2*AOP)
+	){
+	//Taylor series of the sine and cosine of AOP in [-pi/2,pi/2], then the double angle
+	const double x = AOP*(pi/180.0);
+	const double x2 = x*x;
+	double sine = x*(1.0-x2*(1.0/6.0)*(1.0-x2*(1.0/20.0)*(1.0-x2*(1.0/42.0)*(1.0-x2*(1.0/72.0)*(1.0-x2*(1.0/110.0)*(1.0-x2*(1.0/156.0)))))));
+	double cosine = 1.0-x2*(1.0/2.0)*(1.0-x2*(1.0/12.0)*(1.0-x2*(1.0/30.0)*(1.0-x2*(1.0/56.0)*(1.0-x2*(1.0/90.0)*(1.0-x2*(1.0/132.0)*(1.0-x2*(1.0/182.0)))))));
+	c = cosine*cosine-sine*sine;
+	s = 2.0*sine*cosine;
+}
+
+
+
+//New partial state of the statistics.
+static void * ReduceCreate(
+	void *	context             //ReduceContext *
+	){
+	(void)context;
+	return new (std::nothrow) ReduceState();
+}
+
+
+
+//Empty a partial state of the statistics.
+static void ReduceClear(
+	void *	context,            //ReduceContext *
+	void *	state               //ReduceState *
+	){
+	const ReduceContext * ctx = (const ReduceContext *)context;
+	ReduceState * s = (ReduceState *)state;
+	s->Valid = 0;
+	memset(s->Histogram,0,ctx->settings->Bins*sizeof(int64_t));
+	s->Underflow = s->Overflow = s->MeridianCount = 0;
+	s->Peak = -std::numeric_limits<double>::infinity();
+	s->PeakIndex = INT64_MAX;
+	s->BandCount = s->Band_i = s->Band_j = 0;
+	for(int k=0; k<REDUCE_SUMS; k++){
+		s->Sums[k] = 0.0;
+	}
+	s->Meridian.clear();
+}
+
+
+
+//Reduce a block of DOP and AOP into a partial state of the statistics.
+static void ReduceAccumulate(
+	void *	context,            //ReduceContext *
+	void *	state,              //ReduceState *
+	const CameraBlock *	block,  //block of the frame
+	const double *	DOP,        //DOP of the block, row after row
+	const double *	AOP,        //AOP of the block (unit is degree)
+	const size_t  pitch         //values from one row of DOP and AOP to the next
+	){
+	const ReduceContext * ctx = (const ReduceContext *)context;
+	const ReduceSettings * settings = ctx->settings;
+	ReduceState * s = (ReduceState *)state;
+	const double scale = settings->Bins/(settings->DOPMax-settings->DOPMin);
+	const double MeridianAOP = 90.0-settings->MeridianTolerance;
+	const bool Store = settings->Meridian!=NULL && ctx->Stored<settings->MeridianCapacity;
+	double sum[REDUCE_SUMS] = {0.0};
+	for(int i=0; i<block->n_x; i++){
+		const double * DOPRow = DOP+(size_t)i*pitch;
+		const double * AOPRow = AOP+(size_t)i*pitch;
+		for(int j=0; j<block->n_z; j++){
+			double dop = DOPRow[j];
+			double aop = AOPRow[j];
+			if(!std::isfinite(dop) || !std::isfinite(aop)){
+				continue;
+			}
+			s->Valid++;
+			double bin = (dop-settings->DOPMin)*scale;
+			if(dop<settings->DOPMin){
+				s->Underflow++;
+			}
+			else if(bin>=settings->Bins){
+				s->Overflow++;
+			}
+			else{
+				s->Histogram[(int)bin]++;
+			}
+			sum[0] += dop;
+			sum[1] += dop*dop;
+			sum[2] += aop;
+			sum[3] += aop*aop;
+			if(settings->Axial){
+				double c, sine;
+				AxisVector(aop,c,sine);
+				sum[4] += c;
+				sum[5] += sine;
+			}
+
+			int64_t index = (int64_t)(block->i+i)*ctx->n_z+block->j+j;
+			if(dop>s->Peak || (dop==s->Peak && index<s->PeakIndex)){
+				s->Peak = dop;
+				s->PeakIndex = index;
+			}
+			if(dop>=settings->BandThreshold){
+				s->BandCount++;
+				s->Band_i += block->i+i;
+				s->Band_j += block->j+j;
+			}
+			if(fabs(aop)>=MeridianAOP){
+				s->MeridianCount++;
+				if(Store && (int64_t)s->Meridian.size()<settings->MeridianCapacity){
+					CameraPixel pixel = {1+(block->i+i)*ctx->PixelInterval,1+(block->j+j)*ctx->PixelInterval};
+					s->Meridian.push_back(pixel);
+				}
+			}
+		}
+	}
+	for(int k=0; k<REDUCE_SUMS; k++){
+		s->Sums[k] += sum[k];
+	}
+}
+
+
+
+//Add the partial state of the next block to the statistics of the frame.
+static void ReduceMerge(
+	void *	context,            //ReduceContext *
+	void *	state,              //ReduceState * of the frame
+	const void *	from        //ReduceState * of the block
+	){
+	ReduceContext * ctx = (ReduceContext *)context;
+	const ReduceSettings * settings = ctx->settings;
+	ReduceState * s = (ReduceState *)state;
+	const ReduceState * f = (const ReduceState *)from;
+	s->Valid += f->Valid;
+	for(int b=0; b<settings->Bins; b++){
+		s->Histogram[b] += f->Histogram[b];
+	}
+	s->Underflow += f->Underflow;
+	s->Overflow += f->Overflow;
+	s->MeridianCount += f->MeridianCount;
+	if(f->Peak>s->Peak || (f->Peak==s->Peak && f->PeakIndex<s->PeakIndex)){
+		s->Peak = f->Peak;
+		s->PeakIndex = f->PeakIndex;
+	}
+	s->BandCount += f->BandCount;
+	s->Band_i += f->Band_i;
+	s->Band_j += f->Band_j;
+	for(int k=0; k<REDUCE_SUMS; k++){
+		s->Sums[k] += f->Sums[k];
+	}
+	for(size_t p=0; p<f->Meridian.size() && (int64_t)s->Meridian.size()<settings->MeridianCapacity; p++){
+		s->Meridian.push_back(f->Meridian[p]);
+	}
+	ctx->Stored = (int64_t)s->Meridian.size();
+}
+
+
+
+//Release a partial state of the statistics.
+static void ReduceFree(
+	void *	context,            //ReduceContext *
+	void *	state               //ReduceState *
+	){
+	(void)context;
+	delete (ReduceState *)state;
+}
+
+
+
+//Statistics of a frame of n_x*n_z pixels with the reducer of ReduceSettings; reduce(reducer,state) runs it.
+template<typename Reduce>
+static int StatisticsReduction(
+	const int     n_x,                  //frame rows
+	const int     n_z,                  //frame columns
+	const int     PixelInterval,        //pixel interval of the frame
+	const ReduceSettings *	settings,   //statistics to gather
+	Reduce  reduce,                     //reduction of the frame
+	ReduceResult *	result              //statistics
+	){
+	if(settings->Bins<1 || settings->Bins>REDUCE_BINS_MAX || !(settings->DOPMax>settings->DOPMin)
+		|| !(settings->MeridianTolerance>=0.0) || settings->MeridianCapacity<0 || n_x<1 || n_z<1){
+		return -1;
+	}
+	ReduceContext ctx = {settings,n_z,PixelInterval,0};
+	CameraReducer reducer = {&ctx,ReduceCreate,ReduceClear,ReduceAccumulate,ReduceMerge,ReduceFree};
+	ReduceState * s = (ReduceState *)ReduceCreate(&ctx);
+	if(s==NULL){
+		return -1;
+	}
+	if(reduce(&reducer,s)!=0){
+		ReduceFree(&ctx,s);
+		return -1;
+	}
+
+	//counters of the frame
+	memset(result,0,sizeof(ReduceResult));
+	result->Pixels = (int64_t)n_x*n_z;
+	result->Valid = s->Valid;
+	result->Bins = settings->Bins;
+	result->DOPMin = settings->DOPMin;
+	result->DOPMax = settings->DOPMax;
+	memcpy(result->Histogram,s->Histogram,settings->Bins*sizeof(int64_t));
+	result->Underflow = s->Underflow;
+	result->Overflow = s->Overflow;
+	result->MeridianCount = s->MeridianCount;
+	result->MeridianStored = (int64_t)s->Meridian.size();
+	for(size_t p=0; p<s->Meridian.size(); p++){
+		settings->Meridian[p] = s->Meridian[p];
+	}
+	result->BandCount = s->BandCount;
+
+	//moments of the valid pixels
+	const double * Sums = s->Sums;
+	double NaN = std::numeric_limits<double>::quiet_NaN();
+	double n = (double)result->Valid;
+	if(result->Valid>0){
+		result->DOPMean = Sums[0]/n;
+		result->AOPMean = Sums[2]/n;
+		double DOPVariance = result->Valid>1 ? (Sums[1]-Sums[0]*result->DOPMean)/(n-1.0) : 0.0;
+		double AOPVariance = result->Valid>1 ? (Sums[3]-Sums[2]*result->AOPMean)/(n-1.0) : 0.0;
+		result->DOPStdDev = DOPVariance>0.0 ? sqrt(DOPVariance) : 0.0;
+		result->AOPStdDev = AOPVariance>0.0 ? sqrt(AOPVariance) : 0.0;
+		result->AOPAxialMean = settings->Axial ? 0.5*atan2(Sums[5],Sums[4])*180.0/pi : NaN;
+		result->AOPAxialLength = settings->Axial ? sqrt(Sums[4]*Sums[4]+Sums[5]*Sums[5])/n : NaN;
+		result->DOPPeak = s->Peak;
+		result->DOPPeakPixel.i_x = 1+(int)(s->PeakIndex/n_z)*PixelInterval;
+		result->DOPPeakPixel.j_z = 1+(int)(s->PeakIndex%n_z)*PixelInterval;
+	}
+	else{
+		result->DOPMean = result->DOPStdDev = result->AOPMean = result->AOPStdDev = NaN;
+		result->AOPAxialMean = result->AOPAxialLength = result->DOPPeak = NaN;
+	}
+	result->Band_i_x = result->BandCount>0 ? 1.0+(double)s->Band_i/result->BandCount*PixelInterval : NaN;
+	result->Band_j_z = result->BandCount>0 ? 1.0+(double)s->Band_j/result->BandCount*PixelInterval : NaN;
+	ReduceFree(&ctx,s);
+	return 0;
+}
+
+
+
+//Statistics of the frame of an attitude without holding the frame.
+int CameraSimulationReduce(
+	const double  psa,              //yaw angle (unit is radian)
+	const double  afa,              //pitch angle (unit is radian)
+    const double  beta,             //roll angle (unit is radian)
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	ReduceResult *	result              //statistics
+	){
+	int n_x, n_z;
+	CameraFrameSize(parm,n_x,n_z);
+	auto reduce = [&](const CameraReducer * reducer, void * state){
+		return CameraSimulationReduceWith(psa,afa,beta,parm,reducer,pool,state);
+	};
+	return StatisticsReduction(n_x,n_z,parm->PixelInterval,settings,reduce,result);
+}
+
+
+
+//Statistics of a simulated frame in double or single precision.
+template<typename S>
+static int FrameReduce(
+	const CameraFrameOf<S> *	frame,  //DOP and AOP frame
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	ReduceResult *	result              //statistics
+	){
+	auto reduce = [&](const CameraReducer * reducer, void * state){
+		return CameraFrameReduceWith(frame,reducer,pool,state);
+	};
+	return StatisticsReduction(frame->n_x,frame->n_z,frame->PixelInterval,settings,reduce,result);
+}
+
+
+
+//Statistics of a simulated frame.
+int CameraFrameReduce(
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	ReduceResult *	result              //statistics
+	){
+	return FrameReduce(frame,settings,pool,result);
+}
+
+
+
+//Statistics of a simulated single precision frame.
+int CameraFrameReduce(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	ReduceResult *	result              //statistics
+	){
+	return FrameReduce(frame,settings,pool,result);
+}
+
+
+
+//Write the statistics of a frame as JSON.
+int ReduceWriteJson(
+	const ReduceResult *	result,     //statistics
+	const int     Histogram,            //1 writes the histogram too
+	FILE *	file                        //opened file
+	){
+	fprintf(file,"{\n  \"pixels\": %lld,\n  \"valid\": %lld,\n",(long long)result->Pixels,(long long)result->Valid);
+	fprintf(file,"  \"dop\": {\"mean\": ");
+	CameraStatsWriteNumber(result->DOPMean,file);
+	fprintf(file,", \"stddev\": ");
+	CameraStatsWriteNumber(result->DOPStdDev,file);
+	fprintf(file,", \"peak\": ");
+	CameraStatsWriteNumber(result->DOPPeak,file);
+	fprintf(file,", \"peak_i_x\": %d, \"peak_j_z\": %d},\n",result->DOPPeakPixel.i_x,result->DOPPeakPixel.j_z);
+	fprintf(file,"  \"aop\": {\"mean\": ");
+	CameraStatsWriteNumber(result->AOPMean,file);
+	fprintf(file,", \"stddev\": ");
+	CameraStatsWriteNumber(result->AOPStdDev,file);
+	fprintf(file,", \"axial_mean\": ");
+	CameraStatsWriteNumber(result->AOPAxialMean,file);
+	fprintf(file,", \"axial_length\": ");
+	CameraStatsWriteNumber(result->AOPAxialLength,file);
+	fprintf(file,"},\n  \"meridian\": {\"count\": %lld, \"stored\": %lld},\n",
+		(long long)result->MeridianCount,(long long)result->MeridianStored);
+	fprintf(file,"  \"band\": {\"count\": %lld, \"i_x\": ",(long long)result->BandCount);
+	CameraStatsWriteNumber(result->Band_i_x,file);
+	fprintf(file,", \"j_z\": ");
+	CameraStatsWriteNumber(result->Band_j_z,file);
+	fprintf(file,"},\n  \"histogram\": {\"bins\": %d, \"min\": ",result->Bins);
+	CameraStatsWriteNumber(result->DOPMin,file);
+	fprintf(file,", \"max\": ");
+	CameraStatsWriteNumber(result->DOPMax,file);
+	fprintf(file,", \"underflow\": %lld, \"overflow\": %lld",(long long)result->Underflow,(long long)result->Overflow);
+	if(Histogram){
+		fprintf(file,",\n    \"counts\": [");
+		for(int b=0; b<result->Bins; b++){
+			fprintf(file,"%lld%s",(long long)result->Histogram[b],b+1<result->Bins ? ", " : "");
+		}
+		fprintf(file,"]");
+	}
+	fprintf(file,"}\n}\n");
+	return ferror(file) ? -1 : 0;
+}
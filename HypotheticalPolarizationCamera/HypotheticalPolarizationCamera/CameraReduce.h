@@ -0,0 +1,160 @@
+#ifndef _CAMERAREDUCE_H_
+#define _CAMERAREDUCE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "PolarizationCamera.h"
+
+#define REDUCE_BINS_MAX             1024    //bins of a DOP histogram
+#define REDUCE_BLOCK_PIXELS         8192    //simulated pixels of a block, reduced while it is in the cache
+#define REDUCE_ROUND_BLOCKS         256     //blocks whose partial states are kept apart at a time
+
+//statistics to gather from a frame
+typedef struct ReduceSettings
+{
+	int       Bins;                 //bins of the DOP histogram (1 to REDUCE_BINS_MAX)
+	double    DOPMin;               //bin k counts DOP in DOPMin+[k,k+1)*(DOPMax-DOPMin)/Bins
+	double    DOPMax;
+	double    MeridianTolerance;    //pixels with |AOP|>=90-MeridianTolerance lie near the solar and anti-solar
+	                                //meridian (unit is degree)
+	double    BandThreshold;        //pixels with DOP>=BandThreshold belong to the band of maximum DOP
+	CameraPixel *	Meridian;       //receives the first MeridianCapacity pixels near the meridian in frame order,
+	                                //NULL only counts them
+	int64_t   MeridianCapacity;     //entries of Meridian
+	int       Axial;                //1 gathers AOPAxialMean and AOPAxialLength too
+}
+ReduceSettings;
+
+//statistics of a frame
+typedef struct ReduceResult
+{
+	int64_t   Pixels;               //simulated pixels
+	int64_t   Valid;                //pixels with a finite DOP and AOP (NaN outside the field of view of a lens)
+
+	int       Bins;                 //DOP histogram of ReduceSettings
+	double    DOPMin;
+	double    DOPMax;
+	int64_t   Histogram[REDUCE_BINS_MAX];
+	int64_t   Underflow;            //DOP below DOPMin
+	int64_t   Overflow;             //DOP of DOPMax and above
+
+	double    DOPMean;
+	double    DOPStdDev;
+	double    AOPMean;              //mean of AOP as a number (unit is degree)
+	double    AOPStdDev;
+	double    AOPAxialMean;         //mean direction of AOP as an axis, half the angle of the mean of the unit
+	                                //vectors at 2*AOP, unaffected by the jump from 90 to -90 (unit is degree)
+	double    AOPAxialLength;       //length of that mean vector, 1 if every AOP is the same, near 0 if spread out;
+	                                //both NaN without ReduceSettings::Axial
+
+	int64_t   MeridianCount;        //pixels near the meridian
+	int64_t   MeridianStored;       //of them written to ReduceSettings::Meridian
+
+	double    DOPPeak;              //maximum DOP
+	CameraPixel  DOPPeakPixel;      //first pixel in frame order with the maximum DOP
+	int64_t   BandCount;            //pixels of the band of maximum DOP
+	double    Band_i_x;             //mean column and raw coordinate of the band (pixel coordinate system)
+	double    Band_j_z;
+}
+ReduceResult;
+
+//Reducer of frames. A reduction keeps a partial state per block of the frame: it is cleared, the block is
+//accumulated into it on a thread of the pool, and the states of the blocks are merged into the state of the frame
+//in the order of the blocks, so floating point results do not depend on the number of threads.
+typedef struct CameraReducer
+{
+	void *	Context;                //passed to every function of the reducer
+	void * (*Create)(               //new partial state, NULL if memory runs out
+		void *	context             //Context
+		);
+	void (*Clear)(                  //empty a partial state
+		void *	context,            //Context
+		void *	state               //partial state
+		);
+	void (*Accumulate)(             //add a block of the frame, called on threads of the pool for different states
+		void *	context,            //Context
+		void *	state,              //partial state of the block, cleared
+		const CameraBlock *	block,  //block of the frame
+		const double *	DOP,        //DOP of the block, row after row, NaN outside the field of view of a lens
+		const double *	AOP,        //AOP of the block (unit is degree)
+		const size_t  pitch         //values from one row of DOP and AOP to the next
+		);
+	void (*Merge)(                  //add the partial state of a block to the state of the frame, on the calling
+		void *	context,            //thread and never while a block is accumulated
+		void *	state,              //state of the frame
+		const void *	from        //partial state of the next block
+		);
+	void (*Free)(                   //release a partial state
+		void *	context,            //Context
+		void *	state               //partial state
+		);
+}
+CameraReducer;
+
+//Default settings: 100 DOP bins over [0,1], 1 degree from the meridian, band of DOP>=0.9, no axial AOP.
+void ReduceSettingsDefault(
+	ReduceSettings *	settings    //settings
+	);
+
+//Statistics of the frame of an attitude without holding the frame.
+int CameraSimulationReduce(
+	const double  psa,              //yaw angle (unit is radian)
+	const double  afa,              //pitch angle (unit is radian)
+    const double  beta,             //roll angle (unit is radian)
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	ReduceResult *	result              //statistics
+	);
+
+//Statistics of a simulated frame.
+int CameraFrameReduce(
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	ReduceResult *	result              //statistics
+	);
+
+//Statistics of a simulated single precision frame.
+int CameraFrameReduce(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	const ReduceSettings *	settings,   //statistics to gather
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	ReduceResult *	result              //statistics
+	);
+
+//Reduce the frame of an attitude with a reducer without holding the frame.
+int CameraSimulationReduceWith(
+	const double  psa,              //yaw angle (unit is radian)
+	const double  afa,              //pitch angle (unit is radian)
+    const double  beta,             //roll angle (unit is radian)
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const CameraReducer *	reducer,    //reducer
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	void *	state                       //state of the frame made by reducer->Create
+	);
+
+//Reduce a simulated frame with a reducer.
+int CameraFrameReduceWith(
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const CameraReducer *	reducer,    //reducer
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	void *	state                       //state of the frame made by reducer->Create
+	);
+
+//Reduce a simulated single precision frame with a reducer.
+int CameraFrameReduceWith(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	const CameraReducer *	reducer,    //reducer
+	ThreadPool *	pool,               //thread pool, NULL runs on the calling thread
+	void *	state                       //state of the frame made by reducer->Create
+	);
+
+//Write the statistics of a frame as JSON.
+int ReduceWriteJson(
+	const ReduceResult *	result,     //statistics
+	const int     Histogram,            //1 writes the histogram too
+	FILE *	file                        //opened file
+	);
+
+#endif
@@ -0,0 +1,350 @@
+/*
+Multi-camera rig of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for simulating several cameras fixed to one body with their own mounting rotations, lenses and sizes from a single body attitude.
+And this code is written in C++11.
+
+Usage information:
+Add cameras with "CameraRigAddCamera()", then call "CameraSimulationRig()" once per body attitude.
+--------------------------
+
+Rig:
+	A rig carries several cameras with their own lenses, sizes and sky models, each turned against the body by a
+	fixed mounting rotation Mount (x_camera = Mount*x_body). For a body attitude C_vTb (solar vector to body
+	coordinate system, "MatrixEulerRotation()" of psa, afa and beta) camera k sees the sky through
+		C_vTc = Mount_k*C_vTb,    C_cTv = C_vTc'
+	"CameraSimulationRig()" builds C_vTb once per attitude and composes it with every mount, so no Euler angles are
+	composed by hand. The cameras keep their own cached geometry (the ray tables of "CameraRayTableInit()" and
+	"CameraParametersSetLens()"), which does not depend on the attitude.
+	The frames of all cameras are cut into row bands that form one parallel loop, so a small camera does not leave
+	threads idle while a large one finishes, and the frames are identical to "CameraSimulationFrameRotation()" of the
+	composed matrices. The Euler angles of every camera are stored in CameraRigCamera::attitude and in psa, afa and
+	beta of its camera parameters, so a frame can be written with "FrameWriterWrite()" as it is. A camera parameters
+	struct added twice keeps the angles of the last camera.
+
+
+Function 1: "CameraRigInit()" 
+
+    //Allocate a rig without cameras.
+	CameraRig * CameraRigInit(
+		const int     ScalarType
+	);
+	--------------input----------------
+	const int     ScalarType    //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT, the precision of the frames
+	-----------------------------------
+	-------------output----------------
+	CameraRig *                 //empty rig, NULL for an invalid type or without memory
+	-----------------------------------
+
+
+Function 2: "CameraMountRotation()" 
+
+    //Rotation matrix from rig body to camera body coordinate system of three mounting Euler angles.
+	void CameraMountRotation(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		double  (&Mount)[3][3]
+	);
+	--------------input----------------
+	const double  psa,              //yaw angle of the camera on the rig (unit is radian)
+	const double  afa,              //pitch angle of the camera on the rig (unit is radian)
+    const double  beta,             //roll angle of the camera on the rig (unit is radian)
+	-----------------------------------
+	-------------output----------------
+	double  (&Mount)[3][3]          //"MatrixEulerRotation()" with the rig body in place of the solar vector
+	                                //coordinate system; zero angles mount the camera along the body axes
+	-----------------------------------
+	"ConstEulerRotation()" of MatrixTemplate.h gives the same matrix in a constant expression for a fixed rig.
+
+
+Function 3: "CameraRigAddCamera()" 
+
+    //Add a camera to a rig.
+	int CameraRigAddCamera(
+		CameraRig *	rig,
+		CameraParameters *	parm,
+		const double  (&Mount)[3][3]
+	);
+	--------------input----------------
+	CameraRig *	rig,                //rig
+	CameraParameters *	parm,       //camera parameters, owned by the caller and kept until the rig is released
+	const double  (&Mount)[3][3]    //rotation matrix from rig body to camera body coordinate system
+	-----------------------------------
+	-------------output----------------
+	int                             //index of the camera in rig->Camera, or -1 if the rig is full or the frame
+	                                //cannot be allocated
+	-----------------------------------
+
+
+Function 4: "CameraSimulationRig()" 
+
+    //Simulate every camera of a rig for one body attitude.
+	int CameraSimulationRig(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		CameraRig *	rig,
+		ThreadPool *	pool
+	);
+	--------------input----------------
+	const double  psa,              //yaw angle of the rig body (unit is radian)
+	const double  afa,              //pitch angle of the rig body (unit is radian)
+    const double  beta,             //roll angle of the rig body (unit is radian)
+	ThreadPool *	pool            //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	CameraRig *	rig                 //frame and attitude of every camera
+	int                             //0, or -1 for a NULL rig
+	-----------------------------------
+
+
+Function 5: "CameraRigFree()" 
+
+    //Release a rig and its frames, not the camera parameters.
+	void CameraRigFree(
+		CameraRig *	rig
+	);
+	--------------input----------------
+	CameraRig *	rig                 //rig, may be NULL
+	-----------------------------------
+
+Example:
+
+	CameraParameters * front = CameraParametersInit(5.2,5.2,1024,1280,4.0,1);
+	CameraParameters * zenith = CameraParametersInit(3.45,3.45,2048,2048,1.8,1);
+	CameraLens fisheye = {CAMERA_PROJECTION_EQUIDISTANT,180.0,0.0,0.0,0.0,0.0,0.0};
+	CameraParametersSetLens(zenith,&fisheye);
+	CameraRig * rig = CameraRigInit(FRAME_SCALAR_FLOAT);
+	double Mount[3][3];
+	CameraMountRotation(0.0,0.0,0.0,Mount);
+	CameraRigAddCamera(rig,front,Mount);
+	CameraMountRotation(0.0,pi/2,0.0,Mount);	//optical axis (body y) turned up to the body z axis
+	CameraRigAddCamera(rig,zenith,Mount);
+	ThreadPool pool(0);
+	CameraSimulationRig(psa,afa,beta,rig,&pool);	//rig->Camera[k].FrameFloat
+	CameraRigFree(rig);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "CameraRig.h"
+#include "MatrixTemplate.h"
+#include "ThreadPool.h"
+#include "CameraStats.h"
+
+
+//row band of a camera of a rig, one task of the parallel loop
+typedef struct RigBand
+{
+	int       Camera;           //index of the camera
+	int       Begin;            //first frame row
+	int       End;              //frame row after the last one
+}
+RigBand;
+
+
+
+//Allocate a rig without cameras.
+CameraRig * CameraRigInit(
+	const int     ScalarType    //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT, the precision of the frames
+	){
+	if(ScalarType!=FRAME_SCALAR_DOUBLE && ScalarType!=FRAME_SCALAR_FLOAT){
+		return NULL;
+	}
+	CameraRig * rig = (CameraRig *)calloc(1,sizeof(CameraRig));
+	if(rig!=NULL){
+		rig->ScalarType = ScalarType;
+	}
+	return rig;
+}
+
+
+
+//Rotation matrix from rig body to camera body coordinate system of three mounting Euler angles.
+void CameraMountRotation(
+	const double  psa,              //yaw angle of the camera on the rig (unit is radian)
+	const double  afa,              //pitch angle of the camera on the rig (unit is radian)
+    const double  beta,             //roll angle of the camera on the rig (unit is radian)
+	double  (&Mount)[3][3]          //rotation matrix from rig body to camera body coordinate system
+	){
+	MatrixEulerRotation(psa,afa,beta,Mount);
+}
+
+
+
+//Add a camera to a rig, the index of the camera or -1.
+int CameraRigAddCamera(
+	CameraRig *	rig,                //rig
+	CameraParameters *	parm,       //camera parameters, owned by the caller and kept until the rig is released
+	const double  (&Mount)[3][3]    //rotation matrix from rig body to camera body coordinate system
+	){
+	if(rig==NULL || parm==NULL || rig->CameraCount>=CAMERA_RIG_MAX_CAMERAS){
+		return -1;
+	}
+	CameraRigCamera * camera = &rig->Camera[rig->CameraCount];
+	memset(camera,0,sizeof(CameraRigCamera));
+	if(rig->ScalarType==FRAME_SCALAR_DOUBLE){
+		camera->frame = CameraFrameInit(parm);
+	}
+	else{
+		camera->FrameFloat = CameraFrameFloatInit(parm);
+	}
+	if(camera->frame==NULL && camera->FrameFloat==NULL){
+		return -1;
+	}
+	camera->parm = parm;
+	for(int i=0; i<3; i++){
+		for(int j=0; j<3; j++){
+			camera->Mount[i][j] = Mount[i][j];
+		}
+	}
+	return rig->CameraCount++;
+}
+
+
+
+//Simulate every camera of a rig for one body attitude.
+int CameraSimulationRig(
+	const double  psa,              //yaw angle of the rig body (unit is radian)
+	const double  afa,              //pitch angle of the rig body (unit is radian)
+    const double  beta,             //roll angle of the rig body (unit is radian)
+	CameraRig *	rig,                //rig, the frames and attitudes of its cameras are written
+	ThreadPool *	pool            //thread pool, NULL runs on the calling thread
+	){
+	if(rig==NULL){
+		return -1;
+	}
+	STATS_CLOCK(tick);
+
+	//the body attitude is built once and composed with every mount
+	double C_vTb[3][3];//rotation matrix from solar vector to rig body coordinate system
+	MatrixEulerRotation(psa,afa,beta,C_vTb);
+	double C_vTc[CAMERA_RIG_MAX_CAMERAS][3][3];//rotation matrices from solar vector to camera body coordinate system
+	double C_cTv[CAMERA_RIG_MAX_CAMERAS][3][3];//rotation matrices from camera body to solar vector coordinate system
+	std::vector<RigBand> bands;
+	int threads = pool!=NULL ? pool->Size() : 1;
+	for(int k=0; k<rig->CameraCount; k++){
+		CameraRigCamera * camera = &rig->Camera[k];
+		MatrixMultiply(camera->Mount,C_vTb,C_vTc[k]);
+		MatrixTrans(C_vTc[k],C_cTv[k]);
+		MatrixEulerAngles(C_vTc[k],camera->attitude.psa,camera->attitude.afa,camera->attitude.beta);
+		camera->parm->psa = camera->attitude.psa;
+		camera->parm->afa = camera->attitude.afa;
+		camera->parm->beta = camera->attitude.beta;
+
+		//the bands of "CameraSimulationFrameParallel()" for every camera
+		int n_x, n_z;
+		CameraFrameSize(camera->parm,n_x,n_z);
+		int rows = n_x/(8*threads);
+		rows = rows>0 ? rows : 1;
+		for(int begin=0; begin<n_x; begin+=rows){
+			RigBand band;
+			band.Camera = k;
+			band.Begin = begin;
+			band.End = begin+rows<n_x ? begin+rows : n_x;
+			bands.push_back(band);
+		}
+	}
+
+	auto task = [&](int begin, int end){
+		for(int b=begin; b<end; b++){
+			const RigBand & band = bands[b];
+			const CameraRigCamera * camera = &rig->Camera[band.Camera];
+			CameraBlock block;
+			block.i = band.Begin;
+			block.j = 0;
+			block.n_x = band.End-band.Begin;
+			if(camera->frame!=NULL){
+				block.n_z = camera->frame->n_z;
+				size_t first = (size_t)band.Begin*block.n_z;
+				CameraSimulationBlock(C_vTc[band.Camera],C_cTv[band.Camera],camera->parm,&block,
+					camera->frame->DOP+first,camera->frame->AOP+first,(size_t)block.n_z);
+			}
+			else{
+				block.n_z = camera->FrameFloat->n_z;
+				size_t first = (size_t)band.Begin*block.n_z;
+				CameraSimulationBlock(C_vTc[band.Camera],C_cTv[band.Camera],camera->parm,&block,
+					camera->FrameFloat->DOP+first,camera->FrameFloat->AOP+first,(size_t)block.n_z);
+			}
+		}
+	};
+	if(pool==NULL){
+		task(0,(int)bands.size());
+	}
+	else{
+		pool->ParallelFor((int)bands.size(),1,task);
+	}
+
+	STATS_COUNT(Frames,(uint64_t)rig->CameraCount);
+	STATS_TRACE("rig",tick,0,0);
+	return 0;
+}
+
+
+
+//Release a rig and its frames, not the camera parameters.
+void CameraRigFree(
+	CameraRig *	rig                 //rig
+	){
+	if(rig==NULL){
+		return;
+	}
+	for(int k=0; k<rig->CameraCount; k++){
+		CameraFrameFree(rig->Camera[k].frame);
+		CameraFrameFree(rig->Camera[k].FrameFloat);
+	}
+	free(rig);
+}
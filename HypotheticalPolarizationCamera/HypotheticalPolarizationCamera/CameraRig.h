@@ -0,0 +1,65 @@
+#ifndef _CAMERARIG_H_
+#define _CAMERARIG_H_
+
+#include "PolarizationCamera.h"
+#include "CameraBatch.h"
+#include "FrameIO.h"
+
+#define CAMERA_RIG_MAX_CAMERAS      16      //cameras of a rig
+
+//a camera of a rig
+typedef struct CameraRigCamera
+{
+	CameraParameters *	parm;           //camera parameters with their lens, sky model and ray table, owned by the caller
+	double    Mount[3][3];              //rotation matrix from rig body to camera body coordinate system
+	CameraFrame *	frame;              //frame of the last simulation (FRAME_SCALAR_DOUBLE rigs), NULL otherwise
+	CameraFrameFloat *	FrameFloat;     //frame of the last simulation (FRAME_SCALAR_FLOAT rigs), NULL otherwise
+	CameraAttitude  attitude;           //Euler angles of the camera of the last simulation (from camera body to solar
+	                                    //vector coordinate system)
+}
+CameraRigCamera;
+
+//cameras fixed to one body
+typedef struct CameraRig
+{
+	int       ScalarType;               //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	int       CameraCount;              //number of cameras
+	CameraRigCamera  Camera[CAMERA_RIG_MAX_CAMERAS];
+}
+CameraRig;
+
+//Allocate a rig without cameras.
+CameraRig * CameraRigInit(
+	const int     ScalarType    //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT, the precision of the frames
+	);
+
+//Rotation matrix from rig body to camera body coordinate system of three mounting Euler angles.
+void CameraMountRotation(
+	const double  psa,              //yaw angle of the camera on the rig (unit is radian)
+	const double  afa,              //pitch angle of the camera on the rig (unit is radian)
+    const double  beta,             //roll angle of the camera on the rig (unit is radian)
+	double  (&Mount)[3][3]          //rotation matrix from rig body to camera body coordinate system
+	);
+
+//Add a camera to a rig, the index of the camera or -1.
+int CameraRigAddCamera(
+	CameraRig *	rig,                //rig
+	CameraParameters *	parm,       //camera parameters, owned by the caller and kept until the rig is released
+	const double  (&Mount)[3][3]    //rotation matrix from rig body to camera body coordinate system
+	);
+
+//Simulate every camera of a rig for one body attitude.
+int CameraSimulationRig(
+	const double  psa,              //yaw angle of the rig body (unit is radian)
+	const double  afa,              //pitch angle of the rig body (unit is radian)
+    const double  beta,             //roll angle of the rig body (unit is radian)
+	CameraRig *	rig,                //rig, the frames and attitudes of its cameras are written
+	ThreadPool *	pool            //thread pool, NULL runs on the calling thread
+	);
+
+//Release a rig and its frames, not the camera parameters.
+void CameraRigFree(
+	CameraRig *	rig                 //rig
+	);
+
+#endif
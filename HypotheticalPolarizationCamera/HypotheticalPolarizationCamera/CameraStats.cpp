@@ -0,0 +1,443 @@
+/*
+"CameraStats" functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for finding where the time of a frame goes.
+And this code is written in C++11.
+
+Usage information:
+Compile with HPC_ENABLE_STATS, run the simulation, then read the counters with "CameraStatsGet()" or dump a trace with "CameraStatsWriteTrace()".
+--------------------------
+
+Instrumentation:
+	The scalar code of "CameraSimulation()" is timed stage by stage for every pixel: ray construction, the C_bTv
+	multiply, norm and acos, the quadrant judgement of fi_v_P, DOP and AOP. The vectorized and closed-form kernels
+	are timed per row as CAMERA_STAGE_KERNEL, and the text and binary outputs per frame with the bytes they write.
+	The branch of the quadrant judgement taken by every pixel and the pixels whose AOP is eliminated (DOP==0) are
+	counted in the scalar code. Every thread counts into its own counters, which "CameraStatsGet()" sums.
+	Time is read with the time stamp counter on x86 (cycles) and converted to nanoseconds with the rate measured
+	against the steady clock since the program started.
+	Without HPC_ENABLE_STATS no probe is compiled in and all counters stay zero. With it, the per-pixel probes of
+	the scalar code cost several times the stage they measure; compare stages with each other, not with builds
+	without HPC_ENABLE_STATS.
+
+
+Function 1: "CameraStatsEnabled()" 
+
+    //1 if the instrumentation is compiled in.
+	int CameraStatsEnabled();
+
+
+Function 2: "CameraStatsReset()" 
+
+    //Clear the counters and the recorded trace.
+	void CameraStatsReset();
+
+
+Function 3: "CameraStatsGet()" 
+
+    //Sum the counters of all threads (call it between frames).
+	void CameraStatsGet(
+		CameraStats *	stats
+	);
+	-------------output----------------
+	CameraStats *	stats  //counters since the start or the last "CameraStatsReset()"
+	-----------------------------------
+
+
+Function 4: "CameraStatsWriteJson()" 
+
+    //Write counters as a JSON object.
+	int CameraStatsWriteJson(
+		const CameraStats *	stats,
+		FILE *	file
+	);
+	--------------input----------------
+	const CameraStats *	stats,  //counters
+	FILE *	file                //opened file
+	-----------------------------------
+	-------------output----------------
+	int                         //0 on success, -1 if writing failed
+	-----------------------------------
+
+
+Function 5: "CameraStatsWriteNumber()" 
+
+    //Write a number as a JSON value, null if it is NaN or infinite.
+	void CameraStatsWriteNumber(
+		const double  value,
+		FILE *	file
+	);
+	--------------input----------------
+	const double  value,        //number
+	FILE *	file                //opened file
+	-----------------------------------
+	JSON has no NaN or infinity, and printf writes them as "nan" and "inf". The JSON writers of "CameraReduce" and
+	"MonteCarlo" write their statistics through it, so a mean of no pixels or no samples becomes null.
+
+
+Function 6: "CameraStatsTrace()" 
+
+    //Record frame, row band and output events for "CameraStatsWriteTrace()".
+	void CameraStatsTrace(
+		const int     enable
+	);
+	--------------input----------------
+	const int     enable        //1 to record, 0 to stop
+	-----------------------------------
+
+
+Function 7: "CameraStatsWriteTrace()" 
+
+    //Write the recorded events in the Chrome trace event format (chrome://tracing, Perfetto).
+	int CameraStatsWriteTrace(
+		const char *  path
+	);
+	--------------input----------------
+	const char *  path          //JSON file
+	-----------------------------------
+	-------------output----------------
+	int                         //0 on success, -1 if writing failed
+	-----------------------------------
+	Events are "frame" (one simulated frame), "rows" (a row band of a thread), "text" and "binary" (output of a
+	frame), each with the pixels and bytes written in "args".
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <string.h>
+#include <cmath>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include "CameraStats.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define STATS_TSC
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define STATS_TSC
+#endif
+
+//names of the stages in the JSON output
+static const char * const StageName[CAMERA_STAGE_COUNT] = {
+	"ray","rotation","zenith","quadrant","dop","aop","kernel","text","binary"
+};
+
+//an event of the trace
+typedef struct TraceEvent
+{
+	const char *  Name;
+	uint64_t  Begin;            //first tick
+	uint64_t  End;              //last tick
+	uint64_t  Pixels;
+	uint64_t  Bytes;
+	int       Thread;           //index of the thread
+}
+TraceEvent;
+
+//counters of one thread, registered while the thread runs
+struct ThreadStats
+{
+	CameraStats  stats;
+	int          Thread;        //index of the thread in the trace
+	ThreadStats();
+	~ThreadStats();
+};
+
+static std::mutex                   StatsMutex;
+static std::vector<ThreadStats *>   Registry;       //counters of the running threads
+static CameraStats                  Retired;        //counters of the finished threads
+static int                          NextThread = 0;
+static std::vector<TraceEvent>      Trace;
+static std::atomic<int>             Tracing(0);
+static thread_local ThreadStats     Local;
+
+//tick and steady clock at the start of the program, for the tick rate
+static const uint64_t StartTicks = CameraStatsClock();
+static const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+
+
+
+//Add counters b to counters a.
+static void StatsAdd(
+	CameraStats *	a,  //sum
+	const CameraStats *	b   //added counters
+	){
+	for(int k=0; k<CAMERA_STAGE_COUNT; k++){
+		a->StageTicks[k] += b->StageTicks[k];
+		a->StageItems[k] += b->StageItems[k];
+	}
+	for(int k=0; k<CAMERA_QUADRANT_COUNT; k++){
+		a->QuadrantHits[k] += b->QuadrantHits[k];
+	}
+	a->Frames += b->Frames;
+	a->Pixels += b->Pixels;
+	a->BytesWritten += b->BytesWritten;
+	a->ZeroDOP += b->ZeroDOP;
+}
+
+
+
+ThreadStats::ThreadStats(){
+	memset(&stats,0,sizeof(stats));
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	Thread = NextThread++;
+	Registry.push_back(this);
+}
+
+
+
+ThreadStats::~ThreadStats(){
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	StatsAdd(&Retired,&stats);
+	for(size_t k=0; k<Registry.size(); k++){
+		if(Registry[k]==this){
+			Registry.erase(Registry.begin()+k);
+			break;
+		}
+	}
+}
+
+
+
+//Ticks per nanosecond since the start of the program.
+static double TickRate(){
+#ifdef STATS_TSC
+	uint64_t ticks = CameraStatsClock();
+	double ns = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-StartTime).count();
+	return ns>0.0 && ticks>StartTicks ? (ticks-StartTicks)/ns : 1.0;
+#else
+	return 1.0;
+#endif
+}
+
+
+
+//Current tick.
+uint64_t CameraStatsClock(){
+#ifdef STATS_TSC
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+
+//Counters of the calling thread.
+CameraStats * CameraStatsThread(){
+	return &Local.stats;
+}
+
+
+
+//Add the time since begin to a stage and return the current tick, which starts the next stage.
+uint64_t CameraStatsStage(
+	const int     stage,        //CAMERA_STAGE_
+	const uint64_t  begin,      //tick of the start of the stage
+	const uint64_t  items       //pixels through the stage
+	){
+	uint64_t now = CameraStatsClock();
+	CameraStats * stats = &Local.stats;
+	stats->StageTicks[stage] += now-begin;
+	stats->StageItems[stage] += items;
+	return now;
+}
+
+
+
+//Record an event if the trace is enabled.
+void CameraStatsTraceEvent(
+	const char *  name,         //event name
+	const uint64_t  begin,      //first tick
+	const uint64_t  end,        //last tick
+	const uint64_t  pixels,     //pixels of the event
+	const uint64_t  bytes       //bytes written by the event
+	){
+	if(!Tracing.load(std::memory_order_relaxed)){
+		return;
+	}
+	TraceEvent event;
+	event.Name = name;
+	event.Begin = begin;
+	event.End = end;
+	event.Pixels = pixels;
+	event.Bytes = bytes;
+	event.Thread = Local.Thread;
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	Trace.push_back(event);
+}
+
+
+
+//1 if the instrumentation is compiled in.
+int CameraStatsEnabled(){
+#ifdef HPC_ENABLE_STATS
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+
+
+//Clear the counters and the recorded trace.
+void CameraStatsReset(){
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	for(size_t k=0; k<Registry.size(); k++){
+		memset(&Registry[k]->stats,0,sizeof(CameraStats));
+	}
+	memset(&Retired,0,sizeof(Retired));
+	Trace.clear();
+}
+
+
+
+//Sum the counters of all threads (call it between frames).
+void CameraStatsGet(
+	CameraStats *	stats  //counters
+	){
+	memset(stats,0,sizeof(CameraStats));
+	{
+		std::lock_guard<std::mutex> lock(StatsMutex);
+		StatsAdd(stats,&Retired);
+		for(size_t k=0; k<Registry.size(); k++){
+			StatsAdd(stats,&Registry[k]->stats);
+		}
+	}
+	stats->TicksPerNanosecond = TickRate();
+	for(int k=0; k<CAMERA_STAGE_COUNT; k++){
+		stats->StageNanoseconds[k] = stats->StageTicks[k]/stats->TicksPerNanosecond;
+	}
+}
+
+
+
+//Write counters as a JSON object.
+int CameraStatsWriteJson(
+	const CameraStats *	stats,  //counters
+	FILE *	file                //opened file
+	){
+	fprintf(file,"{\n  \"enabled\": %d,\n  \"frames\": %llu,\n  \"pixels\": %llu,\n  \"bytes_written\": %llu,\n",
+		CameraStatsEnabled(),(unsigned long long)stats->Frames,(unsigned long long)stats->Pixels,
+		(unsigned long long)stats->BytesWritten);
+	fprintf(file,"  \"ticks_per_ns\": %.6f,\n  \"stages\": {\n",stats->TicksPerNanosecond);
+	for(int k=0; k<CAMERA_STAGE_COUNT; k++){
+		fprintf(file,"    \"%s\": {\"ticks\": %llu, \"ns\": %.0f, \"items\": %llu, \"ns_per_item\": %.3f}%s\n",
+			StageName[k],(unsigned long long)stats->StageTicks[k],stats->StageNanoseconds[k],
+			(unsigned long long)stats->StageItems[k],
+			stats->StageItems[k] ? stats->StageNanoseconds[k]/stats->StageItems[k] : 0.0,
+			k+1<CAMERA_STAGE_COUNT ? "," : "");
+	}
+	fprintf(file,"  },\n  \"quadrant_hits\": [");
+	for(int k=0; k<CAMERA_QUADRANT_COUNT; k++){
+		fprintf(file,"%llu%s",(unsigned long long)stats->QuadrantHits[k],k+1<CAMERA_QUADRANT_COUNT ? ", " : "");
+	}
+	fprintf(file,"],\n  \"zero_dop\": %llu\n}\n",(unsigned long long)stats->ZeroDOP);
+	return ferror(file) ? -1 : 0;
+}
+
+
+
+//Write a number as a JSON value, null if it is NaN or infinite.
+void CameraStatsWriteNumber(
+	const double  value,        //number
+	FILE *	file                //opened file
+	){
+	if(std::isfinite(value)){
+		fprintf(file,"%.9g",value);
+	}
+	else{
+		fputs("null",file);
+	}
+}
+
+
+
+//Record frame, row band and output events for "CameraStatsWriteTrace()".
+void CameraStatsTrace(
+	const int     enable        //1 to record, 0 to stop
+	){
+	Tracing.store(enable ? 1 : 0);
+}
+
+
+
+//Write the recorded events in the Chrome trace event format (chrome://tracing, Perfetto).
+int CameraStatsWriteTrace(
+	const char *  path          //JSON file
+	){
+	FILE * file = fopen(path,"w");
+	if(file==NULL){
+		return -1;
+	}
+	double rate = TickRate();
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	fprintf(file,"{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+	for(size_t k=0; k<Trace.size(); k++){
+		const TraceEvent & e = Trace[k];
+		//timestamps in microseconds since the start of the program
+		fprintf(file,"{\"name\": \"%s\", \"cat\": \"camera\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+			"\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"pixels\": %llu, \"bytes\": %llu}}%s\n",
+			e.Name,e.Thread,(double)(int64_t)(e.Begin-StartTicks)/rate*1e-3,(double)(e.End-e.Begin)/rate*1e-3,
+			(unsigned long long)e.Pixels,(unsigned long long)e.Bytes,k+1<Trace.size() ? "," : "");
+	}
+	fprintf(file,"]}\n");
+	int status = ferror(file) ? -1 : 0;
+	if(fclose(file)!=0){
+		status = -1;
+	}
+	return status;
+}
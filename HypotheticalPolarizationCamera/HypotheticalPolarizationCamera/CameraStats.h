@@ -0,0 +1,104 @@
+#ifndef _CAMERASTATS_H_
+#define _CAMERASTATS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+//Define HPC_ENABLE_STATS (e.g. in the preprocessor definitions of the project) to compile the instrumentation in.
+//Without it the STATS_ macros expand to nothing and "CameraStatsGet()" returns zeros.
+
+//stages of the simulation
+#define CAMERA_STAGE_RAY            0       //location of pixel P plus focus (ray construction)
+#define CAMERA_STAGE_ROTATION       1       //C_bTv multiply of the shooting direction
+#define CAMERA_STAGE_ZENITH         2       //norm and acos of the zenith angle
+#define CAMERA_STAGE_QUADRANT       3       //quadrant judgement and atan of fi_v_P
+#define CAMERA_STAGE_DOP            4       //DOP of the Rayleigh sky model
+#define CAMERA_STAGE_AOP            5       //E-vector, C_vTb multiply, atan and elimination of invalid AOP
+#define CAMERA_STAGE_KERNEL         6       //rows of the vectorized and closed-form kernels (all of the above at once)
+#define CAMERA_STAGE_TEXT           7       //text output in the format of HypotheticalImages.txt
+#define CAMERA_STAGE_BINARY         8       //binary frame file output
+#define CAMERA_STAGE_COUNT          9
+
+//branches of the quadrant judgement of fi_v_P, in the order of the reference code
+#define CAMERA_QUADRANT_COUNT       8       //7 branches plus "no branch taken" (NaN shooting direction)
+
+//counters of the instrumentation, summed over all threads
+typedef struct CameraStats
+{
+	uint64_t  StageTicks[CAMERA_STAGE_COUNT];       //time of every stage (unit is tick, a processor cycle on x86)
+	double    StageNanoseconds[CAMERA_STAGE_COUNT]; //time of every stage (unit is nanosecond)
+	uint64_t  StageItems[CAMERA_STAGE_COUNT];       //pixels through every stage
+
+	uint64_t  Frames;               //simulated frames
+	uint64_t  Pixels;               //simulated pixels
+	uint64_t  BytesWritten;         //bytes written by the text and binary outputs
+
+	uint64_t  QuadrantHits[CAMERA_QUADRANT_COUNT];  //pixels taking each branch of the quadrant judgement
+	uint64_t  ZeroDOP;              //pixels whose AOP was eliminated because DOP==0
+
+	double    TicksPerNanosecond;   //tick rate used for StageNanoseconds
+}
+CameraStats;
+
+//1 if the instrumentation is compiled in.
+int CameraStatsEnabled();
+
+//Clear the counters and the recorded trace.
+void CameraStatsReset();
+
+//Sum the counters of all threads (call it between frames).
+void CameraStatsGet(
+	CameraStats *	stats  //counters
+	);
+
+//Write counters as a JSON object.
+int CameraStatsWriteJson(
+	const CameraStats *	stats,  //counters
+	FILE *	file                //opened file
+	);
+
+//Write a number as a JSON value, null if it is NaN or infinite.
+void CameraStatsWriteNumber(
+	const double  value,        //number
+	FILE *	file                //opened file
+	);
+
+//Record frame, row band and output events for "CameraStatsWriteTrace()".
+void CameraStatsTrace(
+	const int     enable        //1 to record, 0 to stop
+	);
+
+//Write the recorded events in the Chrome trace event format (chrome://tracing, Perfetto).
+int CameraStatsWriteTrace(
+	const char *  path          //JSON file
+	);
+
+//used by the STATS_ macros
+uint64_t CameraStatsClock();
+CameraStats * CameraStatsThread();
+uint64_t CameraStatsStage(
+	const int     stage,        //CAMERA_STAGE_
+	const uint64_t  begin,      //tick of the start of the stage
+	const uint64_t  items       //pixels through the stage
+	);
+void CameraStatsTraceEvent(
+	const char *  name,         //event name
+	const uint64_t  begin,      //first tick
+	const uint64_t  end,        //last tick
+	const uint64_t  pixels,     //pixels of the event
+	const uint64_t  bytes       //bytes written by the event
+	);
+
+#ifdef HPC_ENABLE_STATS
+#define STATS_CLOCK(t)                      uint64_t t = CameraStatsClock()
+#define STATS_STAGE(stage,t,items)          (t = CameraStatsStage(stage,t,items))
+#define STATS_COUNT(counter,n)              (CameraStatsThread()->counter += (n))
+#define STATS_TRACE(name,t,pixels,bytes)    CameraStatsTraceEvent(name,t,CameraStatsClock(),pixels,bytes)
+#else
+#define STATS_CLOCK(t)                      ((void)0)
+#define STATS_STAGE(stage,t,items)          ((void)0)
+#define STATS_COUNT(counter,n)              ((void)0)
+#define STATS_TRACE(name,t,pixels,bytes)    ((void)0)
+#endif
+
+#endif
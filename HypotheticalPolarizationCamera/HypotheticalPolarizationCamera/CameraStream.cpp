@@ -0,0 +1,370 @@
+/*
+Frame Streaming of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for simulating a time series of frames of a camera on a trajectory under the sun of a location and a UTC time.
+And this code is written in C++11.
+
+Usage information:
+Replay a flight with "CameraSimulationStream()"; simulation and writing overlap through two frame buffers.
+--------------------------
+
+Streaming:
+	Every frame of a stream has its own UTC time, Start plus FrameIndex*FrameInterval seconds. The body attitude of
+	that time is interpolated linearly between the points of the trajectory (the shorter way round for the angles,
+	the first and the last point before and after it), the sun position comes from "SolarPosition()", and
+	"SolarCameraAttitude()" turns both into the Euler angles psa, afa and beta of the simulation.
+	Two frames are allocated. While the sink of frame N runs on a background writer thread, frame N+1 is simulated
+	into the other frame over the thread pool; frame N+2 waits until the sink of frame N has returned. A long replay
+	then takes the time of the slower of the two instead of their sum, and the frames still reach the sink one at a
+	time and in order. The sink receives a copy of the camera parameters with the attitude of its frame.
+
+
+Function 1: "CameraStreamFrameCount()" 
+
+    //Number of frames of a stream.
+	int CameraStreamFrameCount(
+		const CameraStreamSettings *	settings
+	);
+	--------------input----------------
+	const CameraStreamSettings *	settings    //stream settings
+	-----------------------------------
+	-------------output----------------
+	int                                         //floor(Duration/FrameInterval)+1, 0 if the settings are invalid
+	-----------------------------------
+
+
+Function 2: "CameraStreamAttitude()" 
+
+    //Sun position and Euler angles of camera of a frame of a stream.
+	int CameraStreamAttitude(
+		const CameraStreamSettings *	settings,
+		const int     FrameIndex,
+		CameraAttitude *	attitude,
+		double &	Azimuth,
+		double &	Elevation
+	);
+	--------------input----------------
+	const CameraStreamSettings *	settings,   //stream settings
+	const int     FrameIndex,                   //index of the frame, 0 to "CameraStreamFrameCount()"-1
+	-----------------------------------
+	-------------output----------------
+	CameraAttitude *	attitude,               //Euler angles of camera (from body to solar vector coordinate system)
+	double &	Azimuth,                        //azimuth of the sun from north towards east (unit is degree)
+	double &	Elevation                       //elevation of the sun (unit is degree)
+	int                                         //0, or -1 if the settings or FrameIndex are invalid
+	-----------------------------------
+
+
+Function 3: "CameraSimulationStream()" 
+
+    //Hypothetical polarization camera simulation of a stream with a double-buffered background writer.
+	int CameraSimulationStream(
+		const CameraStreamSettings *	settings,
+		const CameraParameters *	parm,
+		ThreadPool *	pool,
+		CameraFrameSink	sink,
+		void *	context
+	);
+	--------------input----------------
+	const CameraStreamSettings *	settings,   //stream settings
+	const CameraParameters *	parm,           //camera parameters, not changed
+	ThreadPool *	pool,                       //thread pool of the simulation, NULL runs on the calling thread
+	CameraFrameSink	sink,                       //called once per frame in the order of the frames, on the writer thread
+	void *	context                             //passed to the sink
+	-----------------------------------
+	-------------output----------------
+	int                                         //0 on success, -1 if the settings are invalid or the frames cannot
+	                                            //be allocated, or the nonzero value of the sink
+	-----------------------------------
+
+Example:
+
+	CameraTrajectoryPoint path[2] = {{0.0,0.0,90.0*pi/180.0,0.0},{600.0,pi,80.0*pi/180.0,0.1}};
+	CameraStreamSettings settings = {{32.03,118.85},{2019,10,23,4,30,0.0},600.0,0.1,path,2};	//10 minutes at 10 Hz
+	FrameWriter * writer = FrameWriterOpen("output/flight.hpcf",FRAME_SCALAR_DOUBLE);
+	ThreadPool pool(0);
+	CameraSimulationStream(&settings,Camera_paremeters,&pool,CameraFrameSinkBinary,writer);
+	FrameWriterClose(writer);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "CameraStream.h"
+#include "ThreadPool.h"
+
+//Number of frames simulated and written at the same time
+#define STREAM_BUFFERS              2
+
+const static double pi = 3.141592653589793;
+
+//frames shared by the simulation and the writer thread
+typedef struct StreamBuffers
+{
+	CameraFrame *	frame[STREAM_BUFFERS];      //DOP and AOP of every buffer
+	CameraParameters	parm[STREAM_BUFFERS];   //camera parameters and attitude of the frame of every buffer
+	int     FrameIndex[STREAM_BUFFERS];         //frame held by every buffer, -1 if the buffer is free
+	int     Status;                             //first nonzero value of the sink
+	bool    Stop;                               //no more frames follow
+	CameraFrameSink	sink;
+	void *	context;
+	std::mutex                Mutex;
+	std::condition_variable   Changed;          //a buffer was filled or freed
+}
+StreamBuffers;
+
+
+
+//Angle a+t*(b-a) the shorter way round (unit is radian).
+static double InterpolateAngle(
+	const double  a,            //angle at t=0
+	const double  b,            //angle at t=1
+	const double  t             //0 to 1
+	){
+	double d = fmod(b-a,2.0*pi);
+	if(d>pi){
+		d = d-2.0*pi;
+	}
+	else if(d<-pi){
+		d = d+2.0*pi;
+	}
+	return a+t*d;
+}
+
+
+
+//Body attitude of a trajectory at a time.
+static void TrajectoryAttitude(
+	const CameraStreamSettings *	settings,   //stream settings
+	const double  time,                         //time from the start of the stream (unit is second)
+	double &	Heading,                        //yaw angle (unit is radian)
+	double &	Pitch,                          //pitch angle (unit is radian)
+	double &	Roll                            //roll angle (unit is radian)
+	){
+	const CameraTrajectoryPoint * p = settings->Trajectory;
+	int n = settings->TrajectoryCount;
+	if(n==1 || time<=p[0].Time){
+		Heading = p[0].Heading;
+		Pitch = p[0].Pitch;
+		Roll = p[0].Roll;
+		return;
+	}
+	if(time>=p[n-1].Time){
+		Heading = p[n-1].Heading;
+		Pitch = p[n-1].Pitch;
+		Roll = p[n-1].Roll;
+		return;
+	}
+
+	//segment [k,k+1] holding the time by bisection
+	int k = 0;
+	int last = n-1;
+	while(last-k>1){
+		int middle = (k+last)/2;
+		if(p[middle].Time<=time){
+			k = middle;
+		}
+		else{
+			last = middle;
+		}
+	}
+	double span = p[k+1].Time-p[k].Time;
+	double t = span>0.0 ? (time-p[k].Time)/span : 1.0;
+	Heading = InterpolateAngle(p[k].Heading,p[k+1].Heading,t);
+	Pitch = InterpolateAngle(p[k].Pitch,p[k+1].Pitch,t);
+	Roll = InterpolateAngle(p[k].Roll,p[k+1].Roll,t);
+}
+
+
+
+//Write the frames of the buffers in order until the stream stops or the sink fails (writer thread).
+static void StreamWriter(
+	StreamBuffers *	buffers     //frames shared with the simulation
+	){
+	for(int n=0; ; n++){
+		int b = n%STREAM_BUFFERS;
+		{
+			std::unique_lock<std::mutex> lock(buffers->Mutex);
+			buffers->Changed.wait(lock,[&](){ return buffers->FrameIndex[b]==n || buffers->Stop; });
+			if(buffers->FrameIndex[b]!=n){
+				return;
+			}
+		}
+
+		int status = buffers->sink(buffers->context,n,buffers->frame[b],&buffers->parm[b]);
+		{
+			std::lock_guard<std::mutex> lock(buffers->Mutex);
+			buffers->FrameIndex[b] = -1;
+			buffers->Status = status;
+		}
+		buffers->Changed.notify_all();
+		if(status!=0){
+			return;
+		}
+	}
+}
+
+
+
+//Number of frames of a stream, 0 if the settings are invalid.
+int CameraStreamFrameCount(
+	const CameraStreamSettings *	settings    //stream settings
+	){
+	if(settings==NULL || settings->Trajectory==NULL || settings->TrajectoryCount<1
+		|| !(settings->FrameInterval>0.0) || !(settings->Duration>=0.0)){
+		return 0;
+	}
+	double count = floor(settings->Duration/settings->FrameInterval*(1.0+1e-12))+1.0;	//the last frame survives rounding
+	return count<2147483647.0 ? (int)count : 0;
+}
+
+
+
+//Sun position and Euler angles of camera of a frame of a stream.
+int CameraStreamAttitude(
+	const CameraStreamSettings *	settings,   //stream settings
+	const int     FrameIndex,                   //index of the frame, 0 to "CameraStreamFrameCount()"-1
+	CameraAttitude *	attitude,               //Euler angles of camera (from body to solar vector coordinate system)
+	double &	Azimuth,                        //azimuth of the sun from north towards east (unit is degree)
+	double &	Elevation                       //elevation of the sun (unit is degree)
+	){
+	if(FrameIndex<0 || FrameIndex>=CameraStreamFrameCount(settings)){
+		return -1;
+	}
+	double time = FrameIndex*settings->FrameInterval;
+	double Heading, Pitch, Roll;
+	TrajectoryAttitude(settings,time,Heading,Pitch,Roll);
+	SolarPosition(&settings->Location,SolarJulianDay(&settings->Start)+time/86400.0,Azimuth,Elevation);
+	SolarCameraAttitude(Azimuth,Elevation,Heading,Pitch,Roll,attitude->psa,attitude->afa,attitude->beta);
+	return 0;
+}
+
+
+
+//Hypothetical polarization camera simulation of a stream, the sink running on a background thread while the
+//next frame is simulated.
+int CameraSimulationStream(
+	const CameraStreamSettings *	settings,   //stream settings
+	const CameraParameters *	parm,           //camera parameters, not changed
+	ThreadPool *	pool,                       //thread pool of the simulation, NULL runs on the calling thread
+	CameraFrameSink	sink,                       //called once per frame in the order of the frames
+	void *	context                             //passed to the sink
+	){
+	int count = CameraStreamFrameCount(settings);
+	if(count==0){
+		return -1;
+	}
+
+	StreamBuffers buffers;
+	int status = 0;
+	for(int b=0; b<STREAM_BUFFERS; b++){
+		buffers.frame[b] = CameraFrameInit(parm);
+		buffers.parm[b] = *parm;
+		buffers.FrameIndex[b] = -1;
+		if(buffers.frame[b]==NULL){
+			status = -1;
+		}
+	}
+	buffers.Status = 0;
+	buffers.Stop = false;
+	buffers.sink = sink;
+	buffers.context = context;
+
+	if(status==0){
+		std::thread writer(StreamWriter,&buffers);
+		for(int n=0; n<count; n++){
+			//wait until the sink has returned the frame of the buffer
+			int b = n%STREAM_BUFFERS;
+			{
+				std::unique_lock<std::mutex> lock(buffers.Mutex);
+				buffers.Changed.wait(lock,[&](){ return buffers.FrameIndex[b]<0 || buffers.Status!=0; });
+				if(buffers.Status!=0){
+					break;
+				}
+			}
+
+			CameraAttitude attitude;
+			double Azimuth, Elevation;
+			CameraStreamAttitude(settings,n,&attitude,Azimuth,Elevation);
+			double C_vTb[3][3], C_bTv[3][3];
+			CameraRotationMatrix(attitude.psa,attitude.afa,attitude.beta,C_vTb,C_bTv);
+			CameraSimulationFrameRotation(C_vTb,C_bTv,parm,buffers.frame[b],pool);
+			buffers.parm[b].psa = attitude.psa;
+			buffers.parm[b].afa = attitude.afa;
+			buffers.parm[b].beta = attitude.beta;
+
+			//hand the frame to the writer thread
+			{
+				std::lock_guard<std::mutex> lock(buffers.Mutex);
+				buffers.FrameIndex[b] = n;
+			}
+			buffers.Changed.notify_all();
+		}
+
+		//the writer finishes the frames it holds, then returns
+		{
+			std::lock_guard<std::mutex> lock(buffers.Mutex);
+			buffers.Stop = true;
+		}
+		buffers.Changed.notify_all();
+		writer.join();
+		status = buffers.Status;
+	}
+
+	for(int b=0; b<STREAM_BUFFERS; b++){
+		CameraFrameFree(buffers.frame[b]);
+	}
+	return status;
+}
@@ -0,0 +1,53 @@
+#ifndef _CAMERASTREAM_H_
+#define _CAMERASTREAM_H_
+
+#include "CameraBatch.h"
+#include "SolarEphemeris.h"
+
+//body attitude of a trajectory in the local east-north-up coordinate system (see SolarEphemeris.cpp)
+typedef struct CameraTrajectoryPoint
+{
+	double  Time;           //time from the start of the stream (unit is second)
+	double  Heading;        //yaw angle, the body y axis from north towards east (unit is radian)
+	double  Pitch;          //pitch angle, the body y axis above the horizon (unit is radian)
+	double  Roll;           //roll angle about the body y axis (unit is radian)
+}
+CameraTrajectoryPoint;
+
+//time series of frames of a camera on a trajectory
+typedef struct CameraStreamSettings
+{
+	SolarLocation  Location;        //geodetic location of the camera
+	SolarTime      Start;           //UTC time of the first frame
+	double         Duration;        //time from the first to the last frame (unit is second)
+	double         FrameInterval;   //time between two frames (unit is second)
+	const CameraTrajectoryPoint *	Trajectory;  //body attitudes in increasing Time, interpolated linearly
+	int            TrajectoryCount; //number of body attitudes (at least 1)
+}
+CameraStreamSettings;
+
+//Number of frames of a stream, 0 if the settings are invalid.
+int CameraStreamFrameCount(
+	const CameraStreamSettings *	settings    //stream settings
+	);
+
+//Sun position and Euler angles of camera of a frame of a stream.
+int CameraStreamAttitude(
+	const CameraStreamSettings *	settings,   //stream settings
+	const int     FrameIndex,                   //index of the frame, 0 to "CameraStreamFrameCount()"-1
+	CameraAttitude *	attitude,               //Euler angles of camera (from body to solar vector coordinate system)
+	double &	Azimuth,                        //azimuth of the sun from north towards east (unit is degree)
+	double &	Elevation                       //elevation of the sun (unit is degree)
+	);
+
+//Hypothetical polarization camera simulation of a stream, the sink running on a background thread while the
+//next frame is simulated.
+int CameraSimulationStream(
+	const CameraStreamSettings *	settings,   //stream settings
+	const CameraParameters *	parm,           //camera parameters, not changed
+	ThreadPool *	pool,                       //thread pool of the simulation, NULL runs on the calling thread
+	CameraFrameSink	sink,                       //called once per frame in the order of the frames
+	void *	context                             //passed to the sink
+	);
+
+#endif
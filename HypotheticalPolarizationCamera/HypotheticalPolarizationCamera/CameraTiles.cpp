@@ -0,0 +1,470 @@
+/*
+"CameraSimulationTiled()" and tile file functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for simulating sensors and mosaics larger than the memory into a tiled binary file.
+And this code is written in C++11.
+
+Usage information:
+Render a huge frame with "CameraSimulationTiled()" and read it back tile by tile with "TileFileReadTile()".
+--------------------------
+
+Tiles:
+	A frame of a sensor with tens of thousands of pixels per side does not fit in memory, and neither does its ray
+	table, which "CameraParametersInit()" builds for frames up to CAMERA_RAY_TABLE_MAX_PIXELS (24 bytes per pixel,
+	384 MB at 4096x4096). Camera parameters of "CameraParametersInitNoTable()" have none: the pinhole frames come
+	from the row kernels and other lenses take the shooting directions of every tile from "CameraLensRay()".
+	"CameraSimulationTiled()" never holds the frame: it cuts it into tiles of TileRows*TileCols simulated pixels
+	and walks them in file order, tile row after tile row, in groups of as many tiles as half of MemoryBudget
+	holds. The tiles of a group are simulated over the thread pool with "CameraSimulationBlock()" straight into
+	the layout of the file, and the group is written with a single fwrite on a background thread while the next
+	group is simulated into the other half. With the parameters of "CameraParametersInitNoTable()" peak memory is
+	then MemoryBudget (at least two tiles) whatever the size of the sensor; a table already built by
+	"CameraParametersInit()" is used, but adds its size. Every pixel is identical to the pixel of
+	"CameraSimulationFrameParallel()" with the same camera parameters.
+	"TileFileOpen()" and "TileFileReadTile()" read a single tile with 64-bit file offsets, so a viewer or a later
+	stage only loads the tiles it looks at.
+
+
+Function 1: "CameraSimulationTiled()" 
+
+    //Hypothetical polarization camera simulation into a tile file with bounded memory.
+	int CameraSimulationTiled(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		const CameraParameters *	parm,
+		const int     TileRows,
+		const int     TileCols,
+		const int     ScalarType,
+		const size_t  MemoryBudget,
+		ThreadPool *	pool,
+		const char *  path
+	);
+	--------------input----------------
+	const double  psa,                 //yaw angle (unit is radian)
+	const double  afa,                 //pitch angle (unit is radian)
+    const double  beta,                //roll angle (unit is radian)
+	const CameraParameters *	parm,  //camera parameters, not changed
+	const int     TileRows,            //frame rows of a tile, 0 for TILE_DEFAULT_SIZE
+	const int     TileCols,            //frame columns of a tile, 0 for TILE_DEFAULT_SIZE
+	const int     ScalarType,          //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT, the precision of the simulation
+	const size_t  MemoryBudget,        //bytes of the tile buffers, 0 for TILE_MEMORY_BUDGET
+	ThreadPool *	pool,              //thread pool, NULL runs on the calling thread
+	const char *  path                 //file name
+	-----------------------------------
+	-------------output----------------
+	int                                //0 on success, -1 if the arguments are invalid or the file cannot be written
+	-----------------------------------
+
+
+Function 2: "TileFileOpen()" 
+
+    //Open a tile file and check its header.
+	TileFile * TileFileOpen(
+		const char *  path
+	);
+	--------------input----------------
+	const char *  path          //file name
+	-----------------------------------
+	-------------output----------------
+	TileFile *                  //tile file with its header, NULL if the file is missing, truncated or not a tile file
+	-----------------------------------
+
+
+Function 3: "TileFileReadTile()" 
+
+    //Read a tile of a tile file.
+	int TileFileReadTile(
+		TileFile *	tiles,
+		const int     a,
+		const int     b,
+		void *	DOP,
+		void *	AOP
+	);
+	--------------input----------------
+	TileFile *	tiles,          //opened tile file
+	const int     a,            //tile row, 0 to header.Tiles_x-1
+	const int     b             //tile column, 0 to header.Tiles_z-1
+	-----------------------------------
+	-------------output----------------
+	void *	DOP,                //DOP of frame pixel (a*TileRows+i, b*TileCols+j) at [i*TileCols+j], NaN outside the frame
+	void *	AOP                 //AOP in the same layout (unit is degree); both double or float as header.ScalarType
+	int                         //0, or -1 if the tile does not exist or cannot be read
+	-----------------------------------
+
+
+Function 4: "TileFileClose()" 
+
+    //Close a tile file.
+	void TileFileClose(
+		TileFile *	tiles
+	);
+
+Example:
+
+	CameraParameters * parm = CameraParametersInitNoTable(2.2,2.2,40001,40001,8.0,1);	//1.6e9 pixels
+	ThreadPool pool(0);
+	CameraSimulationTiled(0.0,pi/2,0.0,parm,0,0,FRAME_SCALAR_FLOAT,0,&pool,"output/panorama.hpct");
+	TileFile * tiles = TileFileOpen("output/panorama.hpct");
+	std::vector<float> DOP(256*256), AOP(256*256);
+	TileFileReadTile(tiles,78,78,&DOP[0],&AOP[0]);	//the tile of the principal point
+	TileFileClose(tiles);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits>
+#include <thread>
+#include "CameraTiles.h"
+#include "ThreadPool.h"
+#include "AlignedMemory.h"
+#include "CameraStats.h"
+
+#ifndef ALLOC
+#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
+#endif
+
+typedef char TileFileHeaderSizeCheck[sizeof(TileFileHeader)==128 ? 1 : -1];
+
+
+
+//Round up to FRAME_FILE_ALIGNMENT
+static int64_t AlignSize(
+	const int64_t  size         //size (unit is byte)
+	){
+	return (size+FRAME_FILE_ALIGNMENT-1)/FRAME_FILE_ALIGNMENT*FRAME_FILE_ALIGNMENT;
+}
+
+
+
+//Size of a tile plane in the file, padded to FRAME_FILE_ALIGNMENT (unit is byte)
+static int64_t TilePlaneSize(
+	const TileFileHeader &	header  //tile file header
+	){
+	size_t scalar = header.ScalarType==FRAME_SCALAR_FLOAT ? sizeof(float) : sizeof(double);
+	return AlignSize((int64_t)header.TileRows*header.TileCols*scalar);
+}
+
+
+
+//Seek to a 64-bit offset from the start of a file.
+static int SeekFile(
+	FILE *	file,               //opened file
+	const int64_t  offset       //offset (unit is byte)
+	){
+#ifdef _WIN32
+	return _fseeki64(file,offset,SEEK_SET);
+#else
+	return fseeko(file,(off_t)offset,SEEK_SET);
+#endif
+}
+
+
+
+//Simulate tile t of the file into its place in a tile buffer.
+template <class S>
+static void TileSimulation(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	const TileFileHeader &	header,    //tile file header
+	const int64_t  t,                  //index of the tile in the file
+	char *	tile                       //TileSize bytes
+	){
+	int a = (int)(t/header.Tiles_z);
+	int b = (int)(t%header.Tiles_z);
+	CameraBlock block;
+	block.i = a*header.TileRows;
+	block.j = b*header.TileCols;
+	block.n_x = header.n_x-block.i<header.TileRows ? header.n_x-block.i : header.TileRows;
+	block.n_z = header.n_z-block.j<header.TileCols ? header.n_z-block.j : header.TileCols;
+
+	S * DOP = (S *)tile;
+	S * AOP = (S *)(tile+TilePlaneSize(header));
+	if(block.n_x<header.TileRows || block.n_z<header.TileCols){
+		size_t count = (size_t)header.TileRows*header.TileCols;
+		for(size_t k=0; k<count; k++){
+			DOP[k] = std::numeric_limits<S>::quiet_NaN();
+			AOP[k] = std::numeric_limits<S>::quiet_NaN();
+		}
+	}
+	CameraSimulationBlock(C_vTb,C_bTv,parm,&block,DOP,AOP,(size_t)header.TileCols);
+}
+
+
+
+//Simulate and write every tile in groups, writing a group while the next one is simulated.
+template <class S>
+static int WriteTiles(
+	const CameraParameters *	parm,  //camera parameters
+	const TileFileHeader &	header,    //tile file header
+	const size_t  MemoryBudget,        //bytes of the tile buffers
+	ThreadPool *	pool,              //thread pool, NULL runs on the calling thread
+	FILE *	file                       //file positioned at the first tile
+	){
+	double C_vTb[3][3];//rotation matrix from solar vector to body coordinate system
+	double C_bTv[3][3];//rotation matrix from body to solar vector coordinate system
+	CameraRotationMatrix(header.psa,header.afa,header.beta,C_vTb,C_bTv);
+
+	int64_t TileCount = (int64_t)header.Tiles_x*header.Tiles_z;
+	int64_t group = (int64_t)(MemoryBudget/2/(size_t)header.TileSize);
+	group = group<1 ? 1 : (group>TileCount ? TileCount : group);
+
+	size_t BufferSize = (size_t)(group*header.TileSize);
+	char * buffer[2];
+	buffer[0] = (char *)AlignedAlloc(BufferSize);
+	buffer[1] = (char *)AlignedAlloc(BufferSize);
+	if(buffer[0]==NULL || buffer[1]==NULL){
+		AlignedFree(buffer[0]);
+		AlignedFree(buffer[1]);
+		return -1;
+	}
+	//the values are overwritten by every group, only the padding of the planes is cleared once
+	size_t plane = (size_t)TilePlaneSize(header);
+	size_t values = (size_t)header.TileRows*header.TileCols*sizeof(S);
+	for(size_t offset=0; offset<BufferSize; offset+=plane){
+		memset(buffer[0]+offset+values,0,plane-values);
+		memset(buffer[1]+offset+values,0,plane-values);
+	}
+
+	int status = 0;       //status of the writer thread, read after joining it
+	std::thread writer;
+	for(int64_t first=0, g=0; first<TileCount; first+=group, g++){
+		int n = (int)(TileCount-first<group ? TileCount-first : group);
+		char * tiles = buffer[g%2];
+		STATS_CLOCK(tick);
+		auto task = [&](int begin, int end){
+			for(int k=begin; k<end; k++){
+				TileSimulation<S>(C_vTb,C_bTv,parm,header,first+k,tiles+(size_t)k*header.TileSize);
+			}
+		};
+		if(pool==NULL){
+			task(0,n);
+		}
+		else{
+			pool->ParallelFor(n,1,task);
+		}
+		STATS_TRACE("tiles",tick,(uint64_t)n*header.TileRows*header.TileCols,0);
+
+		if(writer.joinable()){
+			writer.join();
+		}
+		if(status!=0){
+			break;
+		}
+		size_t size = (size_t)n*header.TileSize;
+		writer = std::thread([&status,file,tiles,size](){
+			STATS_CLOCK(tick);
+			if(fwrite(tiles,1,size,file)!=size){
+				status = -1;
+			}
+			STATS_COUNT(BytesWritten,size);
+			STATS_TRACE("tiles-write",tick,0,size);
+		});
+	}
+	if(writer.joinable()){
+		writer.join();
+	}
+	AlignedFree(buffer[0]);
+	AlignedFree(buffer[1]);
+	return status;
+}
+
+
+
+//Hypothetical polarization camera simulation into a tile file with bounded memory.
+int CameraSimulationTiled(
+	const double  psa,                 //yaw angle (unit is radian)
+	const double  afa,                 //pitch angle (unit is radian)
+    const double  beta,                //roll angle (unit is radian)
+	const CameraParameters *	parm,  //camera parameters, not changed
+	const int     TileRows,            //frame rows of a tile, 0 for TILE_DEFAULT_SIZE
+	const int     TileCols,            //frame columns of a tile, 0 for TILE_DEFAULT_SIZE
+	const int     ScalarType,          //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	const size_t  MemoryBudget,        //bytes of the tile buffers, 0 for TILE_MEMORY_BUDGET
+	ThreadPool *	pool,              //thread pool, NULL runs on the calling thread
+	const char *  path                 //file name
+	){
+	if(parm==NULL || TileRows<0 || TileCols<0 || (ScalarType!=FRAME_SCALAR_DOUBLE && ScalarType!=FRAME_SCALAR_FLOAT)){
+		return -1;
+	}
+	int n_x, n_z;
+	CameraFrameSize(parm,n_x,n_z);
+	if(n_x<=0 || n_z<=0){
+		return -1;
+	}
+
+	TileFileHeader header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.Magic,TILE_FILE_MAGIC,4);
+	header.Version = TILE_FILE_VERSION;
+	header.HeaderSize = sizeof(TileFileHeader);
+	header.ScalarType = ScalarType;
+	header.n_x = n_x;
+	header.n_z = n_z;
+	header.PixelInterval = parm->PixelInterval;
+	header.Camera_n_x = parm->n_x;
+	header.Camera_n_z = parm->n_z;
+	header.TileRows = TileRows>0 ? TileRows : TILE_DEFAULT_SIZE;
+	header.TileCols = TileCols>0 ? TileCols : TILE_DEFAULT_SIZE;
+	header.Tiles_x = (n_x+header.TileRows-1)/header.TileRows;
+	header.Tiles_z = (n_z+header.TileCols-1)/header.TileCols;
+	header.D_x = parm->D_x;
+	header.D_z = parm->D_z;
+	header.f = parm->f;
+	header.psa = psa;
+	header.afa = afa;
+	header.beta = beta;
+	header.DataOffset = AlignSize(sizeof(TileFileHeader));
+	header.TileSize = 2*TilePlaneSize(header);
+
+	FILE * file = fopen(path,"wb");
+	if(file==NULL){
+		return -1;
+	}
+	//the groups are large, so they go straight to the file without a stdio buffer
+	setvbuf(file,NULL,_IONBF,0);
+	static const char zeros[FRAME_FILE_ALIGNMENT] = {0};
+	size_t padding = (size_t)(header.DataOffset-sizeof(header));
+	int status = fwrite(&header,sizeof(header),1,file)==1 && fwrite(zeros,1,padding,file)==padding ? 0 : -1;
+	if(status==0){
+		size_t budget = MemoryBudget>0 ? MemoryBudget : TILE_MEMORY_BUDGET;
+		if(ScalarType==FRAME_SCALAR_FLOAT){
+			status = WriteTiles<float>(parm,header,budget,pool,file);
+		}
+		else{
+			status = WriteTiles<double>(parm,header,budget,pool,file);
+		}
+	}
+	if(fclose(file)!=0){
+		status = -1;
+	}
+	STATS_COUNT(Frames,1);
+	return status;
+}
+
+
+
+//Open a tile file and check its header.
+TileFile * TileFileOpen(
+	const char *  path          //file name
+	){
+	TileFile * tiles = ALLOC(TileFile);
+	if(tiles==NULL){
+		return NULL;
+	}
+	tiles->file = fopen(path,"rb");
+	if(tiles->file==NULL){
+		free(tiles);
+		return NULL;
+	}
+
+	TileFileHeader & header = tiles->header;
+	int valid = fread(&header,sizeof(header),1,tiles->file)==1 && memcmp(header.Magic,TILE_FILE_MAGIC,4)==0
+		&& header.Version==TILE_FILE_VERSION && header.HeaderSize==(int32_t)sizeof(TileFileHeader)
+		&& (header.ScalarType==FRAME_SCALAR_DOUBLE || header.ScalarType==FRAME_SCALAR_FLOAT)
+		&& header.n_x>0 && header.n_z>0 && header.TileRows>0 && header.TileCols>0
+		&& header.Tiles_x==(header.n_x+header.TileRows-1)/header.TileRows
+		&& header.Tiles_z==(header.n_z+header.TileCols-1)/header.TileCols
+		&& header.DataOffset>=header.HeaderSize && header.TileSize==2*TilePlaneSize(header);
+	if(valid){
+		//the last tile must be complete
+		char last;
+		int64_t end = header.DataOffset+(int64_t)header.Tiles_x*header.Tiles_z*header.TileSize;
+		valid = SeekFile(tiles->file,end-1)==0 && fread(&last,1,1,tiles->file)==1;
+	}
+	if(!valid){
+		fclose(tiles->file);
+		free(tiles);
+		return NULL;
+	}
+	return tiles;
+}
+
+
+
+//Read a tile of a tile file.
+int TileFileReadTile(
+	TileFile *	tiles,          //opened tile file
+	const int     a,            //tile row, 0 to Tiles_x-1
+	const int     b,            //tile column, 0 to Tiles_z-1
+	void *	DOP,                //TileRows*TileCols values of the scalar type of the file
+	void *	AOP                 //TileRows*TileCols values of the scalar type of the file (unit is degree)
+	){
+	const TileFileHeader & header = tiles->header;
+	if(a<0 || a>=header.Tiles_x || b<0 || b>=header.Tiles_z){
+		return -1;
+	}
+	size_t scalar = header.ScalarType==FRAME_SCALAR_FLOAT ? sizeof(float) : sizeof(double);
+	size_t count = (size_t)header.TileRows*header.TileCols;
+	int64_t offset = header.DataOffset+((int64_t)a*header.Tiles_z+b)*header.TileSize;
+	if(SeekFile(tiles->file,offset)!=0 || fread(DOP,scalar,count,tiles->file)!=count
+		|| SeekFile(tiles->file,offset+TilePlaneSize(header))!=0 || fread(AOP,scalar,count,tiles->file)!=count){
+		return -1;
+	}
+	return 0;
+}
+
+
+
+//Close a tile file.
+void TileFileClose(
+	TileFile *	tiles           //opened tile file
+	){
+	if(tiles==NULL){
+		return;
+	}
+	fclose(tiles->file);
+	free(tiles);
+}
@@ -0,0 +1,94 @@
+#ifndef _CAMERATILES_H_
+#define _CAMERATILES_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "PolarizationCamera.h"
+#include "FrameIO.h"
+
+#define TILE_FILE_MAGIC             "HPCT"
+#define TILE_FILE_VERSION           1
+
+#define TILE_DEFAULT_SIZE           256         //frame rows and columns of a tile if 0 is given
+#define TILE_MEMORY_BUDGET          (64<<20)    //tile buffers of "CameraSimulationTiled()" if 0 is given (unit is byte)
+
+//binary tile file header (128 bytes, native little endian byte order)
+//The frame is cut into Tiles_x*Tiles_z tiles of TileRows*TileCols simulated pixels. Tile (a,b) holds the frame rows
+//a*TileRows.. and columns b*TileCols.. and starts at DataOffset+(a*Tiles_z+b)*TileSize. A tile is a DOP plane and an
+//AOP plane of TileRows*TileCols values, row after row, each padded to FRAME_FILE_ALIGNMENT bytes; the pixels of the
+//tiles of the last row and column outside the frame are NaN.
+typedef struct TileFileHeader
+{
+	char     Magic[4];          //TILE_FILE_MAGIC
+	int32_t  Version;           //TILE_FILE_VERSION
+	int32_t  HeaderSize;        //size of this header (unit is byte)
+	int32_t  ScalarType;        //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+
+	int32_t  n_x;               //Number of simulated pixels along i_x (unit is pixel)
+	int32_t  n_z;               //Number of simulated pixels along j_z (unit is pixel)
+	int32_t  PixelInterval;     //Pixel interval of the simulation (unit is pixel)
+	int32_t  Camera_n_x;        //Image pixel size of the camera (unit is pixel)
+	int32_t  Camera_n_z;        //Image pixel size of the camera (unit is pixel)
+	int32_t  TileRows;          //frame rows of a tile (unit is simulated pixel)
+	int32_t  TileCols;          //frame columns of a tile (unit is simulated pixel)
+	int32_t  Tiles_x;           //Number of tiles along i_x
+	int32_t  Tiles_z;           //Number of tiles along j_z
+	int32_t  Padding;
+
+	double   D_x;               //Unit cell size of CCD or COMS (unit is millimeter)
+	double   D_z;               //Unit cell size of CCD or COMS (unit is millimeter)
+	double   f;                 //Focus of the camera (unit is millimeter)
+	double   psa;               //yaw angle (unit is radian)
+	double   afa;               //pitch angle (unit is radian)
+	double   beta;              //roll angle (unit is radian)
+
+	int64_t  DataOffset;        //offset of the first tile from the start of the file (unit is byte)
+	int64_t  TileSize;          //offset of a tile from the previous one (unit is byte)
+
+	char     Reserved[8];
+}
+TileFileHeader;
+
+//tile file opened for reading
+typedef struct TileFile
+{
+	FILE *          file;
+	TileFileHeader  header;
+}
+TileFile;
+
+//Hypothetical polarization camera simulation into a tile file with bounded memory.
+int CameraSimulationTiled(
+	const double  psa,                 //yaw angle (unit is radian)
+	const double  afa,                 //pitch angle (unit is radian)
+    const double  beta,                //roll angle (unit is radian)
+	const CameraParameters *	parm,  //camera parameters, not changed
+	const int     TileRows,            //frame rows of a tile, 0 for TILE_DEFAULT_SIZE
+	const int     TileCols,            //frame columns of a tile, 0 for TILE_DEFAULT_SIZE
+	const int     ScalarType,          //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	const size_t  MemoryBudget,        //bytes of the tile buffers, 0 for TILE_MEMORY_BUDGET
+	ThreadPool *	pool,              //thread pool, NULL runs on the calling thread
+	const char *  path                 //file name
+	);
+
+//Open a tile file and check its header.
+TileFile * TileFileOpen(
+	const char *  path          //file name
+	);
+
+//Read a tile of a tile file.
+int TileFileReadTile(
+	TileFile *	tiles,          //opened tile file
+	const int     a,            //tile row, 0 to Tiles_x-1
+	const int     b,            //tile column, 0 to Tiles_z-1
+	void *	DOP,                //TileRows*TileCols values of the scalar type of the file
+	void *	AOP                 //TileRows*TileCols values of the scalar type of the file (unit is degree)
+	);
+
+//Close a tile file.
+void TileFileClose(
+	TileFile *	tiles           //opened tile file
+	);
+
+#endif
@@ -0,0 +1,615 @@
+/*
+Binary frame file functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for writing and reading DOP and AOP frames in a compact binary format.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Using the code to store frames of "CameraSimulationFrame()" without formatted text output and to map them back zero-copy.
+--------------------------
+
+File format:
+	A frame file is a sequence of frames. Each frame is a 128-byte "FrameFileHeader" (resolution, pixel interval,
+	camera geometry, attitude and scalar type) followed by the raw DOP plane and the raw AOP plane in the layout of
+	"CameraFrame". Frames are padded to 64 bytes, so the planes of every frame are aligned when the file is mapped.
+	"FrameFileMap()" indexes the frames up to the first header that is not valid: planes and frame must lie inside
+	the file and after the header, the planes aligned to their values and the frame size a multiple of 8 bytes. A
+	damaged or crafted file therefore maps to fewer frames instead of pointing outside the mapping.
+
+
+Function 1: "FrameWriterOpen()" 
+
+    //Create a binary frame file.
+	FrameWriter * FrameWriterOpen(
+		const char *  path,
+		const int     ScalarType
+	);
+	--------------input----------------
+	const char *  path,         //file name
+	const int     ScalarType    //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT (planes are rounded to float)
+	-----------------------------------
+	-------------output----------------
+	FrameWriter *               //frame file writer, NULL if the file cannot be created
+	-----------------------------------
+
+
+Function 2: "FrameWriterWrite()" 
+
+    //Append a frame simulated with the camera parameters to a binary frame file.
+	int FrameWriterWrite(
+		FrameWriter *	writer,
+		const CameraFrame *	frame,
+		const CameraParameters *	parm
+	);
+	--------------input----------------
+	FrameWriter *	writer,             //frame file writer
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const CameraParameters *	parm    //camera parameters and attitude of the frame
+	-----------------------------------
+	-------------output----------------
+	int                                 //0 on success, -1 if writing failed
+	-----------------------------------
+
+    //Append a single precision frame simulated with the camera parameters to a binary frame file.
+	int FrameWriterWrite(
+		FrameWriter *	writer,
+		const CameraFrameFloat *	frame,
+		const CameraParameters *	parm
+	);
+	--------------input----------------
+	FrameWriter *	writer,                 //frame file writer
+	const CameraFrameFloat *	frame,      //DOP and AOP frame
+	const CameraParameters *	parm        //camera parameters and attitude of the frame
+	-----------------------------------
+	-------------output----------------
+	int                                     //0 on success, -1 if writing failed
+	-----------------------------------
+	A frame is converted to the scalar type of the file when the two differ, so a float file
+	written from a CameraFrameFloat is a plain copy of its planes.
+
+
+Function 3: "FrameWriterClose()" 
+
+    //Flush and close a binary frame file.
+	int FrameWriterClose(
+		FrameWriter *	writer
+	);
+	--------------input----------------
+	FrameWriter *	writer  //frame file writer
+	-----------------------------------
+	-------------output----------------
+	int                     //0 on success, -1 if writing failed
+	-----------------------------------
+
+
+Function 4: "FrameFileMap()" 
+
+    //Map a binary frame file into memory without copying it.
+	FrameFileView * FrameFileMap(
+		const char *  path
+	);
+	--------------input----------------
+	const char *  path          //file name
+	-----------------------------------
+	-------------output----------------
+	FrameFileView *             //mapped file, NULL if the file cannot be mapped or is not a frame file
+	-----------------------------------
+
+
+Function 5: "FrameFileGetFrame()" 
+
+    //Access a frame of a mapped frame file.
+	int FrameFileGetFrame(
+		const FrameFileView *	view,
+		const int     FrameIndex,
+		FrameFileFrame *	frame
+	);
+	--------------input----------------
+	const FrameFileView *	view,   //mapped frame file
+	const int     FrameIndex,       //index of the frame
+	-----------------------------------
+	-------------output----------------
+	FrameFileFrame *	frame       //header and planes of the frame, pointing into the mapping
+	int                             //0 on success, -1 if FrameIndex is out of range
+	-----------------------------------
+
+
+Function 6: "FrameFileUnmap()" 
+
+    //Unmap a binary frame file.
+	void FrameFileUnmap(
+		FrameFileView *	view
+	);
+
+
+Function 7: "FrameFileToText()" 
+
+    //Convert a binary frame file to the four-column text of HypotheticalImages.txt.
+	int FrameFileToText(
+		const char *  BinaryPath,
+		const char *  TextPath
+	);
+	--------------input----------------
+	const char *  BinaryPath,   //binary frame file
+	const char *  TextPath      //text file, readable by output/ImageDarwing.m
+	-----------------------------------
+	-------------output----------------
+	int                         //0 on success, -1 on failure
+	-----------------------------------
+	Every frame starts with the line "# frame k psa afa beta" of its index and attitude (unit is radian), like
+	"CameraFrameSinkText()"; "output/ImageDarwing.m" skips these lines and draws the first frame.
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "FrameIO.h"
+#include "CameraStats.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifndef ALLOC
+#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
+#endif
+
+//Size of the stdio buffer of a frame file (unit is byte)
+#define FRAME_BUFFER_SIZE           (4<<20)
+//Number of values converted between double and float at once
+#define FRAME_SCRATCH_SIZE          (1<<16)
+
+typedef char FrameFileHeaderSizeCheck[sizeof(FrameFileHeader)==128 ? 1 : -1];
+
+
+
+//Size of a plane in the file (unit is byte), -1 if it does not fit in int64_t
+static int64_t PlaneSize(
+	const int     n_x,          //Number of simulated pixels along i_x
+	const int     n_z,          //Number of simulated pixels along j_z
+	const int     ScalarType    //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	){
+	const int64_t ItemSize = ScalarType==FRAME_SCALAR_FLOAT ? sizeof(float) : sizeof(double);
+	const int64_t count = (int64_t)n_x*n_z;     //below 2^62 for n_x and n_z of int
+	return count>INT64_MAX/ItemSize ? -1 : count*ItemSize;
+}
+
+
+
+//Round up to FRAME_FILE_ALIGNMENT
+static int64_t AlignSize(
+	const int64_t  size         //size (unit is byte)
+	){
+	return (size+FRAME_FILE_ALIGNMENT-1)/FRAME_FILE_ALIGNMENT*FRAME_FILE_ALIGNMENT;
+}
+
+
+
+//Write a plane through the scratch buffer, converting every value to scalar type T.
+template <class S, class T>
+static int ConvertPlane(
+	FrameWriter *	writer,     //frame file writer
+	const S *	plane,          //DOP or AOP plane
+	const size_t  count,        //number of values
+	T *	scratch                 //conversion buffer of FRAME_SCRATCH_SIZE values
+	){
+	for(size_t begin=0; begin<count; begin+=FRAME_SCRATCH_SIZE){
+		size_t n = count-begin<FRAME_SCRATCH_SIZE ? count-begin : FRAME_SCRATCH_SIZE;
+		for(size_t k=0; k<n; k++){
+			scratch[k] = (T)plane[begin+k];
+		}
+		if(fwrite(scratch,sizeof(T),n,writer->file)!=n){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+
+//Write a plane of scalar type S, converting it to the scalar type of the file if required.
+template <class S>
+static int WritePlane(
+	FrameWriter *	writer,     //frame file writer
+	const S *	plane,          //DOP or AOP plane
+	const size_t  count         //number of values
+	){
+	if(sizeof(S)==(writer->ScalarType==FRAME_SCALAR_FLOAT ? sizeof(float) : sizeof(double))){
+		return fwrite(plane,sizeof(S),count,writer->file)==count ? 0 : -1;
+	}
+	if(writer->ScalarType==FRAME_SCALAR_FLOAT){
+		return ConvertPlane(writer,plane,count,(float *)writer->Scratch);
+	}
+	return ConvertPlane(writer,plane,count,(double *)writer->Scratch);
+}
+
+
+
+//Write zero bytes up to the next frame.
+static int WritePadding(
+	FrameWriter *	writer,     //frame file writer
+	const int64_t  size         //number of zero bytes
+	){
+	static const char zeros[FRAME_FILE_ALIGNMENT] = {0};
+	return fwrite(zeros,1,(size_t)size,writer->file)==(size_t)size ? 0 : -1;
+}
+
+
+
+//Create a binary frame file.
+FrameWriter * FrameWriterOpen(
+	const char *  path,         //file name
+	const int     ScalarType    //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	){
+	FrameWriter * writer = ALLOC(FrameWriter);
+	if(writer==NULL){
+		return NULL;
+	}
+	writer->ScalarType = ScalarType==FRAME_SCALAR_FLOAT ? FRAME_SCALAR_FLOAT : FRAME_SCALAR_DOUBLE;
+	writer->FrameCount = 0;
+	writer->Buffer = (char *)malloc(FRAME_BUFFER_SIZE);
+	writer->Scratch = malloc(FRAME_SCRATCH_SIZE*sizeof(double));
+	writer->file = fopen(path,"wb");
+	if(writer->file==NULL || writer->Buffer==NULL || writer->Scratch==NULL){
+		if(writer->file!=NULL){
+			fclose(writer->file);
+		}
+		free(writer->Buffer);
+		free(writer->Scratch);
+		free(writer);
+		return NULL;
+	}
+	setvbuf(writer->file,writer->Buffer,_IOFBF,FRAME_BUFFER_SIZE);
+	return writer;
+}
+
+
+
+//Append a frame of scalar type S to a binary frame file.
+template <class S>
+static int WriteFrame(
+	FrameWriter *	writer,             //frame file writer
+	const CameraFrameOf<S> *	frame,  //DOP and AOP frame
+	const CameraParameters *	parm    //camera parameters and attitude of the frame
+	){
+	STATS_CLOCK(tick);
+	FrameFileHeader header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.Magic,FRAME_FILE_MAGIC,4);
+	header.Version = FRAME_FILE_VERSION;
+	header.HeaderSize = sizeof(FrameFileHeader);
+	header.ScalarType = writer->ScalarType;
+	header.n_x = frame->n_x;
+	header.n_z = frame->n_z;
+	header.PixelInterval = frame->PixelInterval;
+	header.Camera_n_x = parm->n_x;
+	header.Camera_n_z = parm->n_z;
+	header.FrameIndex = writer->FrameCount;
+	header.D_x = parm->D_x;
+	header.D_z = parm->D_z;
+	header.f = parm->f;
+	header.psa = parm->psa;
+	header.afa = parm->afa;
+	header.beta = parm->beta;
+
+	int64_t plane = PlaneSize(frame->n_x,frame->n_z,writer->ScalarType);
+	header.DOPOffset = sizeof(FrameFileHeader);
+	header.AOPOffset = header.DOPOffset+plane;
+	header.FrameSize = AlignSize(header.AOPOffset+plane);
+
+	size_t count = (size_t)frame->n_x*frame->n_z;
+	if(fwrite(&header,sizeof(header),1,writer->file)!=1
+		|| WritePlane(writer,frame->DOP,count)!=0
+		|| WritePlane(writer,frame->AOP,count)!=0
+		|| WritePadding(writer,header.FrameSize-header.AOPOffset-plane)!=0){
+		return -1;
+	}
+	writer->FrameCount++;
+	STATS_COUNT(BytesWritten,header.FrameSize);
+	STATS_TRACE("binary",tick,count,header.FrameSize);
+	STATS_STAGE(CAMERA_STAGE_BINARY,tick,count);
+	return 0;
+}
+
+
+
+//Append a frame simulated with the camera parameters to a binary frame file.
+int FrameWriterWrite(
+	FrameWriter *	writer,             //frame file writer
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const CameraParameters *	parm    //camera parameters and attitude of the frame
+	){
+	return WriteFrame(writer,frame,parm);
+}
+
+
+
+//Append a single precision frame simulated with the camera parameters to a binary frame file.
+int FrameWriterWrite(
+	FrameWriter *	writer,                 //frame file writer
+	const CameraFrameFloat *	frame,      //DOP and AOP frame
+	const CameraParameters *	parm        //camera parameters and attitude of the frame
+	){
+	return WriteFrame(writer,frame,parm);
+}
+
+
+
+//Flush and close a binary frame file.
+int FrameWriterClose(
+	FrameWriter *	writer  //frame file writer
+	){
+	if(writer==NULL){
+		return 0;
+	}
+	int status = fclose(writer->file)==0 ? 0 : -1;
+	free(writer->Buffer);
+	free(writer->Scratch);
+	free(writer);
+	return status;
+}
+
+
+
+//Check that a frame header lies inside the file and describes planes and a frame inside the file. The offsets are
+//compared with the bytes left rather than added to the plane size, so that a crafted header cannot wrap around.
+static int HeaderValid(
+	const FrameFileHeader *	header,  //frame header
+	const int64_t  available         //bytes from the header to the end of the file
+	){
+	if(available<(int64_t)sizeof(FrameFileHeader) || memcmp(header->Magic,FRAME_FILE_MAGIC,4)!=0
+		|| header->Version!=FRAME_FILE_VERSION || header->HeaderSize!=(int32_t)sizeof(FrameFileHeader)
+		|| (header->ScalarType!=FRAME_SCALAR_DOUBLE && header->ScalarType!=FRAME_SCALAR_FLOAT)
+		|| header->n_x<=0 || header->n_z<=0){
+		return 0;
+	}
+	int64_t plane = PlaneSize(header->n_x,header->n_z,header->ScalarType);
+	//planes aligned to their values (the AOP plane of an odd number of floats is 4 bytes off), frames to 8 bytes
+	const int64_t ItemSize = header->ScalarType==FRAME_SCALAR_FLOAT ? sizeof(float) : sizeof(double);
+	if(plane<0 || header->DOPOffset%ItemSize!=0 || header->AOPOffset%ItemSize!=0 || header->FrameSize%8!=0){
+		return 0;
+	}
+	return header->DOPOffset>=header->HeaderSize && header->DOPOffset<=available-plane
+		&& header->AOPOffset>=header->DOPOffset && header->AOPOffset-header->DOPOffset>=plane
+		&& header->AOPOffset<=available-plane
+		&& header->FrameSize>=header->AOPOffset && header->FrameSize-header->AOPOffset>=plane
+		&& header->FrameSize<=available;
+}
+
+
+
+//Map a binary frame file into memory without copying it.
+FrameFileView * FrameFileMap(
+	const char *  path          //file name
+	){
+	FrameFileView * view = ALLOC(FrameFileView);
+	if(view==NULL){
+		return NULL;
+	}
+	memset(view,0,sizeof(FrameFileView));
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+	LARGE_INTEGER size;
+	if(file==INVALID_HANDLE_VALUE || !GetFileSizeEx(file,&size) || size.QuadPart==0){
+		if(file!=INVALID_HANDLE_VALUE){
+			CloseHandle(file);
+		}
+		free(view);
+		return NULL;
+	}
+	HANDLE mapping = CreateFileMappingA(file,NULL,PAGE_READONLY,0,0,NULL);
+	const char * data = mapping==NULL ? NULL : (const char *)MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+	if(data==NULL){
+		if(mapping!=NULL){
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		free(view);
+		return NULL;
+	}
+	view->File = file;
+	view->Mapping = mapping;
+	view->Size = (size_t)size.QuadPart;
+#else
+	int file = open(path,O_RDONLY);
+	struct stat status;
+	if(file<0 || fstat(file,&status)!=0 || status.st_size==0){
+		if(file>=0){
+			close(file);
+		}
+		free(view);
+		return NULL;
+	}
+	void * data = mmap(NULL,(size_t)status.st_size,PROT_READ,MAP_SHARED,file,0);
+	close(file);
+	if(data==MAP_FAILED){
+		free(view);
+		return NULL;
+	}
+	view->Size = (size_t)status.st_size;
+#endif
+	view->Data = (const char *)data;
+
+	//index the frames
+	int capacity = 16;
+	view->FrameOffsets = (int64_t *)malloc(capacity*sizeof(int64_t));
+	int64_t offset = 0;
+	while(view->FrameOffsets!=NULL && offset<(int64_t)view->Size){
+		const FrameFileHeader * header = (const FrameFileHeader *)(view->Data+offset);
+		if(!HeaderValid(header,(int64_t)view->Size-offset)){
+			break;
+		}
+		if(view->FrameCount==capacity){
+			capacity *= 2;
+			int64_t * offsets = (int64_t *)realloc(view->FrameOffsets,capacity*sizeof(int64_t));
+			if(offsets==NULL){
+				break;
+			}
+			view->FrameOffsets = offsets;
+		}
+		view->FrameOffsets[view->FrameCount++] = offset;
+		offset += header->FrameSize;
+	}
+	if(view->FrameCount==0){
+		FrameFileUnmap(view);
+		return NULL;
+	}
+	return view;
+}
+
+
+
+//Access a frame of a mapped frame file.
+int FrameFileGetFrame(
+	const FrameFileView *	view,   //mapped frame file
+	const int     FrameIndex,       //index of the frame
+	FrameFileFrame *	frame       //header and planes of the frame
+	){
+	if(FrameIndex<0 || FrameIndex>=view->FrameCount){
+		return -1;
+	}
+	const char * base = view->Data+view->FrameOffsets[FrameIndex];
+	frame->header = (const FrameFileHeader *)base;
+	frame->DOP = base+frame->header->DOPOffset;
+	frame->AOP = base+frame->header->AOPOffset;
+	return 0;
+}
+
+
+
+//Unmap a binary frame file.
+void FrameFileUnmap(
+	FrameFileView *	view    //mapped frame file
+	){
+	if(view==NULL){
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(view->Data);
+	CloseHandle((HANDLE)view->Mapping);
+	CloseHandle((HANDLE)view->File);
+#else
+	munmap((void *)view->Data,view->Size);
+#endif
+	free(view->FrameOffsets);
+	free(view);
+}
+
+
+
+//Convert a binary frame file to the four-column text of HypotheticalImages.txt.
+int FrameFileToText(
+	const char *  BinaryPath,   //binary frame file
+	const char *  TextPath      //text file, readable by output/ImageDarwing.m
+	){
+	FrameFileView * view = FrameFileMap(BinaryPath);
+	if(view==NULL){
+		return -1;
+	}
+	FILE * text = fopen(TextPath,"w");
+	if(text==NULL){
+		FrameFileUnmap(view);
+		return -1;
+	}
+
+	int status = 0;
+	for(int k=0; k<view->FrameCount && status==0; k++){
+		FrameFileFrame stored;
+		FrameFileGetFrame(view,k,&stored);
+		if(fprintf(text,"# frame %d psa %.17g afa %.17g beta %.17g\n",k,stored.header->psa,stored.header->afa,
+			stored.header->beta)<0){
+			status = -1;
+			break;
+		}
+
+		CameraFrame frame;
+		frame.n_x = stored.header->n_x;
+		frame.n_z = stored.header->n_z;
+		frame.PixelInterval = stored.header->PixelInterval;
+		frame.Owner = 0;
+		if(stored.header->ScalarType==FRAME_SCALAR_DOUBLE){
+			frame.DOP = (double *)stored.DOP;
+			frame.AOP = (double *)stored.AOP;
+			status = CameraFrameWriteText(&frame,text);
+		}
+		else{
+			size_t count = (size_t)frame.n_x*frame.n_z;
+			frame.DOP = (double *)malloc(count*sizeof(double));
+			frame.AOP = (double *)malloc(count*sizeof(double));
+			if(frame.DOP!=NULL && frame.AOP!=NULL){
+				for(size_t i=0; i<count; i++){
+					frame.DOP[i] = ((const float *)stored.DOP)[i];
+					frame.AOP[i] = ((const float *)stored.AOP)[i];
+				}
+				status = CameraFrameWriteText(&frame,text);
+			}
+			else{
+				status = -1;
+			}
+			free(frame.DOP);
+			free(frame.AOP);
+		}
+	}
+
+	if(fclose(text)!=0){
+		status = -1;
+	}
+	FrameFileUnmap(view);
+	return status;
+}
@@ -0,0 +1,129 @@
+#ifndef _FRAMEIO_H_
+#define _FRAMEIO_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "PolarizationCamera.h"
+
+#define FRAME_FILE_MAGIC            "HPCF"
+#define FRAME_FILE_VERSION          1
+#define FRAME_FILE_ALIGNMENT        64      //every frame starts at a multiple of 64 bytes
+
+#define FRAME_SCALAR_DOUBLE         0       //planes are stored as double
+#define FRAME_SCALAR_FLOAT          1       //planes are stored as float
+
+//binary frame header (128 bytes, native little endian byte order)
+//A frame file is a sequence of frames. Each frame is this header followed by the DOP plane and the AOP plane,
+//both with the layout of CameraFrame, padded to FRAME_FILE_ALIGNMENT bytes.
+typedef struct FrameFileHeader
+{
+	char     Magic[4];          //FRAME_FILE_MAGIC
+	int32_t  Version;           //FRAME_FILE_VERSION
+	int32_t  HeaderSize;        //size of this header (unit is byte)
+	int32_t  ScalarType;        //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+
+	int32_t  n_x;               //Number of simulated pixels along i_x (unit is pixel)
+	int32_t  n_z;               //Number of simulated pixels along j_z (unit is pixel)
+	int32_t  PixelInterval;     //Pixel interval of the simulation (unit is pixel)
+	int32_t  Camera_n_x;        //Image pixel size of the camera (unit is pixel)
+	int32_t  Camera_n_z;        //Image pixel size of the camera (unit is pixel)
+	int32_t  FrameIndex;        //Index of the frame in the file
+
+	double   D_x;               //Unit cell size of CCD or COMS (unit is millimeter)
+	double   D_z;               //Unit cell size of CCD or COMS (unit is millimeter)
+	double   f;                 //Focus of the camera (unit is millimeter)
+	double   psa;               //yaw angle (unit is radian)
+	double   afa;               //pitch angle (unit is radian)
+	double   beta;              //roll angle (unit is radian)
+
+	int64_t  DOPOffset;         //offset of the DOP plane from the start of this header (unit is byte)
+	int64_t  AOPOffset;         //offset of the AOP plane from the start of this header (unit is byte)
+	int64_t  FrameSize;         //offset of the next frame from the start of this header (unit is byte)
+
+	char     Reserved[16];
+}
+FrameFileHeader;
+
+//buffered frame file writer
+typedef struct FrameWriter
+{
+	FILE *   file;
+	char *   Buffer;            //stdio buffer of the file
+	void *   Scratch;           //conversion buffer between double and float planes
+	int      ScalarType;        //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	int      FrameCount;        //number of frames written
+}
+FrameWriter;
+
+//one frame of a mapped frame file
+typedef struct FrameFileFrame
+{
+	const FrameFileHeader *  header;
+	const void *             DOP;       //const double * or const float * depending on header->ScalarType
+	const void *             AOP;       //const double * or const float * depending on header->ScalarType
+}
+FrameFileFrame;
+
+//read-only memory mapping of a frame file
+typedef struct FrameFileView
+{
+	const char *  Data;         //first byte of the file
+	size_t        Size;         //size of the file (unit is byte)
+	int           FrameCount;   //number of frames in the file
+	int64_t *     FrameOffsets; //offset of every frame header (unit is byte)
+
+	void *        File;         //platform file handle
+	void *        Mapping;      //platform mapping handle
+}
+FrameFileView;
+
+//Create a binary frame file.
+FrameWriter * FrameWriterOpen(
+	const char *  path,         //file name
+	const int     ScalarType    //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	);
+
+//Append a frame simulated with the camera parameters to a binary frame file.
+int FrameWriterWrite(
+	FrameWriter *	writer,             //frame file writer
+	const CameraFrame *	frame,          //DOP and AOP frame
+	const CameraParameters *	parm    //camera parameters and attitude of the frame
+	);
+
+//Append a single precision frame simulated with the camera parameters to a binary frame file.
+int FrameWriterWrite(
+	FrameWriter *	writer,                 //frame file writer
+	const CameraFrameFloat *	frame,      //DOP and AOP frame
+	const CameraParameters *	parm        //camera parameters and attitude of the frame
+	);
+
+//Flush and close a binary frame file.
+int FrameWriterClose(
+	FrameWriter *	writer  //frame file writer
+	);
+
+//Map a binary frame file into memory without copying it.
+FrameFileView * FrameFileMap(
+	const char *  path          //file name
+	);
+
+//Access a frame of a mapped frame file.
+int FrameFileGetFrame(
+	const FrameFileView *	view,   //mapped frame file
+	const int     FrameIndex,       //index of the frame
+	FrameFileFrame *	frame       //header and planes of the frame
+	);
+
+//Unmap a binary frame file.
+void FrameFileUnmap(
+	FrameFileView *	view    //mapped frame file
+	);
+
+//Convert a binary frame file to the four-column text of HypotheticalImages.txt.
+int FrameFileToText(
+	const char *  BinaryPath,   //binary frame file
+	const char *  TextPath      //text file, readable by output/ImageDarwing.m
+	);
+
+#endif
@@ -0,0 +1,1355 @@
+/*
+Frame server of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for serving frames of warm cameras to other processes through a Unix domain socket and shared memory.
+And this code is written in C++11.
+
+Usage information:
+Run "FrameServerServe()" (main.cpp --serve) and connect with "FrameClientConnect()".
+--------------------------
+
+Server:
+	A process that needs frames for new attitudes at a high rate (a closed-loop navigation test) should not pay for
+	a process start, "CameraParametersInit()", the ray table and file I/O on every frame. A frame server keeps
+	them: it listens on a Unix domain socket, keeps up to FRAME_SERVER_MAX_CAMERAS camera configurations with their
+	ray tables, lenses and sky models set up, and simulates frames over one thread pool into memory it shares with
+	the client, so a frame is never copied, serialized or written to a file.
+	A client opens a camera with FRAME_SERVER_OPEN and a FrameServerCamera. The server answers with a
+	FrameServerLayout and passes the descriptor of an anonymous shared memory object of Slots frame slots along
+	with it (SCM_RIGHTS); the client maps it read-only. A configuration that an earlier connection already used is
+	taken over warm (FrameServerLayout::Warm), without building its ray table again.
+	Every FRAME_SERVER_FRAME request names a slot and an attitude and is answered by a FrameServerReply once the
+	frame is in the slot. Requests may be pipelined: the server reads whatever requests have arrived and simulates
+	consecutive frame requests of a connection as one batch, the row bands of all its frames in one parallel loop
+	like "CameraSimulationRig()", so small frames still use every thread. The replies come in the order of the
+	requests. A slot must not be read or requested again before the reply of its last request arrived; requests
+	for the same slot in one batch are simulated one after the other.
+	The latency of a request runs from reading it off the socket to sending its reply, so it holds the wait behind
+	earlier requests as well. Latencies go into a histogram with 8 bins per octave from 1 microsecond, per
+	connection (FRAME_SERVER_STATS) and for the server ("FrameServerGetStats()").
+	The server runs on one thread besides its pool. Its sockets do not block: the replies of a connection are
+	queued and sent as the client takes them, and a connection is not read again until its queue is empty. A
+	client that pipelines requests without receiving the replies only holds up itself; the others are served
+	meanwhile, and its queue never exceeds the SERVER_BUFFER_BYTES of requests it answers. The server is meant for
+	the processes of one machine and one user (the socket is created with the permissions of the umask). On Windows
+	the functions of the server and the client return NULL or -1.
+
+	Messages (native byte order):
+		client                                      server
+		FrameServerRequest{OPEN}, FrameServerCamera ->
+		                                            <- FrameServerLayout + descriptor of the slots
+		FrameServerRequest{FRAME,Slot,Sequence,...} ->
+		FrameServerRequest{FRAME,...}               ->  (pipelined)
+		                                            <- FrameServerReply, FrameServerReply, ...
+		FrameServerRequest{STATS}                   ->
+		                                            <- FrameServerStats
+		FrameServerRequest{SHUTDOWN}                ->  (server stops)
+	"Python/hpcamera.py" has a client in Python (hpcamera.FrameClient) with NumPy views of the slots.
+
+
+Function 1: "FrameServerInit()" 
+
+    //Create a server listening on a Unix domain socket.
+	FrameServer * FrameServerInit(
+		const char *  path,
+		const int     Threads
+	);
+	--------------input----------------
+	const char *  path,         //file name of the socket, replaced if it exists
+	const int     Threads       //threads of the simulation, 0 for every hardware thread
+	-----------------------------------
+	-------------output----------------
+	FrameServer *               //server, NULL if the socket cannot be created
+	-----------------------------------
+
+
+Function 2: "FrameServerRun()" 
+
+    //Serve clients until FRAME_SERVER_SHUTDOWN or "FrameServerStop()".
+	int FrameServerRun(
+		FrameServer *	server
+	);
+	--------------input----------------
+	FrameServer *	server      //server
+	-----------------------------------
+	-------------output----------------
+	int                         //0, or -1 if waiting for the sockets failed
+	-----------------------------------
+
+
+Function 3: "FrameServerStop()" 
+
+    //Make "FrameServerRun()" return; safe in a signal handler and from other threads.
+	void FrameServerStop(
+		FrameServer *	server
+	);
+
+
+Function 4: "FrameServerGetStats()" 
+
+    //Latencies of every frame request the server answered.
+	void FrameServerGetStats(
+		const FrameServer *	server,
+		FrameServerStats *	stats
+	);
+
+
+Function 5: "FrameServerFree()" 
+
+    //Close the connections and the socket and release the server and its cameras.
+	void FrameServerFree(
+		FrameServer *	server
+	);
+
+
+Function 6: "FrameServerServe()" 
+
+    //Serve on a socket until SIGINT, SIGTERM or FRAME_SERVER_SHUTDOWN, then print the latencies.
+	int FrameServerServe(
+		const char *  path,
+		const int     Threads
+	);
+	--------------input----------------
+	const char *  path,         //file name of the socket
+	const int     Threads       //threads of the simulation, 0 for every hardware thread
+	-----------------------------------
+	-------------output----------------
+	int                         //0, or -1 if the server cannot be created
+	-----------------------------------
+	"HypotheticalPolarizationCamera --serve path [threads]" of main.cpp.
+
+
+Function 7: "FrameServerCameraDefault()" 
+
+    //Default camera configuration.
+	void FrameServerCameraDefault(
+		FrameServerCamera *	camera
+	);
+	-------------output----------------
+	FrameServerCamera *	camera  //the camera of main.cpp, pinhole lens, Rayleigh sky, 4 slots of double frames
+	-----------------------------------
+
+
+Function 8: "FrameClientConnect()" 
+
+    //Connect to a server and open a camera.
+	FrameClient * FrameClientConnect(
+		const char *  path,
+		const FrameServerCamera *	camera
+	);
+	--------------input----------------
+	const char *  path,                 //file name of the socket
+	const FrameServerCamera *	camera  //camera configuration
+	-----------------------------------
+	-------------output----------------
+	FrameClient *                       //connection with the layout and the mapped slots, NULL if the server
+	                                    //cannot be reached or refuses the configuration
+	-----------------------------------
+
+
+Function 9: "FrameClientSubmit()", "FrameClientReceive()" and "FrameClientFrame()" 
+
+    //Send a frame request, wait for the next reply, or both.
+	int FrameClientSubmit(
+		FrameClient *	client,
+		const int     Slot,
+		const uint64_t  Sequence,
+		const double  psa,
+		const double  afa,
+		const double  beta
+	);
+	int FrameClientReceive(
+		FrameClient *	client,
+		FrameServerReply *	reply
+	);
+	--------------input----------------
+	FrameClient *	client,     //connection
+	const int     Slot,         //slot of the frame
+	const uint64_t  Sequence,   //returned in the reply
+	const double  psa,          //yaw angle (unit is radian)
+	const double  afa,          //pitch angle (unit is radian)
+    const double  beta          //roll angle (unit is radian)
+	-----------------------------------
+	-------------output----------------
+	FrameServerReply *	reply   //reply of the oldest request without one
+	int                         //0, or -1 if the connection failed (or the reply has a status of -1)
+	-----------------------------------
+
+
+Function 10: "FrameClientPlane()" 
+
+    //DOP or AOP plane of a slot.
+	const void * FrameClientPlane(
+		const FrameClient *	client,
+		const int     Slot,
+		const int     AOP
+	);
+	-------------output----------------
+	const void *                //const double * or const float * (layout.ScalarType) of n_x*n_z values
+	-----------------------------------
+
+
+Function 11: "FrameClientStats()", "FrameClientShutdown()" and "FrameClientClose()" 
+
+    //Latencies of the connection, stopping the server, closing the connection.
+
+
+Example:
+
+	//server process
+	FrameServerServe("/tmp/hpcamera.sock",0);
+
+	//client process
+	FrameServerCamera camera;
+	FrameServerCameraDefault(&camera);
+	camera.ScalarType = FRAME_SCALAR_FLOAT;
+	FrameClient * client = FrameClientConnect("/tmp/hpcamera.sock",&camera);
+	for(int k=0; k<4; k++){
+		FrameClientSubmit(client,k,k,psa[k],afa[k],beta[k]);	//four frames in flight
+	}
+	FrameServerReply reply;
+	FrameClientReceive(client,&reply);
+	const float * DOP = (const float *)FrameClientPlane(client,reply.Slot,0);
+	...
+	FrameClientClose(client);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "FrameServer.h"
+#include "RayleighKernel.h"
+#include "ThreadPool.h"
+#include "CameraStats.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#ifndef ALLOC
+#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
+#endif
+
+#define SERVER_BUFFER_BYTES         4096    //received bytes of a connection not yet handled, and replies not yet sent
+
+typedef char FrameServerRequestSizeCheck[sizeof(FrameServerRequest)==64 ? 1 : -1];
+typedef char FrameServerCameraSizeCheck[sizeof(FrameServerCamera)==128 ? 1 : -1];
+typedef char FrameServerLayoutSizeCheck[sizeof(FrameServerLayout)==64 ? 1 : -1];
+typedef char FrameServerReplySizeCheck[sizeof(FrameServerReply)==64 ? 1 : -1];
+typedef char FrameServerStatsSizeCheck[sizeof(FrameServerStats)==64 ? 1 : -1];
+
+//histogram of request latencies
+typedef struct LatencyHistogram
+{
+	uint64_t  Count;
+	uint64_t  Sum;              //unit is nanosecond
+	uint64_t  Max;
+	uint64_t  Bins[FRAME_SERVER_LATENCY_BINS];
+}
+LatencyHistogram;
+
+
+
+//Default camera configuration.
+void FrameServerCameraDefault(
+	FrameServerCamera *	camera  //camera configuration
+	){
+	memset(camera,0,sizeof(FrameServerCamera));
+	camera->Version = FRAME_SERVER_VERSION;
+	camera->Slots = 4;
+	camera->ScalarType = FRAME_SCALAR_DOUBLE;
+	camera->Kernel = RAYLEIGH_KERNEL_AUTO;
+	camera->D_x = 5.2;
+	camera->D_z = 5.2;
+	camera->n_x = 1024;
+	camera->n_z = 1280;
+	camera->f = 4.0;
+	camera->PixelInterval = 1;
+	camera->Projection = CAMERA_PROJECTION_PINHOLE;
+	camera->SkyModel = SKY_MODEL_RAYLEIGH;
+	camera->DOP_max = 1.0;
+}
+
+
+
+//Add a latency to a histogram.
+static void LatencyAdd(
+	LatencyHistogram *	histogram,  //histogram
+	const uint64_t  ns              //latency (unit is nanosecond)
+	){
+	int bin = 0;
+	if(ns>1000){
+		bin = (int)ceil(8.0*log2((double)ns/1000.0));
+		bin = bin<FRAME_SERVER_LATENCY_BINS ? bin : FRAME_SERVER_LATENCY_BINS-1;
+	}
+	histogram->Bins[bin]++;
+	histogram->Count++;
+	histogram->Sum += ns;
+	histogram->Max = ns>histogram->Max ? ns : histogram->Max;
+}
+
+
+
+//Percentile of a latency histogram, the upper end of its bin (unit is nanosecond).
+static uint64_t LatencyPercentile(
+	const LatencyHistogram *	histogram,  //histogram
+	const double  p                         //percentile, 0 to 100
+	){
+	if(histogram->Count==0){
+		return 0;
+	}
+	double target = p/100.0*(double)histogram->Count;
+	uint64_t below = 0;
+	for(int b=0; b<FRAME_SERVER_LATENCY_BINS; b++){
+		below += histogram->Bins[b];
+		if((double)below>=target && below>0){
+			uint64_t upper = (uint64_t)(1000.0*pow(2.0,b/8.0));
+			return upper<histogram->Max ? upper : histogram->Max;
+		}
+	}
+	return histogram->Max;
+}
+
+
+
+//Statistics of a latency histogram.
+static void LatencyStats(
+	const LatencyHistogram *	histogram,  //histogram
+	FrameServerStats *	stats               //latency statistics
+	){
+	memset(stats,0,sizeof(FrameServerStats));
+	stats->Type = FRAME_SERVER_STATS;
+	stats->Requests = histogram->Count;
+	stats->MeanNs = histogram->Count>0 ? histogram->Sum/histogram->Count : 0;
+	stats->P50Ns = LatencyPercentile(histogram,50.0);
+	stats->P90Ns = LatencyPercentile(histogram,90.0);
+	stats->P99Ns = LatencyPercentile(histogram,99.0);
+	stats->P999Ns = LatencyPercentile(histogram,99.9);
+	stats->MaxNs = histogram->Max;
+}
+
+
+
+//Time of the steady clock (unit is nanosecond).
+static uint64_t ServerClock(){
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+
+#ifdef _WIN32
+
+//The server needs Unix domain sockets and descriptor passing, which Windows does not offer together.
+struct FrameServer
+{
+	int       Unused;
+};
+
+FrameServer * FrameServerInit(const char *, const int){ return NULL; }
+int FrameServerRun(FrameServer *){ return -1; }
+void FrameServerStop(FrameServer *){}
+void FrameServerGetStats(const FrameServer *, FrameServerStats * stats){ memset(stats,0,sizeof(FrameServerStats)); }
+void FrameServerFree(FrameServer *){}
+int FrameServerServe(const char *, const int){ fprintf(stderr,"the frame server needs a POSIX system\n"); return -1; }
+FrameClient * FrameClientConnect(const char *, const FrameServerCamera *){ return NULL; }
+int FrameClientSubmit(FrameClient *, const int, const uint64_t, const double, const double, const double){ return -1; }
+int FrameClientReceive(FrameClient *, FrameServerReply *){ return -1; }
+int FrameClientFrame(FrameClient *, const int, const double, const double, const double, FrameServerReply *){ return -1; }
+const void * FrameClientPlane(const FrameClient *, const int, const int){ return NULL; }
+int FrameClientStats(FrameClient *, FrameServerStats *){ return -1; }
+int FrameClientShutdown(FrameClient *){ return -1; }
+void FrameClientClose(FrameClient *){}
+
+#else
+
+//warm camera configuration
+typedef struct ServerCamera
+{
+	FrameServerCamera  config;  //configuration without Slots and ScalarType
+	CameraParameters *	parm;   //camera parameters with their ray table, NULL if unused
+	int       Users;            //connections using the camera
+}
+ServerCamera;
+
+//connection of a client
+typedef struct ServerClient
+{
+	int       Socket;
+	int       Camera;           //index of the camera of the connection, -1 before FRAME_SERVER_OPEN
+	FrameServerLayout  layout;  //slots of the connection
+	char *	Map;                //shared frame slots
+	size_t    Filled;           //bytes in Buffer
+	uint64_t  Received;         //time the last bytes of Buffer were read (unit is nanosecond)
+	size_t    Pending;          //bytes in Output
+	size_t    Sent;             //bytes of Output already sent
+	int       Descriptor;       //descriptor of the slots sent with the first byte of Output, -1 if none
+	char      Buffer[SERVER_BUFFER_BYTES];
+	char      Output[SERVER_BUFFER_BYTES];  //replies waiting for the socket, no more than the requests they answer
+	LatencyHistogram  latency;
+}
+ServerClient;
+
+struct FrameServer
+{
+	int       Listen;           //listening socket
+	int       Wake[2];          //pipe waking up "FrameServerRun()" for "FrameServerStop()"
+	char      Path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	ThreadPool *	pool;
+	ServerCamera  Camera[FRAME_SERVER_MAX_CAMERAS];
+	ServerClient *	Client[FRAME_SERVER_MAX_CLIENTS];
+	LatencyHistogram  latency;
+	int       Shutdown;         //1 after FRAME_SERVER_SHUTDOWN
+};
+
+//frame request of a batch
+typedef struct ServerFrame
+{
+	FrameServerRequest  request;
+	uint64_t  Received;         //time the request was read (unit is nanosecond)
+	double    C_vTb[3][3];      //rotation matrix from solar vector to body coordinate system
+	double    C_bTv[3][3];      //rotation matrix from body to solar vector coordinate system
+	int       Status;
+}
+ServerFrame;
+
+
+
+//Send all bytes, ignoring SIGPIPE where the platform allows it.
+static int SendAll(
+	const int     Socket,       //socket
+	const void *	data,       //bytes
+	size_t  size                //number of bytes
+	){
+	const char * p = (const char *)data;
+	while(size>0){
+#ifdef MSG_NOSIGNAL
+		ssize_t n = send(Socket,p,size,MSG_NOSIGNAL);
+#else
+		ssize_t n = send(Socket,p,size,0);
+#endif
+		if(n<0 && errno==EINTR){
+			continue;
+		}
+		if(n<=0){
+			return -1;
+		}
+		p += n;
+		size -= (size_t)n;
+	}
+	return 0;
+}
+
+
+
+//Receive exactly size bytes.
+static int ReceiveAll(
+	const int     Socket,       //socket
+	void *	data,               //bytes
+	size_t  size                //number of bytes
+	){
+	char * p = (char *)data;
+	while(size>0){
+		ssize_t n = recv(Socket,p,size,0);
+		if(n<0 && errno==EINTR){
+			continue;
+		}
+		if(n<=0){
+			return -1;
+		}
+		p += n;
+		size -= (size_t)n;
+	}
+	return 0;
+}
+
+
+
+//Queue a reply of a connection; the replies of the requests in Buffer always fit.
+static int ServerClientQueue(
+	ServerClient *	client,     //connection
+	const void *	data,       //bytes
+	const size_t  size          //number of bytes
+	){
+	if(size>SERVER_BUFFER_BYTES-client->Pending){
+		return -1;
+	}
+	memcpy(client->Output+client->Pending,data,size);
+	client->Pending += size;
+	return 0;
+}
+
+
+
+//Send the queued replies of a connection as far as its socket takes them without waiting; -1 closes it.
+static int ServerClientFlush(
+	ServerClient *	client      //connection
+	){
+	while(client->Sent<client->Pending){
+		struct iovec io;
+		io.iov_base = client->Output+client->Sent;
+		io.iov_len = client->Pending-client->Sent;
+		struct msghdr message;
+		memset(&message,0,sizeof(message));
+		message.msg_iov = &io;
+		message.msg_iovlen = 1;
+		union{
+			char      buffer[CMSG_SPACE(sizeof(int))];
+			struct cmsghdr  align;
+		} control;
+		if(client->Descriptor>=0){
+			memset(&control,0,sizeof(control));
+			message.msg_control = control.buffer;
+			message.msg_controllen = sizeof(control.buffer);
+			struct cmsghdr * header = CMSG_FIRSTHDR(&message);
+			header->cmsg_level = SOL_SOCKET;
+			header->cmsg_type = SCM_RIGHTS;
+			header->cmsg_len = CMSG_LEN(sizeof(int));
+			memcpy(CMSG_DATA(header),&client->Descriptor,sizeof(int));
+		}
+#ifdef MSG_NOSIGNAL
+		ssize_t n = sendmsg(client->Socket,&message,MSG_DONTWAIT|MSG_NOSIGNAL);
+#else
+		ssize_t n = sendmsg(client->Socket,&message,MSG_DONTWAIT);
+#endif
+		if(n<0 && errno==EINTR){
+			continue;
+		}
+		if(n<0 && (errno==EAGAIN || errno==EWOULDBLOCK)){
+			return 0;
+		}
+		if(n<=0){
+			return -1;
+		}
+		if(client->Descriptor>=0){
+			close(client->Descriptor);
+			client->Descriptor = -1;
+		}
+		client->Sent += (size_t)n;
+	}
+	client->Pending = client->Sent = 0;
+	return 0;
+}
+
+
+
+//Anonymous shared memory object of a size, -1 if it cannot be created.
+static int SharedMemory(
+	const size_t  size          //bytes
+	){
+	int fd = -1;
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+	fd = memfd_create("hpcamera-frames",MFD_CLOEXEC);
+#endif
+	if(fd<0){
+		const char * folder = getenv("TMPDIR");
+		char name[256];
+		snprintf(name,sizeof(name),"%s/hpcamera-frames-XXXXXX",folder!=NULL ? folder : "/tmp");
+		fd = mkstemp(name);
+		if(fd<0){
+			return -1;
+		}
+		unlink(name);
+		fcntl(fd,F_SETFD,FD_CLOEXEC);
+	}
+	if(ftruncate(fd,(off_t)size)!=0){
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+
+
+//Camera parameters of a configuration, NULL if it is invalid.
+static CameraParameters * ConfigureCamera(
+	const FrameServerCamera *	config  //camera configuration
+	){
+	if(!(config->D_x>0.0) || !(config->D_z>0.0) || !(config->f>0.0) || config->n_x<1 || config->n_z<1
+		|| config->PixelInterval<1 || config->Kernel<RAYLEIGH_KERNEL_AUTO || config->Kernel>RAYLEIGH_KERNEL_CLOSED_FORM
+		|| config->Projection<CAMERA_PROJECTION_PINHOLE || config->Projection>CAMERA_PROJECTION_STEREOGRAPHIC
+		|| !(config->FieldOfView>=0.0) || !(config->DOP_max>=0.0 && config->DOP_max<=1.0)
+		|| (config->SkyModel!=SKY_MODEL_RAYLEIGH && config->SkyModel!=SKY_MODEL_BERRY)
+		|| (config->SkyModel==SKY_MODEL_BERRY && !(config->NeutralPoint>=0.0 && config->NeutralPoint<90.0))){
+		return NULL;
+	}
+	CameraParameters * parm = CameraParametersInit(config->D_x,config->D_z,config->n_x,config->n_z,config->f,
+		config->PixelInterval);
+	if(parm==NULL){
+		return NULL;
+	}
+	parm->Kernel = config->Kernel;
+	CameraLens lens;
+	CameraLensDefault(&lens);
+	if(config->Projection!=lens.Projection || config->FieldOfView!=lens.FieldOfView || config->k1!=0.0
+		|| config->k2!=0.0 || config->k3!=0.0 || config->p1!=0.0 || config->p2!=0.0){
+		lens.Projection = config->Projection;
+		lens.FieldOfView = config->FieldOfView;
+		lens.k1 = config->k1;
+		lens.k2 = config->k2;
+		lens.k3 = config->k3;
+		lens.p1 = config->p1;
+		lens.p2 = config->p2;
+		if(CameraParametersSetLens(parm,&lens)!=0){
+			CameraParametersFree(parm);
+			return NULL;
+		}
+	}
+	if(config->SkyModel==SKY_MODEL_BERRY){
+		SkyModelBerry(&parm->Sky,config->DOP_max,config->NeutralPoint);
+	}
+	else{
+		SkyModelRayleigh(&parm->Sky,config->DOP_max);
+	}
+	return parm;
+}
+
+
+
+//Index of a warm camera of a configuration, set up if it is new; -1 if it is invalid or no entry is free.
+static int ServerCameraFind(
+	FrameServer *	server,         //server
+	const FrameServerCamera *	camera, //camera configuration of a client
+	int &	Warm                    //1 if the camera was already set up
+	){
+	FrameServerCamera config = *camera;
+	config.Slots = 0;
+	config.ScalarType = 0;
+	config.Padding = 0;
+	int free = -1;
+	for(int k=0; k<FRAME_SERVER_MAX_CAMERAS; k++){
+		ServerCamera * entry = &server->Camera[k];
+		if(entry->parm!=NULL && memcmp(&entry->config,&config,sizeof(FrameServerCamera))==0){
+			Warm = 1;
+			return k;
+		}
+		if(free<0 && (entry->parm==NULL || entry->Users==0)){
+			free = k;
+		}
+	}
+	if(free<0){
+		return -1;
+	}
+	CameraParameters * parm = ConfigureCamera(&config);
+	if(parm==NULL){
+		return -1;
+	}
+	//an unused configuration makes room for the new one
+	CameraParametersFree(server->Camera[free].parm);
+	server->Camera[free].config = config;
+	server->Camera[free].parm = parm;
+	server->Camera[free].Users = 0;
+	Warm = 0;
+	return free;
+}
+
+
+
+//Close a connection and release its slots.
+static void ServerClientFree(
+	FrameServer *	server,     //server
+	ServerClient *	client      //connection
+	){
+	if(client->Camera>=0){
+		server->Camera[client->Camera].Users--;
+	}
+	if(client->Map!=NULL){
+		munmap(client->Map,(size_t)client->layout.MapBytes);
+	}
+	if(client->Descriptor>=0){
+		close(client->Descriptor);
+	}
+	close(client->Socket);
+	free(client);
+}
+
+
+
+//Open the camera of a connection and queue its slots for the client, whose replies must all be sent.
+static int ServerOpen(
+	FrameServer *	server,         //server
+	ServerClient *	client,         //connection
+	const FrameServerCamera *	camera  //camera configuration
+	){
+	FrameServerLayout layout;
+	memset(&layout,0,sizeof(FrameServerLayout));
+	layout.Status = -1;
+	int Warm = 0;
+	int index = -1;
+	if(client->Camera<0 && camera->Version==FRAME_SERVER_VERSION && camera->Slots>=1
+		&& camera->Slots<=FRAME_SERVER_MAX_SLOTS
+		&& (camera->ScalarType==FRAME_SCALAR_DOUBLE || camera->ScalarType==FRAME_SCALAR_FLOAT)){
+		index = ServerCameraFind(server,camera,Warm);
+	}
+	int fd = -1;
+	if(index>=0){
+		int n_x, n_z;
+		CameraFrameSize(server->Camera[index].parm,n_x,n_z);
+		size_t ItemSize = camera->ScalarType==FRAME_SCALAR_DOUBLE ? sizeof(double) : sizeof(float);
+		size_t PlaneBytes = ((size_t)n_x*n_z*ItemSize+FRAME_FILE_ALIGNMENT-1)/FRAME_FILE_ALIGNMENT*FRAME_FILE_ALIGNMENT;
+		size_t MapBytes = 2*PlaneBytes*camera->Slots;
+		fd = SharedMemory(MapBytes);
+		void * map = fd>=0 ? mmap(NULL,MapBytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0) : MAP_FAILED;
+		if(map!=MAP_FAILED){
+			client->Map = (char *)map;
+			client->Camera = index;
+			server->Camera[index].Users++;
+			layout.Status = 0;
+			layout.Slots = camera->Slots;
+			layout.n_x = n_x;
+			layout.n_z = n_z;
+			layout.ScalarType = camera->ScalarType;
+			layout.Warm = Warm;
+			layout.PlaneBytes = (int64_t)PlaneBytes;
+			layout.SlotBytes = (int64_t)(2*PlaneBytes);
+			layout.MapBytes = (int64_t)MapBytes;
+			client->layout = layout;
+		}
+		else if(fd>=0){
+			close(fd);
+			fd = -1;
+		}
+	}
+
+	//the layout, with the descriptor of the slots if they were created (only with Status 0); the queue is empty,
+	//so the descriptor goes with the first byte of the layout
+	client->Descriptor = fd;
+	return ServerClientQueue(client,&layout,sizeof(FrameServerLayout));
+}
+
+
+
+//Simulate a batch of frame requests of a connection and queue their replies.
+static int ServerBatch(
+	FrameServer *	server,     //server
+	ServerClient *	client,     //connection
+	std::vector<ServerFrame> &	batch   //frame requests, emptied
+	){
+	if(batch.empty()){
+		return 0;
+	}
+	STATS_CLOCK(tick);
+	const CameraParameters * parm = client->Camera>=0 ? server->Camera[client->Camera].parm : NULL;
+
+	//row bands of every frame in one parallel loop
+	std::vector<CameraBlock> bands;
+	std::vector<int> owner;
+	int n_x = client->layout.n_x;
+	int n_z = client->layout.n_z;
+	int rows = n_x/(8*server->pool->Size());
+	rows = rows>0 ? rows : 1;
+	for(size_t b=0; b<batch.size(); b++){
+		ServerFrame & frame = batch[b];
+		frame.Status = parm!=NULL && frame.request.Slot>=0 && frame.request.Slot<client->layout.Slots ? 0 : -1;
+		if(frame.Status!=0){
+			continue;
+		}
+		CameraRotationMatrix(frame.request.psa,frame.request.afa,frame.request.beta,frame.C_vTb,frame.C_bTv);
+		for(int begin=0; begin<n_x; begin+=rows){
+			CameraBlock band;
+			band.i = begin;
+			band.j = 0;
+			band.n_x = begin+rows<n_x ? rows : n_x-begin;
+			band.n_z = n_z;
+			bands.push_back(band);
+			owner.push_back((int)b);
+		}
+	}
+	uint64_t start = ServerClock();
+	auto task = [&](int begin, int end){
+		for(int t=begin; t<end; t++){
+			const ServerFrame & frame = batch[owner[t]];
+			const CameraBlock & band = bands[t];
+			char * slot = client->Map+(size_t)frame.request.Slot*client->layout.SlotBytes;
+			size_t first = (size_t)band.i*n_z;
+			if(client->layout.ScalarType==FRAME_SCALAR_DOUBLE){
+				CameraSimulationBlock(frame.C_vTb,frame.C_bTv,parm,&band,(double *)slot+first,
+					(double *)(slot+client->layout.PlaneBytes)+first,(size_t)n_z);
+			}
+			else{
+				CameraSimulationBlock(frame.C_vTb,frame.C_bTv,parm,&band,(float *)slot+first,
+					(float *)(slot+client->layout.PlaneBytes)+first,(size_t)n_z);
+			}
+		}
+	};
+	server->pool->ParallelFor((int)bands.size(),1,task);
+	uint64_t now = ServerClock();
+
+	std::vector<FrameServerReply> reply(batch.size());
+	for(size_t b=0; b<batch.size(); b++){
+		memset(&reply[b],0,sizeof(FrameServerReply));
+		reply[b].Type = FRAME_SERVER_FRAME;
+		reply[b].Status = batch[b].Status;
+		reply[b].Sequence = batch[b].request.Sequence;
+		reply[b].Slot = batch[b].request.Slot;
+		reply[b].Batch = (int32_t)batch.size();
+		reply[b].LatencyNs = now-batch[b].Received;
+		reply[b].SimulationNs = now-start;
+		LatencyAdd(&client->latency,reply[b].LatencyNs);
+		LatencyAdd(&server->latency,reply[b].LatencyNs);
+	}
+	STATS_COUNT(Frames,(uint64_t)batch.size());
+	STATS_TRACE("server",tick,(uint64_t)batch.size()*n_x*n_z,0);
+	batch.clear();
+	return ServerClientQueue(client,&reply[0],reply.size()*sizeof(FrameServerReply));
+}
+
+
+
+//Answer the requests in the buffer of a connection with an empty queue; used receives the bytes handled.
+static int ServerClientHandle(
+	FrameServer *	server,     //server
+	ServerClient *	client,     //connection
+	size_t &	used            //bytes of Buffer handled
+	){
+	std::vector<ServerFrame> batch;
+	used = 0;
+	int status = 0;
+	while(status==0 && client->Filled-used>=sizeof(FrameServerRequest)){
+		FrameServerRequest request;
+		memcpy(&request,client->Buffer+used,sizeof(FrameServerRequest));
+		if(request.Type==FRAME_SERVER_FRAME){
+			//a slot is written once per batch, a second request for it starts the next batch
+			for(size_t b=0; b<batch.size(); b++){
+				if(batch[b].request.Slot==request.Slot){
+					status = ServerBatch(server,client,batch);
+					break;
+				}
+			}
+			ServerFrame frame;
+			frame.request = request;
+			frame.Received = client->Received;
+			batch.push_back(frame);
+			used += sizeof(FrameServerRequest);
+			continue;
+		}
+		status = ServerBatch(server,client,batch);
+		if(status!=0){
+			break;
+		}
+		if(request.Type==FRAME_SERVER_OPEN){
+			//the descriptor of the slots needs the queue to itself
+			if(client->Filled-used<sizeof(FrameServerRequest)+sizeof(FrameServerCamera) || client->Pending>0){
+				break;
+			}
+			FrameServerCamera camera;
+			memcpy(&camera,client->Buffer+used+sizeof(FrameServerRequest),sizeof(FrameServerCamera));
+			used += sizeof(FrameServerRequest)+sizeof(FrameServerCamera);
+			status = ServerOpen(server,client,&camera);
+		}
+		else if(request.Type==FRAME_SERVER_STATS){
+			used += sizeof(FrameServerRequest);
+			FrameServerStats stats;
+			LatencyStats(&client->latency,&stats);
+			status = ServerClientQueue(client,&stats,sizeof(FrameServerStats));
+		}
+		else if(request.Type==FRAME_SERVER_SHUTDOWN){
+			used += sizeof(FrameServerRequest);
+			server->Shutdown = 1;
+		}
+		else{
+			status = -1;
+		}
+	}
+	if(status==0){
+		status = ServerBatch(server,client,batch);
+	}
+	memmove(client->Buffer,client->Buffer+used,client->Filled-used);
+	client->Filled -= used;
+	return status;
+}
+
+
+
+//Send the queued replies of a connection, then read and answer its requests while nothing is queued; -1 closes it.
+static int ServerClientService(
+	FrameServer *	server,     //server
+	ServerClient *	client,     //connection
+	const short   events        //events of the socket
+	){
+	if(ServerClientFlush(client)!=0){
+		return -1;
+	}
+	if((events & (POLLIN|POLLHUP|POLLERR)) && client->Pending==0 && client->Filled<SERVER_BUFFER_BYTES){
+		ssize_t n = recv(client->Socket,client->Buffer+client->Filled,SERVER_BUFFER_BYTES-client->Filled,
+			MSG_DONTWAIT);
+		if(n==0 || (n<0 && errno!=EINTR && errno!=EAGAIN && errno!=EWOULDBLOCK)){
+			return -1;
+		}
+		if(n>0){
+			client->Filled += (size_t)n;
+			client->Received = ServerClock();
+		}
+	}
+
+	//requests left over from a full queue are answered once it is sent
+	size_t used = 1;
+	while(client->Pending==0 && used>0 && client->Filled>=sizeof(FrameServerRequest) && !server->Shutdown){
+		if(ServerClientHandle(server,client,used)!=0 || ServerClientFlush(client)!=0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+
+//Create a server listening on a Unix domain socket.
+FrameServer * FrameServerInit(
+	const char *  path,         //file name of the socket, replaced if it exists
+	const int     Threads       //threads of the simulation, 0 for every hardware thread
+	){
+	if(path==NULL || strlen(path)>=sizeof(((struct sockaddr_un *)0)->sun_path) || Threads<0){
+		return NULL;
+	}
+	FrameServer * server = ALLOC(FrameServer);
+	if(server==NULL){
+		return NULL;
+	}
+	memset(server,0,sizeof(FrameServer));
+	server->Wake[0] = server->Wake[1] = -1;
+	strcpy(server->Path,path);
+	try{
+		server->pool = new ThreadPool(Threads);
+	}
+	catch(...){
+		free(server);
+		return NULL;
+	}
+	server->Listen = socket(AF_UNIX,SOCK_STREAM,0);
+	struct sockaddr_un address;
+	memset(&address,0,sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path,path);
+	unlink(path);
+	if(server->Listen<0 || bind(server->Listen,(struct sockaddr *)&address,sizeof(address))!=0
+		|| listen(server->Listen,FRAME_SERVER_MAX_CLIENTS)!=0 || pipe(server->Wake)!=0){
+		if(server->Listen>=0){
+			close(server->Listen);
+			unlink(path);
+		}
+		delete server->pool;
+		free(server);
+		return NULL;
+	}
+	fcntl(server->Listen,F_SETFD,FD_CLOEXEC);
+	fcntl(server->Wake[0],F_SETFL,O_NONBLOCK);
+	fcntl(server->Wake[1],F_SETFL,O_NONBLOCK);
+	return server;
+}
+
+
+
+//Serve clients until FRAME_SERVER_SHUTDOWN or "FrameServerStop()".
+int FrameServerRun(
+	FrameServer *	server      //server
+	){
+	struct pollfd wait[2+FRAME_SERVER_MAX_CLIENTS];
+	int clients[FRAME_SERVER_MAX_CLIENTS];
+	while(!server->Shutdown){
+		int count = 0;
+		wait[0].fd = server->Wake[0];
+		wait[0].events = POLLIN;
+		wait[1].fd = server->Listen;
+		wait[1].events = POLLIN;
+		for(int k=0; k<FRAME_SERVER_MAX_CLIENTS; k++){
+			if(server->Client[k]!=NULL){
+				//a connection with replies waiting is not read until its client takes them
+				wait[2+count].fd = server->Client[k]->Socket;
+				wait[2+count].events = server->Client[k]->Pending>0 ? POLLOUT : POLLIN;
+				clients[count++] = k;
+			}
+		}
+		for(int k=0; k<2+count; k++){
+			wait[k].revents = 0;
+		}
+		if(poll(wait,(nfds_t)(2+count),-1)<0){
+			if(errno==EINTR){
+				continue;
+			}
+			return -1;
+		}
+		if(wait[0].revents!=0){
+			char drain[64];
+			while(read(server->Wake[0],drain,sizeof(drain))>0){
+			}
+			break;
+		}
+		for(int k=0; k<count; k++){
+			ServerClient * client = server->Client[clients[k]];
+			if(wait[2+k].revents!=0 && ServerClientService(server,client,wait[2+k].revents)!=0){
+				ServerClientFree(server,client);
+				server->Client[clients[k]] = NULL;
+			}
+		}
+		if(wait[1].revents & POLLIN){
+			int fd = accept(server->Listen,NULL,NULL);
+			int k = 0;
+			while(k<FRAME_SERVER_MAX_CLIENTS && server->Client[k]!=NULL){
+				k++;
+			}
+			ServerClient * client = fd>=0 && k<FRAME_SERVER_MAX_CLIENTS ? ALLOC(ServerClient) : NULL;
+			if(client==NULL){
+				if(fd>=0){
+					close(fd);
+				}
+				continue;
+			}
+			memset(client,0,offsetof(ServerClient,Buffer));
+			memset(&client->latency,0,sizeof(LatencyHistogram));
+			client->Socket = fd;
+			client->Camera = -1;
+			client->Descriptor = -1;
+			fcntl(fd,F_SETFD,FD_CLOEXEC);
+			fcntl(fd,F_SETFL,O_NONBLOCK);
+			server->Client[k] = client;
+		}
+	}
+	return 0;
+}
+
+
+
+//Make "FrameServerRun()" return; safe in a signal handler and from other threads.
+void FrameServerStop(
+	FrameServer *	server      //server
+	){
+	if(server!=NULL){
+		ssize_t written = write(server->Wake[1],"x",1);
+		(void)written;
+	}
+}
+
+
+
+//Latencies of every frame request the server answered.
+void FrameServerGetStats(
+	const FrameServer *	server, //server
+	FrameServerStats *	stats   //latency statistics
+	){
+	LatencyStats(&server->latency,stats);
+}
+
+
+
+//Close the connections and the socket and release the server and its cameras.
+void FrameServerFree(
+	FrameServer *	server      //server, may be NULL
+	){
+	if(server==NULL){
+		return;
+	}
+	for(int k=0; k<FRAME_SERVER_MAX_CLIENTS; k++){
+		if(server->Client[k]!=NULL){
+			ServerClientFree(server,server->Client[k]);
+		}
+	}
+	for(int k=0; k<FRAME_SERVER_MAX_CAMERAS; k++){
+		CameraParametersFree(server->Camera[k].parm);
+	}
+	close(server->Listen);
+	unlink(server->Path);
+	close(server->Wake[0]);
+	close(server->Wake[1]);
+	delete server->pool;
+	free(server);
+}
+
+
+
+static FrameServer * ServingServer = NULL;   //server of "FrameServerServe()" for its signal handler
+
+//Stop the server of "FrameServerServe()".
+static void ServeSignal(
+	int  signal                 //SIGINT or SIGTERM
+	){
+	(void)signal;
+	FrameServerStop(ServingServer);
+}
+
+
+
+//Serve on a socket until SIGINT, SIGTERM or FRAME_SERVER_SHUTDOWN, then print the latencies.
+int FrameServerServe(
+	const char *  path,         //file name of the socket
+	const int     Threads       //threads of the simulation, 0 for every hardware thread
+	){
+	FrameServer * server = FrameServerInit(path,Threads);
+	if(server==NULL){
+		fprintf(stderr,"cannot listen on %s\n",path);
+		return -1;
+	}
+	ServingServer = server;
+	signal(SIGPIPE,SIG_IGN);
+	signal(SIGINT,ServeSignal);
+	signal(SIGTERM,ServeSignal);
+	fprintf(stderr,"serving frames on %s with %d threads\n",path,server->pool->Size());
+	int status = FrameServerRun(server);
+	FrameServerStats stats;
+	FrameServerGetStats(server,&stats);
+	printf("frames %llu, latency (unit is microsecond): mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+		(unsigned long long)stats.Requests,stats.MeanNs*1e-3,stats.P50Ns*1e-3,stats.P90Ns*1e-3,stats.P99Ns*1e-3,
+		stats.P999Ns*1e-3,stats.MaxNs*1e-3);
+	signal(SIGINT,SIG_DFL);
+	signal(SIGTERM,SIG_DFL);
+	ServingServer = NULL;
+	FrameServerFree(server);
+	return status;
+}
+
+
+
+//Connect to a server and open a camera.
+FrameClient * FrameClientConnect(
+	const char *  path,                 //file name of the socket
+	const FrameServerCamera *	camera  //camera configuration
+	){
+	struct sockaddr_un address;
+	if(path==NULL || strlen(path)>=sizeof(address.sun_path)){
+		return NULL;
+	}
+	FrameClient * client = ALLOC(FrameClient);
+	if(client==NULL){
+		return NULL;
+	}
+	memset(client,0,sizeof(FrameClient));
+	memset(&address,0,sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path,path);
+	client->Socket = socket(AF_UNIX,SOCK_STREAM,0);
+	if(client->Socket<0 || connect(client->Socket,(struct sockaddr *)&address,sizeof(address))!=0){
+		FrameClientClose(client);
+		return NULL;
+	}
+	fcntl(client->Socket,F_SETFD,FD_CLOEXEC);
+
+	//one send, so the server finds the configuration with its request
+	char open[sizeof(FrameServerRequest)+sizeof(FrameServerCamera)];
+	FrameServerRequest request;
+	memset(&request,0,sizeof(FrameServerRequest));
+	request.Type = FRAME_SERVER_OPEN;
+	memcpy(open,&request,sizeof(FrameServerRequest));
+	memcpy(open+sizeof(FrameServerRequest),camera,sizeof(FrameServerCamera));
+	if(SendAll(client->Socket,open,sizeof(open))!=0){
+		FrameClientClose(client);
+		return NULL;
+	}
+
+	//the layout and the descriptor of the slots
+	struct iovec io;
+	io.iov_base = &client->layout;
+	io.iov_len = sizeof(FrameServerLayout);
+	union{
+		char      buffer[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr  align;
+	} control;
+	memset(&control,0,sizeof(control));
+	struct msghdr message;
+	memset(&message,0,sizeof(message));
+	message.msg_iov = &io;
+	message.msg_iovlen = 1;
+	message.msg_control = control.buffer;
+	message.msg_controllen = sizeof(control.buffer);
+	ssize_t n = recvmsg(client->Socket,&message,0);
+	int fd = -1;
+	struct cmsghdr * header = n>0 ? CMSG_FIRSTHDR(&message) : NULL;
+	if(header!=NULL && header->cmsg_level==SOL_SOCKET && header->cmsg_type==SCM_RIGHTS){
+		memcpy(&fd,CMSG_DATA(header),sizeof(int));
+	}
+	if(n>0 && n<(ssize_t)sizeof(FrameServerLayout)){
+		n += recv(client->Socket,(char *)&client->layout+n,sizeof(FrameServerLayout)-(size_t)n,MSG_WAITALL);
+	}
+	if(n!=(ssize_t)sizeof(FrameServerLayout) || client->layout.Status!=0 || fd<0){
+		if(fd>=0){
+			close(fd);
+		}
+		FrameClientClose(client);
+		return NULL;
+	}
+	void * map = mmap(NULL,(size_t)client->layout.MapBytes,PROT_READ,MAP_SHARED,fd,0);
+	close(fd);
+	if(map==MAP_FAILED){
+		FrameClientClose(client);
+		return NULL;
+	}
+	client->Map = (char *)map;
+	return client;
+}
+
+
+
+//Send a frame request without waiting for the frame.
+int FrameClientSubmit(
+	FrameClient *	client,     //connection
+	const int     Slot,         //slot of the frame, not to be read until its reply arrived
+	const uint64_t  Sequence,   //returned in the reply
+	const double  psa,          //yaw angle (unit is radian)
+	const double  afa,          //pitch angle (unit is radian)
+    const double  beta          //roll angle (unit is radian)
+	){
+	FrameServerRequest request;
+	memset(&request,0,sizeof(FrameServerRequest));
+	request.Type = FRAME_SERVER_FRAME;
+	request.Slot = Slot;
+	request.Sequence = Sequence;
+	request.psa = psa;
+	request.afa = afa;
+	request.beta = beta;
+	return SendAll(client->Socket,&request,sizeof(FrameServerRequest));
+}
+
+
+
+//Wait for the next reply, in the order of the requests.
+int FrameClientReceive(
+	FrameClient *	client,     //connection
+	FrameServerReply *	reply   //reply
+	){
+	if(ReceiveAll(client->Socket,reply,sizeof(FrameServerReply))!=0){
+		return -1;
+	}
+	return reply->Type==FRAME_SERVER_FRAME && reply->Status==0 ? 0 : -1;
+}
+
+
+
+//Simulate a frame into a slot and wait for it.
+int FrameClientFrame(
+	FrameClient *	client,     //connection
+	const int     Slot,         //slot of the frame
+	const double  psa,          //yaw angle (unit is radian)
+	const double  afa,          //pitch angle (unit is radian)
+    const double  beta,         //roll angle (unit is radian)
+	FrameServerReply *	reply   //reply, may be NULL
+	){
+	FrameServerReply own;
+	if(FrameClientSubmit(client,Slot,0,psa,afa,beta)!=0){
+		return -1;
+	}
+	return FrameClientReceive(client,reply!=NULL ? reply : &own);
+}
+
+
+
+//DOP or AOP plane of a slot.
+const void * FrameClientPlane(
+	const FrameClient *	client, //connection
+	const int     Slot,         //slot
+	const int     AOP           //0 for the DOP plane, 1 for the AOP plane
+	){
+	if(Slot<0 || Slot>=client->layout.Slots){
+		return NULL;
+	}
+	return client->Map+(size_t)Slot*client->layout.SlotBytes+(AOP ? (size_t)client->layout.PlaneBytes : 0);
+}
+
+
+
+//Latencies of the frame requests of the connection.
+int FrameClientStats(
+	FrameClient *	client,     //connection, without frame requests in flight
+	FrameServerStats *	stats   //latency statistics
+	){
+	FrameServerRequest request;
+	memset(&request,0,sizeof(FrameServerRequest));
+	request.Type = FRAME_SERVER_STATS;
+	if(SendAll(client->Socket,&request,sizeof(FrameServerRequest))!=0
+		|| ReceiveAll(client->Socket,stats,sizeof(FrameServerStats))!=0){
+		return -1;
+	}
+	return stats->Type==FRAME_SERVER_STATS ? 0 : -1;
+}
+
+
+
+//Ask the server to stop.
+int FrameClientShutdown(
+	FrameClient *	client      //connection
+	){
+	FrameServerRequest request;
+	memset(&request,0,sizeof(FrameServerRequest));
+	request.Type = FRAME_SERVER_SHUTDOWN;
+	return SendAll(client->Socket,&request,sizeof(FrameServerRequest));
+}
+
+
+
+//Close a connection and unmap its slots.
+void FrameClientClose(
+	FrameClient *	client      //connection, may be NULL
+	){
+	if(client==NULL){
+		return;
+	}
+	if(client->Map!=NULL){
+		munmap(client->Map,(size_t)client->layout.MapBytes);
+	}
+	if(client->Socket>=0){
+		close(client->Socket);
+	}
+	free(client);
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef _FRAMESERVER_H_
+#define _FRAMESERVER_H_
+
+#include <stdint.h>
+#include "PolarizationCamera.h"
+#include "FrameIO.h"
+
+#define FRAME_SERVER_VERSION        1       //increased when a message changes
+
+#define FRAME_SERVER_OPEN           1       //FrameServerRequest, then FrameServerCamera; answered by FrameServerLayout
+                                            //and the descriptor of the shared frame slots
+#define FRAME_SERVER_FRAME          2       //simulate an attitude into a slot; answered by FrameServerReply
+#define FRAME_SERVER_STATS          3       //latencies of the connection; answered by FrameServerStats
+#define FRAME_SERVER_SHUTDOWN       4       //stop the server after the messages before it; not answered
+
+#define FRAME_SERVER_MAX_SLOTS      64      //frame slots of a connection
+#define FRAME_SERVER_MAX_CAMERAS    16      //warm camera configurations kept by a server
+#define FRAME_SERVER_MAX_CLIENTS    64      //connections of a server at a time
+#define FRAME_SERVER_LATENCY_BINS   256     //bin k holds latencies up to 2^(k/8) microseconds
+
+//message from a client (64 bytes)
+typedef struct FrameServerRequest
+{
+	int32_t  Type;              //FRAME_SERVER_OPEN, FRAME_SERVER_FRAME, FRAME_SERVER_STATS or FRAME_SERVER_SHUTDOWN
+	int32_t  Slot;              //slot of the frame (FRAME_SERVER_FRAME)
+	uint64_t Sequence;          //returned in the reply
+	double   psa;               //yaw angle (unit is radian)
+	double   afa;               //pitch angle (unit is radian)
+	double   beta;              //roll angle (unit is radian)
+	int64_t  Reserved[3];
+}
+FrameServerRequest;
+
+//camera configuration of FRAME_SERVER_OPEN (128 bytes)
+typedef struct FrameServerCamera
+{
+	int32_t  Version;           //FRAME_SERVER_VERSION
+	int32_t  Slots;             //frame slots of the connection (1 to FRAME_SERVER_MAX_SLOTS)
+	int32_t  ScalarType;        //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	int32_t  Kernel;            //RAYLEIGH_KERNEL_AUTO to RAYLEIGH_KERNEL_CLOSED_FORM
+	double   D_x;               //Unit cell size of CCD or COMS (unit is micrometer)
+	double   D_z;               //Unit cell size of CCD or COMS (unit is micrometer)
+	int32_t  n_x;               //Image pixel size (unit is pixel)
+	int32_t  n_z;               //Image pixel size (unit is pixel)
+	double   f;                 //Focus of the camera (unit is millimeter)
+	int32_t  PixelInterval;     //Pixel interval of the simulation (unit is pixel)
+	int32_t  Projection;        //CAMERA_PROJECTION_PINHOLE to CAMERA_PROJECTION_STEREOGRAPHIC
+	double   FieldOfView;       //full field of view of the lens (unit is degree), 0 for no limit
+	double   k1;                //radial distortion coefficients
+	double   k2;
+	double   k3;
+	double   p1;                //tangential distortion coefficients
+	double   p2;
+	int32_t  SkyModel;          //SKY_MODEL_RAYLEIGH or SKY_MODEL_BERRY
+	int32_t  Padding;
+	double   DOP_max;           //maximum DOP in the sky
+	double   NeutralPoint;      //angle of the neutral points from the sun and the anti-sun (unit is degree)
+}
+FrameServerCamera;
+
+//answer to FRAME_SERVER_OPEN (64 bytes)
+//Slot k of the shared memory holds the DOP plane at k*SlotBytes and the AOP plane at k*SlotBytes+PlaneBytes,
+//n_x rows of n_z values each, in the layout of CameraFrame.
+typedef struct FrameServerLayout
+{
+	int32_t  Status;            //0, or -1 if the configuration is invalid or memory runs out (no descriptor follows)
+	int32_t  Slots;             //frame slots
+	int32_t  n_x;               //Number of simulated pixels along i_x (unit is pixel)
+	int32_t  n_z;               //Number of simulated pixels along j_z (unit is pixel)
+	int32_t  ScalarType;        //FRAME_SCALAR_DOUBLE or FRAME_SCALAR_FLOAT
+	int32_t  Warm;              //1 if the camera configuration was already set up by an earlier connection
+	int64_t  PlaneBytes;        //bytes of a plane, padded to FRAME_FILE_ALIGNMENT
+	int64_t  SlotBytes;         //bytes of a slot
+	int64_t  MapBytes;          //bytes of the shared memory
+	int64_t  Reserved[2];
+}
+FrameServerLayout;
+
+//answer to FRAME_SERVER_FRAME (64 bytes)
+typedef struct FrameServerReply
+{
+	int32_t  Type;              //FRAME_SERVER_FRAME
+	int32_t  Status;            //0, or -1 for an invalid slot
+	uint64_t Sequence;          //of the request
+	int32_t  Slot;              //slot holding the frame
+	int32_t  Batch;             //requests simulated together with this one
+	uint64_t LatencyNs;         //from reading the request to sending the reply (unit is nanosecond)
+	uint64_t SimulationNs;      //simulation of the batch of the request (unit is nanosecond)
+	int64_t  Reserved[3];
+}
+FrameServerReply;
+
+//answer to FRAME_SERVER_STATS (64 bytes)
+typedef struct FrameServerStats
+{
+	int32_t  Type;              //FRAME_SERVER_STATS
+	int32_t  Status;            //0
+	uint64_t Requests;          //answered frame requests
+	uint64_t MeanNs;            //latency of the requests (unit is nanosecond); percentiles are the upper ends of
+	uint64_t P50Ns;             //their histogram bins, within 9 percent
+	uint64_t P90Ns;
+	uint64_t P99Ns;
+	uint64_t P999Ns;
+	uint64_t MaxNs;
+}
+FrameServerStats;
+
+typedef struct FrameServer FrameServer;
+
+//client connection with its shared frame slots
+typedef struct FrameClient
+{
+	int      Socket;            //connected socket
+	FrameServerLayout  layout;  //slots of the connection
+	char *	Map;                //shared frame slots
+}
+FrameClient;
+
+//Create a server listening on a Unix domain socket, NULL if the socket cannot be created.
+FrameServer * FrameServerInit(
+	const char *  path,         //file name of the socket, replaced if it exists
+	const int     Threads       //threads of the simulation, 0 for every hardware thread
+	);
+
+//Serve clients until FRAME_SERVER_SHUTDOWN or "FrameServerStop()".
+int FrameServerRun(
+	FrameServer *	server      //server
+	);
+
+//Make "FrameServerRun()" return; safe in a signal handler and from other threads.
+void FrameServerStop(
+	FrameServer *	server      //server
+	);
+
+//Latencies of every frame request the server answered.
+void FrameServerGetStats(
+	const FrameServer *	server, //server
+	FrameServerStats *	stats   //latency statistics
+	);
+
+//Close the connections and the socket and release the server and its cameras.
+void FrameServerFree(
+	FrameServer *	server      //server, may be NULL
+	);
+
+//Serve on a socket until SIGINT, SIGTERM or FRAME_SERVER_SHUTDOWN, then print the latencies (main.cpp --serve).
+int FrameServerServe(
+	const char *  path,         //file name of the socket
+	const int     Threads       //threads of the simulation, 0 for every hardware thread
+	);
+
+//Default camera configuration: the camera of main.cpp with 4 slots of double frames.
+void FrameServerCameraDefault(
+	FrameServerCamera *	camera  //camera configuration
+	);
+
+//Connect to a server and open a camera, NULL if the server refuses it.
+FrameClient * FrameClientConnect(
+	const char *  path,                 //file name of the socket
+	const FrameServerCamera *	camera  //camera configuration
+	);
+
+//Send a frame request without waiting for the frame.
+int FrameClientSubmit(
+	FrameClient *	client,     //connection
+	const int     Slot,         //slot of the frame, not to be read until its reply arrived
+	const uint64_t  Sequence,   //returned in the reply
+	const double  psa,          //yaw angle (unit is radian)
+	const double  afa,          //pitch angle (unit is radian)
+    const double  beta          //roll angle (unit is radian)
+	);
+
+//Wait for the next reply, in the order of the requests.
+int FrameClientReceive(
+	FrameClient *	client,     //connection
+	FrameServerReply *	reply   //reply
+	);
+
+//Simulate a frame into a slot and wait for it.
+int FrameClientFrame(
+	FrameClient *	client,     //connection
+	const int     Slot,         //slot of the frame
+	const double  psa,          //yaw angle (unit is radian)
+	const double  afa,          //pitch angle (unit is radian)
+    const double  beta,         //roll angle (unit is radian)
+	FrameServerReply *	reply   //reply, may be NULL
+	);
+
+//DOP or AOP plane of a slot (const double * or const float *), NULL for an invalid slot.
+const void * FrameClientPlane(
+	const FrameClient *	client, //connection
+	const int     Slot,         //slot
+	const int     AOP           //0 for the DOP plane, 1 for the AOP plane
+	);
+
+//Latencies of the frame requests of the connection.
+int FrameClientStats(
+	FrameClient *	client,     //connection, without frame requests in flight
+	FrameServerStats *	stats   //latency statistics
+	);
+
+//Ask the server to stop.
+int FrameClientShutdown(
+	FrameClient *	client      //connection
+	);
+
+//Close a connection and unmap its slots.
+void FrameClientClose(
+	FrameClient *	client      //connection, may be NULL
+	);
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef _MATRIXTEMPLATE_H_
+#define _MATRIXTEMPLATE_H_
+
+#include <math.h>
+
+//Fixed-size counterparts of MatrixFunction.h (C++11). The sizes are template parameters deduced from the
+//array types, so every call is inlined and unrolled, and the values stay in registers across the calls.
+//The loops add in the same order as MatrixFunction.cpp, so the results are identical.
+
+//number of terms of the Taylor series of "ConstSin()" and "ConstCos()"
+#define MATRIX_CONST_TERMS          15
+
+//value type of a matrix a[M][N], so that matrices can be returned and built at compile time
+template <int M, int N>
+struct Mat
+{
+	double  a[M][N];
+};
+typedef Mat<3,3> Mat3;
+typedef Mat<3,1> Vec3;
+
+//Matrix transpose b=a' where a[m][n] b[n][m]
+template <int M, int N>
+inline void MatrixTrans(const double (&a)[M][N], double (&b)[N][M])
+{
+	for(int i=0; i<M; i++)
+		for(int j=0; j<N; j++)
+			b[j][i] = a[i][j];
+}
+
+//Matrix multiplication c=a*b where a[m][p] b[p][n] c[m][n]
+template <int M, int P, int N>
+inline void MatrixMultiply(const double (&a)[M][P], const double (&b)[P][N], double (&c)[M][N])
+{
+	for(int i=0; i<M; i++)
+		for(int j=0; j<N; j++)
+		{
+			double temp = 0;
+			for(int k=0; k<P; k++)
+				temp += a[i][k]*b[k][j];
+			c[i][j] = temp;
+		}
+}
+
+//Matrix addition c=a+b where a[m][n] b[m][n] c[m][n]
+template <int M, int N>
+inline void MatrixAdd(const double (&a)[M][N], const double (&b)[M][N], double (&c)[M][N])
+{
+	for(int i=0; i<M; i++)
+		for(int j=0; j<N; j++)
+			c[i][j] = a[i][j]+b[i][j];
+}
+
+//Matrix norm where a[m][n] b(scalar)
+template <int M, int N>
+inline void MatrixNorm(const double (&a)[M][N], double & b)
+{
+	b = 0.0;
+	for(int i=0; i<M; i++)
+		for(int j=0; j<N; j++)
+			b = b+a[i][j]*a[i][j];
+	b = sqrt(b);
+}
+
+//Scalar multiplication of matrix c=b*a where a[m][n] b(scalar) c[m][n]
+template <int M, int N>
+inline void MatrixScalarMultiply(const double (&a)[M][N], const double b, double (&c)[M][N])
+{
+	for(int i=0; i<M; i++)
+		for(int j=0; j<N; j++)
+			c[i][j] = b*a[i][j];
+}
+
+//Rotation matrix from solar vector to body coordinate system of three Euler angles (unit is radian)
+inline void MatrixEulerRotation(const double psa, const double afa, const double beta, double (&C)[3][3])
+{
+	double R[3][3] = {cos(beta)*cos(psa)+sin(beta)*sin(afa)*sin(psa),     -cos(beta)*sin(psa)+sin(beta)*sin(afa)*cos(psa),     -sin(beta)*cos(afa),
+					  cos(afa)*sin(psa),									cos(afa)*cos(psa),                                     sin(afa),
+					  sin(beta)*cos(psa)-cos(beta)*sin(afa)*sin(psa),     -sin(beta)*sin(psa)-cos(beta)*sin(afa)*cos(psa),     cos(beta)*cos(afa),
+		};
+	for(int i=0; i<3; i++)
+		for(int j=0; j<3; j++)
+			C[i][j] = R[i][j];
+}
+
+//Three Euler angles of a rotation matrix of "MatrixEulerRotation()" (unit is radian)
+//afa is in [-pi/2,pi/2]; at afa=+-pi/2 only psa+-beta is defined and psa is set to 0.
+inline void MatrixEulerAngles(const double (&C)[3][3], double & psa, double & afa, double & beta)
+{
+	double s = C[1][2]>1.0 ? 1.0 : (C[1][2]<-1.0 ? -1.0 : C[1][2]);
+	afa = asin(s);
+	if(C[1][0]*C[1][0]+C[1][1]*C[1][1]>1e-24){
+		psa = atan2(C[1][0],C[1][1]);
+		beta = atan2(-C[0][2],C[2][2]);
+	}
+	else{
+		psa = 0.0;
+		beta = atan2(C[2][0],C[0][0]);
+	}
+}
+
+//x reduced to [-pi,pi] for the Taylor series
+constexpr double ConstReduce(const double x)
+{
+	return x-6.283185307179586*(double)(long long)(x/6.283185307179586+(x>=0 ? 0.5 : -0.5));
+}
+
+//sum of the terms k, k+1, ... of the Taylor series of sin (term is the term k)
+constexpr double ConstSinSeries(const double x2, const double term, const int k)
+{
+	return k>=MATRIX_CONST_TERMS ? term : term+ConstSinSeries(x2,-term*x2/((2*k+2)*(2*k+3)),k+1);
+}
+
+//sum of the terms k, k+1, ... of the Taylor series of cos (term is the term k)
+constexpr double ConstCosSeries(const double x2, const double term, const int k)
+{
+	return k>=MATRIX_CONST_TERMS ? term : term+ConstCosSeries(x2,-term*x2/((2*k+1)*(2*k+2)),k+1);
+}
+
+//sin(x) usable in constant expressions
+constexpr double ConstSin(const double x)
+{
+	return ConstSinSeries(ConstReduce(x)*ConstReduce(x),ConstReduce(x),0);
+}
+
+//cos(x) usable in constant expressions
+constexpr double ConstCos(const double x)
+{
+	return ConstCosSeries(ConstReduce(x)*ConstReduce(x),1.0,0);
+}
+
+//Rotation matrix of "MatrixEulerRotation()" usable in constant expressions, e.g. for fixed mounting attitudes
+constexpr Mat3 ConstEulerRotation(const double psa, const double afa, const double beta)
+{
+	return Mat3{{{ConstCos(beta)*ConstCos(psa)+ConstSin(beta)*ConstSin(afa)*ConstSin(psa), -ConstCos(beta)*ConstSin(psa)+ConstSin(beta)*ConstSin(afa)*ConstCos(psa), -ConstSin(beta)*ConstCos(afa)},
+				 {ConstCos(afa)*ConstSin(psa),                                               ConstCos(afa)*ConstCos(psa),                                               ConstSin(afa)},
+				 {ConstSin(beta)*ConstCos(psa)-ConstCos(beta)*ConstSin(afa)*ConstSin(psa),  -ConstSin(beta)*ConstSin(psa)-ConstCos(beta)*ConstSin(afa)*ConstCos(psa), ConstCos(beta)*ConstCos(afa)}}};
+}
+
+static_assert(ConstEulerRotation(0.0,0.0,0.0).a[0][0]==1.0 && ConstEulerRotation(0.0,0.0,0.0).a[1][0]==0.0,
+	"ConstEulerRotation() of zero angles is the identity");
+
+#endif
@@ -0,0 +1,737 @@
+/*
+Monte Carlo attitude error analysis of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for drawing millions of random attitudes and noise realizations, running an estimator on every simulated frame and aggregating its errors without writing any frame.
+And this code is written in C++11.
+
+Usage information:
+Fill MonteCarloSettings and a MonteCarloEstimator, then call "CameraSimulationMonteCarlo()" once per run.
+--------------------------
+
+Monte Carlo:
+	Sample n of a run is fully determined by Seed and n: its attitude comes from Philox4x32-10 ("MosaicPhilox()") with
+	the counter {~0,~0,n}, the Gaussian noise of pixel p from the counter {p,0,n}, and the sensor noise of
+	MONTE_CARLO_NOISE_MOSAIC from "CameraSimulationMosaic()" with FrameIndex n. Any sample can be simulated again
+	alone, on any machine, from the index printed by an estimator.
+	The samples are cut into batches of MONTE_CARLO_BATCH consecutive indices. A parallel loop of the thread pool
+	hands out the batches of a round one at a time to whichever thread is free, so threads that hit slow samples
+	(more solver iterations, lens pixels without sky) take fewer batches and none waits for a fixed share. Every
+	thread borrows a worker (camera parameters, frame, raw buffer and estimator state) for the batch and adds the
+	errors to the integer counters of the worker: counts, histograms, minimum and maximum, which give the same
+	totals in any order. The floating point sums of a batch are kept apart and added in the order of the batches
+	after every round, so the mean, RMS and standard deviation are bit for bit the same on 1 or 64 threads.
+	No frame leaves the worker; the memory of a run is one frame per thread and the partial sums of a round.
+
+
+Function 1: "MonteCarloSettingsDefault()" 
+
+    //Default settings.
+	void MonteCarloSettingsDefault(
+		MonteCarloSettings *	settings
+	);
+	-------------output----------------
+	MonteCarloSettings *	settings    //1000 samples, Seed 1, pitch in [-pi/2,pi/2], roll in [-pi,pi],
+	                                    //MONTE_CARLO_NOISE_FRAME with 0.01 DOP and 1 degree AOP, default sensor
+	-----------------------------------
+
+
+Function 2: "MonteCarloSampleAttitude()" 
+
+    //Attitude of a sample of a Monte Carlo run.
+	void MonteCarloSampleAttitude(
+		const MonteCarloSettings *	settings,
+		const int64_t  Index,
+		CameraAttitude *	attitude
+	);
+	--------------input----------------
+	const MonteCarloSettings *	settings,   //settings
+	const int64_t  Index                    //index of the sample
+	-----------------------------------
+	-------------output----------------
+	CameraAttitude *	attitude            //Euler angles of camera the sample is simulated with
+	-----------------------------------
+
+
+Function 3: "MonteCarloEstimatorAttitude()" 
+
+    //Estimator of "AttitudeSolveFrame()".
+	void MonteCarloEstimatorAttitude(
+		MonteCarloEstimator *	estimator
+	);
+	-------------output----------------
+	MonteCarloEstimator *	estimator   //one AttitudeSolver per thread, solving every frame without a hint
+	-----------------------------------
+	The errors are "sun", the angle between the true and the recovered sun vector, and "afa" and "beta", the
+	absolute pitch and roll errors, all in degrees with histograms up to 5 degrees. The opposite sun vector gives
+	the same frame, so the solution or its alternative, whichever is nearer the truth, is compared.
+	Roll is not defined at a pitch of +-pi/2, so keep AfaMin and AfaMax away from it when the roll error matters.
+
+
+Function 4: "CameraSimulationMonteCarlo()" 
+
+    //Monte Carlo analysis: random attitudes and noise, simulation, estimation and streaming error statistics.
+	int CameraSimulationMonteCarlo(
+		const MonteCarloSettings *	settings,
+		const CameraParameters *	parm,
+		const MonteCarloEstimator *	estimator,
+		ThreadPool *	pool,
+		MonteCarloResult *	result
+	);
+	--------------input----------------
+	const MonteCarloSettings *	settings,   //random attitudes and noise
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const MonteCarloEstimator *	estimator,  //estimator of the samples
+	ThreadPool *	pool                    //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	MonteCarloResult *	result              //error statistics, the same for every size of the pool
+	int                                     //0, or -1 if the settings are invalid or a worker cannot be created
+	-----------------------------------
+
+
+Function 5: "MonteCarloPercentile()" 
+
+    //Percentile of an error from its histogram.
+	double MonteCarloPercentile(
+		const MonteCarloStatistics *	stats,
+		const double  p
+	);
+	--------------input----------------
+	const MonteCarloStatistics *	stats,  //statistics of an error
+	const double  p                         //percentile, 0 to 100
+	-----------------------------------
+	-------------output----------------
+	double                                  //value interpolated linearly inside its bin, Min or Max if it falls into
+	                                        //the underflow or overflow, NaN without values
+	-----------------------------------
+
+
+Function 6: "MonteCarloWriteJson()" 
+
+    //Write the statistics of a Monte Carlo run as JSON.
+	int MonteCarloWriteJson(
+		const MonteCarloResult *	result,
+		const int     Histograms,
+		FILE *	file
+	);
+	--------------input----------------
+	const MonteCarloResult *	result,     //error statistics
+	const int     Histograms,               //1 writes the histograms too
+	FILE *	file                            //opened file
+	-----------------------------------
+	-------------output----------------
+	int                                     //0, or -1 if writing failed
+	-----------------------------------
+	The names of the errors are escaped and the statistics of an error without samples (NaN) are written as null,
+	so every run of any estimator gives valid JSON.
+
+Example:
+
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,64,80,4.0,1);
+	MonteCarloSettings settings;
+	MonteCarloSettingsDefault(&settings);
+	settings.Samples = 1000000;
+	MonteCarloEstimator estimator;
+	MonteCarloEstimatorAttitude(&estimator);
+	MonteCarloResult * result = ALLOC(MonteCarloResult);
+	ThreadPool pool(0);
+	CameraSimulationMonteCarlo(&settings,parm,&estimator,&pool,result);
+	MonteCarloWriteJson(result,0,stdout);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include "MonteCarlo.h"
+#include "CameraDemosaic.h"
+#include "AttitudeSolver.h"
+#include "ThreadPool.h"
+#include "CameraStats.h"
+
+#ifndef ALLOC
+#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
+#endif
+
+const static double pi = 3.141592653589793;
+
+//simulation state and integer counters of one thread
+typedef struct MonteCarloWorker
+{
+	CameraParameters  parm;     //copy of the camera parameters sharing their ray table, with the sample attitude
+	CameraFrame *	frame;      //measured DOP and AOP of the sample
+	uint16_t *	Raw;            //raw mosaic of MONTE_CARLO_NOISE_MOSAIC, NULL otherwise
+	void *	state;              //estimator state
+
+	int64_t   Samples;
+	int64_t   Failures;
+	int64_t   Count[MONTE_CARLO_MAX_ERRORS];
+	double    Min[MONTE_CARLO_MAX_ERRORS];
+	double    Max[MONTE_CARLO_MAX_ERRORS];
+	int64_t   Histogram[MONTE_CARLO_MAX_ERRORS][MONTE_CARLO_BINS];
+	int64_t   Underflow[MONTE_CARLO_MAX_ERRORS];
+	int64_t   Overflow[MONTE_CARLO_MAX_ERRORS];
+}
+MonteCarloWorker;
+
+
+
+//Default settings.
+void MonteCarloSettingsDefault(
+	MonteCarloSettings *	settings    //settings
+	){
+	settings->Samples = 1000;
+	settings->Seed = 1;
+	settings->AfaMin = -0.5*pi;
+	settings->AfaMax = 0.5*pi;
+	settings->BetaMin = -pi;
+	settings->BetaMax = pi;
+	settings->Noise = MONTE_CARLO_NOISE_FRAME;
+	settings->DOPNoise = 0.01;
+	settings->AOPNoise = 1.0;
+	MosaicParametersDefault(&settings->Mosaic);
+	settings->DemosaicMethod = DEMOSAIC_BILINEAR;
+}
+
+
+
+//Uniform deviate in (0,1) of a random word.
+static double Uniform(
+	const uint32_t  u   //random word
+	){
+	return ((double)u+0.5)*(1.0/4294967296.0);
+}
+
+
+
+//Attitude of a sample of a Monte Carlo run.
+void MonteCarloSampleAttitude(
+	const MonteCarloSettings *	settings,   //settings
+	const int64_t  Index,                   //index of the sample
+	CameraAttitude *	attitude            //Euler angles of camera
+	){
+	const uint32_t key[2] = {(uint32_t)settings->Seed,(uint32_t)(settings->Seed>>32)};
+	const uint32_t counter[4] = {0xffffffffu,0xffffffffu,(uint32_t)Index,(uint32_t)((uint64_t)Index>>32)};
+	uint32_t random[4];
+	MosaicPhilox(counter,key,random);
+	attitude->psa = 2.0*pi*Uniform(random[0]);
+	attitude->afa = settings->AfaMin+(settings->AfaMax-settings->AfaMin)*Uniform(random[1]);
+	attitude->beta = settings->BetaMin+(settings->BetaMax-settings->BetaMin)*Uniform(random[2]);
+}
+
+
+
+//Add Gaussian noise to DOP and AOP of every pixel of a frame (Box-Muller transform of two Philox words each).
+static void FrameNoise(
+	const MonteCarloSettings *	settings,   //settings
+	const int64_t  Index,                   //index of the sample
+	CameraFrame *	frame                   //DOP and AOP frame
+	){
+	const uint32_t key[2] = {(uint32_t)settings->Seed,(uint32_t)(settings->Seed>>32)};
+	size_t PixelNum = (size_t)frame->n_x*frame->n_z;
+	for(size_t p=0; p<PixelNum; p++){
+		const uint32_t counter[4] = {(uint32_t)p,0,(uint32_t)Index,(uint32_t)((uint64_t)Index>>32)};
+		uint32_t random[4];
+		MosaicPhilox(counter,key,random);
+		double DOP = frame->DOP[p]+settings->DOPNoise*sqrt(-2.0*log(Uniform(random[0])))*cos(2.0*pi*Uniform(random[1]));
+		double AOP = frame->AOP[p]+settings->AOPNoise*sqrt(-2.0*log(Uniform(random[2])))*cos(2.0*pi*Uniform(random[3]));
+		//a measured DOP lies in [0,1] and a measured AOP in [-90,90) degrees, NaN pixels stay NaN
+		frame->DOP[p] = DOP<0.0 ? 0.0 : (DOP>1.0 ? 1.0 : DOP);
+		frame->AOP[p] = AOP-180.0*floor((AOP+90.0)/180.0);
+	}
+}
+
+
+
+//Simulate the measured frame of a sample into the worker.
+static int SampleSimulation(
+	const MonteCarloSettings *	settings,   //settings
+	const int64_t  Index,                   //index of the sample
+	const CameraAttitude &	truth,          //attitude of the sample
+	MonteCarloWorker *	worker              //worker
+	){
+	if(settings->Noise==MONTE_CARLO_NOISE_MOSAIC){
+		MosaicParameters mosaic = settings->Mosaic;
+		mosaic.Seed = settings->Seed;
+		mosaic.FrameIndex = (uint64_t)Index;
+		if(CameraSimulationMosaic(truth.psa,truth.afa,truth.beta,&worker->parm,&mosaic,worker->Raw,NULL)!=0){
+			return -1;
+		}
+		return CameraDemosaic(worker->Raw,&mosaic,settings->DemosaicMethod,worker->parm.Kernel,worker->frame,
+			NULL,NULL,NULL,NULL);
+	}
+
+	worker->parm.psa = truth.psa;
+	worker->parm.afa = truth.afa;
+	worker->parm.beta = truth.beta;
+	double C_vTb[3][3];//rotation matrix from solar vector to body coordinate system
+	double C_bTv[3][3];//rotation matrix from body to solar vector coordinate system
+	CameraRotationMatrix(truth.psa,truth.afa,truth.beta,C_vTb,C_bTv);
+	CameraSimulationFrameRotation(C_vTb,C_bTv,&worker->parm,worker->frame,NULL);
+	if(settings->Noise==MONTE_CARLO_NOISE_FRAME){
+		FrameNoise(settings,Index,worker->frame);
+	}
+	return 0;
+}
+
+
+
+//Simulate and estimate the samples of a batch in order, adding the sums of the errors to Sums.
+static void BatchSimulation(
+	const MonteCarloSettings *	settings,   //settings
+	const MonteCarloEstimator *	estimator,  //estimator
+	MonteCarloWorker *	worker,             //worker of the calling thread
+	const int64_t  first,                   //index of the first sample
+	const int64_t  last,                    //index after the last sample
+	double *	Sums                        //sum and sum of squares of every error
+	){
+	for(int64_t n=first; n<last; n++){
+		CameraAttitude truth;
+		MonteCarloSampleAttitude(settings,n,&truth);
+		worker->Samples++;
+		double errors[MONTE_CARLO_MAX_ERRORS];
+		for(int k=0; k<MONTE_CARLO_MAX_ERRORS; k++){
+			errors[k] = std::numeric_limits<double>::quiet_NaN();
+		}
+		MonteCarloSample sample = {n,truth,&worker->parm,worker->frame};
+		if(SampleSimulation(settings,n,truth,worker)!=0 || estimator->Estimate(worker->state,&sample,errors)!=0){
+			worker->Failures++;
+			continue;
+		}
+		for(int k=0; k<estimator->ErrorCount; k++){
+			double e = errors[k];
+			if(!std::isfinite(e)){
+				continue;
+			}
+			Sums[2*k] += e;
+			Sums[2*k+1] += e*e;
+			worker->Min[k] = e<worker->Min[k] ? e : worker->Min[k];
+			worker->Max[k] = e>worker->Max[k] ? e : worker->Max[k];
+			worker->Count[k]++;
+			double bin = e/estimator->HistogramMax[k]*MONTE_CARLO_BINS;
+			if(e<0.0){
+				worker->Underflow[k]++;
+			}
+			else if(bin>=MONTE_CARLO_BINS){
+				worker->Overflow[k]++;
+			}
+			else{
+				worker->Histogram[k][(int)bin]++;
+			}
+		}
+	}
+}
+
+
+
+//Release a worker.
+static void WorkerFree(
+	const MonteCarloEstimator *	estimator,  //estimator
+	MonteCarloWorker *	worker              //worker
+	){
+	if(worker==NULL){
+		return;
+	}
+	if(estimator->Free!=NULL && worker->state!=NULL){
+		estimator->Free(worker->state);
+	}
+	CameraFrameFree(worker->frame);
+	free(worker->Raw);
+	free(worker);
+}
+
+
+
+//Create a worker with its frame, raw buffer and estimator state.
+static MonteCarloWorker * WorkerInit(
+	const MonteCarloSettings *	settings,   //settings
+	const CameraParameters *	parm,       //camera parameters
+	const MonteCarloEstimator *	estimator   //estimator
+	){
+	MonteCarloWorker * worker = ALLOC(MonteCarloWorker);
+	if(worker==NULL){
+		return NULL;
+	}
+	memset(worker,0,sizeof(MonteCarloWorker));
+	worker->parm = *parm;
+	for(int k=0; k<MONTE_CARLO_MAX_ERRORS; k++){
+		worker->Min[k] = std::numeric_limits<double>::infinity();
+		worker->Max[k] = -std::numeric_limits<double>::infinity();
+	}
+	worker->frame = CameraFrameInit(parm);
+	if(settings->Noise==MONTE_CARLO_NOISE_MOSAIC && worker->frame!=NULL){
+		worker->Raw = (uint16_t *)malloc((size_t)worker->frame->n_x*worker->frame->n_z*sizeof(uint16_t));
+	}
+	if(estimator->Init!=NULL){
+		worker->state = estimator->Init(estimator->context,parm);
+	}
+	if(worker->frame==NULL || (settings->Noise==MONTE_CARLO_NOISE_MOSAIC && worker->Raw==NULL)
+		|| (estimator->Init!=NULL && worker->state==NULL)){
+		WorkerFree(estimator,worker);
+		return NULL;
+	}
+	return worker;
+}
+
+
+
+//Statistics of an error from the sums and the counters of the workers.
+static void ErrorStatistics(
+	const std::vector<MonteCarloWorker *> &	worker, //workers
+	const int     k,                    //index of the error
+	const double  Sum,                  //sum of the error over the samples in order
+	const double  SumSquares,           //sum of the squared error over the samples in order
+	const double  HistogramMax,         //upper end of the histogram
+	MonteCarloStatistics *	stats       //statistics
+	){
+	memset(stats,0,sizeof(MonteCarloStatistics));
+	stats->HistogramMax = HistogramMax;
+	stats->Min = std::numeric_limits<double>::infinity();
+	stats->Max = -std::numeric_limits<double>::infinity();
+	for(size_t w=0; w<worker.size(); w++){
+		stats->Count += worker[w]->Count[k];
+		stats->Min = worker[w]->Min[k]<stats->Min ? worker[w]->Min[k] : stats->Min;
+		stats->Max = worker[w]->Max[k]>stats->Max ? worker[w]->Max[k] : stats->Max;
+		stats->Underflow += worker[w]->Underflow[k];
+		stats->Overflow += worker[w]->Overflow[k];
+		for(int b=0; b<MONTE_CARLO_BINS; b++){
+			stats->Histogram[b] += worker[w]->Histogram[k][b];
+		}
+	}
+	if(stats->Count==0){
+		double NaN = std::numeric_limits<double>::quiet_NaN();
+		stats->Mean = stats->RMS = stats->StdDev = stats->Min = stats->Max = NaN;
+		stats->Median = stats->P90 = stats->P95 = stats->P99 = NaN;
+		return;
+	}
+	double n = (double)stats->Count;
+	stats->Mean = Sum/n;
+	stats->RMS = sqrt(SumSquares/n);
+	double variance = stats->Count>1 ? (SumSquares-Sum*stats->Mean)/(n-1.0) : 0.0;
+	stats->StdDev = variance>0.0 ? sqrt(variance) : 0.0;
+	stats->Median = MonteCarloPercentile(stats,50.0);
+	stats->P90 = MonteCarloPercentile(stats,90.0);
+	stats->P95 = MonteCarloPercentile(stats,95.0);
+	stats->P99 = MonteCarloPercentile(stats,99.0);
+}
+
+
+
+//Monte Carlo analysis: random attitudes and noise, simulation, estimation and streaming error statistics.
+int CameraSimulationMonteCarlo(
+	const MonteCarloSettings *	settings,   //random attitudes and noise
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const MonteCarloEstimator *	estimator,  //estimator of the samples
+	ThreadPool *	pool,                   //thread pool, NULL runs on the calling thread
+	MonteCarloResult *	result              //error statistics
+	){
+	if(settings->Samples<0 || estimator->Estimate==NULL
+		|| estimator->ErrorCount<1 || estimator->ErrorCount>MONTE_CARLO_MAX_ERRORS
+		|| (settings->Noise!=MONTE_CARLO_NOISE_NONE && settings->Noise!=MONTE_CARLO_NOISE_FRAME
+			&& settings->Noise!=MONTE_CARLO_NOISE_MOSAIC)
+		|| (settings->Noise==MONTE_CARLO_NOISE_MOSAIC && (parm->PixelInterval!=1
+			|| settings->Mosaic.Bits<1 || settings->Mosaic.Bits>16 || !(settings->Mosaic.Gain>0.0)))){
+		return -1;
+	}
+	for(int k=0; k<estimator->ErrorCount; k++){
+		if(!(estimator->HistogramMax[k]>0.0)){
+			return -1;
+		}
+	}
+
+	//one worker per thread, lent out for a batch at a time
+	std::vector<MonteCarloWorker *> worker(pool==NULL ? 1 : pool->Size(),(MonteCarloWorker *)NULL);
+	std::vector<int> idle;
+	for(size_t w=0; w<worker.size(); w++){
+		worker[w] = WorkerInit(settings,parm,estimator);
+		if(worker[w]==NULL){
+			for(size_t v=0; v<w; v++){
+				WorkerFree(estimator,worker[v]);
+			}
+			return -1;
+		}
+		idle.push_back((int)w);
+	}
+	std::mutex IdleMutex;
+
+	//sums of every batch of a round, added in the order of the batches
+	const int width = 2*MONTE_CARLO_MAX_ERRORS;
+	std::vector<double> BatchSums((size_t)MONTE_CARLO_ROUND_BATCHES*width);
+	double Sums[2*MONTE_CARLO_MAX_ERRORS] = {0.0};
+	int64_t batches = (settings->Samples+MONTE_CARLO_BATCH-1)/MONTE_CARLO_BATCH;
+	for(int64_t round=0; round<batches; round+=MONTE_CARLO_ROUND_BATCHES){
+		int count = (int)(batches-round<MONTE_CARLO_ROUND_BATCHES ? batches-round : MONTE_CARLO_ROUND_BATCHES);
+		std::fill(BatchSums.begin(),BatchSums.begin()+(size_t)count*width,0.0);
+		auto task = [&](int begin, int end){
+			int w;
+			{
+				std::lock_guard<std::mutex> lock(IdleMutex);
+				w = idle.back();
+				idle.pop_back();
+			}
+			for(int b=begin; b<end; b++){
+				int64_t first = (round+b)*MONTE_CARLO_BATCH;
+				int64_t last = first+MONTE_CARLO_BATCH<settings->Samples ? first+MONTE_CARLO_BATCH : settings->Samples;
+				BatchSimulation(settings,estimator,worker[w],first,last,&BatchSums[(size_t)b*width]);
+			}
+			std::lock_guard<std::mutex> lock(IdleMutex);
+			idle.push_back(w);
+		};
+		if(pool==NULL){
+			task(0,count);
+		}
+		else{
+			pool->ParallelFor(count,1,task);
+		}
+		for(int b=0; b<count; b++){
+			for(int k=0; k<width; k++){
+				Sums[k] += BatchSums[(size_t)b*width+k];
+			}
+		}
+	}
+
+	result->Samples = 0;
+	result->Failures = 0;
+	for(size_t w=0; w<worker.size(); w++){
+		result->Samples += worker[w]->Samples;
+		result->Failures += worker[w]->Failures;
+	}
+	result->ErrorCount = estimator->ErrorCount;
+	for(int k=0; k<MONTE_CARLO_MAX_ERRORS; k++){
+		result->ErrorNames[k] = k<estimator->ErrorCount ? estimator->ErrorNames[k] : NULL;
+		ErrorStatistics(worker,k,Sums[2*k],Sums[2*k+1],k<estimator->ErrorCount ? estimator->HistogramMax[k] : 0.0,
+			&result->Errors[k]);
+	}
+	for(size_t w=0; w<worker.size(); w++){
+		WorkerFree(estimator,worker[w]);
+	}
+	return 0;
+}
+
+
+
+//Percentile of an error from its histogram.
+double MonteCarloPercentile(
+	const MonteCarloStatistics *	stats,  //statistics of an error
+	const double  p                         //percentile, 0 to 100
+	){
+	if(stats->Count==0){
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	double target = (p<0.0 ? 0.0 : (p>100.0 ? 100.0 : p))/100.0*(double)stats->Count;
+	double below = (double)stats->Underflow;
+	if(target<=below){
+		return stats->Min;
+	}
+	double width = stats->HistogramMax/MONTE_CARLO_BINS;
+	for(int b=0; b<MONTE_CARLO_BINS; b++){
+		double n = (double)stats->Histogram[b];
+		if(n>0.0 && below+n>=target){
+			double value = (b+(target-below)/n)*width;
+			value = value<stats->Min ? stats->Min : value;
+			return value>stats->Max ? stats->Max : value;
+		}
+		below += n;
+	}
+	return stats->Max;
+}
+
+
+
+//Write a string as a JSON string, with quotes, backslashes and control characters escaped.
+static void JsonString(
+	const char *  text,         //string, NULL writes an empty string
+	FILE *	file                //opened file
+	){
+	fputc('"',file);
+	for(const char * p = text!=NULL ? text : ""; *p!='\0'; p++){
+		unsigned char c = (unsigned char)*p;
+		if(c=='"' || c=='\\'){
+			fputc('\\',file);
+			fputc(c,file);
+		}
+		else if(c=='\n'){
+			fputs("\\n",file);
+		}
+		else if(c=='\t'){
+			fputs("\\t",file);
+		}
+		else if(c<0x20){
+			fprintf(file,"\\u%04x",c);
+		}
+		else{
+			fputc(c,file);
+		}
+	}
+	fputc('"',file);
+}
+
+
+
+//Write the statistics of a Monte Carlo run as JSON.
+int MonteCarloWriteJson(
+	const MonteCarloResult *	result,     //error statistics
+	const int     Histograms,               //1 writes the histograms too
+	FILE *	file                            //opened file
+	){
+	fprintf(file,"{\n  \"samples\": %lld,\n  \"failures\": %lld,\n  \"errors\": {\n",
+		(long long)result->Samples,(long long)result->Failures);
+	for(int k=0; k<result->ErrorCount; k++){
+		const MonteCarloStatistics & s = result->Errors[k];
+		fprintf(file,"    ");
+		JsonString(result->ErrorNames[k],file);
+		fprintf(file,": {\"count\": %lld",(long long)s.Count);
+		//NaN of an error without samples is written as null
+		const char * name[] = {"mean","rms","stddev","min","max","median","p90","p95","p99","histogram_max"};
+		const double value[] = {s.Mean,s.RMS,s.StdDev,s.Min,s.Max,s.Median,s.P90,s.P95,s.P99,s.HistogramMax};
+		for(int m=0; m<(int)(sizeof(value)/sizeof(value[0])); m++){
+			fprintf(file,", \"%s\": ",name[m]);
+			CameraStatsWriteNumber(value[m],file);
+		}
+		fprintf(file,", \"underflow\": %lld, \"overflow\": %lld",(long long)s.Underflow,(long long)s.Overflow);
+		if(Histograms){
+			fprintf(file,",\n      \"histogram\": [");
+			for(int b=0; b<MONTE_CARLO_BINS; b++){
+				fprintf(file,"%lld%s",(long long)s.Histogram[b],b+1<MONTE_CARLO_BINS ? ", " : "");
+			}
+			fprintf(file,"]");
+		}
+		fprintf(file,"}%s\n",k+1<result->ErrorCount ? "," : "");
+	}
+	fprintf(file,"  }\n}\n");
+	return ferror(file) ? -1 : 0;
+}
+
+
+
+//Angle wrapped into [-180,180) degrees.
+static double WrapDegrees(
+	const double  angle         //angle (unit is radian)
+	){
+	double degree = angle*180.0/pi;
+	return degree-360.0*floor((degree+180.0)/360.0);
+}
+
+
+
+//Attitude solver of a thread.
+static void * AttitudeInit(
+	void *	context,                   //unused
+	const CameraParameters *	parm   //camera parameters
+	){
+	(void)context;
+	return AttitudeSolverInit(parm,0);
+}
+
+
+
+//Sun vector, pitch and roll errors of the attitude recovered from a frame without a hint.
+static int AttitudeEstimate(
+	void *	state,                      //attitude solver
+	const MonteCarloSample *	sample, //sample
+	double *	errors                  //errors (unit is degree)
+	){
+	AttitudeSolution solution;
+	if(AttitudeSolveFrame((AttitudeSolver *)state,sample->frame,NULL,&solution)!=0){
+		return -1;
+	}
+	double C_vTb[3][3];//rotation matrix from solar vector to body coordinate system
+	double C_bTv[3][3];//rotation matrix from body to solar vector coordinate system
+	CameraRotationMatrix(sample->Truth.psa,sample->Truth.afa,sample->Truth.beta,C_vTb,C_bTv);
+	double c = solution.Sun[0]*C_vTb[0][2]+solution.Sun[1]*C_vTb[1][2]+solution.Sun[2]*C_vTb[2][2];
+	double afa = solution.afa;
+	double beta = solution.beta;
+	if(c<0.0){
+		c = -c;
+		afa = solution.AlternativeAfa;
+		beta = solution.AlternativeBeta;
+	}
+	errors[0] = acos(c<1.0 ? c : 1.0)*180.0/pi;
+	errors[1] = fabs(WrapDegrees(afa-sample->Truth.afa));
+	errors[2] = fabs(WrapDegrees(beta-sample->Truth.beta));
+	return 0;
+}
+
+
+
+//Release the attitude solver of a thread.
+static void AttitudeFree(
+	void *	state                       //attitude solver
+	){
+	AttitudeSolverFree((AttitudeSolver *)state);
+}
+
+
+
+//Estimator of "AttitudeSolveFrame()": sun vector, pitch and roll errors (unit is degree).
+void MonteCarloEstimatorAttitude(
+	MonteCarloEstimator *	estimator   //estimator
+	){
+	memset(estimator,0,sizeof(MonteCarloEstimator));
+	estimator->ErrorCount = 3;
+	estimator->ErrorNames[0] = "sun";
+	estimator->ErrorNames[1] = "afa";
+	estimator->ErrorNames[2] = "beta";
+	estimator->HistogramMax[0] = 5.0;
+	estimator->HistogramMax[1] = 5.0;
+	estimator->HistogramMax[2] = 5.0;
+	estimator->Init = AttitudeInit;
+	estimator->Estimate = AttitudeEstimate;
+	estimator->Free = AttitudeFree;
+	estimator->context = NULL;
+}
@@ -0,0 +1,136 @@
+#ifndef _MONTECARLO_H_
+#define _MONTECARLO_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "PolarizationCamera.h"
+#include "CameraBatch.h"
+#include "CameraMosaic.h"
+
+#define MONTE_CARLO_MAX_ERRORS      8       //error values an estimator reports per sample
+#define MONTE_CARLO_BINS            1024    //bins of the histogram of an error
+#define MONTE_CARLO_BATCH           16      //consecutive samples per task, the unit of the ordered reduction
+#define MONTE_CARLO_ROUND_BATCHES   4096    //batches per parallel loop, bounds the memory of the partial sums
+
+#define MONTE_CARLO_NOISE_NONE      0       //noise-free frames
+#define MONTE_CARLO_NOISE_FRAME     1       //Gaussian noise added to DOP and AOP of every pixel
+#define MONTE_CARLO_NOISE_MOSAIC    2       //raw polarizer mosaic with sensor noise, demosaicked (PixelInterval 1)
+
+//random attitudes and noise of a Monte Carlo run
+typedef struct MonteCarloSettings
+{
+	int64_t   Samples;          //number of samples
+	uint64_t  Seed;             //key of the generator, the same seed gives the same samples on any number of threads
+
+	double    AfaMin;           //pitch angles are uniform in [AfaMin,AfaMax] (unit is radian)
+	double    AfaMax;
+	double    BetaMin;          //roll angles are uniform in [BetaMin,BetaMax] (unit is radian)
+	double    BetaMax;          //yaw angles are uniform in [0,2*pi)
+
+	int       Noise;            //MONTE_CARLO_NOISE_NONE, MONTE_CARLO_NOISE_FRAME or MONTE_CARLO_NOISE_MOSAIC
+	double    DOPNoise;         //standard deviation of the DOP noise of MONTE_CARLO_NOISE_FRAME
+	double    AOPNoise;         //standard deviation of the AOP noise of MONTE_CARLO_NOISE_FRAME (unit is degree)
+	MosaicParameters  Mosaic;   //sensor of MONTE_CARLO_NOISE_MOSAIC; Seed and FrameIndex are replaced per sample
+	int       DemosaicMethod;   //DEMOSAIC_BILINEAR or DEMOSAIC_GRADIENT (see CameraDemosaic.h)
+}
+MonteCarloSettings;
+
+//a simulated sample handed to an estimator
+typedef struct MonteCarloSample
+{
+	int64_t   Index;            //index of the sample, 0 to Samples-1
+	CameraAttitude  Truth;      //attitude the frame was simulated with
+	const CameraParameters *	parm;   //camera parameters of the frame
+	const CameraFrame *	frame;      //measured DOP and AOP, with the noise of the settings
+}
+MonteCarloSample;
+
+//pluggable estimator: per-thread state and the errors of a sample
+typedef struct MonteCarloEstimator
+{
+	int       ErrorCount;       //error values per sample (1 to MONTE_CARLO_MAX_ERRORS)
+	const char *	ErrorNames[MONTE_CARLO_MAX_ERRORS];     //names in the JSON output
+	double    HistogramMax[MONTE_CARLO_MAX_ERRORS];     //the histogram of error k covers [0,HistogramMax[k])
+
+	//state of one thread, NULL if it cannot be created; NULL Init gives a NULL state
+	void * (*Init)(void * context, const CameraParameters * parm);
+	//errors of a sample (NaN for a value that does not apply), 0 on success, nonzero counts a failure
+	int (*Estimate)(void * state, const MonteCarloSample * sample, double * errors);
+	//release the state of a thread, may be NULL
+	void (*Free)(void * state);
+	void *	context;            //passed to Init
+}
+MonteCarloEstimator;
+
+//streaming statistics of an error
+typedef struct MonteCarloStatistics
+{
+	int64_t   Count;            //finite values
+	double    Mean;
+	double    RMS;
+	double    StdDev;
+	double    Min;
+	double    Max;
+	double    Median;           //percentiles interpolated in the histogram
+	double    P90;
+	double    P95;
+	double    P99;
+
+	double    HistogramMax;     //bin k counts values in [k,k+1)*HistogramMax/MONTE_CARLO_BINS
+	int64_t   Histogram[MONTE_CARLO_BINS];
+	int64_t   Underflow;        //values below 0
+	int64_t   Overflow;         //values of HistogramMax and above
+}
+MonteCarloStatistics;
+
+//aggregated errors of a Monte Carlo run
+typedef struct MonteCarloResult
+{
+	int64_t   Samples;          //simulated samples
+	int64_t   Failures;         //samples the estimator failed on
+	int       ErrorCount;       //error values per sample
+	const char *	ErrorNames[MONTE_CARLO_MAX_ERRORS];
+	MonteCarloStatistics  Errors[MONTE_CARLO_MAX_ERRORS];
+}
+MonteCarloResult;
+
+//Default settings: 1000 samples, pitch in [-pi/2,pi/2], roll in [-pi,pi], 0.01 DOP and 1 degree AOP frame noise.
+void MonteCarloSettingsDefault(
+	MonteCarloSettings *	settings    //settings
+	);
+
+//Attitude of a sample of a Monte Carlo run.
+void MonteCarloSampleAttitude(
+	const MonteCarloSettings *	settings,   //settings
+	const int64_t  Index,                   //index of the sample
+	CameraAttitude *	attitude            //Euler angles of camera
+	);
+
+//Estimator of "AttitudeSolveFrame()": sun vector, pitch and roll errors (unit is degree).
+void MonteCarloEstimatorAttitude(
+	MonteCarloEstimator *	estimator   //estimator
+	);
+
+//Monte Carlo analysis: random attitudes and noise, simulation, estimation and streaming error statistics.
+int CameraSimulationMonteCarlo(
+	const MonteCarloSettings *	settings,   //random attitudes and noise
+	const CameraParameters *	parm,       //camera parameters, not changed
+	const MonteCarloEstimator *	estimator,  //estimator of the samples
+	ThreadPool *	pool,                   //thread pool, NULL runs on the calling thread
+	MonteCarloResult *	result              //error statistics
+	);
+
+//Percentile of an error from its histogram.
+double MonteCarloPercentile(
+	const MonteCarloStatistics *	stats,  //statistics of an error
+	const double  p                         //percentile, 0 to 100
+	);
+
+//Write the statistics of a Monte Carlo run as JSON.
+int MonteCarloWriteJson(
+	const MonteCarloResult *	result,     //error statistics
+	const int     Histograms,               //1 writes the histograms too
+	FILE *	file                            //opened file
+	);
+
+#endif
@@ -1,234 +1,1876 @@
-/*
-"CameraParametersInit()" and "CameraSimulation()" functions of Hypothetical Polarization Camera
-
-==========================================================================
-
-Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without 
-modification, are permitted provided that the following conditions are met:
-
-    * Redistributions of source code must retain the above copyright
-      notice, this list of conditions and the following disclaimer.
-    * Redistributions in binary form must reproduce the above copyright
-      notice, this list of conditions and the following disclaimer in the
-      documentation and/or other materials provided with the distribution.
-    * None of the names of the contributors may be used to endorse or promote 
-      products derived from this software without specific prior written 
-      permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
-ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
-WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
-DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
-DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
-(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
-LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
-ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-==========================================================================
-
-
-This file is part of an implementation of Hypothetical Polarization Camera
-which is the code of our manuscript
-
-
-     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
-                                    
-                                   by 
-
-                       Huaju Liang and Hongyang Bai
-              Nanjing University of Science and Technology in Nanjing, China
-
-
-                        Version: 1.1, October 23, 2019
-=========================================================================
-
-
-
-This code is written for simulating polarization camera based on Rayleigh sky model.
-And this code is written in Microsoft Visual Studio 2010 C++.
-
-Usage information:
-Using the code to simulate DOP (degree of polarization) and AOP (angle of polarization) based on Rayleigh sky model.
---------------------------
-
-Function 1: "CameraParametersInit()" 
-	
-	//Initialize the hypothetical polarization camera parameters.
-	CameraParameters * CameraParametersInit(
-		const double  D_x,
-		const double  D_z,
-		const int     n_x,
-		const int     n_z,
-		const double  f,
-		const int     PixelInterval
-    );
-	--------------input----------------
-	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
-	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
-	const int     n_x,           //Image pixel size (unit is pixel)
-	const int     n_z,           //Image pixel size (unit is pixel)
-	const double  f,             //Focus of the camera (unit is millimeter)
-	const int     PixelInterval  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
-	-----------------------------------
-	-------------output----------------
-	CameraParameters *           //Record camera parameters
-	-----------------------------------
-
-
-Function 2: "CameraSimulation()" 
-
-    //Hypothetical polarization camera simulation based on Rayleigh sky model.
-	void CameraSimulation(
-		const double  psa,
-		const double  afa,
-		const double  beta,
-		CameraParameters *	parm 
-	);
-	--------------input----------------
-	const double  psa,        //yaw angle (unit is radian)
-	const double  afa,        //pitch angle (unit is radian)
-    const double  beta,       //roll angle (unit is radian)
-	CameraParameters *	parm  //camera parameters
-	-----------------------------------
-	-------------output----------------
-	HypotheticalImages.txt          //Record DOP and AOP captured by polarization camera based on Rayleigh sky model.
-	-----------------------------------
-
---------------------------
-========================================================================== 
-*/
-
-
-#include<math.h>
-#include <iostream>
-#include <fstream>
-#include <iomanip>
-#include"PolarizationCamera.h"
-#include"MatrixFunction.h"
-
-#ifndef ALLOC
-#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
-#endif
-const double pi = 3.141592653589793;
-
-using namespace std;
-
-ofstream HypotheticalImages("output\\HypotheticalImages.txt");
-
-//Initialize the hypothetical polarization camera parameters.
-CameraParameters * CameraParametersInit(
-	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
-	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
-	const int     n_x,           //Image pixel size (unit is pixel)
-	const int     n_z,           //Image pixel size (unit is pixel)
-	const double  f,             //Focus of the camera (unit is millimeter)
-	const int     PixelInterval  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
-        ){
-			CameraParameters  * parm = ALLOC(CameraParameters);
-
-			parm->f = f;
-			parm->D_x = D_x/1000.0;
-			parm->D_z = D_z/1000.0;
-			parm->n_x = n_x;
-			parm->n_z = n_z;
-
-			parm->PixelInterval = PixelInterval;
-
-			return parm;
-}
-
-
-
-//Hypothetical polarization camera simulation based on Rayleigh sky model.
-void CameraSimulation(
-	const double  psa,        //yaw angle (unit is radian)
-	const double  afa,        //pitch angle (unit is radian)
-    const double  beta,       //roll angle (unit is radian)
-	CameraParameters *	parm  //camera parameters
-	){
-	//three Euler angles
-	parm->psa = psa;   //yaw angle (unit is radian)
-	parm->afa = afa;   //pitch angle (unit is radian)
-	parm->beta = beta; //roll angle (unit is radian)
-
-	//rotation matrix
-	double C_vTb[3][3] = {cos(parm->beta)*cos(parm->psa)+sin(parm->beta)*sin(parm->afa)*sin(parm->psa),     -cos(parm->beta)*sin(parm->psa)+sin(parm->beta)*sin(parm->afa)*cos(parm->psa),     -sin(parm->beta)*cos(parm->afa),
-						  cos(parm->afa)*sin(parm->psa),														cos(parm->afa)*cos(parm->psa),                                                       sin(parm->afa),
-						  sin(parm->beta)*cos(parm->psa)-cos(parm->beta)*sin(parm->afa)*sin(parm->psa),     -sin(parm->beta)*sin(parm->psa)-cos(parm->beta)*sin(parm->afa)*cos(parm->psa),     cos(parm->beta)*cos(parm->afa),
-			};	//rotation matrix from solar vector to body coordinate system
-	double C_bTv[3][3];//rotation matrix from body to solar vector coordinate system
-	MatrixTrans(3, 3,C_vTb[0], C_bTv[0]);
-
-	//Calculate DOP and AOP of each pixels.
-	for(int i_x=1; i_x<=parm->n_x; i_x=i_x+parm->PixelInterval){
-		for(int j_z=1; j_z<=parm->n_z; j_z=j_z+parm->PixelInterval){
-
-			//location of a pixel P in pixel coordinate system
-			double P_x = parm->D_x*(i_x-(parm->n_x+1)/2);
-			double P_z = parm->D_z*(j_z-(parm->n_z+1)/2);
-		    double Vector_b_P[3][1] = {P_x,0.0,P_z};	//location
-
-			//shooting direction of pixel P in solar vector coordinate system
-			double Vector_b_f[3][1] = {0.0,parm->f,0.0};
-			double Vector_b_PaF[3][1] = {0.0,0,0.0};
-			double Vector_v_P[3][1] = {0.0,0,0.0};		//shooting direction
-			MatrixAdd(3,1,Vector_b_P[0],Vector_b_f[0],Vector_b_PaF[0]);
-			MatrixMultiply(3,3,1,C_bTv[0],Vector_b_PaF[0],Vector_v_P[0]);
-
-			//zenith angle and yaw angle of pixel P in solar vector coordinate system
-			double Vector_v_P_Norm = 0.0;
-			MatrixNorm(3,1,Vector_v_P[0],Vector_v_P_Norm);
-			double sita_v_P = acos(Vector_v_P[2][0]/Vector_v_P_Norm);	//zenith angle
-			double fi_v_P = 0.0;	//yaw angle
-			if(Vector_v_P[0][0]>0 && Vector_v_P[1][0]>=0){	//quadrants judgement.
-				fi_v_P = atan(Vector_v_P[1][0]/Vector_v_P[0][0]);
-			}
-			else if(Vector_v_P[0][0]<0 && Vector_v_P[1][0]>=0){
-				fi_v_P = atan(Vector_v_P[1][0]/Vector_v_P[0][0])+pi;
-			}
-			else if(Vector_v_P[0][0]>0 && Vector_v_P[1][0]<=0){
-				fi_v_P = atan(Vector_v_P[1][0]/Vector_v_P[0][0])+2*pi;
-			}
-			else if(Vector_v_P[0][0]<0 && Vector_v_P[1][0]<=0){
-				fi_v_P = atan(Vector_v_P[1][0]/Vector_v_P[0][0])+pi;
-			}
-			else if(Vector_v_P[0][0]==0 && Vector_v_P[1][0]>0){
-				fi_v_P = pi;
-			}
-			else if(Vector_v_P[0][0]==0 && Vector_v_P[1][0]<0){
-				fi_v_P = -pi;
-			}
-			else if(Vector_v_P[0][0]==0 && Vector_v_P[1][0]==0){
-				fi_v_P = 0.0;
-			}
-
-			//DOP of pixel P based on Rayleigh sky model
-			double DOP_max = 1;	//maximum DOP in the sky
-			double DOP = DOP_max*sin(sita_v_P)*sin(sita_v_P)/(1+cos(sita_v_P)*cos(sita_v_P));	//DOP
-
-			//AOP of pixel P based on Rayleigh sky model
-			double E_v_P[3][1] = {sin(fi_v_P),-cos(fi_v_P),0.0};	//polarization E-vector in solar vector coordinate system
-			double E_b_P[3][1] = {0.0,0.0,0.0};						//polarization E-vector in body coordinate system
-			MatrixMultiply(3,3,1,C_vTb[0],E_v_P[0],E_b_P[0]);
-			double AOP = atan(E_b_P[0][0]/E_b_P[2][0]);				//AOP
-			if(DOP==0.0){	//	Elimination of invalid solution
-				AOP = 0.0;	
-			}
-
-			//Record DOP and AOP to HypotheticalImages.txt in output folder.
-			HypotheticalImages<<setprecision(16)
-			<<i_x<<setw(25)<<j_z<<setw(25)
-			<<DOP<<setw(25)<<AOP*180/pi<<endl;
-			//HypotheticalImages.txt
-			//The first column is i_x (column coordinate in pixel coordinate system)
-			//The second column is j_z (raw coordinate in pixel coordinate system)
-			//The third column is DOP (degree of polarization)
-			//The forth column is AOP (angle of polarization and the unit of AOP is degree )
-
-		}
-	}
+/*
+"CameraParametersInit()" and "CameraSimulation()" functions of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for simulating polarization camera based on Rayleigh sky model.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Using the code to simulate DOP (degree of polarization) and AOP (angle of polarization) based on Rayleigh sky model.
+--------------------------
+
+Function 1: "CameraParametersInit()" 
+	
+	//Initialize the hypothetical polarization camera parameters.
+	CameraParameters * CameraParametersInit(
+		const double  D_x,
+		const double  D_z,
+		const int     n_x,
+		const int     n_z,
+		const double  f,
+		const int     PixelInterval
+    );
+	--------------input----------------
+	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const int     n_x,           //Image pixel size (unit is pixel)
+	const int     n_z,           //Image pixel size (unit is pixel)
+	const double  f,             //Focus of the camera (unit is millimeter)
+	const int     PixelInterval  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
+	-----------------------------------
+	-------------output----------------
+	CameraParameters *           //Record camera parameters
+	-----------------------------------
+	The ray table of "CameraRayTableInit()" is built as well; "CameraParametersInitNoTable()" leaves it out.
+
+
+Function 2: "CameraSimulation()" 
+
+    //Hypothetical polarization camera simulation based on Rayleigh sky model.
+	void CameraSimulation(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		CameraParameters *	parm 
+	);
+	--------------input----------------
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm  //camera parameters
+	-----------------------------------
+	-------------output----------------
+	HypotheticalImages.txt          //Record DOP and AOP captured by polarization camera based on Rayleigh sky model.
+	-----------------------------------
+
+Function 3: "CameraFrameInit()" 
+
+    //Allocate a DOP and AOP frame for the hypothetical polarization camera.
+	CameraFrame * CameraFrameInit(
+		const CameraParameters *	parm
+	);
+	--------------input----------------
+	const CameraParameters *	parm  //camera parameters
+	-----------------------------------
+	-------------output----------------
+	CameraFrame *                     //Frame with contiguous DOP and AOP planes of n_x*n_z pixels (free with "CameraFrameFree()")
+	-----------------------------------
+
+
+Function 4: "CameraFrameWrap()" 
+
+    //Wrap caller-owned DOP and AOP planes into a frame.
+	void CameraFrameWrap(
+		const CameraParameters *	parm,
+		double *	DOP,
+		double *	AOP,
+		CameraFrame *	frame
+	);
+	--------------input----------------
+	const CameraParameters *	parm  //camera parameters
+	double *	DOP,                  //caller-owned DOP plane, at least n_x*n_z values (see "CameraFrameSize()")
+	double *	AOP,                  //caller-owned AOP plane, at least n_x*n_z values (see "CameraFrameSize()")
+	-----------------------------------
+	-------------output----------------
+	CameraFrame *	frame             //Frame referring to DOP and AOP ("CameraFrameFree()" does not release them)
+	-----------------------------------
+
+
+Function 5: "CameraSimulationFrame()" 
+
+    //Hypothetical polarization camera simulation based on Rayleigh sky model without file I/O.
+	void CameraSimulationFrame(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		CameraParameters *	parm,
+		CameraFrame *	frame
+	);
+	--------------input----------------
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm  //camera parameters
+	-----------------------------------
+	-------------output----------------
+	CameraFrame *	frame     //DOP and AOP (unit is degree) of every simulated pixel.
+	                          //Pixel (i_x, j_z) is stored at index ((i_x-1)/PixelInterval)*frame->n_z+(j_z-1)/PixelInterval,
+	                          //which is the order of the lines in HypotheticalImages.txt.
+	-----------------------------------
+
+
+Function 6: "CameraFrameWriteText()" 
+
+    //Write a frame in the four-column format of HypotheticalImages.txt.
+	int CameraFrameWriteText(
+		const CameraFrame *	frame,
+		FILE *	file
+	);
+	--------------input----------------
+	const CameraFrame *	frame     //DOP and AOP frame
+	FILE *	file                  //opened text file
+	-----------------------------------
+	-------------output----------------
+	int                           //0 on success, -1 if writing failed
+	-----------------------------------
+
+
+Function 7: "CameraFrameSize()" 
+
+    //Size of the frame simulated with the camera parameters.
+	void CameraFrameSize(
+		const CameraParameters *	parm,
+		int &	n_x,
+		int &	n_z
+	);
+	--------------input----------------
+	const CameraParameters *	parm  //camera parameters
+	-----------------------------------
+	-------------output----------------
+	int &	n_x,                  //(parm->n_x-1)/parm->PixelInterval+1 (unit is pixel)
+	int &	n_z,                  //(parm->n_z-1)/parm->PixelInterval+1 (unit is pixel)
+	-----------------------------------
+
+
+Function 8: "CameraFrameFree()" 
+
+    //Release a frame returned by "CameraFrameInit()".
+	void CameraFrameFree(
+		CameraFrame *	frame
+	);
+
+
+Function 9: "CameraSimulationFrameParallel()" 
+
+    //Hypothetical polarization camera simulation split into row bands over a thread pool.
+	void CameraSimulationFrameParallel(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		CameraParameters *	parm,
+		CameraFrame *	frame,
+		ThreadPool *	pool
+	);
+	--------------input----------------
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm  //camera parameters
+	ThreadPool *	pool      //thread pool (see "ThreadPool.h"), NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	CameraFrame *	frame     //DOP and AOP of every simulated pixel, identical to "CameraSimulationFrame()"
+	-----------------------------------
+
+
+Function 10: "CameraFrameWriteTextParallel()" 
+
+    //Write a frame in the four-column format of HypotheticalImages.txt, formatting row bands over a thread pool.
+	int CameraFrameWriteTextParallel(
+		const CameraFrame *	frame,
+		FILE *	file,
+		ThreadPool *	pool
+	);
+	--------------input----------------
+	const CameraFrame *	frame     //DOP and AOP frame
+	FILE *	file                  //opened text file
+	ThreadPool *	pool          //thread pool, NULL formats on the calling thread
+	-----------------------------------
+	-------------output----------------
+	int                           //0 on success, -1 if writing failed; the text is identical to "CameraFrameWriteText()"
+	-----------------------------------
+
+
+Function 11: "CameraRayTableInit()" 
+
+    //Precompute the unit shooting direction of every simulated pixel (called by "CameraParametersInit()").
+	int CameraRayTableInit(
+		CameraParameters *	parm
+	);
+	--------------input----------------
+	CameraParameters *	parm  //camera parameters
+	-----------------------------------
+	-------------output----------------
+	int                       //0 on success or for the parameters of "CameraParametersInitNoTable()", -1 if the table
+	                          //could not be allocated or the frame is larger than CAMERA_RAY_TABLE_MAX_PIXELS (the
+	                          //row kernels are used instead)
+	-----------------------------------
+	The table only depends on D_x, D_z, n_x, n_z, f, PixelInterval and Lens. Call it again after changing any of
+	them ("CameraParametersSetLens()" does it for Lens); a table whose size or lens does not match any more is ignored.
+
+
+Function 12: "CameraParametersFree()" 
+
+    //Release camera parameters returned by "CameraParametersInit()" and their ray table.
+	void CameraParametersFree(
+		CameraParameters *	parm
+	);
+
+
+Function 13: "CameraRotationMatrix()" 
+
+    //Rotation matrices of three Euler angles.
+	void CameraRotationMatrix(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		double  (&C_vTb)[3][3],
+		double  (&C_bTv)[3][3]
+	);
+	--------------input----------------
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	-----------------------------------
+	-------------output----------------
+	double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	double  (&C_bTv)[3][3]    //rotation matrix from body to solar vector coordinate system
+	-----------------------------------
+
+
+Function 14: "CameraSimulationFrameRotation()" 
+
+    //Hypothetical polarization camera simulation of given rotation matrices, without changing the camera parameters.
+	void CameraSimulationFrameRotation(
+		const double  (&C_vTb)[3][3],
+		const double  (&C_bTv)[3][3],
+		const CameraParameters *	parm,
+		CameraFrame *	frame,
+		ThreadPool *	pool
+	);
+	--------------input----------------
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters, only read, so several frames may share them
+	ThreadPool *	pool               //thread pool, NULL runs on the calling thread
+	-----------------------------------
+	-------------output----------------
+	CameraFrame *	frame              //DOP and AOP of every simulated pixel
+	-----------------------------------
+
+Function 15: "CameraRayTableValid()" 
+
+    //Whether the ray table matches the frame layout of the camera parameters.
+	int CameraRayTableValid(
+		const CameraParameters *	parm
+	);
+	--------------input----------------
+	const CameraParameters *	parm  //camera parameters
+	-----------------------------------
+	-------------output----------------
+	int                       //1 if parm->Ray_x, parm->Ray_y and parm->Ray_z can be indexed like a CameraFrame
+	                          //and were built with parm->Lens, 0 if not
+	-----------------------------------
+
+Function 16: "CameraFrameFloatInit()" 
+
+    //Allocate a single precision DOP and AOP frame for the hypothetical polarization camera.
+	CameraFrameFloat * CameraFrameFloatInit(
+		const CameraParameters *	parm
+	);
+	--------------input----------------
+	const CameraParameters *	parm  //camera parameters
+	-----------------------------------
+	-------------output----------------
+	CameraFrameFloat *                //Frame with float DOP and AOP planes of n_x*n_z pixels (free with "CameraFrameFree()")
+	-----------------------------------
+	"CameraFrameWrap()", "CameraFrameFree()", "CameraSimulationFrame()", "CameraSimulationFrameParallel()",
+	"CameraSimulationFrameRotation()", "CameraFrameWriteText()" and "CameraFrameWriteTextParallel()" have
+	CameraFrameFloat overloads with the same parameters. Single precision frames use the float row kernels of
+	"RayleighKernelFloatFunction()" and, with the pinhole lens, never the ray table (see "CameraParametersSetLens()").
+	RAYLEIGH_KERNEL_SCALAR and RAYLEIGH_KERNEL_CLOSED_FORM compute in double and round every pixel, so only the
+	vectorized kernels are faster than in double precision.
+	The text of a single precision frame has 9 significant digits instead of 16.
+
+Function 17: "CameraSimulationRegions()" 
+
+    //Hypothetical polarization camera simulation of regions of interest only.
+	int CameraSimulationRegions(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		CameraParameters *	parm,
+		const CameraRegion *	region,
+		const int     count,
+		double *	DOP,
+		double *	AOP
+	);
+	--------------input----------------
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraRegion *	region,//regions of interest, each inside 1..n_x and 1..n_z
+	const int     count       //number of regions
+	-----------------------------------
+	-------------output----------------
+	double *	DOP,          //DOP of every pixel of the regions, region after region and row after row:
+	                          //pixel (region.i_x+i, region.j_z+j) follows the pixels of the previous regions at i*region.n_z+j
+	double *	AOP           //AOP (unit is degree) in the same layout, both "CameraRegionPixels()" values long
+	int                       //0, or -1 if a region is outside the image (nothing is written)
+	-----------------------------------
+	Only the requested pixels are simulated, PixelInterval is not used. The rows of the regions go through the
+	row kernels of parm->Kernel. "CameraRegionPixels()" returns the number of pixels of a list of regions.
+
+
+Function 18: "CameraSimulationPixels()" 
+
+    //Hypothetical polarization camera simulation of a list of pixels only.
+	int CameraSimulationPixels(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		CameraParameters *	parm,
+		const CameraPixel *	pixel,
+		const int     count,
+		double *	DOP,
+		double *	AOP
+	);
+	--------------input----------------
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraPixel *	pixel,//pixels in any order, each inside 1..n_x and 1..n_z
+	const int     count       //number of pixels
+	-----------------------------------
+	-------------output----------------
+	double *	DOP,          //DOP of pixel k at DOP[k]
+	double *	AOP           //AOP of pixel k at AOP[k] (unit is degree)
+	int                       //0, or -1 if a pixel is outside the image (nothing is written)
+	-----------------------------------
+	The shooting directions of the pixels are built in blocks of PIXEL_BLOCK_SIZE and rotated with the ray kernel of
+	parm->Kernel, so the time is proportional to count. Both functions have float overloads, which compute in
+	double precision and round the results.
+
+
+Function 19: "CameraParametersSetLens()" 
+
+    //Set the lens of the camera and rebuild the ray table with it.
+	int CameraParametersSetLens(
+		CameraParameters *	parm,
+		const CameraLens *	lens
+	);
+	--------------input----------------
+	CameraParameters *	parm, //camera parameters
+	const CameraLens *	lens  //lens (see CameraLens.h)
+	-----------------------------------
+	-------------output----------------
+	int                       //0, or -1 if the ray table could not be allocated (the shooting directions are then
+	                          //computed through the lens every frame)
+	-----------------------------------
+	The row kernels of RayleighKernel.h generate pinhole shooting directions. With any other lens every frame
+	rotates the ray table instead, with the same ray kernels as the pinhole frames in double precision and with a
+	float copy of the table and "RayleighKernelRaysFloatFunction()" in single precision, so a frame costs the same
+	through every lens. RAYLEIGH_KERNEL_CLOSED_FORM rounds double results for single precision frames. Regions,
+	pixel lists and RAYLEIGH_KERNEL_SCALAR take the shooting directions from the table too. Pixels outside the
+	image circle or the field of view of the lens get NaN DOP and AOP.
+
+
+Function 20: "CameraPixelRay()" 
+
+    //Unit shooting direction of a pixel in body coordinate system through the lens of the camera parameters.
+	int CameraPixelRay(
+		const CameraParameters *	parm,
+		const int     i_x,
+		const int     j_z,
+		double  (&Ray)[3]
+	);
+	--------------input----------------
+	const CameraParameters *	parm,  //camera parameters
+	const int     i_x,                 //column coordinate in pixel coordinate system
+	const int     j_z                  //raw coordinate in pixel coordinate system
+	-----------------------------------
+	-------------output----------------
+	double  (&Ray)[3]                  //unit shooting direction, NaN if the pixel sees no sky
+	int                                //0, or -1 if the pixel sees no sky
+	-----------------------------------
+	The direction comes from the ray table when it is valid and holds the pixel, from "CameraLensRay()" otherwise.
+
+
+Function 21: "CameraSimulationBlock()" 
+
+    //Hypothetical polarization camera simulation of a block of the frame, without changing the camera parameters.
+	int CameraSimulationBlock(
+		const double  (&C_vTb)[3][3],
+		const double  (&C_bTv)[3][3],
+		const CameraParameters *	parm,
+		const CameraBlock *	block,
+		double *	DOP,
+		double *	AOP,
+		const size_t  pitch
+	);
+	--------------input----------------
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters, only read
+	const CameraBlock *	block,         //rows block->i.. and columns block->j.. of the frame layout
+	const size_t  pitch                //values from one row of DOP and AOP to the next, at least block->n_z
+	-----------------------------------
+	-------------output----------------
+	double *	DOP,                   //DOP of frame pixel (block->i+i, block->j+j) at DOP[i*pitch+j]
+	double *	AOP                    //AOP in the same layout (unit is degree)
+	int                                //0, or -1 if the block is outside the frame (nothing is written)
+	-----------------------------------
+	The block goes through the same row kernels, ray table or lens path as "CameraSimulationFrameRotation()", so
+	its pixels are identical to the pixels of a whole frame; a frame is a list of blocks that may be simulated in
+	any order on any thread. With a float overload. Without a ray table (see "CameraParametersInitNoTable()") the
+	lenses other than the pinhole take the shooting directions of every block from "CameraLensRay()".
+
+
+Function 22: "CameraParametersInitNoTable()" 
+
+    //Initialize the camera parameters without the ray table, for callers that never hold a frame.
+	CameraParameters * CameraParametersInitNoTable(
+		const double  D_x,
+		const double  D_z,
+		const int     n_x,
+		const int     n_z,
+		const double  f,
+		const int     PixelInterval
+	);
+	--------------input----------------
+	the same as "CameraParametersInit()"
+	-----------------------------------
+	-------------output----------------
+	CameraParameters *           //camera parameters whose "CameraRayTableInit()" and "CameraParametersSetLens()"
+	                             //never build a ray table (free with "CameraParametersFree()")
+	-----------------------------------
+	The ray table takes 24 bytes per simulated pixel, and 12 more for the float copy of a lens, which is more than a
+	float frame. "CameraSimulationTiled()" (CameraTiles.h) and the fused statistics of "CameraSimulationReduce()"
+	(CameraReduce.h) never hold the frame, so with these parameters their memory does not grow with the sensor. The
+	frames are the frames of parameters whose table is not valid: the row kernels for the pinhole, "CameraLensRay()"
+	for every block through other lenses.
+
+
+Sky model:
+	parm->Sky is the Rayleigh sky with DOP_max=1 after "CameraParametersInit()". "SkyModelRayleigh()",
+	"SkyModelBerry()" and "SkyModelTabulated()" of SkyModel.h replace it for every function above: the scalar code
+	evaluates "SkyModelPixel()" after the ROTATION stage, and the kernels of RayleighKernel.h pick their instance of
+	the model once per row or block of rays.
+
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include<math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <limits>
+#include"PolarizationCamera.h"
+#include"MatrixFunction.h"
+#include"MatrixTemplate.h"
+#include"ThreadPool.h"
+#include"RayleighKernel.h"
+#include"AlignedMemory.h"
+#include"CameraStats.h"
+
+#ifndef ALLOC
+#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
+#endif
+const double pi = 3.141592653589793;
+
+using namespace std;
+
+//Pixels of a pixel list rotated per call of a ray kernel
+#define PIXEL_BLOCK_SIZE            256
+//Size of the write buffer of the text sink (unit is byte)
+#define TEXT_BUFFER_SIZE            (1<<20)
+//Upper bound of the length of a line of HypotheticalImages.txt (unit is byte)
+#define TEXT_LINE_SIZE              128
+
+
+
+//Number of frame rows per band, so that every thread of the pool gets several bands.
+static int BandRows(
+	const int     n_rows,       //number of frame rows
+	ThreadPool *	pool        //thread pool
+	){
+	int rows = n_rows/(8*pool->Size());
+	return rows>0 ? rows : 1;
+}
+
+//Camera parameters with or without the ray table.
+static CameraParameters * ParametersInit(
+	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const int     n_x,           //Image pixel size (unit is pixel)
+	const int     n_z,           //Image pixel size (unit is pixel)
+	const double  f,             //Focus of the camera (unit is millimeter)
+	const int     PixelInterval, //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
+	const int     RayTableEnabled  //1 to build the ray table, 0 never
+        ){
+			CameraParameters  * parm = ALLOC(CameraParameters);
+
+			parm->f = f;
+			parm->D_x = D_x/1000.0;
+			parm->D_z = D_z/1000.0;
+			parm->n_x = n_x;
+			parm->n_z = n_z;
+
+			parm->PixelInterval = PixelInterval;
+
+			parm->psa = 0.0;
+			parm->afa = 0.0;
+			parm->beta = 0.0;
+
+			parm->Kernel = RAYLEIGH_KERNEL_AUTO;
+			CameraLensDefault(&parm->Lens);
+			SkyModelDefault(&parm->Sky);
+
+			parm->Ray_x = NULL;
+			parm->Ray_y = NULL;
+			parm->Ray_z = NULL;
+			parm->RayFloat_x = NULL;
+			parm->RayFloat_y = NULL;
+			parm->RayFloat_z = NULL;
+			parm->RayTableEnabled = RayTableEnabled;
+			CameraRayTableInit(parm);
+
+			return parm;
+}
+
+
+
+//Initialize the hypothetical polarization camera parameters.
+CameraParameters * CameraParametersInit(
+	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const int     n_x,           //Image pixel size (unit is pixel)
+	const int     n_z,           //Image pixel size (unit is pixel)
+	const double  f,             //Focus of the camera (unit is millimeter)
+	const int     PixelInterval  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
+        ){
+	return ParametersInit(D_x,D_z,n_x,n_z,f,PixelInterval,1);
+}
+
+
+
+//Initialize the camera parameters without the ray table, for callers that never hold a frame.
+CameraParameters * CameraParametersInitNoTable(
+	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const int     n_x,           //Image pixel size (unit is pixel)
+	const int     n_z,           //Image pixel size (unit is pixel)
+	const double  f,             //Focus of the camera (unit is millimeter)
+	const int     PixelInterval  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
+        ){
+	return ParametersInit(D_x,D_z,n_x,n_z,f,PixelInterval,0);
+}
+
+
+
+//Precompute the unit shooting direction of every simulated pixel.
+int CameraRayTableInit(
+	CameraParameters *	parm  //camera parameters
+	){
+	AlignedFree(parm->Ray_x);
+	AlignedFree(parm->Ray_y);
+	AlignedFree(parm->Ray_z);
+	AlignedFree(parm->RayFloat_x);
+	AlignedFree(parm->RayFloat_y);
+	AlignedFree(parm->RayFloat_z);
+	parm->RayFloat_x = NULL;
+	parm->RayFloat_y = NULL;
+	parm->RayFloat_z = NULL;
+	if(!parm->RayTableEnabled){
+		parm->Ray_x = NULL;
+		parm->Ray_y = NULL;
+		parm->Ray_z = NULL;
+		return 0;
+	}
+
+	CameraFrameSize(parm,parm->Ray_n_x,parm->Ray_n_z);
+	parm->RayPixelInterval = parm->PixelInterval;
+	parm->RayImage_n_x = parm->n_x;
+	parm->RayImage_n_z = parm->n_z;
+	parm->RayD_x = parm->D_x;
+	parm->RayD_z = parm->D_z;
+	parm->RayF = parm->f;
+	parm->RayLens = parm->Lens;
+	size_t PixelNum = (size_t)parm->Ray_n_x*parm->Ray_n_z;
+	if(PixelNum>CAMERA_RAY_TABLE_MAX_PIXELS){
+		parm->Ray_x = NULL;
+		parm->Ray_y = NULL;
+		parm->Ray_z = NULL;
+		return -1;
+	}
+	parm->Ray_x = (double *)AlignedAlloc(PixelNum*sizeof(double));
+	parm->Ray_y = (double *)AlignedAlloc(PixelNum*sizeof(double));
+	parm->Ray_z = (double *)AlignedAlloc(PixelNum*sizeof(double));
+	if(parm->Ray_x==NULL || parm->Ray_y==NULL || parm->Ray_z==NULL){
+		AlignedFree(parm->Ray_x);
+		AlignedFree(parm->Ray_y);
+		AlignedFree(parm->Ray_z);
+		parm->Ray_x = NULL;
+		parm->Ray_y = NULL;
+		parm->Ray_z = NULL;
+		return -1;
+	}
+
+	size_t n = 0;
+	for(int i_x=1; i_x<=parm->n_x; i_x=i_x+parm->PixelInterval){
+		for(int j_z=1; j_z<=parm->n_z; j_z=j_z+parm->PixelInterval){
+			//shooting direction of pixel P in body coordinate system
+			double P_x = parm->D_x*(i_x-(parm->n_x+1)/2);
+			double P_z = parm->D_z*(j_z-(parm->n_z+1)/2);
+			double Ray[3];
+			CameraLensRay(&parm->Lens,parm->f,P_x,P_z,Ray);
+
+			parm->Ray_x[n] = Ray[0];
+			parm->Ray_y[n] = Ray[1];
+			parm->Ray_z[n] = Ray[2];
+			n++;
+		}
+	}
+
+	//the float row kernels only know the pinhole, so other lenses get a single precision table
+	if(!CameraLensPinhole(&parm->Lens)){
+		parm->RayFloat_x = (float *)AlignedAlloc(PixelNum*sizeof(float));
+		parm->RayFloat_y = (float *)AlignedAlloc(PixelNum*sizeof(float));
+		parm->RayFloat_z = (float *)AlignedAlloc(PixelNum*sizeof(float));
+		if(parm->RayFloat_x==NULL || parm->RayFloat_y==NULL || parm->RayFloat_z==NULL){
+			AlignedFree(parm->RayFloat_x);
+			AlignedFree(parm->RayFloat_y);
+			AlignedFree(parm->RayFloat_z);
+			parm->RayFloat_x = NULL;
+			parm->RayFloat_y = NULL;
+			parm->RayFloat_z = NULL;
+			return 0;
+		}
+		for(size_t k=0; k<PixelNum; k++){
+			parm->RayFloat_x[k] = (float)parm->Ray_x[k];
+			parm->RayFloat_y[k] = (float)parm->Ray_y[k];
+			parm->RayFloat_z[k] = (float)parm->Ray_z[k];
+		}
+	}
+	return 0;
+}
+
+
+
+//Release camera parameters returned by "CameraParametersInit()".
+void CameraParametersFree(
+	CameraParameters *	parm  //camera parameters
+	){
+	if(parm==NULL){
+		return;
+	}
+	AlignedFree(parm->Ray_x);
+	AlignedFree(parm->Ray_y);
+	AlignedFree(parm->Ray_z);
+	AlignedFree(parm->RayFloat_x);
+	AlignedFree(parm->RayFloat_y);
+	AlignedFree(parm->RayFloat_z);
+	free(parm);
+}
+
+
+
+//Whether the ray table matches the frame layout of the camera parameters.
+int CameraRayTableValid(
+	const CameraParameters *	parm  //camera parameters
+	){
+	int n_x, n_z;
+	CameraFrameSize(parm,n_x,n_z);
+	return parm->Ray_x!=NULL && parm->Ray_n_x==n_x && parm->Ray_n_z==n_z && parm->RayPixelInterval==parm->PixelInterval
+		&& parm->RayImage_n_x==parm->n_x && parm->RayImage_n_z==parm->n_z
+		&& parm->RayD_x==parm->D_x && parm->RayD_z==parm->D_z && parm->RayF==parm->f
+		&& CameraLensEqual(&parm->RayLens,&parm->Lens);
+}
+
+
+
+//Set the lens of the camera and rebuild the ray table with it.
+int CameraParametersSetLens(
+	CameraParameters *	parm,  //camera parameters
+	const CameraLens *	lens   //lens
+	){
+	parm->Lens = *lens;
+	return CameraRayTableInit(parm);
+}
+
+
+
+//Unit shooting direction of a pixel in body coordinate system through the lens of the camera parameters.
+int CameraPixelRay(
+	const CameraParameters *	parm,  //camera parameters
+	const int     i_x,                 //column coordinate in pixel coordinate system
+	const int     j_z,                 //raw coordinate in pixel coordinate system
+	double  (&Ray)[3]                  //unit shooting direction, NaN if the pixel sees no sky
+	){
+	if((i_x-1)%parm->PixelInterval==0 && (j_z-1)%parm->PixelInterval==0 && CameraRayTableValid(parm)){
+		size_t n = (size_t)((i_x-1)/parm->PixelInterval)*parm->Ray_n_z+(j_z-1)/parm->PixelInterval;
+		Ray[0] = parm->Ray_x[n];
+		Ray[1] = parm->Ray_y[n];
+		Ray[2] = parm->Ray_z[n];
+		return Ray[0]==Ray[0] ? 0 : -1;
+	}
+	double P_x = parm->D_x*(i_x-(parm->n_x+1)/2);
+	double P_z = parm->D_z*(j_z-(parm->n_z+1)/2);
+	return CameraLensRay(&parm->Lens,parm->f,P_x,P_z,Ray);
+}
+
+
+
+//DOP and AOP of pixel (i_x, j_z) based on Rayleigh sky model.
+static void PixelSimulation(
+	const CameraParameters *	parm,  //camera parameters
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const int     i_x,                 //column coordinate in pixel coordinate system
+	const int     j_z,                 //raw coordinate in pixel coordinate system
+	double &	DOP_out,               //DOP (degree of polarization)
+	double &	AOP_out                //AOP (unit is degree)
+	){
+			STATS_CLOCK(tick);
+
+			//location of a pixel P in pixel coordinate system
+			double P_x = parm->D_x*(i_x-(parm->n_x+1)/2);
+			double P_z = parm->D_z*(j_z-(parm->n_z+1)/2);
+		    double Vector_b_P[3][1] = {P_x,0.0,P_z};	//location
+
+			//shooting direction of pixel P in solar vector coordinate system
+			double Vector_b_f[3][1] = {0.0,parm->f,0.0};
+			double Vector_b_PaF[3][1] = {0.0,0,0.0};
+			double Vector_v_P[3][1] = {0.0,0,0.0};		//shooting direction
+			if(CameraLensPinhole(&parm->Lens)){
+				MatrixAdd(Vector_b_P,Vector_b_f,Vector_b_PaF);
+			}
+			else{	//shooting direction through the lens, no sky outside its image circle
+				double Ray[3];
+				if(CameraPixelRay(parm,i_x,j_z,Ray)!=0){
+					DOP_out = std::numeric_limits<double>::quiet_NaN();
+					AOP_out = std::numeric_limits<double>::quiet_NaN();
+					return;
+				}
+				Vector_b_PaF[0][0] = Ray[0];
+				Vector_b_PaF[1][0] = Ray[1];
+				Vector_b_PaF[2][0] = Ray[2];
+			}
+			STATS_STAGE(CAMERA_STAGE_RAY,tick,1);
+			MatrixMultiply(C_bTv,Vector_b_PaF,Vector_v_P);
+			STATS_STAGE(CAMERA_STAGE_ROTATION,tick,1);
+
+			if(parm->Sky.Model!=SKY_MODEL_RAYLEIGH){
+				//DOP and E-vector of the other sky models
+				double DOP = 0.0;
+				double E_v_P[3][1];
+				double E_b_P[3][1] = {0.0,0.0,0.0};
+				SkyModelPixel(&parm->Sky,Vector_v_P,DOP,E_v_P);
+				STATS_STAGE(CAMERA_STAGE_DOP,tick,1);
+				MatrixMultiply(C_vTb,E_v_P,E_b_P);
+				double AOP = atan(E_b_P[0][0]/E_b_P[2][0]);
+				if(DOP==0.0 || (E_b_P[0][0]==0.0 && E_b_P[2][0]==0.0)){	//	Elimination of invalid solution
+					AOP = 0.0;
+					STATS_COUNT(ZeroDOP,1);
+				}
+				STATS_STAGE(CAMERA_STAGE_AOP,tick,1);
+
+				DOP_out = DOP;
+				AOP_out = AOP*180/pi;
+				return;
+			}
+
+			//zenith angle and yaw angle of pixel P in solar vector coordinate system
+			double Vector_v_P_Norm = 0.0;
+			MatrixNorm(Vector_v_P,Vector_v_P_Norm);
+			double sita_v_P = acos(Vector_v_P[2][0]/Vector_v_P_Norm);	//zenith angle
+			STATS_STAGE(CAMERA_STAGE_ZENITH,tick,1);
+			double fi_v_P = 0.0;	//yaw angle
+			if(Vector_v_P[0][0]>0 && Vector_v_P[1][0]>=0){	//quadrants judgement.
+				fi_v_P = atan(Vector_v_P[1][0]/Vector_v_P[0][0]);
+				STATS_COUNT(QuadrantHits[0],1);
+			}
+			else if(Vector_v_P[0][0]<0 && Vector_v_P[1][0]>=0){
+				fi_v_P = atan(Vector_v_P[1][0]/Vector_v_P[0][0])+pi;
+				STATS_COUNT(QuadrantHits[1],1);
+			}
+			else if(Vector_v_P[0][0]>0 && Vector_v_P[1][0]<=0){
+				fi_v_P = atan(Vector_v_P[1][0]/Vector_v_P[0][0])+2*pi;
+				STATS_COUNT(QuadrantHits[2],1);
+			}
+			else if(Vector_v_P[0][0]<0 && Vector_v_P[1][0]<=0){
+				fi_v_P = atan(Vector_v_P[1][0]/Vector_v_P[0][0])+pi;
+				STATS_COUNT(QuadrantHits[3],1);
+			}
+			else if(Vector_v_P[0][0]==0 && Vector_v_P[1][0]>0){
+				fi_v_P = pi;
+				STATS_COUNT(QuadrantHits[4],1);
+			}
+			else if(Vector_v_P[0][0]==0 && Vector_v_P[1][0]<0){
+				fi_v_P = -pi;
+				STATS_COUNT(QuadrantHits[5],1);
+			}
+			else if(Vector_v_P[0][0]==0 && Vector_v_P[1][0]==0){
+				fi_v_P = 0.0;
+				STATS_COUNT(QuadrantHits[6],1);
+			}
+			else{
+				STATS_COUNT(QuadrantHits[7],1);
+			}
+			STATS_STAGE(CAMERA_STAGE_QUADRANT,tick,1);
+
+			//DOP of pixel P based on Rayleigh sky model
+			double DOP_max = parm->Sky.DOP_max;	//maximum DOP in the sky
+			double DOP = DOP_max*sin(sita_v_P)*sin(sita_v_P)/(1+cos(sita_v_P)*cos(sita_v_P));	//DOP
+			STATS_STAGE(CAMERA_STAGE_DOP,tick,1);
+
+			//AOP of pixel P based on Rayleigh sky model
+			double E_v_P[3][1] = {sin(fi_v_P),-cos(fi_v_P),0.0};	//polarization E-vector in solar vector coordinate system
+			double E_b_P[3][1] = {0.0,0.0,0.0};						//polarization E-vector in body coordinate system
+			MatrixMultiply(C_vTb,E_v_P,E_b_P);
+			double AOP = atan(E_b_P[0][0]/E_b_P[2][0]);				//AOP
+			if(DOP==0.0){	//	Elimination of invalid solution
+				AOP = 0.0;	
+				STATS_COUNT(ZeroDOP,1);
+			}
+			STATS_STAGE(CAMERA_STAGE_AOP,tick,1);
+
+			DOP_out = DOP;
+			AOP_out = AOP*180/pi;
+}
+
+
+
+//Simulate a frame with a kernel type, over a thread pool if one is given.
+template <class S>
+static void FrameSimulation(const double psa, const double afa, const double beta,
+	CameraParameters * parm, CameraFrameOf<S> * frame, ThreadPool * pool, const int type);
+
+
+
+//Hypothetical polarization camera simulation based on Rayleigh sky model.
+void CameraSimulation(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm  //camera parameters
+	){
+	//HypotheticalImages.txt is created by the first call and every later call appends to it.
+	static FILE * HypotheticalImages = fopen("output\\HypotheticalImages.txt","w");
+	if(HypotheticalImages==NULL){
+		return;
+	}
+
+	CameraFrame * frame = CameraFrameInit(parm);
+	if(frame==NULL){
+		return;
+	}
+	//The text output is produced by the reference scalar code whatever CameraParameters::Kernel is.
+	FrameSimulation(psa,afa,beta,parm,frame,NULL,RAYLEIGH_KERNEL_SCALAR);
+
+	//Record DOP and AOP to HypotheticalImages.txt in output folder.
+	CameraFrameWriteText(frame,HypotheticalImages);
+	fflush(HypotheticalImages);
+
+	CameraFrameFree(frame);
+}
+
+
+
+//Size of the frame simulated with the camera parameters.
+void CameraFrameSize(
+	const CameraParameters *	parm,  //camera parameters
+	int &	n_x,                       //number of simulated pixels along i_x (unit is pixel)
+	int &	n_z                        //number of simulated pixels along j_z (unit is pixel)
+	){
+	n_x = (parm->n_x-1)/parm->PixelInterval+1;
+	n_z = (parm->n_z-1)/parm->PixelInterval+1;
+}
+
+
+
+//Allocate a DOP and AOP frame of scalar type S.
+template <class S>
+static CameraFrameOf<S> * FrameInit(
+	const CameraParameters *	parm  //camera parameters
+	){
+	CameraFrameOf<S> * frame = ALLOC(CameraFrameOf<S>);
+	if(frame==NULL){
+		return NULL;
+	}
+	CameraFrameSize(parm,frame->n_x,frame->n_z);
+	frame->PixelInterval = parm->PixelInterval;
+
+	size_t PixelNum = (size_t)frame->n_x*frame->n_z;
+	frame->DOP = (S *)malloc(PixelNum*sizeof(S));
+	frame->AOP = (S *)malloc(PixelNum*sizeof(S));
+	frame->Owner = 1;
+	if(frame->DOP==NULL || frame->AOP==NULL){
+		CameraFrameFree(frame);
+		return NULL;
+	}
+	return frame;
+}
+
+
+
+//Wrap caller-owned planes of scalar type S into a frame.
+template <class S>
+static void FrameWrap(
+	const CameraParameters *	parm,  //camera parameters
+	S *	DOP,                           //caller-owned DOP plane
+	S *	AOP,                           //caller-owned AOP plane
+	CameraFrameOf<S> *	frame          //frame referring to DOP and AOP
+	){
+	CameraFrameSize(parm,frame->n_x,frame->n_z);
+	frame->PixelInterval = parm->PixelInterval;
+	frame->DOP = DOP;
+	frame->AOP = AOP;
+	frame->Owner = 0;
+}
+
+
+
+//Release a frame of scalar type S.
+template <class S>
+static void FrameFree(
+	CameraFrameOf<S> *	frame  //frame
+	){
+	if(frame==NULL){
+		return;
+	}
+	if(frame->Owner){
+		free(frame->DOP);
+		free(frame->AOP);
+	}
+	free(frame);
+}
+
+
+
+//Allocate a DOP and AOP frame for the hypothetical polarization camera.
+CameraFrame * CameraFrameInit(
+	const CameraParameters *	parm  //camera parameters
+	){
+	return FrameInit<double>(parm);
+}
+
+
+
+//Allocate a single precision DOP and AOP frame for the hypothetical polarization camera.
+CameraFrameFloat * CameraFrameFloatInit(
+	const CameraParameters *	parm  //camera parameters
+	){
+	return FrameInit<float>(parm);
+}
+
+
+
+//Wrap caller-owned DOP and AOP planes into a frame.
+void CameraFrameWrap(
+	const CameraParameters *	parm,  //camera parameters
+	double *	DOP,                   //caller-owned DOP plane
+	double *	AOP,                   //caller-owned AOP plane
+	CameraFrame *	frame              //frame referring to DOP and AOP
+	){
+	FrameWrap(parm,DOP,AOP,frame);
+}
+
+
+
+//Wrap caller-owned single precision DOP and AOP planes into a frame.
+void CameraFrameWrap(
+	const CameraParameters *	parm,  //camera parameters
+	float *	DOP,                       //caller-owned DOP plane
+	float *	AOP,                       //caller-owned AOP plane
+	CameraFrameFloat *	frame          //frame referring to DOP and AOP
+	){
+	FrameWrap(parm,DOP,AOP,frame);
+}
+
+
+
+//Release a frame returned by "CameraFrameInit()".
+void CameraFrameFree(
+	CameraFrame *	frame  //frame
+	){
+	FrameFree(frame);
+}
+
+
+
+//Release a frame returned by "CameraFrameFloatInit()".
+void CameraFrameFree(
+	CameraFrameFloat *	frame  //frame
+	){
+	FrameFree(frame);
+}
+
+
+
+//Rotation matrices of three Euler angles.
+void CameraRotationMatrix(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	double  (&C_bTv)[3][3]    //rotation matrix from body to solar vector coordinate system
+	){
+	//rotation matrix from solar vector to body coordinate system
+	MatrixEulerRotation(psa,afa,beta,C_vTb);
+	MatrixTrans(C_vTb,C_bTv);
+}
+
+
+
+//Rotate the ray table of a block with a double precision kernel, if it has one.
+static bool RaysSimulation(
+	const CameraParameters *	parm,  //camera parameters
+	RayleighKernelState *	state,     //rotation matrices and maximum DOP
+	const int     type,                //kernel type
+	const CameraBlock &	block,         //block of the frame layout
+	double *	DOP,                   //DOP of the block, row by row
+	double *	AOP,                   //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next
+	){
+	RayleighRaysFunction RaysKernel = RayleighKernelRaysFunction(type);
+	if(RaysKernel==NULL || !CameraRayTableValid(parm)){
+		return false;
+	}
+	//whole rows are contiguous in the table and in a frame, so they take a single call
+	bool whole = block.n_z==parm->Ray_n_z && pitch==(size_t)block.n_z;
+	RayleighKernelRays rays;
+	rays.state = state;
+	for(int i=0; i<block.n_x; i+=(whole ? block.n_x : 1)){
+		size_t first = (size_t)(block.i+i)*parm->Ray_n_z+block.j;
+		rays.Ray_x = parm->Ray_x+first;
+		rays.Ray_y = parm->Ray_y+first;
+		rays.Ray_z = parm->Ray_z+first;
+		rays.count = (int)((whole ? (size_t)block.n_x : 1)*block.n_z);
+		rays.DOP = DOP+i*pitch;
+		rays.AOP = AOP+i*pitch;
+		RaysKernel(&rays);
+	}
+	return true;
+}
+
+
+
+//Rotate the float ray table of a block with a single precision kernel; the table only exists for a lens other
+//than the pinhole, so pinhole frames use the float row kernels.
+static bool RaysSimulation(
+	const CameraParameters *	parm,  //camera parameters
+	RayleighKernelState *	state,     //rotation matrices and maximum DOP
+	const int     type,                //kernel type
+	const CameraBlock &	block,         //block of the frame layout
+	float *	DOP,                       //DOP of the block, row by row
+	float *	AOP,                       //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next
+	){
+	RayleighRaysFloatFunction RaysKernel = RayleighKernelRaysFloatFunction(type);
+	if(RaysKernel==NULL || parm->RayFloat_x==NULL || !CameraRayTableValid(parm)){
+		return false;
+	}
+	bool whole = block.n_z==parm->Ray_n_z && pitch==(size_t)block.n_z;
+	RayleighKernelRaysFloat rays;
+	rays.state = state;
+	for(int i=0; i<block.n_x; i+=(whole ? block.n_x : 1)){
+		size_t first = (size_t)(block.i+i)*parm->Ray_n_z+block.j;
+		rays.Ray_x = parm->RayFloat_x+first;
+		rays.Ray_y = parm->RayFloat_y+first;
+		rays.Ray_z = parm->RayFloat_z+first;
+		rays.count = (int)((whole ? (size_t)block.n_x : 1)*block.n_z);
+		rays.DOP = DOP+i*pitch;
+		rays.AOP = AOP+i*pitch;
+		RaysKernel(&rays);
+	}
+	return true;
+}
+
+
+
+//Rotate shooting directions with a ray kernel into DOP and AOP of scalar type S, PIXEL_BLOCK_SIZE pixels at a time.
+template <class S>
+static void RaysBlocks(
+	const RayleighKernelState *	state, //rotation matrices and maximum DOP
+	RayleighRaysFunction  RaysKernel,  //double precision ray kernel
+	const double *	Ray_x,             //unit shooting directions in body coordinate system
+	const double *	Ray_y,
+	const double *	Ray_z,
+	const int     count,               //number of pixels
+	S *	DOP,                           //DOP of the pixels
+	S *	AOP                            //AOP of the pixels (unit is degree)
+	){
+	double BlockDOP[PIXEL_BLOCK_SIZE],BlockAOP[PIXEL_BLOCK_SIZE];
+	RayleighKernelRays rays;
+	rays.state = state;
+	rays.DOP = BlockDOP;
+	rays.AOP = BlockAOP;
+	for(int first=0; first<count; first+=PIXEL_BLOCK_SIZE){
+		rays.Ray_x = Ray_x+first;
+		rays.Ray_y = Ray_y+first;
+		rays.Ray_z = Ray_z+first;
+		rays.count = count-first<PIXEL_BLOCK_SIZE ? count-first : PIXEL_BLOCK_SIZE;
+		RaysKernel(&rays);
+		for(int k=0; k<rays.count; k++){
+			DOP[first+k] = (S)BlockDOP[k];
+			AOP[first+k] = (S)BlockAOP[k];
+		}
+	}
+}
+
+
+
+//Simulate a list of pixels through the lens with the ray kernel of a type, PIXEL_BLOCK_SIZE pixels at a time.
+template <class S>
+static void LensPixelsSimulation(
+	const CameraParameters *	parm,  //camera parameters
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const RayleighKernelState *	state, //rotation matrices and maximum DOP
+	const int     type,                //kernel type
+	const CameraPixel *	pixel,         //pixels
+	const int     count,               //number of pixels
+	S *	DOP,                           //DOP of the pixels
+	S *	AOP                            //AOP of the pixels (unit is degree)
+	){
+	RayleighRaysFunction RaysKernel = RayleighKernelRaysFunction(type);
+	double Ray_x[PIXEL_BLOCK_SIZE],Ray_y[PIXEL_BLOCK_SIZE],Ray_z[PIXEL_BLOCK_SIZE];
+	for(int first=0; first<count; first+=PIXEL_BLOCK_SIZE){
+		int n = count-first<PIXEL_BLOCK_SIZE ? count-first : PIXEL_BLOCK_SIZE;
+		if(RaysKernel==NULL){
+			for(int k=0; k<n; k++){
+				double PixelDOP,PixelAOP;
+				PixelSimulation(parm,C_vTb,C_bTv,pixel[first+k].i_x,pixel[first+k].j_z,PixelDOP,PixelAOP);
+				DOP[first+k] = (S)PixelDOP;
+				AOP[first+k] = (S)PixelAOP;
+			}
+			continue;
+		}
+
+		//shooting directions of the block, from the ray table where it holds the pixel
+		for(int k=0; k<n; k++){
+			double Ray[3];
+			CameraPixelRay(parm,pixel[first+k].i_x,pixel[first+k].j_z,Ray);
+			Ray_x[k] = Ray[0];
+			Ray_y[k] = Ray[1];
+			Ray_z[k] = Ray[2];
+		}
+		RaysBlocks(state,RaysKernel,Ray_x,Ray_y,Ray_z,n,DOP+first,AOP+first);
+	}
+}
+
+
+
+//Calculate DOP and AOP of a block through a lens other than the pinhole.
+template <class S>
+static void LensRowsSimulation(
+	const CameraParameters *	parm,  //camera parameters
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const RayleighKernelState *	state, //rotation matrices and maximum DOP
+	const int     type,                //kernel type
+	const CameraBlock &	block,         //block of the frame layout
+	S *	DOP,                           //DOP of the block, row by row
+	S *	AOP,                           //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next
+	){
+	RayleighRaysFunction RaysKernel = RayleighKernelRaysFunction(type);
+	if(RaysKernel!=NULL && CameraRayTableValid(parm)){
+		for(int i=0; i<block.n_x; i++){
+			size_t first = (size_t)(block.i+i)*parm->Ray_n_z+block.j;
+			RaysBlocks(state,RaysKernel,parm->Ray_x+first,parm->Ray_y+first,parm->Ray_z+first,block.n_z,
+				DOP+i*pitch,AOP+i*pitch);
+		}
+		return;
+	}
+
+	//without a ray table, every row in blocks of pixels
+	CameraPixel pixel[PIXEL_BLOCK_SIZE];
+	for(int i=0; i<block.n_x; i++){
+		for(int j=0; j<block.n_z; j+=PIXEL_BLOCK_SIZE){
+			int n = block.n_z-j<PIXEL_BLOCK_SIZE ? block.n_z-j : PIXEL_BLOCK_SIZE;
+			for(int k=0; k<n; k++){
+				pixel[k].i_x = 1+(block.i+i)*parm->PixelInterval;
+				pixel[k].j_z = 1+(block.j+j+k)*parm->PixelInterval;
+			}
+			size_t offset = i*pitch+j;
+			LensPixelsSimulation(parm,C_vTb,C_bTv,state,type,pixel,n,DOP+offset,AOP+offset);
+		}
+	}
+}
+
+
+
+//Row kernel of a type for double precision frames.
+static RayleighRowFunction RowFunction(
+	const int     type,   //kernel type
+	const double *        //scalar type of the frame
+	){
+	return RayleighKernelFunction(type);
+}
+
+
+
+//Row kernel of a type for single precision frames.
+static RayleighRowFloatFunction RowFunction(
+	const int     type,   //kernel type
+	const float *         //scalar type of the frame
+	){
+	return RayleighKernelFloatFunction(type);
+}
+
+
+
+//Calculate DOP and AOP of a block of the frame layout.
+template <class S>
+static void RowsSimulation(
+	const CameraParameters *	parm,  //camera parameters
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const int     type,                //kernel type
+	const CameraBlock &	block,         //block of the frame layout
+	S *	DOP,                           //DOP of the block, row by row
+	S *	AOP,                           //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next
+	){
+	RayleighKernelState state;
+	RayleighKernelSky(C_vTb,C_bTv,&parm->Sky,state);
+	STATS_CLOCK(tick);
+
+	//rotate the precomputed shooting directions
+	if(RaysSimulation(parm,&state,type,block,DOP,AOP,pitch)){
+		STATS_STAGE(CAMERA_STAGE_KERNEL,tick,(uint64_t)block.n_x*block.n_z);
+		return;
+	}
+
+	//the row kernels only know the pinhole
+	if(!CameraLensPinhole(&parm->Lens)){
+		LensRowsSimulation(parm,C_vTb,C_bTv,&state,type,block,DOP,AOP,pitch);
+		STATS_STAGE(CAMERA_STAGE_KERNEL,tick,(uint64_t)block.n_x*block.n_z);
+		return;
+	}
+
+	//generate the shooting directions of each row
+	void (*RowKernel)(const RayleighKernelRowOf<S> *) = RowFunction(type,(const S *)NULL);
+	if(RowKernel!=NULL){
+		RayleighKernelRowOf<S> row;
+		row.state = &state;
+		row.f = parm->f;
+		row.D_z = parm->D_z;
+		row.Offset = 1+block.j*parm->PixelInterval-(parm->n_z+1)/2;
+		row.Step = parm->PixelInterval;
+		row.count = block.n_z;
+		for(int i=block.i; i<block.i+block.n_x; i++){
+			int i_x = 1+i*parm->PixelInterval;
+			row.P_x = parm->D_x*(i_x-(parm->n_x+1)/2);
+			row.DOP = DOP;
+			row.AOP = AOP;
+			RowKernel(&row);
+			DOP += pitch;
+			AOP += pitch;
+		}
+		STATS_STAGE(CAMERA_STAGE_KERNEL,tick,(uint64_t)block.n_x*block.n_z);
+		return;
+	}
+
+	for(int i=block.i; i<block.i+block.n_x; i++){
+		for(int j=block.j; j<block.j+block.n_z; j++){
+			double PixelDOP,PixelAOP;
+			PixelSimulation(parm,C_vTb,C_bTv,1+i*parm->PixelInterval,1+j*parm->PixelInterval,PixelDOP,PixelAOP);
+			DOP[j-block.j] = (S)PixelDOP;
+			AOP[j-block.j] = (S)PixelAOP;
+		}
+		DOP += pitch;
+		AOP += pitch;
+	}
+}
+
+
+
+//Calculate DOP and AOP of the frame rows [row_begin,row_end).
+template <class S>
+static void RowsSimulation(
+	const CameraParameters *	parm,  //camera parameters
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const int     type,                //kernel type
+	CameraFrameOf<S> *	frame,        //DOP and AOP of every simulated pixel
+	const int     row_begin,           //first frame row
+	const int     row_end              //frame row after the last one
+	){
+	CameraBlock block = {row_begin,0,row_end-row_begin,frame->n_z};
+	size_t first = (size_t)row_begin*frame->n_z;
+	RowsSimulation(parm,C_vTb,C_bTv,type,block,frame->DOP+first,frame->AOP+first,(size_t)frame->n_z);
+}
+
+
+
+//Simulate a frame of given rotation matrices with a kernel type, over a thread pool if one is given.
+template <class S>
+static void RotationSimulation(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	CameraFrameOf<S> *	frame,        //DOP and AOP of every simulated pixel
+	ThreadPool *	pool,              //thread pool, NULL runs on the calling thread
+	const int     type                 //kernel type
+	){
+	STATS_CLOCK(tick);
+
+	//Calculate DOP and AOP of each pixels.
+	if(pool==NULL){
+		RowsSimulation(parm,C_vTb,C_bTv,type,frame,0,frame->n_x);
+	}
+	else{
+		pool->ParallelFor(frame->n_x,BandRows(frame->n_x,pool),[&](int begin, int end){
+			STATS_CLOCK(band);
+			RowsSimulation(parm,C_vTb,C_bTv,type,frame,begin,end);
+			STATS_TRACE("rows",band,(uint64_t)(end-begin)*frame->n_z,0);
+		});
+	}
+
+	STATS_COUNT(Frames,1);
+	STATS_COUNT(Pixels,(uint64_t)frame->n_x*frame->n_z);
+	STATS_TRACE("frame",tick,(uint64_t)frame->n_x*frame->n_z,0);
+}
+
+
+
+//Simulate a frame with a kernel type, over a thread pool if one is given.
+template <class S>
+static void FrameSimulation(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrameOf<S> *	frame,//DOP and AOP of every simulated pixel
+	ThreadPool *	pool,     //thread pool, NULL runs on the calling thread
+	const int     type        //kernel type
+	){
+	//three Euler angles
+	parm->psa = psa;   //yaw angle (unit is radian)
+	parm->afa = afa;   //pitch angle (unit is radian)
+	parm->beta = beta; //roll angle (unit is radian)
+
+	double C_vTb[3][3];//rotation matrix from solar vector to body coordinate system
+	double C_bTv[3][3];//rotation matrix from body to solar vector coordinate system
+	CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+
+	RotationSimulation(C_vTb,C_bTv,parm,frame,pool,type);
+}
+
+
+
+//Hypothetical polarization camera simulation based on Rayleigh sky model without file I/O.
+void CameraSimulationFrame(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrame *	frame     //DOP and AOP of every simulated pixel
+	){
+	FrameSimulation(psa,afa,beta,parm,frame,NULL,parm->Kernel);
+}
+
+
+
+//Hypothetical polarization camera simulation in single precision without file I/O.
+void CameraSimulationFrame(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrameFloat *	frame //DOP and AOP of every simulated pixel
+	){
+	FrameSimulation(psa,afa,beta,parm,frame,NULL,parm->Kernel);
+}
+
+
+
+//Hypothetical polarization camera simulation split into row bands over a thread pool.
+void CameraSimulationFrameParallel(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrame *	frame,    //DOP and AOP of every simulated pixel
+	ThreadPool *	pool      //thread pool, NULL runs on the calling thread
+	){
+	FrameSimulation(psa,afa,beta,parm,frame,pool,parm->Kernel);
+}
+
+
+
+//Hypothetical polarization camera simulation in single precision split into row bands over a thread pool.
+void CameraSimulationFrameParallel(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrameFloat *	frame,//DOP and AOP of every simulated pixel
+	ThreadPool *	pool      //thread pool, NULL runs on the calling thread
+	){
+	FrameSimulation(psa,afa,beta,parm,frame,pool,parm->Kernel);
+}
+
+
+
+//Hypothetical polarization camera simulation of given rotation matrices, without changing the camera parameters.
+void CameraSimulationFrameRotation(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	CameraFrame *	frame,             //DOP and AOP of every simulated pixel
+	ThreadPool *	pool               //thread pool, NULL runs on the calling thread
+	){
+	RotationSimulation(C_vTb,C_bTv,parm,frame,pool,parm->Kernel);
+}
+
+
+
+//Hypothetical polarization camera simulation in single precision of given rotation matrices.
+void CameraSimulationFrameRotation(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	CameraFrameFloat *	frame,         //DOP and AOP of every simulated pixel
+	ThreadPool *	pool               //thread pool, NULL runs on the calling thread
+	){
+	RotationSimulation(C_vTb,C_bTv,parm,frame,pool,parm->Kernel);
+}
+
+
+
+//Simulate a block of the frame layout with the kernel of the camera parameters.
+template <class S>
+static int BlockSimulation(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	const CameraBlock *	block,         //block of the frame
+	S *	DOP,                           //DOP of the block, row after row
+	S *	AOP,                           //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next
+	){
+	int n_x, n_z;
+	CameraFrameSize(parm,n_x,n_z);
+	if(block->i<0 || block->j<0 || block->n_x<0 || block->n_z<0
+		|| block->n_x>n_x-block->i || block->n_z>n_z-block->j || pitch<(size_t)block->n_z){
+		return -1;
+	}
+	if(block->n_x==0 || block->n_z==0){
+		return 0;
+	}
+	RowsSimulation(parm,C_vTb,C_bTv,parm->Kernel,*block,DOP,AOP,pitch);
+	STATS_COUNT(Pixels,(uint64_t)block->n_x*block->n_z);
+	return 0;
+}
+
+
+
+//Hypothetical polarization camera simulation of a block of the frame, without changing the camera parameters.
+int CameraSimulationBlock(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	const CameraBlock *	block,         //block of the frame
+	double *	DOP,                   //DOP of the block, row after row
+	double *	AOP,                   //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next, at least block->n_z
+	){
+	return BlockSimulation(C_vTb,C_bTv,parm,block,DOP,AOP,pitch);
+}
+
+
+
+//Hypothetical polarization camera simulation in single precision of a block of the frame.
+int CameraSimulationBlock(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	const CameraBlock *	block,         //block of the frame
+	float *	DOP,                       //DOP of the block, row after row
+	float *	AOP,                       //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next, at least block->n_z
+	){
+	return BlockSimulation(C_vTb,C_bTv,parm,block,DOP,AOP,pitch);
+}
+
+
+
+//Number of pixels of a list of regions of interest.
+size_t CameraRegionPixels(
+	const CameraRegion *	region,   //regions of interest
+	const int     count               //number of regions
+	){
+	size_t PixelNum = 0;
+	for(int k=0; k<count; k++){
+		PixelNum += (size_t)region[k].n_x*region[k].n_z;
+	}
+	return PixelNum;
+}
+
+
+
+//Simulate the pixels of regions of interest with the row kernel of the camera parameters.
+template <class S>
+static int RegionSimulation(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraRegion *	region,//regions of interest
+	const int     count,      //number of regions
+	S *	DOP,                  //DOP of the pixels of the regions
+	S *	AOP                   //AOP of the pixels of the regions (unit is degree)
+	){
+	for(int k=0; k<count; k++){
+		if(region[k].n_x<0 || region[k].n_z<0 || region[k].i_x<1 || region[k].j_z<1
+			|| region[k].i_x+region[k].n_x-1>parm->n_x || region[k].j_z+region[k].n_z-1>parm->n_z){
+			return -1;
+		}
+	}
+	parm->psa = psa;
+	parm->afa = afa;
+	parm->beta = beta;
+	double C_vTb[3][3];
+	double C_bTv[3][3];
+	CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+	RayleighKernelState state;
+	RayleighKernelSky(C_vTb,C_bTv,&parm->Sky,state);
+	STATS_CLOCK(tick);
+
+	void (*RowKernel)(const RayleighKernelRowOf<S> *) = RowFunction(parm->Kernel,(const S *)NULL);
+	bool pinhole = CameraLensPinhole(&parm->Lens)!=0;
+	RayleighKernelRowOf<S> row;
+	row.state = &state;
+	row.f = parm->f;
+	row.D_z = parm->D_z;
+	row.Step = 1;
+	for(int k=0; k<count; k++){
+		for(int i_x=region[k].i_x; i_x<region[k].i_x+region[k].n_x; i_x++){
+			if(!pinhole){	//the row kernels only know the pinhole
+				CameraPixel pixel[PIXEL_BLOCK_SIZE];
+				for(int j=0; j<region[k].n_z; j+=PIXEL_BLOCK_SIZE){
+					int n = region[k].n_z-j<PIXEL_BLOCK_SIZE ? region[k].n_z-j : PIXEL_BLOCK_SIZE;
+					for(int m=0; m<n; m++){
+						pixel[m].i_x = i_x;
+						pixel[m].j_z = region[k].j_z+j+m;
+					}
+					LensPixelsSimulation(parm,C_vTb,C_bTv,&state,parm->Kernel,pixel,n,DOP,AOP);
+					DOP += n;
+					AOP += n;
+				}
+				continue;
+			}
+			if(RowKernel!=NULL){
+				row.P_x = parm->D_x*(i_x-(parm->n_x+1)/2);
+				row.Offset = region[k].j_z-(parm->n_z+1)/2;
+				row.count = region[k].n_z;
+				row.DOP = DOP;
+				row.AOP = AOP;
+				RowKernel(&row);
+				DOP += region[k].n_z;
+				AOP += region[k].n_z;
+				continue;
+			}
+			for(int j_z=region[k].j_z; j_z<region[k].j_z+region[k].n_z; j_z++){
+				double PixelDOP,PixelAOP;
+				PixelSimulation(parm,C_vTb,C_bTv,i_x,j_z,PixelDOP,PixelAOP);
+				*DOP++ = (S)PixelDOP;
+				*AOP++ = (S)PixelAOP;
+			}
+		}
+	}
+	STATS_STAGE(CAMERA_STAGE_KERNEL,tick,CameraRegionPixels(region,count));
+	STATS_COUNT(Pixels,CameraRegionPixels(region,count));
+	return 0;
+}
+
+
+
+//Simulate a list of pixels with the ray kernel of the camera parameters.
+template <class S>
+static int PixelListSimulation(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraPixel *	pixel,//pixels
+	const int     count,      //number of pixels
+	S *	DOP,                  //DOP of the pixels
+	S *	AOP                   //AOP of the pixels (unit is degree)
+	){
+	for(int k=0; k<count; k++){
+		if(pixel[k].i_x<1 || pixel[k].i_x>parm->n_x || pixel[k].j_z<1 || pixel[k].j_z>parm->n_z){
+			return -1;
+		}
+	}
+	parm->psa = psa;
+	parm->afa = afa;
+	parm->beta = beta;
+	double C_vTb[3][3];
+	double C_bTv[3][3];
+	CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+	RayleighKernelState state;
+	RayleighKernelSky(C_vTb,C_bTv,&parm->Sky,state);
+	STATS_CLOCK(tick);
+
+	LensPixelsSimulation(parm,C_vTb,C_bTv,&state,parm->Kernel,pixel,count,DOP,AOP);
+	STATS_STAGE(CAMERA_STAGE_KERNEL,tick,(uint64_t)count);
+	STATS_COUNT(Pixels,(uint64_t)count);
+	return 0;
+}
+
+
+
+//Hypothetical polarization camera simulation of regions of interest only.
+int CameraSimulationRegions(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraRegion *	region,//regions of interest
+	const int     count,      //number of regions
+	double *	DOP,          //DOP of the pixels of the regions
+	double *	AOP           //AOP of the pixels of the regions (unit is degree)
+	){
+	return RegionSimulation(psa,afa,beta,parm,region,count,DOP,AOP);
+}
+
+
+
+//Hypothetical polarization camera simulation of regions of interest only, in single precision.
+int CameraSimulationRegions(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraRegion *	region,//regions of interest
+	const int     count,      //number of regions
+	float *	DOP,              //DOP of the pixels of the regions
+	float *	AOP               //AOP of the pixels of the regions (unit is degree)
+	){
+	return RegionSimulation(psa,afa,beta,parm,region,count,DOP,AOP);
+}
+
+
+
+//Hypothetical polarization camera simulation of a list of pixels only.
+int CameraSimulationPixels(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraPixel *	pixel,//pixels
+	const int     count,      //number of pixels
+	double *	DOP,          //DOP of the pixels
+	double *	AOP           //AOP of the pixels (unit is degree)
+	){
+	return PixelListSimulation(psa,afa,beta,parm,pixel,count,DOP,AOP);
+}
+
+
+
+//Hypothetical polarization camera simulation of a list of pixels only, in single precision.
+int CameraSimulationPixels(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraPixel *	pixel,//pixels
+	const int     count,      //number of pixels
+	float *	DOP,              //DOP of the pixels
+	float *	AOP               //AOP of the pixels (unit is degree)
+	){
+	return PixelListSimulation(psa,afa,beta,parm,pixel,count,DOP,AOP);
+}
+
+
+
+//Format the frame rows [row_begin,row_end) in the four-column format of HypotheticalImages.txt.
+template <class S>
+static size_t FormatRows(
+	const CameraFrameOf<S> *	frame,  //DOP and AOP frame
+	const int     row_begin,    //first frame row
+	const int     row_end,      //frame row after the last one
+	char *	buffer              //text, at most TEXT_LINE_SIZE characters per pixel
+	){
+	//HypotheticalImages.txt
+	//The first column is i_x (column coordinate in pixel coordinate system)
+	//The second column is j_z (raw coordinate in pixel coordinate system)
+	//The third column is DOP (degree of polarization)
+	//The forth column is AOP (angle of polarization and the unit of AOP is degree )
+	//Each line matches "<<setprecision(16)<<i_x<<setw(25)<<j_z<<setw(25)<<DOP<<setw(25)<<AOP".
+	//Single precision frames print 9 significant digits, enough to restore every float.
+	const int digits = sizeof(S)==sizeof(float) ? 9 : 16;
+	size_t used = 0;
+	const S * DOP = frame->DOP+(size_t)row_begin*frame->n_z;
+	const S * AOP = frame->AOP+(size_t)row_begin*frame->n_z;
+	for(int i=row_begin; i<row_end; i++){
+		for(int j=0; j<frame->n_z; j++){
+			used += sprintf(buffer+used,"%d%25d%25.*g%25.*g\n",
+				1+i*frame->PixelInterval,1+j*frame->PixelInterval,digits,(double)*DOP,digits,(double)*AOP);
+			DOP++;
+			AOP++;
+		}
+	}
+	return used;
+}
+
+
+
+//Write a frame of scalar type S in the four-column format, formatting row bands over a thread pool.
+template <class S>
+static int WriteText(
+	const CameraFrameOf<S> *	frame,  //DOP and AOP frame
+	FILE *	file,                       //opened text file
+	ThreadPool *	pool                //thread pool, NULL formats on the calling thread
+	){
+	//rows per buffer, so that a buffer holds about TEXT_BUFFER_SIZE characters
+	int rows = (int)(TEXT_BUFFER_SIZE/((size_t)frame->n_z*TEXT_LINE_SIZE));
+	if(rows<1){
+		rows = 1;
+	}
+	int buffers = pool==NULL ? 1 : pool->Size();
+	size_t BufferSize = (size_t)rows*frame->n_z*TEXT_LINE_SIZE;
+
+	STATS_CLOCK(tick);
+	std::vector<char *> buffer(buffers,(char *)NULL);
+	std::vector<size_t> used(buffers,0);
+	int status = 0;
+	for(int k=0; k<buffers; k++){
+		buffer[k] = (char *)malloc(BufferSize);
+		if(buffer[k]==NULL){
+			status = -1;
+		}
+	}
+
+	//Format up to "buffers" bands at once and write them in row order.
+	for(int row=0; row<frame->n_x && status==0; row+=rows*buffers){
+		int bands = (frame->n_x-row+rows-1)/rows;
+		if(bands>buffers){
+			bands = buffers;
+		}
+		if(pool==NULL){
+			used[0] = FormatRows(frame,row,row+rows<frame->n_x ? row+rows : frame->n_x,buffer[0]);
+		}
+		else{
+			pool->ParallelFor(bands,1,[&](int begin, int end){
+				for(int k=begin; k<end; k++){
+					int first = row+k*rows;
+					int last = first+rows<frame->n_x ? first+rows : frame->n_x;
+					used[k] = FormatRows(frame,first,last,buffer[k]);
+				}
+			});
+		}
+		for(int k=0; k<bands; k++){
+			if(fwrite(buffer[k],1,used[k],file)!=used[k]){
+				status = -1;
+				break;
+			}
+			STATS_COUNT(BytesWritten,used[k]);
+		}
+	}
+
+	for(int k=0; k<buffers; k++){
+		free(buffer[k]);
+	}
+	STATS_TRACE("text",tick,(uint64_t)frame->n_x*frame->n_z,0);
+	STATS_STAGE(CAMERA_STAGE_TEXT,tick,(uint64_t)frame->n_x*frame->n_z);
+	return status;
+}
+
+
+
+//Write a frame in the four-column format of HypotheticalImages.txt.
+int CameraFrameWriteText(
+	const CameraFrame *	frame,  //DOP and AOP frame
+	FILE *	file                //opened text file
+	){
+	return WriteText(frame,file,NULL);
+}
+
+
+
+//Write a single precision frame in the four-column format of HypotheticalImages.txt.
+int CameraFrameWriteText(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	FILE *	file                        //opened text file
+	){
+	return WriteText(frame,file,NULL);
+}
+
+
+
+//Write a frame in the four-column format of HypotheticalImages.txt, formatting row bands over a thread pool.
+int CameraFrameWriteTextParallel(
+	const CameraFrame *	frame,  //DOP and AOP frame
+	FILE *	file,               //opened text file
+	ThreadPool *	pool        //thread pool, NULL formats on the calling thread
+	){
+	return WriteText(frame,file,pool);
+}
+
+
+
+//Write a single precision frame in the four-column format of HypotheticalImages.txt over a thread pool.
+int CameraFrameWriteTextParallel(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	FILE *	file,                       //opened text file
+	ThreadPool *	pool                //thread pool, NULL formats on the calling thread
+	){
+	return WriteText(frame,file,pool);
 }
\ No newline at end of file
@@ -1,41 +1,369 @@
-#ifndef _POLARIZATIONCAMERA_H_
-#define _POLARIZATIONCAMERA_H_
-
-//polarization camera parameters struct
-typedef struct CameraParameters
-{
-
-	double  D_x;            //Unit cell size of CCD or COMS (unit is micrometer)
-	double  D_z;            //Unit cell size of CCD or COMS (unit is micrometer)
-	int     n_x;            //Image pixel size (unit is pixel)
-	int     n_z;            //Image pixel size (unit is pixel)
-	double  f;              //Focus of the camera (unit is millimeter)
-
-	int     PixelInterval;  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
-
-	double  psa;            //yaw angle (unit is degree)
-	double  afa;            //pitch angle (unit is degree)
-	double  beta;           //roll angle (unit is degree)
-}
-CameraParameters;
-
-
-//Initialize the hypothetical polarization camera parameters.
-CameraParameters * CameraParametersInit(
-	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
-	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
-	const int     n_x,           //Image pixel size (unit is pixel)
-	const int     n_z,           //Image pixel size (unit is pixel)
-	const double  f,             //Focus of the camera (unit is millimeter)
-	const int     PixelInterval  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
-        );
-
-//Hypothetical polarization camera simulation based on Rayleigh sky model.
-void CameraSimulation(
-	const double  psa,        //yaw angle (unit is radian)
-	const double  afa,        //pitch angle (unit is radian)
-    const double  beta,       //roll angle (unit is radian)
-	CameraParameters *	parm  //camera parameters
-	);
-
+#ifndef _POLARIZATIONCAMERA_H_
+#define _POLARIZATIONCAMERA_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include "CameraLens.h"
+#include "SkyModel.h"
+
+class ThreadPool;
+
+//Largest frame whose shooting directions are precomputed by "CameraRayTableInit()" (unit is simulated pixel)
+#define CAMERA_RAY_TABLE_MAX_PIXELS (1<<24)
+
+//polarization camera parameters struct
+typedef struct CameraParameters
+{
+
+	double  D_x;            //Unit cell size of CCD or COMS (unit is micrometer)
+	double  D_z;            //Unit cell size of CCD or COMS (unit is micrometer)
+	int     n_x;            //Image pixel size (unit is pixel)
+	int     n_z;            //Image pixel size (unit is pixel)
+	double  f;              //Focus of the camera (unit is millimeter)
+
+	int     PixelInterval;  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
+
+	double  psa;            //yaw angle (unit is degree)
+	double  afa;            //pitch angle (unit is degree)
+	double  beta;           //roll angle (unit is degree)
+
+	int     Kernel;         //RAYLEIGH_KERNEL_AUTO, RAYLEIGH_KERNEL_SCALAR, ... (see RayleighKernel.h)
+
+	CameraLens  Lens;       //projection and distortion of the lens, set by "CameraParametersSetLens()" (pinhole by default)
+	SkyModel    Sky;        //sky polarization model (see SkyModel.h), Rayleigh with DOP_max=1 by default
+
+	//ray table of "CameraRayTableInit()", in the layout of CameraFrame (NULL if it is not built)
+	int     RayTableEnabled;    //0 for the parameters of "CameraParametersInitNoTable()", which never build the table
+	int     Ray_n_x;        //Number of simulated pixels along i_x of the table (unit is pixel)
+	int     Ray_n_z;        //Number of simulated pixels along j_z of the table (unit is pixel)
+	int     RayPixelInterval;   //Pixel interval of the table (unit is pixel)
+	int     RayImage_n_x;   //Image pixel size of the table (unit is pixel)
+	int     RayImage_n_z;   //Image pixel size of the table (unit is pixel)
+	double  RayD_x;         //Unit cell size of the table (unit is micrometer)
+	double  RayD_z;         //Unit cell size of the table (unit is micrometer)
+	double  RayF;           //Focus of the table (unit is millimeter)
+	CameraLens  RayLens;    //lens of the table
+	double *Ray_x;          //unit shooting direction of every simulated pixel in body coordinate system
+	double *Ray_y;
+	double *Ray_z;
+	float * RayFloat_x;     //single precision copy of the table for the float kernels, NULL for the pinhole lens
+	float * RayFloat_y;
+	float * RayFloat_z;
+}
+CameraParameters;
+
+
+//DOP and AOP frame struct (structure of arrays)
+template <class S>
+struct CameraFrameOf
+{
+	int     n_x;            //Number of simulated pixels along i_x, (CameraParameters::n_x-1)/PixelInterval+1 (unit is pixel)
+	int     n_z;            //Number of simulated pixels along j_z, (CameraParameters::n_z-1)/PixelInterval+1 (unit is pixel)
+	int     PixelInterval;  //Pixel interval of the simulation (unit is pixel)
+
+	S *     DOP;            //DOP plane, DOP[i*n_z+j] belongs to pixel i_x=1+i*PixelInterval, j_z=1+j*PixelInterval
+	S *     AOP;            //AOP plane with the same layout as DOP (unit is degree)
+
+	int     Owner;          //1 if DOP and AOP are released by CameraFrameFree()
+};
+
+typedef CameraFrameOf<double> CameraFrame;        //double precision frame
+typedef CameraFrameOf<float>  CameraFrameFloat;   //single precision frame
+
+//rectangular region of interest in pixel coordinate system
+typedef struct CameraRegion
+{
+	int     i_x;            //column coordinate of the first pixel (1 to CameraParameters::n_x)
+	int     j_z;            //raw coordinate of the first pixel (1 to CameraParameters::n_z)
+	int     n_x;            //Number of pixels along i_x (unit is pixel)
+	int     n_z;            //Number of pixels along j_z (unit is pixel)
+}
+CameraRegion;
+
+//a pixel in pixel coordinate system
+typedef struct CameraPixel
+{
+	int     i_x;            //column coordinate (1 to CameraParameters::n_x)
+	int     j_z;            //raw coordinate (1 to CameraParameters::n_z)
+}
+CameraPixel;
+
+//rectangular block of a frame in the layout of CameraFrameOf
+typedef struct CameraBlock
+{
+	int     i;              //first frame row (0 to CameraFrameOf::n_x-1)
+	int     j;              //first frame column (0 to CameraFrameOf::n_z-1)
+	int     n_x;            //Number of frame rows (unit is simulated pixel)
+	int     n_z;            //Number of frame columns (unit is simulated pixel)
+}
+CameraBlock;
+
+
+//Initialize the hypothetical polarization camera parameters.
+CameraParameters * CameraParametersInit(
+	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const int     n_x,           //Image pixel size (unit is pixel)
+	const int     n_z,           //Image pixel size (unit is pixel)
+	const double  f,             //Focus of the camera (unit is millimeter)
+	const int     PixelInterval  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
+        );
+
+//Initialize the camera parameters without the ray table, for callers that never hold a frame.
+CameraParameters * CameraParametersInitNoTable(
+	const double  D_x,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const double  D_z,           //Unit cell size of CCD or COMS (unit is micrometer)
+	const int     n_x,           //Image pixel size (unit is pixel)
+	const int     n_z,           //Image pixel size (unit is pixel)
+	const double  f,             //Focus of the camera (unit is millimeter)
+	const int     PixelInterval  //Convenient for debugging. Its value is 1 for practical application.(unit is pixel)
+        );
+
+//Precompute the unit shooting direction of every simulated pixel (called by "CameraParametersInit()").
+int CameraRayTableInit(
+	CameraParameters *	parm  //camera parameters
+	);
+
+//Set the lens of the camera and rebuild the ray table with it.
+int CameraParametersSetLens(
+	CameraParameters *	parm,  //camera parameters
+	const CameraLens *	lens   //lens
+	);
+
+//Unit shooting direction of a pixel in body coordinate system through the lens of the camera parameters.
+int CameraPixelRay(
+	const CameraParameters *	parm,  //camera parameters
+	const int     i_x,                 //column coordinate in pixel coordinate system
+	const int     j_z,                 //raw coordinate in pixel coordinate system
+	double  (&Ray)[3]                  //unit shooting direction, NaN if the pixel sees no sky
+	);
+
+//Whether the ray table matches the frame layout of the camera parameters.
+int CameraRayTableValid(
+	const CameraParameters *	parm  //camera parameters
+	);
+
+//Release camera parameters returned by "CameraParametersInit()".
+void CameraParametersFree(
+	CameraParameters *	parm  //camera parameters
+	);
+
+//Hypothetical polarization camera simulation based on Rayleigh sky model.
+void CameraSimulation(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm  //camera parameters
+	);
+
+//Size of the frame simulated with the camera parameters.
+void CameraFrameSize(
+	const CameraParameters *	parm,  //camera parameters
+	int &	n_x,                       //number of simulated pixels along i_x (unit is pixel)
+	int &	n_z                        //number of simulated pixels along j_z (unit is pixel)
+	);
+
+//Allocate a DOP and AOP frame for the hypothetical polarization camera.
+CameraFrame * CameraFrameInit(
+	const CameraParameters *	parm  //camera parameters
+	);
+
+//Allocate a single precision DOP and AOP frame for the hypothetical polarization camera.
+CameraFrameFloat * CameraFrameFloatInit(
+	const CameraParameters *	parm  //camera parameters
+	);
+
+//Wrap caller-owned DOP and AOP planes into a frame.
+void CameraFrameWrap(
+	const CameraParameters *	parm,  //camera parameters
+	double *	DOP,                   //caller-owned DOP plane
+	double *	AOP,                   //caller-owned AOP plane
+	CameraFrame *	frame              //frame referring to DOP and AOP
+	);
+
+//Wrap caller-owned single precision DOP and AOP planes into a frame.
+void CameraFrameWrap(
+	const CameraParameters *	parm,  //camera parameters
+	float *	DOP,                       //caller-owned DOP plane
+	float *	AOP,                       //caller-owned AOP plane
+	CameraFrameFloat *	frame          //frame referring to DOP and AOP
+	);
+
+//Release a frame returned by "CameraFrameInit()".
+void CameraFrameFree(
+	CameraFrame *	frame  //frame
+	);
+
+//Release a frame returned by "CameraFrameFloatInit()".
+void CameraFrameFree(
+	CameraFrameFloat *	frame  //frame
+	);
+
+//Hypothetical polarization camera simulation based on Rayleigh sky model without file I/O.
+void CameraSimulationFrame(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrame *	frame     //DOP and AOP of every simulated pixel
+	);
+
+//Hypothetical polarization camera simulation in single precision without file I/O.
+void CameraSimulationFrame(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrameFloat *	frame //DOP and AOP of every simulated pixel
+	);
+
+//Hypothetical polarization camera simulation split into row bands over a thread pool.
+void CameraSimulationFrameParallel(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrame *	frame,    //DOP and AOP of every simulated pixel
+	ThreadPool *	pool      //thread pool, NULL runs on the calling thread
+	);
+
+//Hypothetical polarization camera simulation in single precision split into row bands over a thread pool.
+void CameraSimulationFrameParallel(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	CameraFrameFloat *	frame,//DOP and AOP of every simulated pixel
+	ThreadPool *	pool      //thread pool, NULL runs on the calling thread
+	);
+
+//Rotation matrices of three Euler angles.
+void CameraRotationMatrix(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	double  (&C_bTv)[3][3]    //rotation matrix from body to solar vector coordinate system
+	);
+
+//Hypothetical polarization camera simulation of given rotation matrices, without changing the camera parameters.
+void CameraSimulationFrameRotation(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	CameraFrame *	frame,             //DOP and AOP of every simulated pixel
+	ThreadPool *	pool               //thread pool, NULL runs on the calling thread
+	);
+
+//Hypothetical polarization camera simulation in single precision of given rotation matrices.
+void CameraSimulationFrameRotation(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	CameraFrameFloat *	frame,         //DOP and AOP of every simulated pixel
+	ThreadPool *	pool               //thread pool, NULL runs on the calling thread
+	);
+
+//Hypothetical polarization camera simulation of a block of the frame, without changing the camera parameters.
+int CameraSimulationBlock(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	const CameraBlock *	block,         //block of the frame
+	double *	DOP,                   //DOP of the block, row after row
+	double *	AOP,                   //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next, at least block->n_z
+	);
+
+//Hypothetical polarization camera simulation in single precision of a block of the frame.
+int CameraSimulationBlock(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const CameraParameters *	parm,  //camera parameters
+	const CameraBlock *	block,         //block of the frame
+	float *	DOP,                       //DOP of the block, row after row
+	float *	AOP,                       //AOP of the block (unit is degree)
+	const size_t  pitch                //values from one row of DOP and AOP to the next, at least block->n_z
+	);
+
+//Number of pixels of a list of regions of interest.
+size_t CameraRegionPixels(
+	const CameraRegion *	region,   //regions of interest
+	const int     count               //number of regions
+	);
+
+//Hypothetical polarization camera simulation of regions of interest only.
+int CameraSimulationRegions(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraRegion *	region,//regions of interest
+	const int     count,      //number of regions
+	double *	DOP,          //DOP of the pixels of the regions, "CameraRegionPixels()" values
+	double *	AOP           //AOP of the pixels of the regions (unit is degree)
+	);
+
+//Hypothetical polarization camera simulation of regions of interest only, in single precision.
+int CameraSimulationRegions(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraRegion *	region,//regions of interest
+	const int     count,      //number of regions
+	float *	DOP,              //DOP of the pixels of the regions, "CameraRegionPixels()" values
+	float *	AOP               //AOP of the pixels of the regions (unit is degree)
+	);
+
+//Hypothetical polarization camera simulation of a list of pixels only.
+int CameraSimulationPixels(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraPixel *	pixel,//pixels
+	const int     count,      //number of pixels
+	double *	DOP,          //DOP of the pixels, count values
+	double *	AOP           //AOP of the pixels (unit is degree)
+	);
+
+//Hypothetical polarization camera simulation of a list of pixels only, in single precision.
+int CameraSimulationPixels(
+	const double  psa,        //yaw angle (unit is radian)
+	const double  afa,        //pitch angle (unit is radian)
+    const double  beta,       //roll angle (unit is radian)
+	CameraParameters *	parm, //camera parameters
+	const CameraPixel *	pixel,//pixels
+	const int     count,      //number of pixels
+	float *	DOP,              //DOP of the pixels, count values
+	float *	AOP               //AOP of the pixels (unit is degree)
+	);
+
+//Write a frame in the four-column format of HypotheticalImages.txt.
+int CameraFrameWriteText(
+	const CameraFrame *	frame,  //DOP and AOP frame
+	FILE *	file                //opened text file
+	);
+
+//Write a single precision frame in the four-column format of HypotheticalImages.txt.
+int CameraFrameWriteText(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	FILE *	file                        //opened text file
+	);
+
+//Write a frame in the four-column format of HypotheticalImages.txt, formatting row bands over a thread pool.
+int CameraFrameWriteTextParallel(
+	const CameraFrame *	frame,  //DOP and AOP frame
+	FILE *	file,               //opened text file
+	ThreadPool *	pool        //thread pool, NULL formats on the calling thread
+	);
+
+//Write a single precision frame in the four-column format of HypotheticalImages.txt over a thread pool.
+int CameraFrameWriteTextParallel(
+	const CameraFrameFloat *	frame,  //DOP and AOP frame
+	FILE *	file,                       //opened text file
+	ThreadPool *	pool                //thread pool, NULL formats on the calling thread
+	);
+
 #endif //
\ No newline at end of file
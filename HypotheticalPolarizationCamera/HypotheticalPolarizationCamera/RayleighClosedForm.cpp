@@ -0,0 +1,569 @@
+/*
+Closed-form Rayleigh sky model of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for evaluating the Rayleigh sky model algebraically from the shooting direction and the sun vector.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Using the code through CameraParameters::Kernel=RAYLEIGH_KERNEL_CLOSED_FORM, or "CameraSimulationStokes()" for Stokes components.
+--------------------------
+
+Closed form:
+	With the unit sun vector in body coordinate system s = C_vTb*{0,0,1} (the third column of C_vTb) and the
+	shooting direction r = Vector_b_PaF of a pixel,
+		c = cos(sita_v_P) = s.r/|r|,    DOP = DOP_max*(1-c^2)/(1+c^2)
+		E_b_P = s x r                   (equals -C_vTb*E_v_P*|{Vector_v_P[0][0],Vector_v_P[1][0]}|)
+	and with E_x = E_b_P[0][0], E_z = E_b_P[2][0]
+		cos(2*AOP) = (E_z^2-E_x^2)/(E_x^2+E_z^2),    sin(2*AOP) = 2*E_x*E_z/(E_x^2+E_z^2)
+		AOP = atan2(2*E_x*E_z,E_z^2-E_x^2)/2
+	so a pixel costs one atan2 and no other trigonometric function, and the Stokes components none at all.
+	The sign of the E-vector does not change AOP, which is the same angle modulo 180 degrees as atan(E_x/E_z).
+
+Edge cases:
+	Sky models               The closed form is the algebra of the Rayleigh sky (with CameraParameters::Sky.DOP_max);
+	                         for the other models of SkyModel.h every function here evaluates "SkyModelRay()" or
+	                         "SkyModelStokes()" per pixel instead.
+	DOP==0                   At the solar and anti-solar points s x r = 0, the closed form gives AOP=0 like the
+	                         "Elimination of invalid solution" of "CameraSimulation()".
+	Vector_v_P[0][0]==0      The quadrant judgement of "CameraSimulation()" sets fi_v_P to +-pi or 0, i.e. the
+	                         E-vector {+-sin(pi),1,0} or {0,-1,0}, which lies in the plane of the sun and the shooting
+	                         direction. RAYLEIGH_EDGE_LEGACY reproduces it including sin(pi)=1.2e-16 (the kernels
+	                         always do), RAYLEIGH_EDGE_GEOMETRIC keeps s x r, which can differ by 90 degrees on these
+	                         pixels. They happen for instance on the centre column i_x=(n_x+1)/2 when psa=afa=beta=0.
+
+
+Function 1: "RayleighRowClosedForm()" 
+
+    //DOP and AOP of a frame row without acos, sin, cos and quadrant judgement.
+	void RayleighRowClosedForm(
+		const RayleighKernelRow *	row
+	);
+	--------------input----------------
+	const RayleighKernelRow *	row    //attitude, pixel locations and output planes of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP                 //DOP and AOP (unit is degree) of row->count pixels
+	-----------------------------------
+
+
+Function 2: "RayleighRaysClosedForm()" 
+
+    //DOP and AOP of pixels of a ray table without acos, sin, cos and quadrant judgement.
+	void RayleighRaysClosedForm(
+		const RayleighKernelRays *	rays
+	);
+	--------------input----------------
+	const RayleighKernelRays *	rays   //attitude, unit shooting directions and output planes of rays->count pixels
+	-----------------------------------
+	-------------output----------------
+	rays->DOP, rays->AOP               //DOP and AOP (unit is degree) of rays->count pixels
+	-----------------------------------
+
+
+Function 3: "RayleighRowClosedFormFloat()" 
+
+    //DOP and AOP of a frame row in single precision (RAYLEIGH_KERNEL_CLOSED_FORM for CameraFrameFloat).
+	void RayleighRowClosedFormFloat(
+		const RayleighKernelRowFloat *	row
+	);
+	--------------input----------------
+	const RayleighKernelRowFloat *	row   //attitude, pixel locations and float output planes of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP                 //DOP and AOP (unit is degree) of row->count pixels, computed in double and rounded
+	-----------------------------------
+
+
+Function 4: "CameraSimulationStokes()" 
+
+    //Normalized Stokes components of a frame without any trigonometric function.
+	void CameraSimulationStokes(
+		const double  psa,
+		const double  afa,
+		const double  beta,
+		const CameraParameters *	parm,
+		const int     Edge,
+		double *	S1,
+		double *	S2
+	);
+	--------------input----------------
+	const double  psa,                 //yaw angle (unit is radian)
+	const double  afa,                 //pitch angle (unit is radian)
+    const double  beta,                //roll angle (unit is radian)
+	const CameraParameters *	parm,  //camera parameters, the ray table is used when it is valid
+	const int     Edge,                //RAYLEIGH_EDGE_LEGACY or RAYLEIGH_EDGE_GEOMETRIC
+	-----------------------------------
+	-------------output----------------
+	double *	S1,                    //S1/S0=DOP*cos(2*AOP) of every simulated pixel, in the layout of CameraFrame
+	double *	S2                     //S2/S0=DOP*sin(2*AOP) of every simulated pixel, in the layout of CameraFrame
+	-----------------------------------
+	DOP=sqrt(S1^2+S2^2) and AOP=atan2(S2,S1)/2 when they are needed.
+
+
+Function 5: "RayleighClosedFormReport()" 
+
+    //Compare RAYLEIGH_KERNEL_CLOSED_FORM with RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+	int RayleighClosedFormReport(
+		CameraParameters *	parm,
+		const int     NumAttitudes,
+		RayleighClosedFormAccuracy &	report
+	);
+	--------------input----------------
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of attitudes: psa=afa=beta=0, afa=pi/2, then the attitudes of "RayleighKernelValidate()"
+	-----------------------------------
+	-------------output----------------
+	RayleighClosedFormAccuracy &	report  //maximum and mean errors overall and on the edge cases, over the pixels inside
+	                                        //the image circle of a lens (NaN in one frame only is an infinite error)
+	int                             //0 if DOP and AOP are within RAYLEIGH_KERNEL_DOP_TOLERANCE and RAYLEIGH_KERNEL_AOP_TOLERANCE, 1 if not, -1 on failure
+	-----------------------------------
+
+
+Function 6: "RayleighClosedFormPrint()" 
+
+    //Print an accuracy report.
+	void RayleighClosedFormPrint(
+		const RayleighClosedFormAccuracy &	report,
+		FILE *	file
+	);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <stdlib.h>
+#include "RayleighClosedForm.h"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+const static double pi = 3.141592653589793;
+
+
+
+//Sun vector in body coordinate system, the third column of C_vTb.
+static void SunVector(
+	const double  C_vTb[3][3],  //rotation matrix from solar vector to body coordinate system
+	double  s[3]                //unit sun vector in body coordinate system
+	){
+	s[0] = C_vTb[0][2];
+	s[1] = C_vTb[1][2];
+	s[2] = C_vTb[2][2];
+}
+
+
+
+//DOP and the x and z components of the E-vector in body coordinate system of a shooting direction.
+static inline void ClosedFormPixel(
+	const RayleighKernelState *	state,  //rotation matrices and DOP_max
+	const double  s[3],                 //unit sun vector in body coordinate system
+	const double  r_x,                  //shooting direction in body coordinate system, any length
+	const double  r_y,
+	const double  r_z,
+	const double  r2,                   //squared length of the shooting direction
+	const bool    axis,                 //whether the legacy E-vector of Vector_v_P[0][0]==0 replaces s x r
+	const double  v_y,                  //Vector_v_P[1][0], only used when axis is set
+	double &	DOP,                    //DOP
+	double &	E_x,                    //E_b_P[0][0] up to sign and length
+	double &	E_z                     //E_b_P[2][0] up to sign and length
+	){
+	//DOP from the cosine of the zenith angle sita_v_P
+	double c = s[0]*r_x+s[1]*r_y+s[2]*r_z;
+	double c2 = c*c/r2;
+	c2 = c2>1.0 ? 1.0 : c2;		//rounding of the rotation
+	DOP = state->DOP_max*(1.0-c2)/(1.0+c2);
+
+	//polarization E-vector perpendicular to the sun vector and the shooting direction
+	E_x = s[1]*r_z-s[2]*r_y;
+	E_z = s[0]*r_y-s[1]*r_x;
+	if(axis){
+		//E_v_P of the quadrant judgement: fi_v_P=pi, -pi or 0
+		double e_x = v_y>0 ? RAYLEIGH_SIN_PI : (v_y<0 ? -RAYLEIGH_SIN_PI : 0.0);
+		double e_y = v_y==0 ? -1.0 : 1.0;
+		E_x = state->C_vTb[0][0]*e_x+state->C_vTb[0][1]*e_y;
+		E_z = state->C_vTb[2][0]*e_x+state->C_vTb[2][1]*e_y;
+	}
+}
+
+
+
+//AOP (unit is degree) of the E-vector components.
+static inline double ClosedFormAOP(
+	const double  DOP,          //DOP
+	const double  E_x,          //E_b_P[0][0] up to sign and length
+	const double  E_z           //E_b_P[2][0] up to sign and length
+	){
+	double AOP = 0.5*atan2(2.0*E_x*E_z,E_z*E_z-E_x*E_x);
+	return DOP==0.0 ? 0.0 : AOP*180/pi;	//Elimination of invalid solution
+}
+
+
+
+//DOP and AOP of a frame row without acos, sin, cos and quadrant judgement, rounded to the scalar type S.
+template <class S>
+static void ClosedFormRow(
+	const RayleighKernelRowOf<S> *	row     //frame row
+	){
+	const RayleighKernelState * state = row->state;
+	double s[3];
+	SunVector(state->C_vTb,s);
+
+	for(int k=0; k<row->count; k++){
+		double P_z = row->D_z*(row->Offset+k*row->Step);
+		if(state->Sky->Model!=SKY_MODEL_RAYLEIGH){
+			//the closed form only exists for the Rayleigh sky
+			double Ray[3] = {row->P_x,row->f,P_z};
+			double DOP, AOP;
+			SkyModelRay(state->Sky,state->C_vTb,state->C_bTv,Ray,DOP,AOP);
+			row->DOP[k] = (S)DOP;
+			row->AOP[k] = (S)AOP;
+			continue;
+		}
+
+		//Vector_v_P summed in the order of "MatrixMultiply()", so that zeros match the scalar code
+		double v_x = 0.0;
+		v_x += state->C_bTv[0][0]*row->P_x;
+		v_x += state->C_bTv[0][1]*row->f;
+		v_x += state->C_bTv[0][2]*P_z;
+		double v_y = 0.0;
+		v_y += state->C_bTv[1][0]*row->P_x;
+		v_y += state->C_bTv[1][1]*row->f;
+		v_y += state->C_bTv[1][2]*P_z;
+
+		double r2 = row->P_x*row->P_x+row->f*row->f+P_z*P_z;
+		double DOP, E_x, E_z;
+		ClosedFormPixel(state,s,row->P_x,row->f,P_z,r2,v_x==0.0,v_y,DOP,E_x,E_z);
+		row->DOP[k] = (S)DOP;
+		row->AOP[k] = (S)ClosedFormAOP(DOP,E_x,E_z);
+	}
+}
+
+
+
+//DOP and AOP of a frame row without acos, sin, cos and quadrant judgement.
+void RayleighRowClosedForm(
+	const RayleighKernelRow *	row     //frame row
+	){
+	ClosedFormRow(row);
+}
+
+
+
+//DOP and AOP of a frame row without acos, sin, cos and quadrant judgement in single precision.
+void RayleighRowClosedFormFloat(
+	const RayleighKernelRowFloat *	row     //frame row
+	){
+	ClosedFormRow(row);
+}
+
+
+
+//DOP and AOP of pixels of a ray table without acos, sin, cos and quadrant judgement.
+void RayleighRaysClosedForm(
+	const RayleighKernelRays *	rays    //pixels of a ray table
+	){
+	const RayleighKernelState * state = rays->state;
+	double s[3];
+	SunVector(state->C_vTb,s);
+
+	for(int k=0; k<rays->count; k++){
+		double r_x = rays->Ray_x[k];
+		double r_y = rays->Ray_y[k];
+		double r_z = rays->Ray_z[k];
+		if(state->Sky->Model!=SKY_MODEL_RAYLEIGH){
+			//the closed form only exists for the Rayleigh sky
+			double Ray[3] = {r_x,r_y,r_z};
+			SkyModelRay(state->Sky,state->C_vTb,state->C_bTv,Ray,rays->DOP[k],rays->AOP[k]);
+			continue;
+		}
+		double v_x = state->C_bTv[0][0]*r_x+state->C_bTv[0][1]*r_y+state->C_bTv[0][2]*r_z;
+		double v_y = state->C_bTv[1][0]*r_x+state->C_bTv[1][1]*r_y+state->C_bTv[1][2]*r_z;
+
+		double E_x, E_z;
+		ClosedFormPixel(state,s,r_x,r_y,r_z,1.0,v_x==0.0,v_y,rays->DOP[k],E_x,E_z);
+		rays->AOP[k] = ClosedFormAOP(rays->DOP[k],E_x,E_z);
+	}
+}
+
+
+
+//Normalized Stokes components of a frame without any trigonometric function.
+void CameraSimulationStokes(
+	const double  psa,                 //yaw angle (unit is radian)
+	const double  afa,                 //pitch angle (unit is radian)
+    const double  beta,                //roll angle (unit is radian)
+	const CameraParameters *	parm,  //camera parameters
+	const int     Edge,                //RAYLEIGH_EDGE_LEGACY or RAYLEIGH_EDGE_GEOMETRIC
+	double *	S1,                    //S1/S0=DOP*cos(2*AOP) of every simulated pixel, in the layout of CameraFrame
+	double *	S2                     //S2/S0=DOP*sin(2*AOP) of every simulated pixel, in the layout of CameraFrame
+	){
+	RayleighKernelState state;
+	double C_vTb[3][3],C_bTv[3][3];
+	CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+	RayleighKernelSky(C_vTb,C_bTv,&parm->Sky,state);
+	bool rayleigh = parm->Sky.Model==SKY_MODEL_RAYLEIGH;
+	double s[3];
+	SunVector(state.C_vTb,s);
+
+	bool table = CameraRayTableValid(parm)!=0;
+	bool pinhole = CameraLensPinhole(&parm->Lens)!=0;
+	size_t n = 0;
+	for(int i_x=1; i_x<=parm->n_x; i_x=i_x+parm->PixelInterval){
+		for(int j_z=1; j_z<=parm->n_z; j_z=j_z+parm->PixelInterval){
+			//shooting direction of pixel P in body coordinate system
+			double r_x, r_y, r_z, r2;
+			if(table){
+				r_x = parm->Ray_x[n];
+				r_y = parm->Ray_y[n];
+				r_z = parm->Ray_z[n];
+				r2 = 1.0;
+			}
+			else if(pinhole){
+				r_x = parm->D_x*(i_x-(parm->n_x+1)/2);
+				r_y = parm->f;
+				r_z = parm->D_z*(j_z-(parm->n_z+1)/2);
+				r2 = r_x*r_x+r_y*r_y+r_z*r_z;
+			}
+			else{
+				double Ray[3];
+				CameraPixelRay(parm,i_x,j_z,Ray);
+				r_x = Ray[0];
+				r_y = Ray[1];
+				r_z = Ray[2];
+				r2 = 1.0;
+			}
+			if(!rayleigh){
+				double Ray[3] = {r_x,r_y,r_z};
+				SkyModelStokes(&parm->Sky,C_vTb,C_bTv,Ray,S1[n],S2[n]);
+				n++;
+				continue;
+			}
+			double v_x = state.C_bTv[0][0]*r_x+state.C_bTv[0][1]*r_y+state.C_bTv[0][2]*r_z;
+			double v_y = state.C_bTv[1][0]*r_x+state.C_bTv[1][1]*r_y+state.C_bTv[1][2]*r_z;
+			bool axis = Edge==RAYLEIGH_EDGE_LEGACY && v_x==0.0;
+
+			double DOP, E_x, E_z;
+			ClosedFormPixel(&state,s,r_x,r_y,r_z,r2,axis,v_y,DOP,E_x,E_z);
+			double E2 = E_x*E_x+E_z*E_z;
+			if(DOP==0.0 || E2==0.0){
+				S1[n] = 0.0;
+				S2[n] = 0.0;
+			}
+			else{
+				S1[n] = DOP*(E_z*E_z-E_x*E_x)/E2;
+				S2[n] = DOP*2.0*E_x*E_z/E2;
+			}
+			n++;
+		}
+	}
+}
+
+
+
+//AOP difference modulo 180 degrees (unit is degree).
+static double AOPDifference(
+	const double  a,            //AOP (unit is degree)
+	const double  b             //AOP (unit is degree)
+	){
+	double d = fmod(fabs(a-b),180.0);
+	return d>90.0 ? 180.0-d : d;
+}
+
+
+
+//Compare RAYLEIGH_KERNEL_CLOSED_FORM with RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+int RayleighClosedFormReport(
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of attitudes
+	RayleighClosedFormAccuracy &	report  //accuracy
+	){
+	report.NumAttitudes = NumAttitudes;
+	report.NumPixels = 0;
+	report.DOPError = 0.0;
+	report.DOPMeanError = 0.0;
+	report.AOPError = 0.0;
+	report.AOPMeanError = 0.0;
+	report.AxisPixels = 0;
+	report.AxisAOPError = 0.0;
+	report.AxisGeometricAOPError = 0.0;
+	report.ZeroDOPPixels = 0;
+	report.ZeroDOPAOPError = 0.0;
+	report.StokesError = 0.0;
+
+	CameraFrame * reference = CameraFrameInit(parm);
+	CameraFrame * frame = CameraFrameInit(parm);
+	size_t PixelNum = reference==NULL ? 0 : (size_t)reference->n_x*reference->n_z;
+	double * S1 = (double *)malloc(PixelNum*sizeof(double));
+	double * S2 = (double *)malloc(PixelNum*sizeof(double));
+	double * G1 = (double *)malloc(PixelNum*sizeof(double));
+	double * G2 = (double *)malloc(PixelNum*sizeof(double));
+	int status = reference==NULL || frame==NULL || S1==NULL || S2==NULL || G1==NULL || G2==NULL ? -1 : 0;
+
+	int kernel = parm->Kernel;
+	unsigned int seed = 12345;
+	for(int n=0; n<NumAttitudes && status==0; n++){
+		//psa=afa=beta=0 (Vector_v_P[0][0]==0 on the centre column), afa=pi/2 (sun on the optical axis),
+		//then the pseudo-random attitudes of "RayleighKernelValidate()"
+		double psa = 0.0;
+		double afa = n==1 ? pi/2 : 0.0;
+		double beta = 0.0;
+		if(n>1){
+			double angle[3];
+			for(int k=0; k<3; k++){
+				seed = seed*1103515245u+12345u;
+				angle[k] = (seed>>8)/16777216.0;
+			}
+			psa = 2*pi*angle[0];
+			afa = pi*(angle[1]-0.5);
+			beta = 2*pi*angle[2];
+		}
+
+		parm->Kernel = RAYLEIGH_KERNEL_SCALAR;
+		CameraSimulationFrame(psa,afa,beta,parm,reference);
+		parm->Kernel = RAYLEIGH_KERNEL_CLOSED_FORM;
+		CameraSimulationFrame(psa,afa,beta,parm,frame);
+		CameraSimulationStokes(psa,afa,beta,parm,RAYLEIGH_EDGE_LEGACY,S1,S2);
+		CameraSimulationStokes(psa,afa,beta,parm,RAYLEIGH_EDGE_GEOMETRIC,G1,G2);
+
+		double C_vTb[3][3], C_bTv[3][3];
+		CameraRotationMatrix(psa,afa,beta,C_vTb,C_bTv);
+
+		size_t i = 0;
+		for(int i_x=1; i_x<=parm->n_x; i_x=i_x+parm->PixelInterval){
+			for(int j_z=1; j_z<=parm->n_z; j_z=j_z+parm->PixelInterval){
+				//Vector_v_P[0][0] of the scalar code
+				double P_x = parm->D_x*(i_x-(parm->n_x+1)/2);
+				double P_y = parm->f;
+				double P_z = parm->D_z*(j_z-(parm->n_z+1)/2);
+				if(!CameraLensPinhole(&parm->Lens)){
+					double Ray[3];
+					CameraPixelRay(parm,i_x,j_z,Ray);
+					P_x = Ray[0];
+					P_y = Ray[1];
+					P_z = Ray[2];
+				}
+				double v_x = 0.0;
+				v_x += C_bTv[0][0]*P_x;
+				v_x += C_bTv[0][1]*P_y;
+				v_x += C_bTv[0][2]*P_z;
+
+				double DOP = reference->DOP[i];
+				double AOP = reference->AOP[i];
+				if(DOP!=DOP || frame->DOP[i]!=frame->DOP[i]){	//outside the image circle of a lens, NaN on one side only counts as a failure
+					if((DOP!=DOP)!=(frame->DOP[i]!=frame->DOP[i])){
+						report.DOPError = HUGE_VAL;
+						report.AOPError = HUGE_VAL;
+					}
+					i++;
+					continue;
+				}
+				double dDOP = fabs(frame->DOP[i]-DOP);
+				double dAOP = AOPDifference(frame->AOP[i],AOP);
+				report.DOPError = dDOP>report.DOPError ? dDOP : report.DOPError;
+				report.AOPError = dAOP>report.AOPError ? dAOP : report.AOPError;
+				report.DOPMeanError += dDOP;
+				report.AOPMeanError += dAOP;
+
+				if(v_x==0.0){
+					report.AxisPixels++;
+					double dGeometric = AOPDifference(0.5*atan2(G2[i],G1[i])*180/pi,AOP);
+					report.AxisAOPError = dAOP>report.AxisAOPError ? dAOP : report.AxisAOPError;
+					report.AxisGeometricAOPError = dGeometric>report.AxisGeometricAOPError ? dGeometric : report.AxisGeometricAOPError;
+				}
+				if(DOP==0.0 || frame->DOP[i]==0.0){
+					report.ZeroDOPPixels++;
+					report.ZeroDOPAOPError = dAOP>report.ZeroDOPAOPError ? dAOP : report.ZeroDOPAOPError;
+				}
+
+				double dS1 = fabs(S1[i]-DOP*cos(2*AOP*pi/180));
+				double dS2 = fabs(S2[i]-DOP*sin(2*AOP*pi/180));
+				double dS = dS1>dS2 ? dS1 : dS2;
+				report.StokesError = dS>report.StokesError ? dS : report.StokesError;
+				report.NumPixels++;
+				i++;
+			}
+		}
+	}
+	parm->Kernel = kernel;
+	if(report.NumPixels>0){
+		report.DOPMeanError /= report.NumPixels;
+		report.AOPMeanError /= report.NumPixels;
+	}
+
+	CameraFrameFree(reference);
+	CameraFrameFree(frame);
+	free(S1);
+	free(S2);
+	free(G1);
+	free(G2);
+	if(status!=0){
+		return status;
+	}
+	return report.DOPError<=RAYLEIGH_KERNEL_DOP_TOLERANCE && report.AOPError<=RAYLEIGH_KERNEL_AOP_TOLERANCE ? 0 : 1;
+}
+
+
+
+//Print an accuracy report.
+void RayleighClosedFormPrint(
+	const RayleighClosedFormAccuracy &	report,  //accuracy
+	FILE *	file                                 //opened text file
+	){
+	fprintf(file,"closed form against the scalar code: %d attitudes, %lu pixels\n",report.NumAttitudes,(unsigned long)report.NumPixels);
+	fprintf(file,"  DOP error              max %.3e  mean %.3e\n",report.DOPError,report.DOPMeanError);
+	fprintf(file,"  AOP error (degree)     max %.3e  mean %.3e\n",report.AOPError,report.AOPMeanError);
+	fprintf(file,"  Vector_v_P[0][0]==0    %lu pixels, AOP error %.3e (legacy edge), %.3e (geometric edge)\n",
+		(unsigned long)report.AxisPixels,report.AxisAOPError,report.AxisGeometricAOPError);
+	fprintf(file,"  DOP==0                 %lu pixels, AOP error %.3e\n",(unsigned long)report.ZeroDOPPixels,report.ZeroDOPAOPError);
+	fprintf(file,"  Stokes error           max %.3e\n",report.StokesError);
+}
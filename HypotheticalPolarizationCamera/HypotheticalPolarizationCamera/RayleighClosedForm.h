@@ -0,0 +1,73 @@
+#ifndef _RAYLEIGHCLOSEDFORM_H_
+#define _RAYLEIGHCLOSEDFORM_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include "RayleighKernel.h"
+
+//conventions for the E-vector of pixels with Vector_v_P[0][0]==0
+#define RAYLEIGH_EDGE_LEGACY        0       //E-vector {+-sin(pi),1,0} or {0,-1,0} in solar vector coordinate system, as "CameraSimulation()"
+#define RAYLEIGH_EDGE_GEOMETRIC     1       //E-vector perpendicular to the sun and the shooting direction, as every other pixel
+
+//accuracy of RAYLEIGH_KERNEL_CLOSED_FORM against RAYLEIGH_KERNEL_SCALAR
+typedef struct RayleighClosedFormAccuracy
+{
+	int     NumAttitudes;       //number of attitudes, the first ones are psa=afa=beta=0 and afa=pi/2
+	size_t  NumPixels;          //number of compared pixels
+
+	double  DOPError;           //maximum absolute DOP difference
+	double  DOPMeanError;       //mean absolute DOP difference
+	double  AOPError;           //maximum AOP difference modulo 180 degrees (unit is degree)
+	double  AOPMeanError;       //mean AOP difference modulo 180 degrees (unit is degree)
+
+	size_t  AxisPixels;         //pixels with Vector_v_P[0][0]==0 in the scalar code
+	double  AxisAOPError;       //maximum AOP difference of these pixels with RAYLEIGH_EDGE_LEGACY (unit is degree)
+	double  AxisGeometricAOPError;  //maximum AOP difference of these pixels with RAYLEIGH_EDGE_GEOMETRIC (unit is degree)
+
+	size_t  ZeroDOPPixels;      //pixels with DOP==0 in the scalar code or in the closed form
+	double  ZeroDOPAOPError;    //maximum AOP difference of these pixels (unit is degree)
+
+	double  StokesError;        //maximum difference of the Stokes components and DOP*cos(2*AOP), DOP*sin(2*AOP) of the scalar code
+}
+RayleighClosedFormAccuracy;
+
+//DOP and AOP of a frame row without acos, sin, cos and quadrant judgement (RAYLEIGH_KERNEL_CLOSED_FORM).
+void RayleighRowClosedForm(
+	const RayleighKernelRow *	row     //frame row
+	);
+
+//DOP and AOP of a frame row in single precision (RAYLEIGH_KERNEL_CLOSED_FORM for CameraFrameFloat).
+void RayleighRowClosedFormFloat(
+	const RayleighKernelRowFloat *	row     //frame row
+	);
+
+//DOP and AOP of pixels of a ray table without acos, sin, cos and quadrant judgement (RAYLEIGH_KERNEL_CLOSED_FORM).
+void RayleighRaysClosedForm(
+	const RayleighKernelRays *	rays    //pixels of a ray table
+	);
+
+//Normalized Stokes components of a frame without any trigonometric function.
+void CameraSimulationStokes(
+	const double  psa,                 //yaw angle (unit is radian)
+	const double  afa,                 //pitch angle (unit is radian)
+    const double  beta,                //roll angle (unit is radian)
+	const CameraParameters *	parm,  //camera parameters
+	const int     Edge,                //RAYLEIGH_EDGE_LEGACY or RAYLEIGH_EDGE_GEOMETRIC
+	double *	S1,                    //S1/S0=DOP*cos(2*AOP) of every simulated pixel, in the layout of CameraFrame
+	double *	S2                     //S2/S0=DOP*sin(2*AOP) of every simulated pixel, in the layout of CameraFrame
+	);
+
+//Compare RAYLEIGH_KERNEL_CLOSED_FORM with RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+int RayleighClosedFormReport(
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of attitudes
+	RayleighClosedFormAccuracy &	report  //accuracy
+	);
+
+//Print an accuracy report.
+void RayleighClosedFormPrint(
+	const RayleighClosedFormAccuracy &	report,  //accuracy
+	FILE *	file                                 //opened text file
+	);
+
+#endif
@@ -0,0 +1,556 @@
+/*
+Kernel dispatch of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for selecting the widest vectorized Rayleigh kernel supported by the processor.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Using the code to pick the kernel of "CameraSimulationFrame()" at runtime through CameraParameters::Kernel and to validate it.
+--------------------------
+
+Kernels:
+	RAYLEIGH_KERNEL_SCALAR    The reference per-pixel code of "CameraSimulation()".
+	RAYLEIGH_KERNEL_SSE2      2 pixels per instruction, 4 in single precision ("RayleighKernelSSE2.cpp").
+	RAYLEIGH_KERNEL_AVX2      4 pixels per instruction, 8 in single precision ("RayleighKernelAVX2.cpp").
+	RAYLEIGH_KERNEL_AVX512    8 pixels per instruction, 16 in single precision ("RayleighKernelAVX512.cpp").
+	RAYLEIGH_KERNEL_AUTO      The widest of them supported by the processor (default of "CameraParametersInit()").
+	RAYLEIGH_KERNEL_CLOSED_FORM  Scalar algebraic code of "RayleighClosedForm.cpp" (one atan2 per pixel), on every processor.
+
+	The vectorized kernels generate the pixel locations of a row, rotate them with C_bTv, normalize them and
+	evaluate DOP and AOP for a whole register of pixels. With the ray table of "CameraRayTableInit()" they only
+	rotate the stored unit directions, which skips the pixel geometry and the normalization. They use the identities
+		sin(sita_v_P)^2/(1+cos(sita_v_P)^2) = (1-c^2)/(1+c^2),  c = Vector_v_P[2][0]/|Vector_v_P|
+		{sin(fi_v_P),-cos(fi_v_P),0} = {Vector_v_P[1][0],-Vector_v_P[0][0],0}/|{Vector_v_P[0][0],Vector_v_P[1][0]}|
+	instead of acos, sin, cos and the quadrant judgement, and a vectorized atan for AOP.
+	Against RAYLEIGH_KERNEL_SCALAR, DOP differs by less than RAYLEIGH_KERNEL_DOP_TOLERANCE and AOP by less than
+	RAYLEIGH_KERNEL_AOP_TOLERANCE degrees modulo 180 degrees (AOP=+-90 degrees are the same polarization direction).
+	At the anti-solar point the reference DOP is 1.5e-32 instead of 0, so only the kernels eliminate its AOP.
+
+Single precision:
+	Frames of type CameraFrameFloat ("PolarizationCamera.h") are simulated by the same template instantiated for
+	float vectors, so each instruction handles twice as many pixels and the planes take half the memory. The
+	rotation matrices and the pixel geometry of a row are prepared in double and rounded once. The scalar code
+	computes in double and rounds the results. "RayleighKernelValidateFloat()" measures the error against the
+	double reference; it is below RAYLEIGH_FLOAT_DOP_TOLERANCE in DOP and RAYLEIGH_FLOAT_AOP_TOLERANCE degrees in
+	AOP. AOP errors are largest where the E-vector is nearly parallel to the y axis of the body. Single precision
+	frames through a lens other than the pinhole rotate the float copy of the ray table with the kernels of
+	"RayleighKernelRaysFloatFunction()".
+
+Sky models:
+	The vectorized kernels are templates over the sky models of SkyModel.h (VectorSkyRayleigh, VectorSkyBerry and
+	VectorSkyTable in "RayleighKernelSimd.h"). Each kernel function picks the instance of state->Sky->Model once per
+	row or block of rays, so no pixel goes through a function pointer and every model keeps its loop in registers.
+	The table model gathers its nodes lane by lane between two vector steps. RAYLEIGH_KERNEL_SCALAR evaluates the
+	other models with "SkyModelPixel()", and RAYLEIGH_KERNEL_CLOSED_FORM, which is algebra of the Rayleigh sky only,
+	falls back to it as well. Against it the vectorized Berry and table models stay within
+	SKY_MODEL_DOP_TOLERANCE and SKY_MODEL_AOP_TOLERANCE, which "RayleighKernelValidate()" applies to them, and
+	"RayleighKernelValidateFloat()" applies SKY_MODEL_FLOAT_DOP_TOLERANCE and SKY_MODEL_FLOAT_AOP_TOLERANCE.
+
+
+Function 1: "RayleighKernelFunction()" 
+
+    //Kernel of a kernel type for frame rows, NULL for RAYLEIGH_KERNEL_SCALAR.
+	RayleighRowFunction RayleighKernelFunction(
+		const int     type
+	);
+	--------------input----------------
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	-----------------------------------
+	-------------output----------------
+	RayleighRowFunction         //kernel evaluating a frame row, NULL if the scalar code has to be used
+	-----------------------------------
+
+
+Function 2: "RayleighKernelRaysFunction()" 
+
+    //Kernel of a kernel type for ray tables, NULL for RAYLEIGH_KERNEL_SCALAR.
+	RayleighRaysFunction RayleighKernelRaysFunction(
+		const int     type
+	);
+	--------------input----------------
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	-----------------------------------
+	-------------output----------------
+	RayleighRaysFunction        //kernel evaluating unit shooting directions of "CameraRayTableInit()", NULL for the scalar code
+	-----------------------------------
+
+
+Function 3: "RayleighKernelFloatFunction()" 
+
+    //Single precision kernel of a kernel type for frame rows, NULL for RAYLEIGH_KERNEL_SCALAR.
+	RayleighRowFloatFunction RayleighKernelFloatFunction(
+		const int     type
+	);
+	--------------input----------------
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	-----------------------------------
+	-------------output----------------
+	RayleighRowFloatFunction    //kernel evaluating a frame row into float planes, NULL if the scalar code has to be used
+	-----------------------------------
+
+
+Function 4: "RayleighKernelResolve()" 
+
+    //Kernel type used for a requested kernel type on this processor.
+	int RayleighKernelResolve(
+		const int     type
+	);
+
+
+Function 5: "RayleighKernelName()" 
+
+    //Name of a kernel type.
+	const char * RayleighKernelName(
+		const int     type
+	);
+
+
+Function 6: "RayleighKernelValidate()" 
+
+    //Compare a kernel with RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+	int RayleighKernelValidate(
+		const int     type,
+		CameraParameters *	parm,
+		const int     NumAttitudes,
+		double &	DOPError,
+		double &	AOPError
+	);
+	--------------input----------------
+	const int     type,             //kernel type
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of pseudo-random attitudes
+	-----------------------------------
+	-------------output----------------
+	double &	DOPError,           //maximum absolute DOP difference
+	double &	AOPError            //maximum AOP difference modulo 180 degrees (unit is degree)
+	int                             //0 if both are within the documented tolerance, 1 if not, -1 on failure
+	-----------------------------------
+
+
+Function 7: "RayleighKernelValidateFloat()" 
+
+    //Compare the single precision frames of a kernel with double frames of RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+	int RayleighKernelValidateFloat(
+		const int     type,
+		CameraParameters *	parm,
+		const int     NumAttitudes,
+		double &	DOPError,
+		double &	AOPError
+	);
+	--------------input----------------
+	const int     type,             //kernel type, also RAYLEIGH_KERNEL_SCALAR (double code rounded to float)
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of attitudes: psa=afa=beta=0, then the attitudes of "RayleighKernelValidate()"
+	-----------------------------------
+	-------------output----------------
+	double &	DOPError,           //maximum absolute DOP difference
+	double &	AOPError            //maximum AOP difference modulo 180 degrees (unit is degree)
+	int                             //0 if both are within the float tolerance of the sky model, 1 if not, -1 on failure
+	-----------------------------------
+
+
+Function 8: "RayleighKernelRaysFloatFunction()" 
+
+    //Single precision kernel of a kernel type for ray tables, NULL for the scalar kernel types.
+	RayleighRaysFloatFunction RayleighKernelRaysFloatFunction(
+		const int     type
+	);
+	--------------input----------------
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	-----------------------------------
+	-------------output----------------
+	RayleighRaysFloatFunction   //kernel evaluating the float unit shooting directions of "CameraRayTableInit()" into
+	                            //float planes, NULL for RAYLEIGH_KERNEL_SCALAR and RAYLEIGH_KERNEL_CLOSED_FORM
+	-----------------------------------
+
+
+Function 9: "RayleighKernelSky()" 
+
+    //Rotation matrices and sky model of a kernel state.
+	void RayleighKernelSky(
+		const double  (&C_vTb)[3][3],
+		const double  (&C_bTv)[3][3],
+		const SkyModel *	sky,
+		RayleighKernelState &	state
+	);
+	--------------input----------------
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const SkyModel *	sky            //sky model, it has to outlive the state
+	-----------------------------------
+	-------------output----------------
+	RayleighKernelState &	state      //attitude and sky of the kernels, with the constants of the sky model
+	-----------------------------------
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include "RayleighKernel.h"
+#include "RayleighClosedForm.h"
+
+#if defined(RAYLEIGH_KERNEL_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+
+
+//Whether the processor and the operating system support a kernel type.
+static bool KernelSupported(
+	const int     type          //kernel type
+	){
+	if(type==RAYLEIGH_KERNEL_SCALAR || type==RAYLEIGH_KERNEL_CLOSED_FORM){
+		return true;
+	}
+#if defined(RAYLEIGH_KERNEL_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info,0);
+	int max = info[0];
+	__cpuid(info,1);
+	bool sse2 = (info[3]&(1<<26))!=0;
+	bool osxsave = (info[2]&(1<<27))!=0;
+	bool avx = (info[2]&(1<<28))!=0;
+	unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	bool avx2 = false;
+	bool avx512 = false;
+	if(max>=7){
+		__cpuidex(info,7,0);
+		avx2 = avx && (xcr0&0x6)==0x6 && (info[1]&(1<<5))!=0;
+		avx512 = (xcr0&0xe6)==0xe6 && (info[1]&(1<<16))!=0;
+	}
+	switch(type){
+	case RAYLEIGH_KERNEL_SSE2:   return sse2;
+	case RAYLEIGH_KERNEL_AVX2:   return avx2;
+	case RAYLEIGH_KERNEL_AVX512: return avx512;
+	}
+#elif defined(RAYLEIGH_KERNEL_X86)
+	__builtin_cpu_init();
+	switch(type){
+	case RAYLEIGH_KERNEL_SSE2:   return __builtin_cpu_supports("sse2")!=0;
+	case RAYLEIGH_KERNEL_AVX2:   return __builtin_cpu_supports("avx2")!=0;
+	case RAYLEIGH_KERNEL_AVX512: return __builtin_cpu_supports("avx512f")!=0;
+	}
+#endif
+	return false;
+}
+
+
+
+//Rotation matrices and sky model of a kernel state.
+void RayleighKernelSky(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const SkyModel *	sky,           //sky model
+	RayleighKernelState &	state      //attitude and sky
+	){
+	for(int i=0; i<3; i++){
+		for(int j=0; j<3; j++){
+			state.C_vTb[i][j] = C_vTb[i][j];
+			state.C_bTv[i][j] = C_bTv[i][j];
+		}
+	}
+	state.DOP_max = sky->DOP_max;	//maximum DOP in the sky
+	state.Sky = sky;
+	double A = tan(sky->NeutralPoint*3.141592653589793/360.0);
+	state.NeutralPoint = A*A;
+}
+
+
+
+//Kernel type used for a requested kernel type on this processor.
+int RayleighKernelResolve(
+	const int     type          //kernel type
+	){
+	//Supported types only change with the processor, so they are detected once.
+	static const int widest = KernelSupported(RAYLEIGH_KERNEL_AVX512) ? RAYLEIGH_KERNEL_AVX512
+		: KernelSupported(RAYLEIGH_KERNEL_AVX2) ? RAYLEIGH_KERNEL_AVX2
+		: KernelSupported(RAYLEIGH_KERNEL_SSE2) ? RAYLEIGH_KERNEL_SSE2
+		: RAYLEIGH_KERNEL_SCALAR;
+
+	if(type==RAYLEIGH_KERNEL_CLOSED_FORM){
+		return type;
+	}
+	if(type==RAYLEIGH_KERNEL_AUTO || type>widest){
+		return widest;
+	}
+	return type<RAYLEIGH_KERNEL_SCALAR ? RAYLEIGH_KERNEL_SCALAR : type;
+}
+
+
+
+//Kernel of a kernel type for frame rows, NULL for RAYLEIGH_KERNEL_SCALAR.
+RayleighRowFunction RayleighKernelFunction(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	){
+	switch(RayleighKernelResolve(type)){
+	case RAYLEIGH_KERNEL_CLOSED_FORM: return RayleighRowClosedForm;
+#ifdef RAYLEIGH_KERNEL_X86
+	case RAYLEIGH_KERNEL_SSE2:   return RayleighRowSSE2;
+	case RAYLEIGH_KERNEL_AVX2:   return RayleighRowAVX2;
+	case RAYLEIGH_KERNEL_AVX512: return RayleighRowAVX512;
+#endif
+	}
+	return NULL;
+}
+
+
+
+//Kernel of a kernel type for ray tables, NULL for RAYLEIGH_KERNEL_SCALAR.
+RayleighRaysFunction RayleighKernelRaysFunction(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	){
+	switch(RayleighKernelResolve(type)){
+	case RAYLEIGH_KERNEL_CLOSED_FORM: return RayleighRaysClosedForm;
+#ifdef RAYLEIGH_KERNEL_X86
+	case RAYLEIGH_KERNEL_SSE2:   return RayleighRaysSSE2;
+	case RAYLEIGH_KERNEL_AVX2:   return RayleighRaysAVX2;
+	case RAYLEIGH_KERNEL_AVX512: return RayleighRaysAVX512;
+#endif
+	}
+	return NULL;
+}
+
+
+
+//Single precision kernel of a kernel type for frame rows, NULL for RAYLEIGH_KERNEL_SCALAR.
+RayleighRowFloatFunction RayleighKernelFloatFunction(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	){
+	switch(RayleighKernelResolve(type)){
+	case RAYLEIGH_KERNEL_CLOSED_FORM: return RayleighRowClosedFormFloat;
+#ifdef RAYLEIGH_KERNEL_X86
+	case RAYLEIGH_KERNEL_SSE2:   return RayleighRowFloatSSE2;
+	case RAYLEIGH_KERNEL_AVX2:   return RayleighRowFloatAVX2;
+	case RAYLEIGH_KERNEL_AVX512: return RayleighRowFloatAVX512;
+#endif
+	}
+	return NULL;
+}
+
+
+
+//Single precision kernel of a kernel type for ray tables, NULL for the scalar kernel types.
+RayleighRaysFloatFunction RayleighKernelRaysFloatFunction(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	){
+	switch(RayleighKernelResolve(type)){
+#ifdef RAYLEIGH_KERNEL_X86
+	case RAYLEIGH_KERNEL_SSE2:   return RayleighRaysFloatSSE2;
+	case RAYLEIGH_KERNEL_AVX2:   return RayleighRaysFloatAVX2;
+	case RAYLEIGH_KERNEL_AVX512: return RayleighRaysFloatAVX512;
+#endif
+	}
+	return NULL;
+}
+
+
+
+//Name of a kernel type.
+const char * RayleighKernelName(
+	const int     type          //kernel type
+	){
+	switch(type){
+	case RAYLEIGH_KERNEL_AUTO:   return "auto";
+	case RAYLEIGH_KERNEL_SCALAR: return "scalar";
+	case RAYLEIGH_KERNEL_SSE2:   return "sse2";
+	case RAYLEIGH_KERNEL_AVX2:   return "avx2";
+	case RAYLEIGH_KERNEL_AVX512: return "avx512";
+	case RAYLEIGH_KERNEL_CLOSED_FORM: return "closed-form";
+	}
+	return "unknown";
+}
+
+
+
+//Pseudo-random attitude n of the validation sweeps (linear congruential generator, reproducible on every platform).
+static void ValidationAttitude(
+	unsigned int &	seed,       //state of the generator
+	double &	psa,            //yaw angle (unit is radian)
+	double &	afa,            //pitch angle (unit is radian)
+	double &	beta            //roll angle (unit is radian)
+	){
+	const double pi = 3.141592653589793;
+	double angle[3];
+	for(int k=0; k<3; k++){
+		seed = seed*1103515245u+12345u;
+		angle[k] = (seed>>8)/16777216.0;
+	}
+	psa = 2*pi*angle[0];
+	afa = pi*(angle[1]-0.5);
+	beta = 2*pi*angle[2];
+}
+
+
+
+//Accumulate the maximum DOP and AOP differences of a frame against a double reference frame.
+template <class S>
+static void FrameErrors(
+	const CameraFrame *	reference,  //reference frame
+	const CameraFrameOf<S> *	frame,  //compared frame
+	double &	DOPError,           //maximum absolute DOP difference
+	double &	AOPError            //maximum AOP difference modulo 180 degrees (unit is degree)
+	){
+	size_t PixelNum = (size_t)frame->n_x*frame->n_z;
+	for(size_t i=0; i<PixelNum; i++){
+		double DOP = frame->DOP[i];
+		double AOP = frame->AOP[i];
+		double dDOP = fabs(DOP-reference->DOP[i]);
+		double dAOP = fabs(AOP-reference->AOP[i]);
+		if(dAOP>90.0){
+			dAOP = 180.0-dAOP;
+		}
+		if(dDOP!=dDOP || dAOP!=dAOP){	//NaN on one side only counts as a failure
+			bool same = (DOP!=DOP)==(reference->DOP[i]!=reference->DOP[i])
+				&& (AOP!=AOP)==(reference->AOP[i]!=reference->AOP[i]);
+			dDOP = same ? 0.0 : HUGE_VAL;
+			dAOP = same ? 0.0 : HUGE_VAL;
+		}
+		if(dDOP>DOPError){
+			DOPError = dDOP;
+		}
+		if(dAOP>AOPError){
+			AOPError = dAOP;
+		}
+	}
+}
+
+
+
+//Compare a kernel with RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+int RayleighKernelValidate(
+	const int     type,             //kernel type
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of pseudo-random attitudes
+	double &	DOPError,           //maximum absolute DOP difference
+	double &	AOPError            //maximum AOP difference modulo 180 degrees (unit is degree)
+	){
+	DOPError = 0.0;
+	AOPError = 0.0;
+
+	CameraFrame * reference = CameraFrameInit(parm);
+	CameraFrame * frame = CameraFrameInit(parm);
+	if(reference==NULL || frame==NULL){
+		CameraFrameFree(reference);
+		CameraFrameFree(frame);
+		return -1;
+	}
+
+	int kernel = parm->Kernel;
+	unsigned int seed = 12345;
+	for(int n=0; n<NumAttitudes; n++){
+		double psa, afa, beta;
+		ValidationAttitude(seed,psa,afa,beta);
+
+		parm->Kernel = RAYLEIGH_KERNEL_SCALAR;
+		CameraSimulationFrame(psa,afa,beta,parm,reference);	//through a lens the reference shares the ray table
+		parm->Kernel = type;
+		CameraSimulationFrame(psa,afa,beta,parm,frame);
+		FrameErrors(reference,frame,DOPError,AOPError);
+	}
+	parm->Kernel = kernel;
+
+	CameraFrameFree(reference);
+	CameraFrameFree(frame);
+	if(parm->Sky.Model!=SKY_MODEL_RAYLEIGH){
+		return DOPError<=SKY_MODEL_DOP_TOLERANCE && AOPError<=SKY_MODEL_AOP_TOLERANCE ? 0 : 1;
+	}
+	return DOPError<=RAYLEIGH_KERNEL_DOP_TOLERANCE && AOPError<=RAYLEIGH_KERNEL_AOP_TOLERANCE ? 0 : 1;
+}
+
+
+
+//Compare the single precision frames of a kernel with double frames of RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+int RayleighKernelValidateFloat(
+	const int     type,             //kernel type
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of pseudo-random attitudes
+	double &	DOPError,           //maximum absolute DOP difference
+	double &	AOPError            //maximum AOP difference modulo 180 degrees (unit is degree)
+	){
+	DOPError = 0.0;
+	AOPError = 0.0;
+
+	CameraFrame * reference = CameraFrameInit(parm);
+	CameraFrameFloat * frame = CameraFrameFloatInit(parm);
+	if(reference==NULL || frame==NULL){
+		CameraFrameFree(reference);
+		CameraFrameFree(frame);
+		return -1;
+	}
+
+	int kernel = parm->Kernel;
+	unsigned int seed = 12345;
+	for(int n=0; n<NumAttitudes; n++){
+		//psa=afa=beta=0 first, it has pixels with Vector_v_P[0][0]==0
+		double psa = 0.0;
+		double afa = 0.0;
+		double beta = 0.0;
+		if(n>0){
+			ValidationAttitude(seed,psa,afa,beta);
+		}
+
+		parm->Kernel = RAYLEIGH_KERNEL_SCALAR;
+		CameraSimulationFrame(psa,afa,beta,parm,reference);
+		parm->Kernel = type;
+		CameraSimulationFrame(psa,afa,beta,parm,frame);
+		FrameErrors(reference,frame,DOPError,AOPError);
+	}
+	parm->Kernel = kernel;
+
+	CameraFrameFree(reference);
+	CameraFrameFree(frame);
+	if(parm->Sky.Model!=SKY_MODEL_RAYLEIGH){
+		return DOPError<=SKY_MODEL_FLOAT_DOP_TOLERANCE && AOPError<=SKY_MODEL_FLOAT_AOP_TOLERANCE ? 0 : 1;
+	}
+	return DOPError<=RAYLEIGH_FLOAT_DOP_TOLERANCE && AOPError<=RAYLEIGH_FLOAT_AOP_TOLERANCE ? 0 : 1;
+}
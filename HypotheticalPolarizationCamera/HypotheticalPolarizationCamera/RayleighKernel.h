@@ -0,0 +1,166 @@
+#ifndef _RAYLEIGHKERNEL_H_
+#define _RAYLEIGHKERNEL_H_
+
+#include "PolarizationCamera.h"
+
+//kernel types of CameraParameters::Kernel
+#define RAYLEIGH_KERNEL_AUTO        0       //widest instruction set supported by the processor
+#define RAYLEIGH_KERNEL_SCALAR      1       //reference scalar code (acos, quadrant judgement, atan)
+#define RAYLEIGH_KERNEL_SSE2        2       //2 pixels per instruction (4 in single precision)
+#define RAYLEIGH_KERNEL_AVX2        3       //4 pixels per instruction (8 in single precision)
+#define RAYLEIGH_KERNEL_AVX512      4       //8 pixels per instruction (16 in single precision)
+#define RAYLEIGH_KERNEL_CLOSED_FORM 5       //scalar algebraic code without acos, sin, cos and quadrant judgement (see RayleighClosedForm.h)
+
+//Tolerance of the vectorized kernels against RAYLEIGH_KERNEL_SCALAR.
+//The kernels evaluate DOP=DOP_max*(1-c*c)/(1+c*c) with c=cos(sita_v_P) and AOP from the E-vector
+//(Vector_v_P[1][0],-Vector_v_P[0][0],0), which equal the reference formulas without acos, sin, cos and the first atan.
+#define RAYLEIGH_KERNEL_DOP_TOLERANCE   1e-13   //maximum absolute DOP difference
+#define RAYLEIGH_KERNEL_AOP_TOLERANCE   1e-10   //maximum AOP difference modulo 180 degrees (unit is degree)
+
+//Tolerance of the single precision frames against RAYLEIGH_KERNEL_SCALAR (see "RayleighKernelValidateFloat()").
+//The vectorized float kernels stay below 2.5e-7 in DOP and 6e-3 degree in AOP over 300 attitudes, the AOP error
+//being largest next to the sun and the anti-sun point where DOP vanishes.
+#define RAYLEIGH_FLOAT_DOP_TOLERANCE    1e-6    //maximum absolute DOP difference
+#define RAYLEIGH_FLOAT_AOP_TOLERANCE    2e-2    //maximum AOP difference modulo 180 degrees (unit is degree)
+
+//Tolerance of the vectorized kernels against RAYLEIGH_KERNEL_SCALAR for SKY_MODEL_BERRY and SKY_MODEL_TABLE.
+//The reference evaluates these models with acos, atan2 and complex arithmetic (see "SkyModelPixel()"), the kernels
+//with the algebra of "RayleighKernelSimd.h", so the rounding differs more than for the Rayleigh sky.
+#define SKY_MODEL_DOP_TOLERANCE         1e-12   //maximum absolute DOP difference
+#define SKY_MODEL_AOP_TOLERANCE         1e-6    //maximum AOP difference modulo 180 degrees (unit is degree)
+
+//Tolerance of the single precision frames of SKY_MODEL_BERRY and SKY_MODEL_TABLE (see "RayleighKernelValidateFloat()").
+//The AOP error is largest next to the neutral points, where DOP vanishes as well.
+#define SKY_MODEL_FLOAT_DOP_TOLERANCE   1e-6    //maximum absolute DOP difference
+#define SKY_MODEL_FLOAT_AOP_TOLERANCE   1e-1    //maximum AOP difference modulo 180 degrees (unit is degree)
+
+//sin(pi) of the reference code in double precision, the x component of its E-vector when Vector_v_P[0][0]==0
+#define RAYLEIGH_SIN_PI             1.2246467991473532e-16
+
+//attitude and sky of a vectorized kernel, filled by "RayleighKernelSky()"
+typedef struct RayleighKernelState
+{
+	double  C_vTb[3][3];    //rotation matrix from solar vector to body coordinate system
+	double  C_bTv[3][3];    //rotation matrix from body to solar vector coordinate system
+	double  DOP_max;        //maximum DOP in the sky
+	const SkyModel *	Sky;    //sky model (see SkyModel.h), selects the template instance of the vectorized kernels
+	double  NeutralPoint;   //tan(Sky->NeutralPoint/2)^2 of SKY_MODEL_BERRY
+}
+RayleighKernelState;
+
+//one frame row for a vectorized kernel, with DOP and AOP of scalar type S (double or float)
+//Pixel k of the row has Vector_b_PaF = {P_x, f, D_z*(Offset+k*Step)}, matching "CameraSimulation()".
+template <class S>
+struct RayleighKernelRowOf
+{
+	const RayleighKernelState *	state;  //attitude and sky
+
+	double  P_x;            //location of the row in pixel coordinate system (unit is millimeter)
+	double  f;              //Focus of the camera (unit is millimeter)
+	double  D_z;            //Unit cell size of CCD or COMS (unit is millimeter)
+	double  Offset;         //j_z-(n_z+1)/2 of the first pixel
+	double  Step;           //PixelInterval
+
+	int     count;          //number of pixels
+	S *     DOP;            //DOP of the pixels
+	S *     AOP;            //AOP of the pixels (unit is degree)
+};
+typedef RayleighKernelRowOf<double> RayleighKernelRow;
+typedef RayleighKernelRowOf<float> RayleighKernelRowFloat;
+
+//pixels of a ray table for a vectorized kernel, with shooting directions, DOP and AOP of scalar type S (double or float)
+template <class S>
+struct RayleighKernelRaysOf
+{
+	const RayleighKernelState *	state;  //attitude and sky
+
+	const S *Ray_x;         //unit shooting directions in body coordinate system
+	const S *Ray_y;
+	const S *Ray_z;
+
+	int     count;          //number of pixels
+	S *     DOP;            //DOP of the pixels
+	S *     AOP;            //AOP of the pixels (unit is degree)
+};
+typedef RayleighKernelRaysOf<double> RayleighKernelRays;
+typedef RayleighKernelRaysOf<float> RayleighKernelRaysFloat;
+
+typedef void (*RayleighRowFunction)(const RayleighKernelRow * row);
+typedef void (*RayleighRaysFunction)(const RayleighKernelRays * rays);
+typedef void (*RayleighRowFloatFunction)(const RayleighKernelRowFloat * row);
+typedef void (*RayleighRaysFloatFunction)(const RayleighKernelRaysFloat * rays);
+
+//Kernel of a kernel type for frame rows, NULL for RAYLEIGH_KERNEL_SCALAR.
+RayleighRowFunction RayleighKernelFunction(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	);
+
+//Kernel of a kernel type for ray tables, NULL for RAYLEIGH_KERNEL_SCALAR.
+RayleighRaysFunction RayleighKernelRaysFunction(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	);
+
+//Single precision kernel of a kernel type for frame rows, NULL for RAYLEIGH_KERNEL_SCALAR.
+RayleighRowFloatFunction RayleighKernelFloatFunction(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	);
+
+//Single precision kernel of a kernel type for ray tables, NULL for the scalar kernel types.
+RayleighRaysFloatFunction RayleighKernelRaysFloatFunction(
+	const int     type          //kernel type, unsupported types fall back to narrower ones
+	);
+
+//Rotation matrices and sky model of a kernel state.
+void RayleighKernelSky(
+	const double  (&C_vTb)[3][3],      //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],      //rotation matrix from body to solar vector coordinate system
+	const SkyModel *	sky,           //sky model
+	RayleighKernelState &	state      //attitude and sky
+	);
+
+//Kernel type used for a requested kernel type on this processor.
+int RayleighKernelResolve(
+	const int     type          //kernel type
+	);
+
+//Name of a kernel type.
+const char * RayleighKernelName(
+	const int     type          //kernel type
+	);
+
+//Compare a kernel with RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+int RayleighKernelValidate(
+	const int     type,             //kernel type
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of pseudo-random attitudes
+	double &	DOPError,           //maximum absolute DOP difference
+	double &	AOPError            //maximum AOP difference modulo 180 degrees (unit is degree)
+	);
+
+//Compare the single precision frames of a kernel with double frames of RAYLEIGH_KERNEL_SCALAR over a sweep of attitudes.
+int RayleighKernelValidateFloat(
+	const int     type,             //kernel type
+	CameraParameters *	parm,       //camera parameters
+	const int     NumAttitudes,     //number of pseudo-random attitudes
+	double &	DOPError,           //maximum absolute DOP difference
+	double &	AOPError            //maximum AOP difference modulo 180 degrees (unit is degree)
+	);
+
+//vectorized kernels of the instruction sets, only present on x86 processors
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define RAYLEIGH_KERNEL_X86
+void RayleighRowSSE2(const RayleighKernelRow * row);
+void RayleighRowAVX2(const RayleighKernelRow * row);
+void RayleighRowAVX512(const RayleighKernelRow * row);
+void RayleighRaysSSE2(const RayleighKernelRays * rays);
+void RayleighRaysAVX2(const RayleighKernelRays * rays);
+void RayleighRaysAVX512(const RayleighKernelRays * rays);
+void RayleighRowFloatSSE2(const RayleighKernelRowFloat * row);
+void RayleighRowFloatAVX2(const RayleighKernelRowFloat * row);
+void RayleighRowFloatAVX512(const RayleighKernelRowFloat * row);
+void RayleighRaysFloatSSE2(const RayleighKernelRaysFloat * rays);
+void RayleighRaysFloatAVX2(const RayleighKernelRaysFloat * rays);
+void RayleighRaysFloatAVX512(const RayleighKernelRaysFloat * rays);
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+/*
+AVX2 kernel of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for evaluating the Rayleigh sky model for 4 pixels (double) or 8 pixels (float) per AVX2 instruction.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Using the code through "RayleighKernelFunction()", "RayleighKernelRaysFunction()", "RayleighKernelFloatFunction()" and
+"RayleighKernelRaysFloatFunction()", which only return it when the processor supports AVX2.
+--------------------------
+
+Function 1: "RayleighRowAVX2()" 
+
+    //DOP and AOP of a frame row.
+	void RayleighRowAVX2(
+		const RayleighKernelRow *	row
+	);
+	--------------input----------------
+	const RayleighKernelRow *	row    //attitude, pixel locations and output planes of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP                 //DOP and AOP (unit is degree) of row->count pixels
+	-----------------------------------
+
+
+Function 2: "RayleighRaysAVX2()" 
+
+    //DOP and AOP of pixels of a ray table.
+	void RayleighRaysAVX2(
+		const RayleighKernelRays *	rays
+	);
+	--------------input----------------
+	const RayleighKernelRays *	rays   //attitude, unit shooting directions and output planes of rays->count pixels
+	-----------------------------------
+	-------------output----------------
+	rays->DOP, rays->AOP               //DOP and AOP (unit is degree) of rays->count pixels
+	-----------------------------------
+
+
+Function 3: "RayleighRowFloatAVX2()" 
+
+    //DOP and AOP of a frame row in single precision, 8 pixels per instruction.
+	void RayleighRowFloatAVX2(
+		const RayleighKernelRowFloat *	row
+	);
+	--------------input----------------
+	const RayleighKernelRowFloat *	row   //attitude, pixel locations and float output planes of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP                 //DOP and AOP (unit is degree) of row->count pixels
+	-----------------------------------
+
+
+Function 4: "RayleighRaysFloatAVX2()" 
+
+    //DOP and AOP of pixels of the float ray table, 8 pixels per instruction.
+	void RayleighRaysFloatAVX2(
+		const RayleighKernelRaysFloat *	rays
+	);
+	--------------input----------------
+	const RayleighKernelRaysFloat *	rays //attitude, unit shooting directions and float output planes of rays->count pixels
+	-----------------------------------
+	-------------output----------------
+	rays->DOP, rays->AOP               //DOP and AOP (unit is degree) of rays->count pixels
+	-----------------------------------
+
+
+Function 5: "DemosaicRowAVX2()" 
+
+    //Interpolation, Stokes components, DOP and AOP of a demosaicked frame row, 8 pixels per instruction.
+	void DemosaicRowAVX2(
+		const DemosaicRow *	row
+	);
+	--------------input----------------
+	const DemosaicRow *	row            //padded band rows, weights and outputs of a frame row (see CameraDemosaic.h)
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP, row->S0, row->S1, row->S2   //row->count values each
+	-----------------------------------
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include "RayleighKernel.h"
+#include "CameraDemosaic.h"
+
+#ifdef RAYLEIGH_KERNEL_X86
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx2")
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace {
+
+//four doubles in an AVX register
+struct VectorAVX2
+{
+	typedef double S;
+	typedef __m256d T;
+	typedef __m256d M;
+	enum { Width = 4 };
+
+	static T Set(double a)                 { return _mm256_set1_pd(a); }
+	static T Load(const double * p)        { return _mm256_loadu_pd(p); }
+	static void Store(double * p, T a)     { _mm256_storeu_pd(p,a); }
+	static T Index()                       { return _mm256_set_pd(3.0,2.0,1.0,0.0); }
+	static T Add(T a, T b)                 { return _mm256_add_pd(a,b); }
+	static T Sub(T a, T b)                 { return _mm256_sub_pd(a,b); }
+	static T Mul(T a, T b)                 { return _mm256_mul_pd(a,b); }
+	static T Div(T a, T b)                 { return _mm256_div_pd(a,b); }
+	static T Sqrt(T a)                     { return _mm256_sqrt_pd(a); }
+	static T Abs(T a)                      { return _mm256_andnot_pd(_mm256_set1_pd(-0.0),a); }
+	static T Sign(T a)                     { return _mm256_and_pd(_mm256_set1_pd(-0.0),a); }
+	static T Xor(T a, T b)                 { return _mm256_xor_pd(a,b); }
+	static M CmpGT(T a, T b)               { return _mm256_cmp_pd(a,b,_CMP_GT_OQ); }
+	static M CmpEQ(T a, T b)               { return _mm256_cmp_pd(a,b,_CMP_EQ_OQ); }
+	static T Select(T a, T b, M m)         { return _mm256_blendv_pd(a,b,m); }
+};
+
+//eight floats in an AVX register
+struct VectorAVX2Float
+{
+	typedef float S;
+	typedef __m256 T;
+	typedef __m256 M;
+	enum { Width = 8 };
+
+	static T Set(double a)                 { return _mm256_set1_ps((float)a); }
+	static T Load(const float * p)         { return _mm256_loadu_ps(p); }
+	static void Store(float * p, T a)      { _mm256_storeu_ps(p,a); }
+	static T Index()                       { return _mm256_set_ps(7.0f,6.0f,5.0f,4.0f,3.0f,2.0f,1.0f,0.0f); }
+	static T Add(T a, T b)                 { return _mm256_add_ps(a,b); }
+	static T Sub(T a, T b)                 { return _mm256_sub_ps(a,b); }
+	static T Mul(T a, T b)                 { return _mm256_mul_ps(a,b); }
+	static T Div(T a, T b)                 { return _mm256_div_ps(a,b); }
+	static T Sqrt(T a)                     { return _mm256_sqrt_ps(a); }
+	static T Abs(T a)                      { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f),a); }
+	static T Sign(T a)                     { return _mm256_and_ps(_mm256_set1_ps(-0.0f),a); }
+	static T Xor(T a, T b)                 { return _mm256_xor_ps(a,b); }
+	static M CmpGT(T a, T b)               { return _mm256_cmp_ps(a,b,_CMP_GT_OQ); }
+	static M CmpEQ(T a, T b)               { return _mm256_cmp_ps(a,b,_CMP_EQ_OQ); }
+	static T Select(T a, T b, M m)         { return _mm256_blendv_ps(a,b,m); }
+};
+
+#include "RayleighKernelSimd.h"
+#include "CameraDemosaicSimd.h"
+
+}
+
+
+
+//DOP and AOP of a frame row.
+void RayleighRowAVX2(
+	const RayleighKernelRow *	row    //frame row
+	){
+	VectorRow<VectorAVX2>(row);
+}
+
+
+
+//DOP and AOP of pixels of a ray table.
+void RayleighRaysAVX2(
+	const RayleighKernelRays *	rays   //pixels of a ray table
+	){
+	VectorRays<VectorAVX2>(rays);
+}
+
+
+
+//DOP and AOP of a frame row in single precision.
+void RayleighRowFloatAVX2(
+	const RayleighKernelRowFloat *	row    //frame row
+	){
+	VectorRow<VectorAVX2Float>(row);
+}
+
+
+
+//DOP and AOP of pixels of the float ray table.
+void RayleighRaysFloatAVX2(
+	const RayleighKernelRaysFloat *	rays   //pixels of a ray table
+	){
+	VectorRays<VectorAVX2Float>(rays);
+}
+
+
+
+//Interpolation, Stokes components, DOP and AOP of a demosaicked frame row.
+void DemosaicRowAVX2(
+	const DemosaicRow *	row    //frame row
+	){
+	VectorDemosaic<VectorAVX2Float>(row);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
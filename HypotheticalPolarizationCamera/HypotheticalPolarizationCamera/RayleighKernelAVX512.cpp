@@ -0,0 +1,257 @@
+/*
+AVX-512 kernel of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for evaluating the Rayleigh sky model for 8 pixels (double) or 16 pixels (float) per AVX-512 instruction.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Using the code through "RayleighKernelFunction()", "RayleighKernelRaysFunction()", "RayleighKernelFloatFunction()" and
+"RayleighKernelRaysFloatFunction()", which only return it when the processor supports AVX-512.
+--------------------------
+
+Function 1: "RayleighRowAVX512()" 
+
+    //DOP and AOP of a frame row.
+	void RayleighRowAVX512(
+		const RayleighKernelRow *	row
+	);
+	--------------input----------------
+	const RayleighKernelRow *	row    //attitude, pixel locations and output planes of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP                 //DOP and AOP (unit is degree) of row->count pixels
+	-----------------------------------
+
+
+Function 2: "RayleighRaysAVX512()" 
+
+    //DOP and AOP of pixels of a ray table.
+	void RayleighRaysAVX512(
+		const RayleighKernelRays *	rays
+	);
+	--------------input----------------
+	const RayleighKernelRays *	rays   //attitude, unit shooting directions and output planes of rays->count pixels
+	-----------------------------------
+	-------------output----------------
+	rays->DOP, rays->AOP               //DOP and AOP (unit is degree) of rays->count pixels
+	-----------------------------------
+
+
+Function 3: "RayleighRowFloatAVX512()" 
+
+    //DOP and AOP of a frame row in single precision, 16 pixels per instruction.
+	void RayleighRowFloatAVX512(
+		const RayleighKernelRowFloat *	row
+	);
+	--------------input----------------
+	const RayleighKernelRowFloat *	row   //attitude, pixel locations and float output planes of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP                 //DOP and AOP (unit is degree) of row->count pixels
+	-----------------------------------
+
+
+Function 4: "RayleighRaysFloatAVX512()" 
+
+    //DOP and AOP of pixels of the float ray table, 16 pixels per instruction.
+	void RayleighRaysFloatAVX512(
+		const RayleighKernelRaysFloat *	rays
+	);
+	--------------input----------------
+	const RayleighKernelRaysFloat *	rays //attitude, unit shooting directions and float output planes of rays->count pixels
+	-----------------------------------
+	-------------output----------------
+	rays->DOP, rays->AOP               //DOP and AOP (unit is degree) of rays->count pixels
+	-----------------------------------
+
+
+Function 5: "DemosaicRowAVX512()" 
+
+    //Interpolation, Stokes components, DOP and AOP of a demosaicked frame row, 16 pixels per instruction.
+	void DemosaicRowAVX512(
+		const DemosaicRow *	row
+	);
+	--------------input----------------
+	const DemosaicRow *	row            //padded band rows, weights and outputs of a frame row (see CameraDemosaic.h)
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP, row->S0, row->S1, row->S2   //row->count values each
+	-----------------------------------
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include "RayleighKernel.h"
+#include "CameraDemosaic.h"
+
+#ifdef RAYLEIGH_KERNEL_X86
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx512f")
+#pragma GCC optimize ("fp-contract=off")
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"	//_mm512_undefined_pd() inside the intrinsics
+#endif
+
+namespace {
+
+//eight doubles in an AVX-512 register
+struct VectorAVX512
+{
+	typedef double S;
+	typedef __m512d T;
+	typedef __mmask8 M;
+	enum { Width = 8 };
+
+	static T Set(double a)                 { return _mm512_set1_pd(a); }
+	static T Load(const double * p)        { return _mm512_loadu_pd(p); }
+	static void Store(double * p, T a)     { _mm512_storeu_pd(p,a); }
+	static T Index()                       { return _mm512_set_pd(7.0,6.0,5.0,4.0,3.0,2.0,1.0,0.0); }
+	static T Add(T a, T b)                 { return _mm512_add_pd(a,b); }
+	static T Sub(T a, T b)                 { return _mm512_sub_pd(a,b); }
+	static T Mul(T a, T b)                 { return _mm512_mul_pd(a,b); }
+	static T Div(T a, T b)                 { return _mm512_div_pd(a,b); }
+	static T Sqrt(T a)                     { return _mm512_sqrt_pd(a); }
+	static T Abs(T a)                      { return _mm512_abs_pd(a); }
+	static T Sign(T a)                     { return _mm512_castsi512_pd(_mm512_and_epi64(_mm512_castpd_si512(a),_mm512_set1_epi64((long long)0x8000000000000000ULL))); }
+	static T Xor(T a, T b)                 { return _mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(a),_mm512_castpd_si512(b))); }
+	static M CmpGT(T a, T b)               { return _mm512_cmp_pd_mask(a,b,_CMP_GT_OQ); }
+	static M CmpEQ(T a, T b)               { return _mm512_cmp_pd_mask(a,b,_CMP_EQ_OQ); }
+	static T Select(T a, T b, M m)         { return _mm512_mask_blend_pd(m,a,b); }
+};
+
+//sixteen floats in an AVX-512 register
+struct VectorAVX512Float
+{
+	typedef float S;
+	typedef __m512 T;
+	typedef __mmask16 M;
+	enum { Width = 16 };
+
+	static T Set(double a)                 { return _mm512_set1_ps((float)a); }
+	static T Load(const float * p)         { return _mm512_loadu_ps(p); }
+	static void Store(float * p, T a)      { _mm512_storeu_ps(p,a); }
+	static T Index()                       { return _mm512_set_ps(15.0f,14.0f,13.0f,12.0f,11.0f,10.0f,9.0f,8.0f,7.0f,6.0f,5.0f,4.0f,3.0f,2.0f,1.0f,0.0f); }
+	static T Add(T a, T b)                 { return _mm512_add_ps(a,b); }
+	static T Sub(T a, T b)                 { return _mm512_sub_ps(a,b); }
+	static T Mul(T a, T b)                 { return _mm512_mul_ps(a,b); }
+	static T Div(T a, T b)                 { return _mm512_div_ps(a,b); }
+	static T Sqrt(T a)                     { return _mm512_sqrt_ps(a); }
+	static T Abs(T a)                      { return _mm512_abs_ps(a); }
+	static T Sign(T a)                     { return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a),_mm512_set1_epi32((int)0x80000000U))); }
+	static T Xor(T a, T b)                 { return _mm512_castsi512_ps(_mm512_xor_epi32(_mm512_castps_si512(a),_mm512_castps_si512(b))); }
+	static M CmpGT(T a, T b)               { return _mm512_cmp_ps_mask(a,b,_CMP_GT_OQ); }
+	static M CmpEQ(T a, T b)               { return _mm512_cmp_ps_mask(a,b,_CMP_EQ_OQ); }
+	static T Select(T a, T b, M m)         { return _mm512_mask_blend_ps(m,a,b); }
+};
+
+#include "RayleighKernelSimd.h"
+#include "CameraDemosaicSimd.h"
+
+}
+
+
+
+//DOP and AOP of a frame row.
+void RayleighRowAVX512(
+	const RayleighKernelRow *	row    //frame row
+	){
+	VectorRow<VectorAVX512>(row);
+}
+
+
+
+//DOP and AOP of pixels of a ray table.
+void RayleighRaysAVX512(
+	const RayleighKernelRays *	rays   //pixels of a ray table
+	){
+	VectorRays<VectorAVX512>(rays);
+}
+
+
+
+//DOP and AOP of a frame row in single precision.
+void RayleighRowFloatAVX512(
+	const RayleighKernelRowFloat *	row    //frame row
+	){
+	VectorRow<VectorAVX512Float>(row);
+}
+
+
+
+//DOP and AOP of pixels of the float ray table.
+void RayleighRaysFloatAVX512(
+	const RayleighKernelRaysFloat *	rays   //pixels of a ray table
+	){
+	VectorRays<VectorAVX512Float>(rays);
+}
+
+
+
+//Interpolation, Stokes components, DOP and AOP of a demosaicked frame row.
+void DemosaicRowAVX512(
+	const DemosaicRow *	row    //frame row
+	){
+	VectorDemosaic<VectorAVX512Float>(row);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+/*
+SSE2 kernel of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for evaluating the Rayleigh sky model for 2 pixels (double) or 4 pixels (float) per SSE2 instruction.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Using the code through "RayleighKernelFunction()", "RayleighKernelRaysFunction()", "RayleighKernelFloatFunction()" and
+"RayleighKernelRaysFloatFunction()", which only return it when the processor supports SSE2.
+--------------------------
+
+Function 1: "RayleighRowSSE2()" 
+
+    //DOP and AOP of a frame row.
+	void RayleighRowSSE2(
+		const RayleighKernelRow *	row
+	);
+	--------------input----------------
+	const RayleighKernelRow *	row    //attitude, pixel locations and output planes of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP                 //DOP and AOP (unit is degree) of row->count pixels
+	-----------------------------------
+
+
+Function 2: "RayleighRaysSSE2()" 
+
+    //DOP and AOP of pixels of a ray table.
+	void RayleighRaysSSE2(
+		const RayleighKernelRays *	rays
+	);
+	--------------input----------------
+	const RayleighKernelRays *	rays   //attitude, unit shooting directions and output planes of rays->count pixels
+	-----------------------------------
+	-------------output----------------
+	rays->DOP, rays->AOP               //DOP and AOP (unit is degree) of rays->count pixels
+	-----------------------------------
+
+
+Function 3: "RayleighRowFloatSSE2()" 
+
+    //DOP and AOP of a frame row in single precision, 4 pixels per instruction.
+	void RayleighRowFloatSSE2(
+		const RayleighKernelRowFloat *	row
+	);
+	--------------input----------------
+	const RayleighKernelRowFloat *	row   //attitude, pixel locations and float output planes of a frame row
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP                 //DOP and AOP (unit is degree) of row->count pixels
+	-----------------------------------
+
+
+Function 4: "RayleighRaysFloatSSE2()" 
+
+    //DOP and AOP of pixels of the float ray table, 4 pixels per instruction.
+	void RayleighRaysFloatSSE2(
+		const RayleighKernelRaysFloat *	rays
+	);
+	--------------input----------------
+	const RayleighKernelRaysFloat *	rays //attitude, unit shooting directions and float output planes of rays->count pixels
+	-----------------------------------
+	-------------output----------------
+	rays->DOP, rays->AOP               //DOP and AOP (unit is degree) of rays->count pixels
+	-----------------------------------
+
+
+Function 5: "DemosaicRowSSE2()" 
+
+    //Interpolation, Stokes components, DOP and AOP of a demosaicked frame row, 4 pixels per instruction.
+	void DemosaicRowSSE2(
+		const DemosaicRow *	row
+	);
+	--------------input----------------
+	const DemosaicRow *	row            //padded band rows, weights and outputs of a frame row (see CameraDemosaic.h)
+	-----------------------------------
+	-------------output----------------
+	row->DOP, row->AOP, row->S0, row->S1, row->S2   //row->count values each
+	-----------------------------------
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include "RayleighKernel.h"
+#include "CameraDemosaic.h"
+
+#ifdef RAYLEIGH_KERNEL_X86
+
+#include <emmintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace {
+
+//two doubles in an SSE2 register
+struct VectorSSE2
+{
+	typedef double S;
+	typedef __m128d T;
+	typedef __m128d M;
+	enum { Width = 2 };
+
+	static T Set(double a)                 { return _mm_set1_pd(a); }
+	static T Load(const double * p)        { return _mm_loadu_pd(p); }
+	static void Store(double * p, T a)     { _mm_storeu_pd(p,a); }
+	static T Index()                       { return _mm_set_pd(1.0,0.0); }
+	static T Add(T a, T b)                 { return _mm_add_pd(a,b); }
+	static T Sub(T a, T b)                 { return _mm_sub_pd(a,b); }
+	static T Mul(T a, T b)                 { return _mm_mul_pd(a,b); }
+	static T Div(T a, T b)                 { return _mm_div_pd(a,b); }
+	static T Sqrt(T a)                     { return _mm_sqrt_pd(a); }
+	static T Abs(T a)                      { return _mm_andnot_pd(_mm_set1_pd(-0.0),a); }
+	static T Sign(T a)                     { return _mm_and_pd(_mm_set1_pd(-0.0),a); }
+	static T Xor(T a, T b)                 { return _mm_xor_pd(a,b); }
+	static M CmpGT(T a, T b)               { return _mm_cmpgt_pd(a,b); }
+	static M CmpEQ(T a, T b)               { return _mm_cmpeq_pd(a,b); }
+	static T Select(T a, T b, M m)         { return _mm_or_pd(_mm_and_pd(m,b),_mm_andnot_pd(m,a)); }
+};
+
+//four floats in an SSE register
+struct VectorSSE2Float
+{
+	typedef float S;
+	typedef __m128 T;
+	typedef __m128 M;
+	enum { Width = 4 };
+
+	static T Set(double a)                 { return _mm_set1_ps((float)a); }
+	static T Load(const float * p)         { return _mm_loadu_ps(p); }
+	static void Store(float * p, T a)      { _mm_storeu_ps(p,a); }
+	static T Index()                       { return _mm_set_ps(3.0f,2.0f,1.0f,0.0f); }
+	static T Add(T a, T b)                 { return _mm_add_ps(a,b); }
+	static T Sub(T a, T b)                 { return _mm_sub_ps(a,b); }
+	static T Mul(T a, T b)                 { return _mm_mul_ps(a,b); }
+	static T Div(T a, T b)                 { return _mm_div_ps(a,b); }
+	static T Sqrt(T a)                     { return _mm_sqrt_ps(a); }
+	static T Abs(T a)                      { return _mm_andnot_ps(_mm_set1_ps(-0.0f),a); }
+	static T Sign(T a)                     { return _mm_and_ps(_mm_set1_ps(-0.0f),a); }
+	static T Xor(T a, T b)                 { return _mm_xor_ps(a,b); }
+	static M CmpGT(T a, T b)               { return _mm_cmpgt_ps(a,b); }
+	static M CmpEQ(T a, T b)               { return _mm_cmpeq_ps(a,b); }
+	static T Select(T a, T b, M m)         { return _mm_or_ps(_mm_and_ps(m,b),_mm_andnot_ps(m,a)); }
+};
+
+#include "RayleighKernelSimd.h"
+#include "CameraDemosaicSimd.h"
+
+}
+
+
+
+//DOP and AOP of a frame row.
+void RayleighRowSSE2(
+	const RayleighKernelRow *	row    //frame row
+	){
+	VectorRow<VectorSSE2>(row);
+}
+
+
+
+//DOP and AOP of pixels of a ray table.
+void RayleighRaysSSE2(
+	const RayleighKernelRays *	rays   //pixels of a ray table
+	){
+	VectorRays<VectorSSE2>(rays);
+}
+
+
+
+//DOP and AOP of a frame row in single precision.
+void RayleighRowFloatSSE2(
+	const RayleighKernelRowFloat *	row    //frame row
+	){
+	VectorRow<VectorSSE2Float>(row);
+}
+
+
+
+//DOP and AOP of pixels of the float ray table.
+void RayleighRaysFloatSSE2(
+	const RayleighKernelRaysFloat *	rays   //pixels of a ray table
+	){
+	VectorRays<VectorSSE2Float>(rays);
+}
+
+
+
+//Interpolation, Stokes components, DOP and AOP of a demosaicked frame row.
+void DemosaicRowSSE2(
+	const DemosaicRow *	row    //frame row
+	){
+	VectorDemosaic<VectorSSE2Float>(row);
+}
+
+#endif
@@ -0,0 +1,518 @@
+#ifndef _RAYLEIGHKERNELSIMD_H_
+#define _RAYLEIGHKERNELSIMD_H_
+
+//Vectorized Rayleigh kernel shared by RayleighKernelSSE2.cpp, RayleighKernelAVX2.cpp and RayleighKernelAVX512.cpp.
+//Each of them includes this file inside an unnamed namespace after defining vector types V with
+//	V::S                             scalar type, double or float
+//	V::T, V::M                       vector and comparison mask types
+//	V::Width                         number of scalars in V::T
+//	Set, Load, Store, Index          broadcast, load, store, {0,1,...,Width-1}
+//	Add, Sub, Mul, Div, Sqrt, Abs    arithmetic
+//	Sign                             sign bits of a vector
+//	Xor                              bitwise exclusive or
+//	CmpGT, CmpEQ                     comparisons
+//	Select(m,a,b)                    b where m is set, a elsewhere
+//so that every instruction set gets its own copy of the code compiled for its own target.
+//The sky models are the structs VectorSkyRayleigh, VectorSkyBerry and VectorSkyTable with the same "Evaluate()";
+//"VectorRow()" and "VectorRays()" pick one per call, and the pixel loops are instantiated for each of them.
+
+//arc tangent of a vector of doubles (Cephes atan, error below 2 ulp)
+template <class V>
+inline typename V::T VectorAtan(typename V::T x, double)
+{
+	typedef typename V::T T;
+	const double T3P8 = 2.41421356237309504880;     //tan(3*pi/8)
+	const double MOREBITS = 6.123233995736765886130E-17;
+
+	T sign = V::Sign(x);
+	T a = V::Abs(x);
+
+	//range reduction to [0, tan(pi/8)]
+	typename V::M big = V::CmpGT(a,V::Set(T3P8));
+	typename V::M mid = V::CmpGT(a,V::Set(0.66));
+	T y = V::Select(V::Select(V::Set(0.0),V::Set(3.141592653589793/4),mid),V::Set(3.141592653589793/2),big);
+	T more = V::Select(V::Select(V::Set(0.0),V::Set(0.5*MOREBITS),mid),V::Set(MOREBITS),big);
+	T r = V::Select(V::Select(a,V::Div(V::Sub(a,V::Set(1.0)),V::Add(a,V::Set(1.0))),mid),
+		V::Div(V::Set(-1.0),a),big);
+
+	T z = V::Mul(r,r);
+	T p = V::Set(-8.750608600031904122785E-1);
+	p = V::Add(V::Mul(p,z),V::Set(-1.615753718733365076637E1));
+	p = V::Add(V::Mul(p,z),V::Set(-7.500855792314704667340E1));
+	p = V::Add(V::Mul(p,z),V::Set(-1.228866684490136173410E2));
+	p = V::Add(V::Mul(p,z),V::Set(-6.485021904942025371773E1));
+	T q = V::Add(z,V::Set(2.485846490142306297962E1));
+	q = V::Add(V::Mul(q,z),V::Set(1.650270098316988542046E2));
+	q = V::Add(V::Mul(q,z),V::Set(4.328810604912902668951E2));
+	q = V::Add(V::Mul(q,z),V::Set(4.853903996359136964868E2));
+	q = V::Add(V::Mul(q,z),V::Set(1.945506571482613964425E2));
+	z = V::Div(V::Mul(z,p),q);
+	z = V::Add(V::Mul(r,z),r);
+	y = V::Add(y,V::Add(z,more));
+	return V::Xor(y,sign);
+}
+
+
+
+//arc tangent of a vector of floats (Cephes atanf, error below 2 ulp)
+template <class V>
+inline typename V::T VectorAtan(typename V::T x, float)
+{
+	typedef typename V::T T;
+	T sign = V::Sign(x);
+	T a = V::Abs(x);
+
+	//range reduction to [0, tan(pi/8)]
+	typename V::M big = V::CmpGT(a,V::Set(2.414213562373095));
+	typename V::M mid = V::CmpGT(a,V::Set(0.4142135623730950));
+	T y = V::Select(V::Select(V::Set(0.0),V::Set(3.141592653589793/4),mid),V::Set(3.141592653589793/2),big);
+	T r = V::Select(V::Select(a,V::Div(V::Sub(a,V::Set(1.0)),V::Add(a,V::Set(1.0))),mid),
+		V::Div(V::Set(-1.0),a),big);
+
+	T z = V::Mul(r,r);
+	T p = V::Set(8.05374449538e-2);
+	p = V::Sub(V::Mul(p,z),V::Set(1.38776856032E-1));
+	p = V::Add(V::Mul(p,z),V::Set(1.99777106478E-1));
+	p = V::Sub(V::Mul(p,z),V::Set(3.33329491539E-1));
+	y = V::Add(y,V::Add(V::Mul(V::Mul(p,z),r),r));
+	return V::Xor(y,sign);
+}
+
+
+
+//arc tangent of a vector of the scalar type of V
+template <class V>
+inline typename V::T VectorAtan(typename V::T x)
+{
+	return VectorAtan<V>(x,typename V::S());
+}
+
+
+
+//DOP and AOP of Width pixels from their shooting directions in solar vector coordinate system.
+template <class V>
+inline void VectorRayleigh(
+	const RayleighKernelState *	state,  //rotation matrices and DOP_max
+	typename V::T  v_x,                 //Vector_v_P[0][0]
+	typename V::T  v_y,                 //Vector_v_P[1][0]
+	typename V::T  v_z,                 //Vector_v_P[2][0]
+	const bool    unit,                 //whether Vector_v_P is a unit vector
+	typename V::T &	DOP,                //DOP
+	typename V::T &	AOP                 //AOP (unit is degree)
+	)
+{
+	typedef typename V::T T;
+	const T zero = V::Set(0.0);
+	const T one = V::Set(1.0);
+
+	//cosine of the zenith angle sita_v_P
+	T c2;
+	if(unit){
+		c2 = V::Mul(v_z,v_z);
+		c2 = V::Select(c2,one,V::CmpGT(c2,one));	//rounding of the rotation
+	}
+	else{
+		T norm = V::Sqrt(V::Add(V::Add(V::Mul(v_x,v_x),V::Mul(v_y,v_y)),V::Mul(v_z,v_z)));
+		T c = V::Div(v_z,norm);
+		c2 = V::Mul(c,c);
+	}
+
+	//DOP of pixel P based on Rayleigh sky model: sin^2/(1+cos^2)
+	DOP = V::Div(V::Mul(V::Set(state->DOP_max),V::Sub(one,c2)),V::Add(one,c2));
+
+	//polarization E-vector in solar vector coordinate system {sin(fi_v_P),-cos(fi_v_P),0} up to its length.
+	//The quadrant judgement gives fi_v_P=+-pi or 0 when Vector_v_P[0][0]==0, i.e. the E-vector
+	//{+-sin(pi),1,0} or {0,-1,0}; sin(pi)!=0 decides AOP when C_vTb maps {0,1,0} onto the y axis.
+	typename V::M axis = V::CmpEQ(v_x,zero);
+	typename V::M level = V::CmpEQ(v_y,zero);
+	T axis_x = V::Xor(V::Select(V::Set(RAYLEIGH_SIN_PI),zero,level),V::Sign(v_y));
+	T axis_y = V::Select(one,V::Set(-1.0),level);
+	T e_x = V::Select(v_y,axis_x,axis);
+	T e_y = V::Select(V::Sub(zero,v_x),axis_y,axis);
+
+	//polarization E-vector in body coordinate system, AOP=atan(E_b_P[0][0]/E_b_P[2][0])
+	T E_x = V::Add(V::Mul(V::Set(state->C_vTb[0][0]),e_x),V::Mul(V::Set(state->C_vTb[0][1]),e_y));
+	T E_z = V::Add(V::Mul(V::Set(state->C_vTb[2][0]),e_x),V::Mul(V::Set(state->C_vTb[2][1]),e_y));
+	T angle = VectorAtan<V>(V::Div(E_x,E_z));
+
+	//Elimination of invalid solution
+	angle = V::Select(angle,zero,V::CmpEQ(DOP,zero));
+	AOP = V::Div(V::Mul(angle,V::Set(180.0)),V::Set(3.141592653589793));
+}
+
+
+
+//Rayleigh sky model of "CameraSimulation()".
+template <class V>
+struct VectorSkyRayleigh
+{
+	static inline void Evaluate(
+		const RayleighKernelState *	state,  //rotation matrices and sky
+		typename V::T  v_x,                 //Vector_v_P[0][0]
+		typename V::T  v_y,                 //Vector_v_P[1][0]
+		typename V::T  v_z,                 //Vector_v_P[2][0]
+		const bool    unit,                 //whether Vector_v_P is a unit vector
+		typename V::T &	DOP,                //DOP
+		typename V::T &	AOP                 //AOP (unit is degree)
+		)
+	{
+		VectorRayleigh<V>(state,v_x,v_y,v_z,unit,DOP,AOP);
+	}
+};
+
+
+
+//Shooting direction scaled to unit length, unless it already is one.
+template <class V>
+inline void VectorUnit(
+	typename V::T &	v_x,                //Vector_v_P
+	typename V::T &	v_y,
+	typename V::T &	v_z,
+	const bool    unit                  //whether Vector_v_P is a unit vector
+	)
+{
+	if(!unit){
+		typename V::T norm = V::Sqrt(V::Add(V::Add(V::Mul(v_x,v_x),V::Mul(v_y,v_y)),V::Mul(v_z,v_z)));
+		v_x = V::Div(v_x,norm);
+		v_y = V::Div(v_y,norm);
+		v_z = V::Div(v_z,norm);
+	}
+}
+
+
+
+//AOP of a unit shooting direction whose E-vector is turned from the Rayleigh E-vector towards the sun by psi,
+//given as cos(2*psi) and sin(2*psi).
+template <class V>
+inline typename V::T VectorSkyAOP(
+	const RayleighKernelState *	state,  //rotation matrices
+	typename V::T  v_x,                 //unit Vector_v_P
+	typename V::T  v_y,
+	typename V::T  v_z,
+	typename V::T  rho2,                //v_x^2+v_y^2
+	typename V::T  cos2,                //cos(2*psi)
+	typename V::T  sin2,                //sin(2*psi)
+	typename V::T  DOP                  //DOP
+	)
+{
+	typedef typename V::T T;
+	const T zero = V::Set(0.0);
+	const T half = V::Set(0.5);
+
+	//cos(psi) and sin(psi) of the half angle, psi in [-90,90] degrees. The larger one is sqrt((1+|cos2|)/2) and the
+	//smaller one |sin2| divided by twice the larger one, since sqrt((1-|cos2|)/2) loses half the digits next to
+	//psi=0 and psi=+-90 degrees.
+	T large = V::Sqrt(V::Mul(half,V::Add(V::Set(1.0),V::Abs(cos2))));
+	T small = V::Div(V::Mul(half,V::Abs(sin2)),large);
+	typename V::M obtuse = V::CmpGT(zero,cos2);
+	T c = V::Select(large,small,obtuse);
+	T s = V::Xor(V::Select(small,large,obtuse),V::Sign(sin2));
+
+	//E-vector cos(psi)*{-v_y,v_x,0}-sin(psi)*{v_z*v_x,v_z*v_y,-rho2}/rho without the common factor 1/rho
+	T e_x = V::Sub(V::Mul(c,V::Sub(zero,v_y)),V::Mul(s,V::Mul(v_z,v_x)));
+	T e_y = V::Sub(V::Mul(c,v_x),V::Mul(s,V::Mul(v_z,v_y)));
+	T e_z = V::Mul(s,rho2);
+
+	//polarization E-vector in body coordinate system, AOP=atan(E_b_P[0][0]/E_b_P[2][0])
+	T E_x = V::Add(V::Add(V::Mul(V::Set(state->C_vTb[0][0]),e_x),V::Mul(V::Set(state->C_vTb[0][1]),e_y)),
+		V::Mul(V::Set(state->C_vTb[0][2]),e_z));
+	T E_z = V::Add(V::Add(V::Mul(V::Set(state->C_vTb[2][0]),e_x),V::Mul(V::Set(state->C_vTb[2][1]),e_y)),
+		V::Mul(V::Set(state->C_vTb[2][2]),e_z));
+	T angle = VectorAtan<V>(V::Div(E_x,E_z));
+
+	//Elimination of invalid solution, also at the sun and the anti-sun where the E-vector is undefined
+	angle = V::Select(angle,zero,V::CmpEQ(DOP,zero));
+	angle = V::Select(angle,zero,V::CmpEQ(rho2,zero));
+	return V::Div(V::Mul(angle,V::Set(180.0)),V::Set(3.141592653589793));
+}
+
+
+
+//Neutral point model of SKY_MODEL_BERRY (see SkyModel.cpp).
+//zeta=x/y is used in projective form: x=v_x+i*v_y, y=1+v_z towards the sun and, to keep y away from 0,
+//x=v_x-i*v_y, y=1-v_z (which is 1/zeta) towards the anti-sun. N(zeta) only changes by the factor zeta^4
+//under zeta->1/zeta, so with P=(x^2-A^2*y^2)*(y^2-A^2*x^2) in both halves
+//	DOP = DOP_max*2*|P|/((1+A^2)^2*(|x|^4+y^4)),    2*psi = arg(P*conj(x)^2)
+template <class V>
+struct VectorSkyBerry
+{
+	static inline void Evaluate(
+		const RayleighKernelState *	state,  //rotation matrices and sky
+		typename V::T  v_x,                 //Vector_v_P[0][0]
+		typename V::T  v_y,                 //Vector_v_P[1][0]
+		typename V::T  v_z,                 //Vector_v_P[2][0]
+		const bool    unit,                 //whether Vector_v_P is a unit vector
+		typename V::T &	DOP,                //DOP
+		typename V::T &	AOP                 //AOP (unit is degree)
+		)
+	{
+		typedef typename V::T T;
+		const T zero = V::Set(0.0);
+		const T A2 = V::Set(state->NeutralPoint);
+		VectorUnit<V>(v_x,v_y,v_z,unit);
+
+		//projective zeta of the half sphere of the shooting direction
+		T x_i = V::Select(v_y,V::Sub(zero,v_y),V::CmpGT(zero,v_z));
+		T y = V::Add(V::Set(1.0),V::Abs(v_z));
+
+		//X=x^2, F=X-A^2*y^2, G=y^2-A^2*X and P=F*G
+		T y2 = V::Mul(y,y);
+		T X_r = V::Sub(V::Mul(v_x,v_x),V::Mul(x_i,x_i));
+		T X_i = V::Mul(V::Set(2.0),V::Mul(v_x,x_i));
+		T F_r = V::Sub(X_r,V::Mul(A2,y2));
+		T G_r = V::Sub(y2,V::Mul(A2,X_r));
+		T G_i = V::Sub(zero,V::Mul(A2,X_i));
+		T P_r = V::Sub(V::Mul(F_r,G_r),V::Mul(X_i,G_i));
+		T P_i = V::Add(V::Mul(F_r,G_i),V::Mul(X_i,G_r));
+		T P = V::Sqrt(V::Add(V::Mul(P_r,P_r),V::Mul(P_i,P_i)));
+		T X2 = V::Add(V::Mul(X_r,X_r),V::Mul(X_i,X_i));
+
+		double k = 2.0*state->DOP_max/((1.0+state->NeutralPoint)*(1.0+state->NeutralPoint));
+		DOP = V::Div(V::Mul(V::Set(k),P),V::Add(X2,V::Mul(y2,y2)));
+
+		//P*conj(X), whose angle is 2*psi
+		T Q_r = V::Add(V::Mul(P_r,X_r),V::Mul(P_i,X_i));
+		T Q_i = V::Sub(V::Mul(P_i,X_r),V::Mul(P_r,X_i));
+		T Q = V::Sqrt(V::Add(V::Mul(Q_r,Q_r),V::Mul(Q_i,Q_i)));
+		typename V::M none = V::CmpEQ(Q,zero);
+		T cos2 = V::Select(V::Div(Q_r,Q),V::Set(1.0),none);
+		T sin2 = V::Select(V::Div(Q_i,Q),zero,none);
+
+		T rho2 = V::Add(V::Mul(v_x,v_x),V::Mul(v_y,v_y));
+		AOP = VectorSkyAOP<V>(state,v_x,v_y,v_z,rho2,cos2,sin2,DOP);
+	}
+};
+
+
+
+//Normalized Stokes components of a grid in the scalar type of a kernel.
+inline const double * VectorSkyTableQ(const SkyTable * table, double)   { return table->Q; }
+inline const double * VectorSkyTableU(const SkyTable * table, double)   { return table->U; }
+inline const float * VectorSkyTableQ(const SkyTable * table, float)     { return table->QFloat; }
+inline const float * VectorSkyTableU(const SkyTable * table, float)     { return table->UFloat; }
+
+
+
+//Bilinear interpolation of the measured grid of SKY_MODEL_TABLE.
+//sita_v_P=pi/2-atan(v_z/rho) and fi_v_P=atan(v_y/v_x) plus its quadrant are vectorized, the four nodes of every
+//pixel are gathered lane by lane, and the interpolation is vectorized again.
+template <class V>
+struct VectorSkyTable
+{
+	static inline void Evaluate(
+		const RayleighKernelState *	state,  //rotation matrices and sky
+		typename V::T  v_x,                 //Vector_v_P[0][0]
+		typename V::T  v_y,                 //Vector_v_P[1][0]
+		typename V::T  v_z,                 //Vector_v_P[2][0]
+		const bool    unit,                 //whether Vector_v_P is a unit vector
+		typename V::T &	DOP,                //DOP
+		typename V::T &	AOP                 //AOP (unit is degree)
+		)
+	{
+		typedef typename V::T T;
+		typedef typename V::S S;
+		const int W = V::Width;
+		const double pi = 3.141592653589793;
+		const T zero = V::Set(0.0);
+		const SkyTable * table = state->Sky->Table;
+		VectorUnit<V>(v_x,v_y,v_z,unit);
+
+		//grid location: angle from the sun and azimuth around it in nodes
+		T rho2 = V::Add(V::Mul(v_x,v_x),V::Mul(v_y,v_y));
+		T sita = V::Sub(V::Set(0.5*pi),VectorAtan<V>(V::Div(v_z,V::Sqrt(rho2))));
+		T fi = V::Add(VectorAtan<V>(V::Div(v_y,v_x)),V::Select(zero,V::Set(pi),V::CmpGT(zero,v_x)));
+		fi = V::Select(fi,V::Add(fi,V::Set(2.0*pi)),V::CmpGT(zero,fi));
+		S g[V::Width], p[V::Width];
+		V::Store(g,V::Mul(sita,V::Set((table->n_g-1)/pi)));
+		V::Store(p,V::Mul(fi,V::Set(table->n_p/(2.0*pi))));
+
+		//nodes of every lane
+		const S * Q = VectorSkyTableQ(table,S());
+		const S * U = VectorSkyTableU(table,S());
+		S q[4][V::Width], u[4][V::Width], w_g[V::Width], w_p[V::Width];
+		for(int k=0; k<W; k++){
+			size_t node[4];
+			double t_g, t_p;
+			SkyTableCell(table,g[k],p[k],node,t_g,t_p);
+			for(int n=0; n<4; n++){
+				q[n][k] = Q[node[n]];
+				u[n][k] = U[node[n]];
+			}
+			w_g[k] = (S)t_g;
+			w_p[k] = (S)t_p;
+		}
+
+		//bilinear interpolation of Q and U
+		T t_g = V::Load(w_g);
+		T t_p = V::Load(w_p);
+		T Q_0 = V::Add(V::Load(q[0]),V::Mul(t_p,V::Sub(V::Load(q[1]),V::Load(q[0]))));
+		T Q_1 = V::Add(V::Load(q[2]),V::Mul(t_p,V::Sub(V::Load(q[3]),V::Load(q[2]))));
+		T U_0 = V::Add(V::Load(u[0]),V::Mul(t_p,V::Sub(V::Load(u[1]),V::Load(u[0]))));
+		T U_1 = V::Add(V::Load(u[2]),V::Mul(t_p,V::Sub(V::Load(u[3]),V::Load(u[2]))));
+		T Q_s = V::Add(Q_0,V::Mul(t_g,V::Sub(Q_1,Q_0)));
+		T U_s = V::Add(U_0,V::Mul(t_g,V::Sub(U_1,U_0)));
+
+		T P = V::Sqrt(V::Add(V::Mul(Q_s,Q_s),V::Mul(U_s,U_s)));
+		DOP = V::Select(sita,V::Mul(V::Set(state->DOP_max),P),V::CmpEQ(sita,sita));	//NaN outside the image circle of a lens
+		typename V::M none = V::CmpEQ(P,zero);
+		T cos2 = V::Select(V::Div(Q_s,P),V::Set(1.0),none);
+		T sin2 = V::Select(V::Div(U_s,P),zero,none);
+		AOP = VectorSkyAOP<V>(state,v_x,v_y,v_z,rho2,cos2,sin2,DOP);
+	}
+};
+
+
+
+//Store Width values, of which only count may be inside the output.
+template <class V>
+inline void VectorStore(
+	typename V::S *	p,              //output
+	typename V::T  a,               //values
+	const int     count             //number of values to store
+	)
+{
+	if(count>=V::Width){
+		V::Store(p,a);
+		return;
+	}
+	typename V::S tail[V::Width];
+	V::Store(tail,a);
+	for(int i=0; i<count; i++){
+		p[i] = tail[i];
+	}
+}
+
+
+
+//DOP and AOP of a frame row with a sky model.
+template <class V, class Sky>
+inline void VectorRowOf(
+	const RayleighKernelRowOf<typename V::S> *	row     //frame row
+	)
+{
+	typedef typename V::T T;
+	const int W = V::Width;
+	const RayleighKernelState * state = row->state;
+
+	//Vector_b_PaF = {P_x, f, P_z}, so Vector_v_P = C_bTv*Vector_b_PaF = r + C_bTv[.][2]*P_z
+	double r_x = 0.0;
+	double r_y = 0.0;
+	double r_z = 0.0;
+	r_x += state->C_bTv[0][0]*row->P_x;
+	r_x += state->C_bTv[0][1]*row->f;
+	r_y += state->C_bTv[1][0]*row->P_x;
+	r_y += state->C_bTv[1][1]*row->f;
+	r_z += state->C_bTv[2][0]*row->P_x;
+	r_z += state->C_bTv[2][1]*row->f;
+
+	const T R_x = V::Set(r_x);
+	const T R_y = V::Set(r_y);
+	const T R_z = V::Set(r_z);
+	const T C_x = V::Set(state->C_bTv[0][2]);
+	const T C_y = V::Set(state->C_bTv[1][2]);
+	const T C_z = V::Set(state->C_bTv[2][2]);
+	const T D_z = V::Set(row->D_z);
+	const T step = V::Set(row->Step*W);
+	T offset = V::Add(V::Set(row->Offset),V::Mul(V::Index(),V::Set(row->Step)));
+
+	for(int k=0; k<row->count; k+=W){
+		//location of the pixels in pixel coordinate system
+		T P_z = V::Mul(D_z,offset);
+		offset = V::Add(offset,step);
+
+		//shooting direction in solar vector coordinate system
+		T v_x = V::Add(R_x,V::Mul(C_x,P_z));
+		T v_y = V::Add(R_y,V::Mul(C_y,P_z));
+		T v_z = V::Add(R_z,V::Mul(C_z,P_z));
+
+		T dop, aop;
+		Sky::Evaluate(state,v_x,v_y,v_z,false,dop,aop);
+		VectorStore<V>(row->DOP+k,dop,row->count-k);
+		VectorStore<V>(row->AOP+k,aop,row->count-k);
+	}
+}
+
+
+
+//DOP and AOP of pixels of a ray table with a sky model.
+template <class V, class Sky>
+inline void VectorRaysOf(
+	const RayleighKernelRaysOf<typename V::S> *	rays    //pixels of a ray table
+	)
+{
+	typedef typename V::T T;
+	const int W = V::Width;
+	const RayleighKernelState * state = rays->state;
+
+	T C[3][3];
+	for(int i=0; i<3; i++){
+		for(int j=0; j<3; j++){
+			C[i][j] = V::Set(state->C_bTv[i][j]);
+		}
+	}
+
+	int body = rays->count/W*W;
+	for(int k=0; k<rays->count; k+=W){
+		//shooting direction in body coordinate system, the last partial register is padded with copies
+		T b_x, b_y, b_z;
+		if(k<body){
+			b_x = V::Load(rays->Ray_x+k);
+			b_y = V::Load(rays->Ray_y+k);
+			b_z = V::Load(rays->Ray_z+k);
+		}
+		else{
+			typename V::S tail[3][V::Width];
+			for(int i=0; i<W; i++){
+				int n = k+i<rays->count ? k+i : rays->count-1;
+				tail[0][i] = rays->Ray_x[n];
+				tail[1][i] = rays->Ray_y[n];
+				tail[2][i] = rays->Ray_z[n];
+			}
+			b_x = V::Load(tail[0]);
+			b_y = V::Load(tail[1]);
+			b_z = V::Load(tail[2]);
+		}
+
+		//shooting direction in solar vector coordinate system
+		T v_x = V::Add(V::Add(V::Mul(C[0][0],b_x),V::Mul(C[0][1],b_y)),V::Mul(C[0][2],b_z));
+		T v_y = V::Add(V::Add(V::Mul(C[1][0],b_x),V::Mul(C[1][1],b_y)),V::Mul(C[1][2],b_z));
+		T v_z = V::Add(V::Add(V::Mul(C[2][0],b_x),V::Mul(C[2][1],b_y)),V::Mul(C[2][2],b_z));
+
+		T dop, aop;
+		Sky::Evaluate(state,v_x,v_y,v_z,true,dop,aop);
+		VectorStore<V>(rays->DOP+k,dop,rays->count-k);
+		VectorStore<V>(rays->AOP+k,aop,rays->count-k);
+	}
+}
+
+
+
+//DOP and AOP of a frame row, with the instance of its sky model.
+template <class V>
+inline void VectorRow(
+	const RayleighKernelRowOf<typename V::S> *	row     //frame row
+	)
+{
+	switch(row->state->Sky->Model){
+	case SKY_MODEL_BERRY: VectorRowOf<V,VectorSkyBerry<V> >(row); break;
+	case SKY_MODEL_TABLE: VectorRowOf<V,VectorSkyTable<V> >(row); break;
+	default:              VectorRowOf<V,VectorSkyRayleigh<V> >(row); break;
+	}
+}
+
+
+
+//DOP and AOP of pixels of a ray table, with the instance of its sky model.
+template <class V>
+inline void VectorRays(
+	const RayleighKernelRaysOf<typename V::S> *	rays    //pixels of a ray table
+	)
+{
+	switch(rays->state->Sky->Model){
+	case SKY_MODEL_BERRY: VectorRaysOf<V,VectorSkyBerry<V> >(rays); break;
+	case SKY_MODEL_TABLE: VectorRaysOf<V,VectorSkyTable<V> >(rays); break;
+	default:              VectorRaysOf<V,VectorSkyRayleigh<V> >(rays); break;
+	}
+}
+
+#endif
@@ -0,0 +1,631 @@
+/*
+Sky polarization models of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for the sky polarization models of the simulation: the Rayleigh sky, the neutral point model of Berry, Dennis and Lee, and a sky interpolated from a measured grid.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Set CameraParameters::Sky with "SkyModelRayleigh()", "SkyModelBerry()" or "SkyModelTabulated()"; every kernel type of RayleighKernel.h evaluates it.
+--------------------------
+
+Models:
+	Every model gives DOP and the E-vector of a shooting direction in solar vector coordinate system, whose z axis
+	points to the sun; sita_v_P is the angle from the sun and fi_v_P the azimuth around it.
+	SKY_MODEL_RAYLEIGH  DOP=DOP_max*sin(sita_v_P)^2/(1+cos(sita_v_P)^2) and the E-vector normal to the plane of the
+	                    sun and the shooting direction, the model of "CameraSimulation()".
+	SKY_MODEL_BERRY     With the stereographic projection zeta=tan(sita_v_P/2)*exp(i*fi_v_P) and A=tan(NeutralPoint/2),
+	                        N = (zeta^2-A^2)*(1-A^2*zeta^2)
+	                        DOP = DOP_max*2*|N|/((1+A^2)^2*(1+|zeta|^4)),   2*chi = arg(-N)
+	                    where chi is the direction of the E-vector in the zeta plane. With A=0 it is the Rayleigh sky
+	                    (N=zeta^2); otherwise its singular points at the sun and the anti-sun split into the four
+	                    neutral points (DOP=0) zeta=+-A and +-1/A: the Babinet and Brewster points NeutralPoint degrees
+	                    from the sun and the Arago point and its counterpart NeutralPoint degrees from the anti-sun,
+	                    all in the x-z plane of the solar vector coordinate system. DOP stays below DOP_max, which it
+	                    reaches 90 degrees from the sun in the y-z plane.
+	SKY_MODEL_TABLE     Bilinear interpolation of the normalized Stokes components Q and U of the nodes of a SkyTable
+	                    (see SkyModel.h), so that the interpolated E-vector turns smoothly between the nodes;
+	                    DOP=DOP_max*sqrt(Q^2+U^2) and the E-vector is turned by psi=atan2(U,Q)/2 towards the sun.
+	The vectorized kernels of RayleighKernel.h evaluate the same models without acos and sin: the Berry model with
+	the projective form of zeta, the table with one vectorized atan for sita_v_P and one for fi_v_P.
+
+
+Function 1: "SkyModelDefault()" 
+
+    //Rayleigh sky with DOP_max=1, the sky of "CameraSimulation()".
+	void SkyModelDefault(
+		SkyModel *	sky
+	);
+	-------------output----------------
+	SkyModel *	sky         //sky model
+	-----------------------------------
+
+
+Function 2: "SkyModelRayleigh()" 
+
+    //Rayleigh sky with a maximum DOP.
+	void SkyModelRayleigh(
+		SkyModel *	sky,
+		const double  DOP_max
+	);
+	--------------input----------------
+	const double  DOP_max   //maximum DOP in the sky
+	-----------------------------------
+	-------------output----------------
+	SkyModel *	sky         //sky model
+	-----------------------------------
+
+
+Function 3: "SkyModelBerry()" 
+
+    //Rayleigh sky with the Babinet and Brewster points above and below the sun and the Arago point and its counterpart next to the anti-sun.
+	void SkyModelBerry(
+		SkyModel *	sky,
+		const double  DOP_max,
+		const double  NeutralPoint
+	);
+	--------------input----------------
+	const double  DOP_max,          //maximum DOP in the sky
+	const double  NeutralPoint      //angle of the neutral points from the sun and the anti-sun (unit is degree)
+	-----------------------------------
+	-------------output----------------
+	SkyModel *	sky                 //sky model
+	-----------------------------------
+
+
+Function 4: "SkyModelTabulated()" 
+
+    //Sky interpolated from a measured grid.
+	void SkyModelTabulated(
+		SkyModel *	sky,
+		const SkyTable *	table
+	);
+	--------------input----------------
+	const SkyTable *	table       //measured grid, it has to outlive every simulation with the sky model
+	-----------------------------------
+	-------------output----------------
+	SkyModel *	sky                 //sky model with DOP_max=1
+	-----------------------------------
+
+
+Function 5: "SkyModelPixel()" 
+
+    //DOP and E-vector of a shooting direction in solar vector coordinate system.
+	void SkyModelPixel(
+		const SkyModel *	sky,
+		const double  (&Vector_v_P)[3][1],
+		double &	DOP,
+		double  (&E_v_P)[3][1]
+	);
+	--------------input----------------
+	const SkyModel *	sky,            //sky model
+	const double  (&Vector_v_P)[3][1]   //shooting direction in solar vector coordinate system (any length)
+	-----------------------------------
+	-------------output----------------
+	double &	DOP,                    //DOP
+	double  (&E_v_P)[3][1]              //unit polarization E-vector, 0 when Vector_v_P points to the sun or the anti-sun
+	-----------------------------------
+	The reference scalar code of RAYLEIGH_KERNEL_SCALAR for the models other than SKY_MODEL_RAYLEIGH, with acos,
+	atan2 and the complex arithmetic of the formulas above.
+
+
+Function 6: "SkyModelRay()" 
+
+    //DOP and AOP of a shooting direction in body coordinate system.
+	void SkyModelRay(
+		const SkyModel *	sky,
+		const double  (&C_vTb)[3][3],
+		const double  (&C_bTv)[3][3],
+		const double  (&Ray)[3],
+		double &	DOP,
+		double &	AOP
+	);
+	--------------input----------------
+	const SkyModel *	sky,        //sky model
+	const double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],   //rotation matrix from body to solar vector coordinate system
+	const double  (&Ray)[3]         //shooting direction in body coordinate system (any length)
+	-----------------------------------
+	-------------output----------------
+	double &	DOP,                //DOP
+	double &	AOP                 //AOP=atan(E_b_P[0][0]/E_b_P[2][0]) (unit is degree), 0 where it is undefined
+	-----------------------------------
+
+
+Function 7: "SkyModelStokes()" 
+
+    //Normalized Stokes components of a shooting direction in body coordinate system.
+	void SkyModelStokes(
+		const SkyModel *	sky,
+		const double  (&C_vTb)[3][3],
+		const double  (&C_bTv)[3][3],
+		const double  (&Ray)[3],
+		double &	S1,
+		double &	S2
+	);
+	--------------input----------------
+	const SkyModel *	sky,        //sky model
+	const double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],   //rotation matrix from body to solar vector coordinate system
+	const double  (&Ray)[3]         //shooting direction in body coordinate system (any length)
+	-----------------------------------
+	-------------output----------------
+	double &	S1,                 //S1/S0=DOP*cos(2*AOP)
+	double &	S2                  //S2/S0=DOP*sin(2*AOP)
+	-----------------------------------
+
+
+Function 8: "SkyTableInit()" 
+
+    //Allocate an unpolarized grid.
+	SkyTable * SkyTableInit(
+		const int     n_g,
+		const int     n_p
+	);
+	--------------input----------------
+	const int     n_g,          //number of nodes from the sun to the anti-sun (at least 2)
+	const int     n_p           //number of nodes around the sun (at least 1)
+	-----------------------------------
+	-------------output----------------
+	SkyTable *                  //grid with DOP=0 at every node, NULL on failure
+	-----------------------------------
+
+
+Function 9: "SkyTableSetNode()" 
+
+    //Set the polarization of a node of a grid.
+	void SkyTableSetNode(
+		SkyTable *	table,
+		const int     i,
+		const int     j,
+		const double  DOP,
+		const double  psi
+	);
+	--------------input----------------
+	SkyTable *	table,          //grid
+	const int     i,            //node from the sun, 0 to n_g-1
+	const int     j,            //node around the sun, 0 to n_p-1
+	const double  DOP,          //DOP
+	const double  psi           //angle of the E-vector from the Rayleigh E-vector, positive towards the sun (unit is degree)
+	-----------------------------------
+
+
+Function 10: "SkyTableSample()" 
+
+    //Sample a sky model on a grid.
+	SkyTable * SkyTableSample(
+		const SkyModel *	sky,
+		const int     n_g,
+		const int     n_p
+	);
+	--------------input----------------
+	const SkyModel *	sky,    //sky model
+	const int     n_g,          //number of nodes from the sun to the anti-sun (at least 2)
+	const int     n_p           //number of nodes around the sun (at least 1)
+	-----------------------------------
+	-------------output----------------
+	SkyTable *                  //grid, NULL on failure
+	-----------------------------------
+
+
+Function 11: "SkyTableLoad()" 
+
+    //Read a grid from a text file.
+	SkyTable * SkyTableLoad(
+		const char *  path
+	);
+	--------------input----------------
+	const char *  path          //text file
+	-----------------------------------
+	-------------output----------------
+	SkyTable *                  //grid, NULL if the file cannot be read or its nodes are not in the order of the grid
+	-----------------------------------
+	The file starts with "n_g n_p", followed by one line "gamma phi DOP psi" per node (unit is degree), i from 0 to
+	n_g-1 in the outer and j from 0 to n_p-1 in the inner loop, with gamma=i*180/(n_g-1) and phi=j*360/n_p.
+
+
+Function 12: "SkyTableSave()" 
+
+    //Write a grid to a text file readable by "SkyTableLoad()".
+	int SkyTableSave(
+		const SkyTable *	table,
+		const char *  path
+	);
+	--------------input----------------
+	const SkyTable *	table,  //grid
+	const char *  path          //text file
+	-----------------------------------
+	-------------output----------------
+	int                         //0, or -1 if the file cannot be written
+	-----------------------------------
+
+
+Function 13: "SkyTableFree()" 
+
+    //Release a grid.
+	void SkyTableFree(
+		SkyTable *	table
+	);
+	--------------input----------------
+	SkyTable *	table           //grid returned by "SkyTableInit()", "SkyTableSample()" or "SkyTableLoad()"
+	-----------------------------------
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex>
+#include "SkyModel.h"
+#include "MatrixTemplate.h"
+
+#define ALLOC(_struct)              ((_struct *)malloc(sizeof(_struct)))
+
+const static double pi = 3.141592653589793;
+
+
+
+//Rayleigh sky with DOP_max=1, the sky of "CameraSimulation()".
+void SkyModelDefault(
+	SkyModel *	sky         //sky model
+	){
+	SkyModelRayleigh(sky,1.0);
+}
+
+
+
+//Rayleigh sky with a maximum DOP.
+void SkyModelRayleigh(
+	SkyModel *	sky,        //sky model
+	const double  DOP_max   //maximum DOP in the sky
+	){
+	sky->Model = SKY_MODEL_RAYLEIGH;
+	sky->DOP_max = DOP_max;
+	sky->NeutralPoint = 0.0;
+	sky->Table = NULL;
+}
+
+
+
+//Rayleigh sky with neutral points next to the sun and the anti-sun.
+void SkyModelBerry(
+	SkyModel *	sky,                //sky model
+	const double  DOP_max,          //maximum DOP in the sky
+	const double  NeutralPoint      //angle of the neutral points from the sun and the anti-sun (unit is degree)
+	){
+	SkyModelRayleigh(sky,DOP_max);
+	sky->Model = SKY_MODEL_BERRY;
+	sky->NeutralPoint = NeutralPoint;
+}
+
+
+
+//Sky interpolated from a measured grid.
+void SkyModelTabulated(
+	SkyModel *	sky,                //sky model
+	const SkyTable *	table       //measured grid, owned by the caller
+	){
+	SkyModelRayleigh(sky,1.0);
+	sky->Model = SKY_MODEL_TABLE;
+	sky->Table = table;
+}
+
+
+
+//DOP and E-vector of a shooting direction in solar vector coordinate system (reference scalar code of the models).
+void SkyModelPixel(
+	const SkyModel *	sky,            //sky model
+	const double  (&Vector_v_P)[3][1],  //shooting direction in solar vector coordinate system (any length)
+	double &	DOP,                    //DOP
+	double  (&E_v_P)[3][1]              //polarization E-vector in solar vector coordinate system, 0 at the sun and the anti-sun
+	){
+	//angle from the sun and azimuth around it
+	double Vector_v_P_Norm = 0.0;
+	MatrixNorm(Vector_v_P,Vector_v_P_Norm);
+	double c = Vector_v_P[2][0]/Vector_v_P_Norm;
+	double sita_v_P = acos(c>1.0 ? 1.0 : (c<-1.0 ? -1.0 : c));
+	double fi_v_P = atan2(Vector_v_P[1][0],Vector_v_P[0][0]);
+
+	//DOP and angle psi of the E-vector from the Rayleigh E-vector, positive towards the sun
+	double psi = 0.0;
+	switch(sky->Model){
+	case SKY_MODEL_BERRY:
+		{
+			//stereographic projection zeta=tan(sita_v_P/2)*exp(i*fi_v_P) from the anti-sun; the Rayleigh sky is
+			//w=-zeta^2 and its double zeros at the sun and the anti-sun split into +-A and +-1/A
+			double A = tan(sky->NeutralPoint*pi/360.0);
+			std::complex<double> zeta = std::polar(tan(0.5*sita_v_P),fi_v_P);
+			std::complex<double> N = (zeta*zeta-A*A)*(1.0-A*A*zeta*zeta);
+			double t4 = std::norm(zeta)*std::norm(zeta);
+			DOP = sky->DOP_max*2.0*std::abs(N)/((1.0+A*A)*(1.0+A*A)*(1.0+t4));
+			psi = 0.5*std::arg(-N)-fi_v_P-0.5*pi;
+		}
+		break;
+	case SKY_MODEL_TABLE:
+		{
+			const SkyTable * table = sky->Table;
+			size_t node[4];
+			double t_g, t_p;
+			double fi = fi_v_P<0.0 ? fi_v_P+2.0*pi : fi_v_P;
+			SkyTableCell(table,sita_v_P*(table->n_g-1)/pi,fi*table->n_p/(2.0*pi),node,t_g,t_p);
+			double Q = (1.0-t_g)*((1.0-t_p)*table->Q[node[0]]+t_p*table->Q[node[1]])
+				+t_g*((1.0-t_p)*table->Q[node[2]]+t_p*table->Q[node[3]]);
+			double U = (1.0-t_g)*((1.0-t_p)*table->U[node[0]]+t_p*table->U[node[1]])
+				+t_g*((1.0-t_p)*table->U[node[2]]+t_p*table->U[node[3]]);
+			DOP = sita_v_P==sita_v_P ? sky->DOP_max*sqrt(Q*Q+U*U) : sita_v_P;	//NaN outside the image circle of a lens
+			psi = 0.5*atan2(U,Q);
+		}
+		break;
+	default:
+		DOP = sky->DOP_max*sin(sita_v_P)*sin(sita_v_P)/(1+cos(sita_v_P)*cos(sita_v_P));
+		break;
+	}
+
+	//E-vector from the unit vectors along fi_v_P and sita_v_P, undefined at the sun and the anti-sun
+	double e_fi[3] = {-sin(fi_v_P),cos(fi_v_P),0.0};
+	double e_sita[3] = {cos(sita_v_P)*cos(fi_v_P),cos(sita_v_P)*sin(fi_v_P),-sin(sita_v_P)};
+	bool axis = Vector_v_P[0][0]==0.0 && Vector_v_P[1][0]==0.0;
+	for(int k=0; k<3; k++){
+		E_v_P[k][0] = axis ? 0.0 : cos(psi)*e_fi[k]-sin(psi)*e_sita[k];
+	}
+}
+
+
+
+//DOP and the x and z components of the E-vector in body coordinate system of a shooting direction.
+static void BodyPixel(
+	const SkyModel *	sky,        //sky model
+	const double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],   //rotation matrix from body to solar vector coordinate system
+	const double  (&Ray)[3],        //shooting direction in body coordinate system (any length)
+	double &	DOP,                //DOP
+	double &	E_x,                //E_b_P[0][0]
+	double &	E_z                 //E_b_P[2][0]
+	){
+	double Vector_b_PaF[3][1] = {Ray[0],Ray[1],Ray[2]};
+	double Vector_v_P[3][1] = {0.0,0.0,0.0};
+	MatrixMultiply(C_bTv,Vector_b_PaF,Vector_v_P);
+
+	double E_v_P[3][1];
+	double E_b_P[3][1] = {0.0,0.0,0.0};
+	SkyModelPixel(sky,Vector_v_P,DOP,E_v_P);
+	MatrixMultiply(C_vTb,E_v_P,E_b_P);
+	E_x = E_b_P[0][0];
+	E_z = E_b_P[2][0];
+}
+
+
+
+//DOP and AOP of a shooting direction in body coordinate system.
+void SkyModelRay(
+	const SkyModel *	sky,        //sky model
+	const double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],   //rotation matrix from body to solar vector coordinate system
+	const double  (&Ray)[3],        //shooting direction in body coordinate system (any length)
+	double &	DOP,                //DOP
+	double &	AOP                 //AOP (unit is degree)
+	){
+	double E_x, E_z;
+	BodyPixel(sky,C_vTb,C_bTv,Ray,DOP,E_x,E_z);
+	AOP = atan(E_x/E_z)*180/pi;
+	if(DOP==0.0 || (E_x==0.0 && E_z==0.0)){	//	Elimination of invalid solution
+		AOP = 0.0;
+	}
+}
+
+
+
+//Normalized Stokes components of a shooting direction in body coordinate system.
+void SkyModelStokes(
+	const SkyModel *	sky,        //sky model
+	const double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],   //rotation matrix from body to solar vector coordinate system
+	const double  (&Ray)[3],        //shooting direction in body coordinate system (any length)
+	double &	S1,                 //S1/S0
+	double &	S2                  //S2/S0
+	){
+	double DOP, E_x, E_z;
+	BodyPixel(sky,C_vTb,C_bTv,Ray,DOP,E_x,E_z);
+
+	//cos(2*AOP) and sin(2*AOP) of AOP=atan(E_b_P[0][0]/E_b_P[2][0])
+	double E2 = E_x*E_x+E_z*E_z;
+	S1 = DOP==0.0 || E2==0.0 ? 0.0 : DOP*(E_z*E_z-E_x*E_x)/E2;
+	S2 = DOP==0.0 || E2==0.0 ? 0.0 : DOP*2.0*E_x*E_z/E2;
+}
+
+
+
+//Allocate an unpolarized grid.
+SkyTable * SkyTableInit(
+	const int     n_g,          //number of nodes from the sun to the anti-sun (at least 2)
+	const int     n_p           //number of nodes around the sun (at least 1)
+	){
+	if(n_g<2 || n_p<1){
+		return NULL;
+	}
+	SkyTable * table = ALLOC(SkyTable);
+	if(table==NULL){
+		return NULL;
+	}
+	size_t NodeNum = (size_t)n_g*n_p;
+	table->n_g = n_g;
+	table->n_p = n_p;
+	table->Q = (double *)calloc(NodeNum,sizeof(double));
+	table->U = (double *)calloc(NodeNum,sizeof(double));
+	table->QFloat = (float *)calloc(NodeNum,sizeof(float));
+	table->UFloat = (float *)calloc(NodeNum,sizeof(float));
+	if(table->Q==NULL || table->U==NULL || table->QFloat==NULL || table->UFloat==NULL){
+		SkyTableFree(table);
+		return NULL;
+	}
+	return table;
+}
+
+
+
+//Set the polarization of a node of a grid.
+void SkyTableSetNode(
+	SkyTable *	table,          //grid
+	const int     i,            //node from the sun, 0 to n_g-1
+	const int     j,            //node around the sun, 0 to n_p-1
+	const double  DOP,          //DOP
+	const double  psi           //angle of the E-vector from the Rayleigh E-vector, positive towards the sun (unit is degree)
+	){
+	size_t n = (size_t)i*table->n_p+j;
+	table->Q[n] = DOP*cos(psi*pi/90.0);
+	table->U[n] = DOP*sin(psi*pi/90.0);
+	table->QFloat[n] = (float)table->Q[n];
+	table->UFloat[n] = (float)table->U[n];
+}
+
+
+
+//Sample a sky model on a grid.
+SkyTable * SkyTableSample(
+	const SkyModel *	sky,    //sky model
+	const int     n_g,          //number of nodes from the sun to the anti-sun (at least 2)
+	const int     n_p           //number of nodes around the sun (at least 1)
+	){
+	SkyTable * table = SkyTableInit(n_g,n_p);
+	if(table==NULL){
+		return NULL;
+	}
+	for(int i=0; i<n_g; i++){
+		//the E-vector is undefined at the sun and the anti-sun, so their nodes take it from next to them
+		double sita = i*pi/(n_g-1);
+		sita = sita<1e-8 ? 1e-8 : (sita>pi-1e-8 ? pi-1e-8 : sita);
+		for(int j=0; j<n_p; j++){
+			double fi = j*2.0*pi/n_p;
+			double Vector_v_P[3][1] = {sin(sita)*cos(fi),sin(sita)*sin(fi),cos(sita)};
+			double DOP;
+			double E_v_P[3][1];
+			SkyModelPixel(sky,Vector_v_P,DOP,E_v_P);
+
+			//psi from the components of the E-vector along fi and sita
+			double E_fi = -sin(fi)*E_v_P[0][0]+cos(fi)*E_v_P[1][0];
+			double E_sita = cos(sita)*cos(fi)*E_v_P[0][0]+cos(sita)*sin(fi)*E_v_P[1][0]-sin(sita)*E_v_P[2][0];
+			SkyTableSetNode(table,i,j,DOP,atan2(-E_sita,E_fi)*180/pi);
+		}
+	}
+	return table;
+}
+
+
+
+//Read a grid from a text file.
+SkyTable * SkyTableLoad(
+	const char *  path          //text file: "n_g n_p", then one line "gamma phi DOP psi" (unit is degree) per node
+	){
+	FILE * file = fopen(path,"r");
+	if(file==NULL){
+		return NULL;
+	}
+	int n_g, n_p;
+	SkyTable * table = NULL;
+	if(fscanf(file,"%d %d",&n_g,&n_p)==2){
+		table = SkyTableInit(n_g,n_p);
+	}
+	for(int i=0; table!=NULL && i<n_g; i++){
+		for(int j=0; j<n_p; j++){
+			//the nodes have to be listed in the order of the grid
+			double gamma, phi, DOP, psi;
+			if(fscanf(file,"%lf %lf %lf %lf",&gamma,&phi,&DOP,&psi)!=4
+				|| fabs(gamma-i*180.0/(n_g-1))>1e-6 || fabs(phi-j*360.0/n_p)>1e-6){
+				SkyTableFree(table);
+				table = NULL;
+				break;
+			}
+			SkyTableSetNode(table,i,j,DOP,psi);
+		}
+	}
+	fclose(file);
+	return table;
+}
+
+
+
+//Write a grid to a text file readable by "SkyTableLoad()".
+int SkyTableSave(
+	const SkyTable *	table,  //grid
+	const char *  path          //text file
+	){
+	FILE * file = fopen(path,"w");
+	if(file==NULL){
+		return -1;
+	}
+	fprintf(file,"%d %d\n",table->n_g,table->n_p);
+	for(int i=0; i<table->n_g; i++){
+		for(int j=0; j<table->n_p; j++){
+			size_t n = (size_t)i*table->n_p+j;
+			double DOP = sqrt(table->Q[n]*table->Q[n]+table->U[n]*table->U[n]);
+			double psi = 0.5*atan2(table->U[n],table->Q[n])*180/pi;
+			fprintf(file,"%.10f %.10f %.17g %.17g\n",i*180.0/(table->n_g-1),j*360.0/table->n_p,DOP,psi);
+		}
+	}
+	return fclose(file)==0 ? 0 : -1;
+}
+
+
+
+//Release a grid.
+void SkyTableFree(
+	SkyTable *	table           //grid
+	){
+	if(table==NULL){
+		return;
+	}
+	free(table->Q);
+	free(table->U);
+	free(table->QFloat);
+	free(table->UFloat);
+	free(table);
+}
@@ -0,0 +1,150 @@
+#ifndef _SKYMODEL_H_
+#define _SKYMODEL_H_
+
+#include <stddef.h>
+
+//sky polarization models of SkyModel::Model
+#define SKY_MODEL_RAYLEIGH          0       //single scattering: DOP=DOP_max*sin^2/(1+cos^2), E-vector normal to the scattering plane
+#define SKY_MODEL_BERRY             1       //Rayleigh sky whose singularities at the sun and the anti-sun split into neutral points
+#define SKY_MODEL_TABLE             2       //bilinear interpolation of a measured grid (see SkyTable)
+
+//grid of a measured sky in solar vector coordinate system
+//Node (i, j) lies at the angle gamma_i=i*180/(n_g-1) degrees from the sun and the azimuth phi_j=j*360/n_p degrees
+//around it, measured from the x axis towards the y axis of the solar vector coordinate system. Its polarization is
+//stored as the normalized Stokes components Q=DOP*cos(2*psi) and U=DOP*sin(2*psi), psi being the angle of the E-vector
+//from the Rayleigh E-vector (normal to the plane of the sun and the shooting direction), positive towards the sun.
+typedef struct SkyTable
+{
+	int     n_g;            //number of nodes from the sun to the anti-sun (at least 2)
+	int     n_p;            //number of nodes around the sun (at least 1)
+	double *Q;              //Q of node (i, j) at Q[i*n_p+j]
+	double *U;              //U of node (i, j) at U[i*n_p+j]
+	float * QFloat;         //single precision copies for the float kernels
+	float * UFloat;
+}
+SkyTable;
+
+//sky polarization model
+typedef struct SkyModel
+{
+	int     Model;          //SKY_MODEL_RAYLEIGH, SKY_MODEL_BERRY or SKY_MODEL_TABLE
+	double  DOP_max;        //maximum DOP in the sky, scales the DOP of every model
+	double  NeutralPoint;   //angle of the neutral points from the sun and the anti-sun (unit is degree, SKY_MODEL_BERRY)
+	const SkyTable *	Table;  //measured grid of SKY_MODEL_TABLE, owned by the caller
+}
+SkyModel;
+
+//Rayleigh sky with DOP_max=1, the sky of "CameraSimulation()".
+void SkyModelDefault(
+	SkyModel *	sky         //sky model
+	);
+
+//Rayleigh sky with a maximum DOP.
+void SkyModelRayleigh(
+	SkyModel *	sky,        //sky model
+	const double  DOP_max   //maximum DOP in the sky
+	);
+
+//Rayleigh sky with the Babinet and Brewster points above and below the sun and the Arago point and its
+//counterpart next to the anti-sun (Berry, Dennis and Lee, New J. Phys. 6, 162, 2004).
+void SkyModelBerry(
+	SkyModel *	sky,                //sky model
+	const double  DOP_max,          //maximum DOP in the sky
+	const double  NeutralPoint      //angle of the neutral points from the sun and the anti-sun (unit is degree)
+	);
+
+//Sky interpolated from a measured grid.
+void SkyModelTabulated(
+	SkyModel *	sky,                //sky model
+	const SkyTable *	table       //measured grid, owned by the caller
+	);
+
+//DOP and E-vector of a shooting direction in solar vector coordinate system (reference scalar code of the models).
+void SkyModelPixel(
+	const SkyModel *	sky,            //sky model
+	const double  (&Vector_v_P)[3][1],  //shooting direction in solar vector coordinate system (any length)
+	double &	DOP,                    //DOP
+	double  (&E_v_P)[3][1]              //polarization E-vector in solar vector coordinate system, 0 at the sun and the anti-sun
+	);
+
+//DOP and AOP of a shooting direction in body coordinate system.
+void SkyModelRay(
+	const SkyModel *	sky,        //sky model
+	const double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],   //rotation matrix from body to solar vector coordinate system
+	const double  (&Ray)[3],        //shooting direction in body coordinate system (any length)
+	double &	DOP,                //DOP
+	double &	AOP                 //AOP (unit is degree)
+	);
+
+//Normalized Stokes components S1=DOP*cos(2*AOP) and S2=DOP*sin(2*AOP) of a shooting direction in body coordinate system.
+void SkyModelStokes(
+	const SkyModel *	sky,        //sky model
+	const double  (&C_vTb)[3][3],   //rotation matrix from solar vector to body coordinate system
+	const double  (&C_bTv)[3][3],   //rotation matrix from body to solar vector coordinate system
+	const double  (&Ray)[3],        //shooting direction in body coordinate system (any length)
+	double &	S1,                 //S1/S0
+	double &	S2                  //S2/S0
+	);
+
+//Allocate an unpolarized grid.
+SkyTable * SkyTableInit(
+	const int     n_g,          //number of nodes from the sun to the anti-sun (at least 2)
+	const int     n_p           //number of nodes around the sun (at least 1)
+	);
+
+//Set the polarization of a node of a grid.
+void SkyTableSetNode(
+	SkyTable *	table,          //grid
+	const int     i,            //node from the sun, 0 to n_g-1
+	const int     j,            //node around the sun, 0 to n_p-1
+	const double  DOP,          //DOP
+	const double  psi           //angle of the E-vector from the Rayleigh E-vector, positive towards the sun (unit is degree)
+	);
+
+//Sample a sky model on a grid.
+SkyTable * SkyTableSample(
+	const SkyModel *	sky,    //sky model
+	const int     n_g,          //number of nodes from the sun to the anti-sun (at least 2)
+	const int     n_p           //number of nodes around the sun (at least 1)
+	);
+
+//Read a grid from a text file.
+SkyTable * SkyTableLoad(
+	const char *  path          //text file: "n_g n_p", then one line "gamma phi DOP psi" (unit is degree) per node
+	);
+
+//Write a grid to a text file readable by "SkyTableLoad()".
+int SkyTableSave(
+	const SkyTable *	table,  //grid
+	const char *  path          //text file
+	);
+
+//Release a grid.
+void SkyTableFree(
+	SkyTable *	table           //grid
+	);
+
+//Bilinear cell of a grid location, shared by the scalar and the vectorized code.
+inline void SkyTableCell(
+	const SkyTable *	table,  //grid
+	double  g,                  //gamma/(180/(n_g-1)), the location from the sun in nodes
+	double  p,                  //phi/(360/n_p), the location around the sun in nodes
+	size_t  (&node)[4],         //nodes (i, j), (i, j+1), (i+1, j), (i+1, j+1)
+	double &	t_g,            //weight of the nodes i+1
+	double &	t_p             //weight of the nodes j+1
+	){
+	g = g>0.0 ? g : 0.0;	//also NaN
+	p = p>0.0 ? p : 0.0;
+	int i = g<table->n_g-1 ? (int)g : table->n_g-2;
+	int j = p<table->n_p ? (int)p : table->n_p-1;
+	t_g = g-i>1.0 ? 1.0 : g-i;
+	t_p = p-j>1.0 ? 1.0 : p-j;
+	int j1 = j+1<table->n_p ? j+1 : 0;	//around the sun the grid is periodic
+	node[0] = (size_t)i*table->n_p+j;
+	node[1] = (size_t)i*table->n_p+j1;
+	node[2] = (size_t)(i+1)*table->n_p+j;
+	node[3] = (size_t)(i+1)*table->n_p+j1;
+}
+
+#endif
@@ -0,0 +1,278 @@
+/*
+Solar Ephemeris of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for computing the position of the sun for a location and a UTC time, and the attitude of the camera relative to it.
+And this code is written in Microsoft Visual Studio 2010 C++.
+
+Usage information:
+Turn a geodetic location, a UTC time and a body attitude in the local east-north-up coordinate system into the Euler angles of "CameraSimulation()".
+--------------------------
+
+Coordinate systems:
+	The local level coordinate system has its x axis to the east, its y axis to the north and its z axis up
+	(east-north-up). A body attitude in it is given by Heading, Pitch and Roll with the convention of
+	"MatrixEulerRotation()": the body y axis points Heading radians from north towards east and Pitch radians above
+	the horizon, and Roll turns the body about its y axis. The solar vector coordinate system is the local level
+	coordinate system turned by the sun's azimuth and by 90 degrees minus its elevation, so its z axis points to the
+	sun. "SolarCameraAttitude()" combines both rotations into the Euler angles psa, afa and beta of the simulation.
+
+Solar position:
+	The low precision formulas of the Astronomical Almanac as used by the NOAA solar calculator (Meeus,
+	Astronomical Algorithms, chapter 25): mean longitude, mean anomaly and equation of center of the sun, the
+	apparent longitude with the main nutation and aberration terms, the obliquity of the ecliptic and Greenwich
+	mean sidereal time. Over 1950 to 2050 the direction is within about 0.01 degree of the full theory, far below
+	the attitude resolution of a polarization camera; the difference between UTC and terrestrial time (about a
+	minute) changes it by less than 0.001 degree and is neglected. There is no atmospheric refraction: the
+	scattering geometry of the sky follows the true direction of the sun. A sun below the horizon is returned as
+	it is (twilight skies keep the Rayleigh pattern).
+
+
+Function 1: "SolarJulianDay()" 
+
+    //Julian day of a UTC date and time (Gregorian calendar).
+	double SolarJulianDay(
+		const SolarTime *	time
+	);
+	--------------input----------------
+	const SolarTime *	time    //UTC date and time
+	-----------------------------------
+	-------------output----------------
+	double                      //Julian day, e.g. 2451545.0 for 2000 January 1 12:00 UTC
+	-----------------------------------
+
+
+Function 2: "SolarPosition()" 
+
+    //Topocentric position of the sun without atmospheric refraction.
+	void SolarPosition(
+		const SolarLocation *	location,
+		const double  JulianDay,
+		double &	Azimuth,
+		double &	Elevation
+	);
+	--------------input----------------
+	const SolarLocation *	location,   //geodetic location (unit is degree)
+	const double  JulianDay,            //Julian day of the UTC time
+	-----------------------------------
+	-------------output----------------
+	double &	Azimuth,                //azimuth of the sun from north towards east, 0 to 360 (unit is degree)
+	double &	Elevation               //elevation of the sun above the horizon, -90 to 90 (unit is degree)
+	-----------------------------------
+
+
+Function 3: "SolarVectorENU()" 
+
+    //Unit sun vector in the local east-north-up coordinate system.
+	void SolarVectorENU(
+		const double  Azimuth,
+		const double  Elevation,
+		double  (&Sun)[3]
+	);
+	--------------input----------------
+	const double  Azimuth,      //azimuth of the sun from north towards east (unit is degree)
+	const double  Elevation,    //elevation of the sun (unit is degree)
+	-----------------------------------
+	-------------output----------------
+	double  (&Sun)[3]           //{cos(Elevation)*sin(Azimuth), cos(Elevation)*cos(Azimuth), sin(Elevation)}
+	-----------------------------------
+
+
+Function 4: "SolarCameraAttitude()" 
+
+    //Three Euler angles of camera of a body attitude in the local east-north-up coordinate system and a sun position.
+	void SolarCameraAttitude(
+		const double  Azimuth,
+		const double  Elevation,
+		const double  Heading,
+		const double  Pitch,
+		const double  Roll,
+		double &	psa,
+		double &	afa,
+		double &	beta
+	);
+	--------------input----------------
+	const double  Azimuth,      //azimuth of the sun from north towards east (unit is degree)
+	const double  Elevation,    //elevation of the sun (unit is degree)
+	const double  Heading,      //yaw angle of the body in east-north-up coordinate system (unit is radian)
+	const double  Pitch,        //pitch angle of the body in east-north-up coordinate system (unit is radian)
+	const double  Roll,         //roll angle of the body in east-north-up coordinate system (unit is radian)
+	-----------------------------------
+	-------------output----------------
+	double &	psa,            //yaw angle (unit is radian)
+	double &	afa,            //pitch angle (unit is radian)
+	double &	beta            //roll angle (unit is radian)
+	-----------------------------------
+	C_vTb = C_nTb*C_vTn with C_nTb=MatrixEulerRotation(Heading,Pitch,Roll) and
+	C_vTn=MatrixEulerRotation(Azimuth,Elevation-90 degrees,0)', then "MatrixEulerAngles()" of C_vTb, so
+	"CameraRotationMatrix(psa,afa,beta,...)" gives C_vTb back to rounding.
+
+Example:
+
+	SolarLocation location = {32.03,118.85};                //Nanjing
+	SolarTime time = {2019,10,23,4,30,0.0};                 //12:30 Beijing time
+	double Azimuth, Elevation, psa, afa, beta;
+	SolarPosition(&location,SolarJulianDay(&time),Azimuth,Elevation);
+	SolarCameraAttitude(Azimuth,Elevation,0.0,90.0*pi/180.0,0.0,psa,afa,beta);	//camera body pointing at the zenith
+	CameraSimulation(psa,afa,beta,Camera_paremeters);
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include <math.h>
+#include "SolarEphemeris.h"
+#include "MatrixTemplate.h"
+
+const static double pi = 3.141592653589793;
+
+
+
+//Julian day of a UTC date and time (Gregorian calendar).
+double SolarJulianDay(
+	const SolarTime *	time    //UTC date and time
+	){
+	//January and February count as the months 13 and 14 of the previous year
+	int Y = time->Year;
+	int M = time->Month;
+	if(M<=2){
+		Y = Y-1;
+		M = M+12;
+	}
+	int A = (int)floor(Y/100.0);
+	int B = 2-A+(int)floor(A/4.0);
+	double day = floor(365.25*(Y+4716))+floor(30.6001*(M+1))+time->Day+B-1524.5;
+	return day+(time->Hour+(time->Minute+time->Second/60.0)/60.0)/24.0;
+}
+
+
+
+//Topocentric position of the sun without atmospheric refraction.
+void SolarPosition(
+	const SolarLocation *	location,   //geodetic location
+	const double  JulianDay,            //Julian day of the UTC time (see "SolarJulianDay()")
+	double &	Azimuth,                //azimuth of the sun from north towards east, 0 to 360 (unit is degree)
+	double &	Elevation               //elevation of the sun above the horizon, -90 to 90 (unit is degree)
+	){
+	const double rad = pi/180.0;
+	double d = JulianDay-2451545.0;	//days from J2000.0
+	double T = d/36525.0;           //Julian centuries from J2000.0
+
+	//geometric mean longitude, mean anomaly and equation of center of the sun (unit is degree)
+	double L0 = fmod(280.46646+T*(36000.76983+T*0.0003032),360.0);
+	double M = 357.52911+T*(35999.05029-T*0.0001537);
+	double C = sin(M*rad)*(1.914602-T*(0.004817+T*0.000014))+sin(2.0*M*rad)*(0.019993-T*0.000101)
+		+sin(3.0*M*rad)*0.000289;
+
+	//apparent longitude and obliquity of the ecliptic with the main nutation term
+	double omega = 125.04-1934.136*T;
+	double lambda = L0+C-0.00569-0.00478*sin(omega*rad);
+	double epsilon = 23.0+(26.0+(21.448-T*(46.815+T*(0.00059-T*0.001813)))/60.0)/60.0+0.00256*cos(omega*rad);
+
+	//right ascension and declination
+	double alpha = atan2(cos(epsilon*rad)*sin(lambda*rad),cos(lambda*rad));
+	double delta = asin(sin(epsilon*rad)*sin(lambda*rad));
+
+	//Greenwich mean sidereal time and local hour angle
+	double theta = 280.46061837+360.98564736629*d+T*T*(0.000387933-T/38710000.0);
+	double H = fmod(theta+location->Longitude,360.0)*rad-alpha;
+
+	//horizontal coordinates
+	double phi = location->Latitude*rad;
+	double s = sin(phi)*sin(delta)+cos(phi)*cos(delta)*cos(H);
+	s = s>1.0 ? 1.0 : (s<-1.0 ? -1.0 : s);
+	Elevation = asin(s)/rad;
+	Azimuth = atan2(-sin(H)*cos(delta),cos(phi)*sin(delta)-sin(phi)*cos(delta)*cos(H))/rad;
+	if(Azimuth<0.0){
+		Azimuth = Azimuth+360.0;
+	}
+}
+
+
+
+//Unit sun vector in the local east-north-up coordinate system.
+void SolarVectorENU(
+	const double  Azimuth,      //azimuth of the sun from north towards east (unit is degree)
+	const double  Elevation,    //elevation of the sun (unit is degree)
+	double  (&Sun)[3]           //east, north and up components
+	){
+	Sun[0] = cos(Elevation*pi/180.0)*sin(Azimuth*pi/180.0);
+	Sun[1] = cos(Elevation*pi/180.0)*cos(Azimuth*pi/180.0);
+	Sun[2] = sin(Elevation*pi/180.0);
+}
+
+
+
+//Three Euler angles of camera (from body to solar vector coordinate system) of a body attitude in the local
+//east-north-up coordinate system and a sun position.
+void SolarCameraAttitude(
+	const double  Azimuth,      //azimuth of the sun from north towards east (unit is degree)
+	const double  Elevation,    //elevation of the sun (unit is degree)
+	const double  Heading,      //yaw angle of the body in east-north-up coordinate system (unit is radian)
+	const double  Pitch,        //pitch angle of the body in east-north-up coordinate system (unit is radian)
+	const double  Roll,         //roll angle of the body in east-north-up coordinate system (unit is radian)
+	double &	psa,            //yaw angle (unit is radian)
+	double &	afa,            //pitch angle (unit is radian)
+	double &	beta            //roll angle (unit is radian)
+	){
+	//rotation matrix from east-north-up to body coordinate system
+	double C_nTb[3][3];
+	MatrixEulerRotation(Heading,Pitch,Roll,C_nTb);
+
+	//rotation matrix from east-north-up to solar vector coordinate system, its third row is the sun vector
+	double C_nTv[3][3], C_vTn[3][3];
+	MatrixEulerRotation(Azimuth*pi/180.0,(Elevation-90.0)*pi/180.0,0.0,C_nTv);
+	MatrixTrans(C_nTv,C_vTn);
+
+	//rotation matrix from solar vector to body coordinate system
+	double C_vTb[3][3];
+	MatrixMultiply(C_nTb,C_vTn,C_vTb);
+	MatrixEulerAngles(C_vTb,psa,afa,beta);
+}
@@ -0,0 +1,57 @@
+#ifndef _SOLAREPHEMERIS_H_
+#define _SOLAREPHEMERIS_H_
+
+//UTC date and time
+typedef struct SolarTime
+{
+	int     Year;           //e.g. 2019
+	int     Month;          //1 to 12
+	int     Day;            //1 to 31
+	int     Hour;           //0 to 23
+	int     Minute;         //0 to 59
+	double  Second;         //0 to 60
+}
+SolarTime;
+
+//geodetic location on the WGS84 ellipsoid
+typedef struct SolarLocation
+{
+	double  Latitude;       //geodetic latitude, north positive (unit is degree)
+	double  Longitude;      //longitude, east positive (unit is degree)
+}
+SolarLocation;
+
+//Julian day of a UTC date and time (Gregorian calendar).
+double SolarJulianDay(
+	const SolarTime *	time    //UTC date and time
+	);
+
+//Topocentric position of the sun without atmospheric refraction.
+void SolarPosition(
+	const SolarLocation *	location,   //geodetic location
+	const double  JulianDay,            //Julian day of the UTC time (see "SolarJulianDay()")
+	double &	Azimuth,                //azimuth of the sun from north towards east, 0 to 360 (unit is degree)
+	double &	Elevation               //elevation of the sun above the horizon, -90 to 90 (unit is degree)
+	);
+
+//Unit sun vector in the local east-north-up coordinate system.
+void SolarVectorENU(
+	const double  Azimuth,      //azimuth of the sun from north towards east (unit is degree)
+	const double  Elevation,    //elevation of the sun (unit is degree)
+	double  (&Sun)[3]           //east, north and up components
+	);
+
+//Three Euler angles of camera (from body to solar vector coordinate system) of a body attitude in the local
+//east-north-up coordinate system and a sun position.
+void SolarCameraAttitude(
+	const double  Azimuth,      //azimuth of the sun from north towards east (unit is degree)
+	const double  Elevation,    //elevation of the sun (unit is degree)
+	const double  Heading,      //yaw angle of the body in east-north-up coordinate system (unit is radian)
+	const double  Pitch,        //pitch angle of the body in east-north-up coordinate system (unit is radian)
+	const double  Roll,         //roll angle of the body in east-north-up coordinate system (unit is radian)
+	double &	psa,            //yaw angle (unit is radian)
+	double &	afa,            //pitch angle (unit is radian)
+	double &	beta            //roll angle (unit is radian)
+	);
+
+#endif
@@ -0,0 +1,214 @@
+/*
+Thread pool of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for running the independent pixels of a frame on several cores.
+And this code is written in C++11.
+
+Usage information:
+Using the code to split frames into row bands that are simulated in parallel.
+--------------------------
+
+Class: "ThreadPool" 
+
+    //Create a pool with NumThreads threads (NumThreads<=0 uses every hardware thread).
+	ThreadPool pool(NumThreads);
+
+    //Run task(begin,end) over [0,count) in chunks of grain indices and wait until all chunks are done.
+	void ParallelFor(
+		const int  count,
+		const int  grain,
+		const std::function<void(int,int)> &	task
+	);
+	--------------input----------------
+	const int  count,   //number of indices
+	const int  grain,   //number of indices per chunk
+	const std::function<void(int,int)> &	task  //task(begin,end) for one chunk, called concurrently
+	-----------------------------------
+
+	Chunks are handed out in increasing order. The thread calling "ParallelFor()" works on chunks as well,
+	so a pool of one thread runs the loop serially without any synchronization.
+
+--------------------------
+========================================================================== 
+*/
+
+
+#include "ThreadPool.h"
+
+//true on the worker threads of any pool and while a thread runs a ParallelFor() task
+static thread_local bool InsideTask = false;
+
+
+
+//Create NumThreads-1 worker threads.
+ThreadPool::ThreadPool(const int NumThreads)
+	: Task(NULL), Count(0), Grain(1), Next(0), Active(0), Generation(0), Stop(false)
+{
+	int threads = NumThreads;
+	if(threads<=0){
+		threads = (int)std::thread::hardware_concurrency();
+	}
+	if(threads<=0){
+		threads = 1;
+	}
+	for(int i=1; i<threads; i++){
+		Workers.push_back(std::thread(&ThreadPool::WorkerLoop,this));
+	}
+}
+
+
+
+//Stop and join the worker threads.
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(StateMutex);
+		Stop = true;
+	}
+	WakeUp.notify_all();
+	for(size_t i=0; i<Workers.size(); i++){
+		Workers[i].join();
+	}
+}
+
+
+
+//Number of threads taking part in ParallelFor(), including the calling thread.
+int ThreadPool::Size() const
+{
+	return (int)Workers.size()+1;
+}
+
+
+
+//Take chunks of the current job until none is left.
+void ThreadPool::RunChunks()
+{
+	for(;;){
+		int begin = Next.fetch_add(Grain);
+		if(begin>=Count){
+			break;
+		}
+		int end = begin+Grain<Count ? begin+Grain : Count;
+		(*Task)(begin,end);
+	}
+}
+
+
+
+//Wait for jobs and run their chunks.
+void ThreadPool::WorkerLoop()
+{
+	InsideTask = true;
+	unsigned seen = 0;
+	for(;;){
+		{
+			std::unique_lock<std::mutex> lock(StateMutex);
+			while(!Stop && Generation==seen){
+				WakeUp.wait(lock);
+			}
+			if(Stop){
+				return;
+			}
+			seen = Generation;
+		}
+		RunChunks();
+		{
+			std::lock_guard<std::mutex> lock(StateMutex);
+			Active--;
+			if(Active==0){
+				Finished.notify_one();
+			}
+		}
+	}
+}
+
+
+
+//Run task(begin,end) over [0,count) in chunks of grain indices and wait until all chunks are done.
+void ThreadPool::ParallelFor(
+	const int  count,   //number of indices
+	const int  grain,   //number of indices per chunk
+	const std::function<void(int,int)> &	task  //task(begin,end) for one chunk
+	)
+{
+	if(count<=0){
+		return;
+	}
+	int chunk = grain>0 ? grain : 1;
+	if(Workers.empty() || InsideTask || count<=chunk){
+		for(int begin=0; begin<count; begin+=chunk){
+			task(begin,begin+chunk<count ? begin+chunk : count);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> job(JobMutex);
+	{
+		std::lock_guard<std::mutex> lock(StateMutex);
+		Task = &task;
+		Count = count;
+		Grain = chunk;
+		Next.store(0);
+		Active = (int)Workers.size();
+		Generation++;
+	}
+	WakeUp.notify_all();
+
+	InsideTask = true;
+	RunChunks();
+	InsideTask = false;
+
+	std::unique_lock<std::mutex> lock(StateMutex);
+	while(Active>0){
+		Finished.wait(lock);
+	}
+	Task = NULL;
+}
@@ -0,0 +1,53 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+//fixed-size pool of worker threads running one parallel loop at a time
+class ThreadPool
+{
+public:
+	//Create NumThreads-1 worker threads; the thread calling ParallelFor() is the last one.
+	//NumThreads<=0 uses every hardware thread.
+	explicit ThreadPool(const int NumThreads);
+	~ThreadPool();
+
+	//Number of threads taking part in ParallelFor(), including the calling thread.
+	int Size() const;
+
+	//Run task(begin,end) over [0,count) in chunks of grain indices and wait until all chunks are done.
+	//Calls from inside a task run serially on the calling thread.
+	void ParallelFor(
+		const int  count,   //number of indices
+		const int  grain,   //number of indices per chunk
+		const std::function<void(int,int)> &	task  //task(begin,end) for one chunk
+		);
+
+private:
+	ThreadPool(const ThreadPool &);
+	ThreadPool & operator=(const ThreadPool &);
+
+	void WorkerLoop();
+	void RunChunks();
+
+	std::vector<std::thread>  Workers;
+	std::mutex                JobMutex;      //serializes ParallelFor() calls
+	std::mutex                StateMutex;
+	std::condition_variable   WakeUp;
+	std::condition_variable   Finished;
+
+	const std::function<void(int,int)> *  Task;
+	int                       Count;
+	int                       Grain;
+	std::atomic<int>          Next;          //first index of the next chunk
+	int                       Active;        //workers still running the current job
+	unsigned                  Generation;    //incremented for every job
+	bool                      Stop;
+};
+
+#endif
@@ -0,0 +1,364 @@
+"""Python interface of Hypothetical Polarization Camera.
+
+A thin ctypes wrapper of the C interface of the shared library (CameraAPI.h). The DOP and AOP planes are
+returned as NumPy arrays (memoryviews without NumPy) over the memory the library simulated into, so a frame is
+neither copied nor parsed:
+
+    import hpcamera
+    with hpcamera.Camera(n_x=1024, n_z=1280, dtype="float32") as camera:
+        DOP, AOP = camera.simulate(psa, afa, beta)      # views of the frame of the camera (radian, degree)
+        stack = numpy.empty((2, 100, 1024, 1280), numpy.float32)
+        for k in range(100):
+            camera.simulate_into(psa[k], afa[k], beta[k], stack[0, k], stack[1, k])
+
+The library is looked up in HPC_LIBRARY, next to this file and in the build folder of the repository.
+
+FrameClient talks to a frame server ("HypotheticalPolarizationCamera --serve path", FrameServer.h) instead and
+needs neither the library nor ctypes calls; its slots are mapped from the server's shared memory:
+
+    with hpcamera.FrameClient("/tmp/hpcamera.sock", n_x=1024, n_z=1280, slots=4) as client:
+        for k in range(4):
+            client.submit(k, psa[k], afa[k], beta[k])       # pipelined
+        for k in range(4):
+            reply = client.receive()
+            DOP, AOP = client.planes(reply["slot"])         # views of the slot until it is requested again
+"""
+
+import ctypes
+import mmap
+import os
+import socket
+import struct
+import sys
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+API_VERSION = 1
+
+DTYPE_FLOAT64 = 0
+DTYPE_FLOAT32 = 1
+
+PLANE_DOP = 0
+PLANE_AOP = 1
+
+KERNEL_AUTO = 0
+KERNEL_SCALAR = 1
+KERNEL_SSE2 = 2
+KERNEL_AVX2 = 3
+KERNEL_AVX512 = 4
+KERNEL_CLOSED_FORM = 5
+
+PROJECTION_PINHOLE = 0
+PROJECTION_EQUIDISTANT = 1
+PROJECTION_EQUISOLID = 2
+PROJECTION_STEREOGRAPHIC = 3
+
+SKY_RAYLEIGH = 0
+SKY_BERRY = 1
+
+SERVER_VERSION = 1
+SERVER_OPEN = 1
+SERVER_FRAME = 2
+SERVER_STATS = 3
+SERVER_SHUTDOWN = 4
+
+# messages of FrameServer.h in native byte order and alignment
+_REQUEST = struct.Struct("@iiQddd24x")
+_CAMERA = struct.Struct("@iiiiddiidiiddddddiidd")
+_SERVER_LAYOUT = struct.Struct("@iiiiiiqqq16x")
+_REPLY = struct.Struct("@iiQiiQQ24x")
+_STATS = struct.Struct("@iiQQQQQQQ")
+
+_DTYPES = {"float64": DTYPE_FLOAT64, "float32": DTYPE_FLOAT32}
+_SCALARS = {DTYPE_FLOAT64: (ctypes.c_double, "d"), DTYPE_FLOAT32: (ctypes.c_float, "f")}
+
+
+class FrameLayout(ctypes.Structure):
+    """HpcFrameLayout: shape, value type and byte strides of the planes of a camera."""
+    _fields_ = [
+        ("Rows", ctypes.c_int32),
+        ("Cols", ctypes.c_int32),
+        ("DType", ctypes.c_int32),
+        ("ItemSize", ctypes.c_int32),
+        ("RowStride", ctypes.c_int64),
+        ("ColStride", ctypes.c_int64),
+        ("PixelInterval", ctypes.c_int32),
+        ("Padding", ctypes.c_int32),
+        ("Reserved", ctypes.c_int64 * 3),
+    ]
+
+
+def _library_names():
+    if sys.platform.startswith("win"):
+        return ["hpcamera.dll"]
+    if sys.platform == "darwin":
+        return ["libhpcamera.dylib"]
+    return ["libhpcamera.so"]
+
+
+def load(path=None):
+    """Load the shared library and declare the functions of CameraAPI.h."""
+    candidates = []
+    if path is None:
+        path = os.environ.get("HPC_LIBRARY")
+    if path is not None:
+        candidates.append(path)
+    here = os.path.dirname(os.path.abspath(__file__))
+    for folder in (here, os.path.join(here, "..", "..", "build")):
+        candidates += [os.path.join(folder, name) for name in _library_names()]
+    candidates += _library_names()
+
+    errors = []
+    for candidate in candidates:
+        if os.path.sep in candidate and not os.path.exists(candidate):
+            continue
+        try:
+            lib = ctypes.CDLL(candidate)
+            break
+        except OSError as error:
+            errors.append(str(error))
+    else:
+        raise OSError("hpcamera library not found (set HPC_LIBRARY): " + "; ".join(errors))
+
+    camera = ctypes.c_void_p
+    lib.HpcApiVersion.argtypes = []
+    lib.HpcApiVersion.restype = ctypes.c_int
+    lib.HpcCameraCreate.argtypes = [ctypes.c_double, ctypes.c_double, ctypes.c_int, ctypes.c_int,
+                                    ctypes.c_double, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+    lib.HpcCameraCreate.restype = camera
+    lib.HpcCameraDestroy.argtypes = [camera]
+    lib.HpcCameraDestroy.restype = None
+    lib.HpcCameraSetKernel.argtypes = [camera, ctypes.c_int]
+    lib.HpcCameraSetKernel.restype = ctypes.c_int
+    lib.HpcCameraSetLens.argtypes = [camera, ctypes.c_int] + [ctypes.c_double] * 6
+    lib.HpcCameraSetLens.restype = ctypes.c_int
+    lib.HpcCameraSetSky.argtypes = [camera, ctypes.c_int, ctypes.c_double, ctypes.c_double]
+    lib.HpcCameraSetSky.restype = ctypes.c_int
+    lib.HpcCameraLayout.argtypes = [camera, ctypes.POINTER(FrameLayout)]
+    lib.HpcCameraLayout.restype = ctypes.c_int
+    lib.HpcCameraSimulate.argtypes = [camera, ctypes.c_double, ctypes.c_double, ctypes.c_double]
+    lib.HpcCameraSimulate.restype = ctypes.c_int
+    lib.HpcCameraPlane.argtypes = [camera, ctypes.c_int]
+    lib.HpcCameraPlane.restype = ctypes.c_void_p
+    lib.HpcCameraSimulateInto.argtypes = [camera, ctypes.c_double, ctypes.c_double, ctypes.c_double,
+                                          ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int64]
+    lib.HpcCameraSimulateInto.restype = ctypes.c_int
+
+    if lib.HpcApiVersion() != API_VERSION:
+        raise OSError("hpcamera library has interface version %d, expected %d" % (lib.HpcApiVersion(), API_VERSION))
+    return lib
+
+
+class Camera(object):
+    """Camera of the shared library; D_x and D_z in micrometer, f in millimeter, angles in radian."""
+
+    def __init__(self, D_x=5.2, D_z=5.2, n_x=1024, n_z=1280, f=4.0, pixel_interval=1, dtype="float64",
+                 threads=0, library=None):
+        self._lib = library if library is not None else load()
+        self._handle = None
+        if dtype not in _DTYPES:
+            raise ValueError("dtype must be 'float64' or 'float32'")
+        handle = self._lib.HpcCameraCreate(D_x, D_z, n_x, n_z, f, pixel_interval, _DTYPES[dtype], threads)
+        if not handle:
+            raise ValueError("invalid camera parameters or out of memory")
+        self._handle = handle
+        self.layout = FrameLayout()
+        self._lib.HpcCameraLayout(self._handle, ctypes.byref(self.layout))
+        self.dtype = dtype
+        self.shape = (self.layout.Rows, self.layout.Cols)
+
+    def close(self):
+        """Destroy the camera; views of its frame must not be used afterwards."""
+        if self._handle:
+            self._lib.HpcCameraDestroy(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def _check(self, status, what):
+        if status != 0:
+            raise ValueError(what)
+
+    def set_kernel(self, kernel):
+        self._check(self._lib.HpcCameraSetKernel(self._handle, kernel), "invalid kernel type")
+
+    def set_lens(self, projection, field_of_view=0.0, k1=0.0, k2=0.0, k3=0.0, p1=0.0, p2=0.0):
+        self._check(self._lib.HpcCameraSetLens(self._handle, projection, field_of_view, k1, k2, k3, p1, p2),
+                    "invalid lens")
+
+    def set_sky(self, model=SKY_RAYLEIGH, dop_max=1.0, neutral_point=0.0):
+        self._check(self._lib.HpcCameraSetSky(self._handle, model, dop_max, neutral_point), "invalid sky model")
+
+    def _view(self, plane):
+        """Plane of the frame of the camera without copying."""
+        address = self._lib.HpcCameraPlane(self._handle, plane)
+        scalar, code = _SCALARS[self.layout.DType]
+        values = (scalar * (self.layout.Rows * self.layout.Cols)).from_address(address)
+        values._camera = self       # the frame lives as long as a view of it
+        view = memoryview(values).cast("B").cast(code, self.shape)
+        return numpy.asarray(view) if numpy is not None else view
+
+    @property
+    def dop(self):
+        """DOP of the last "simulate()" (a view, overwritten by the next one)."""
+        return self._view(PLANE_DOP)
+
+    @property
+    def aop(self):
+        """AOP of the last "simulate()" in degree (a view, overwritten by the next one)."""
+        return self._view(PLANE_AOP)
+
+    def simulate(self, psa, afa, beta):
+        """Simulate the frame of the camera and return views of its DOP and AOP planes."""
+        self._check(self._lib.HpcCameraSimulate(self._handle, psa, afa, beta), "simulation failed")
+        return self.dop, self.aop
+
+    def _buffer(self, array):
+        """Address and row stride of a writable buffer of the shape and type of the planes."""
+        if numpy is not None and isinstance(array, numpy.ndarray):
+            if array.dtype != numpy.dtype(self.dtype) or array.shape != self.shape:
+                raise ValueError("expected a %s array of shape %s" % (self.dtype, self.shape))
+            if not array.flags.writeable or array.strides[1] != self.layout.ItemSize:
+                raise ValueError("the array must be writable with contiguous rows")
+            return array.ctypes.data, array.strides[0]
+        view = memoryview(array)
+        if view.readonly or not view.c_contiguous or view.nbytes != self.shape[0] * self.layout.RowStride:
+            raise ValueError("expected a writable contiguous buffer of %d bytes" % (self.shape[0] * self.layout.RowStride))
+        return ctypes.addressof((ctypes.c_char * view.nbytes).from_buffer(view.cast("B"))), self.layout.RowStride
+
+    def simulate_into(self, psa, afa, beta, dop, aop):
+        """Simulate a frame into caller arrays (e.g. slices of a NumPy stack) with the same row stride."""
+        dop_address, dop_stride = self._buffer(dop)
+        aop_address, aop_stride = self._buffer(aop)
+        if dop_stride != aop_stride:
+            raise ValueError("DOP and AOP must have the same row stride")
+        self._check(self._lib.HpcCameraSimulateInto(self._handle, psa, afa, beta, dop_address, aop_address, dop_stride),
+                    "invalid buffers")
+
+
+
+class FrameClient(object):
+    """Connection to a frame server with a warm camera; D_x and D_z in micrometer, f in millimeter, angles in
+    radian. Frames arrive in shared memory slots, so "planes()" returns views that are never copied."""
+
+    def __init__(self, path, D_x=5.2, D_z=5.2, n_x=1024, n_z=1280, f=4.0, pixel_interval=1, dtype="float64",
+                 slots=4, kernel=KERNEL_AUTO, projection=PROJECTION_PINHOLE, field_of_view=0.0,
+                 k1=0.0, k2=0.0, k3=0.0, p1=0.0, p2=0.0, sky=SKY_RAYLEIGH, dop_max=1.0, neutral_point=0.0):
+        if dtype not in _DTYPES:
+            raise ValueError("dtype must be 'float64' or 'float32'")
+        self._map = None
+        self._socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            self._socket.connect(path)
+            camera = _CAMERA.pack(SERVER_VERSION, slots, _DTYPES[dtype], kernel, D_x, D_z, n_x, n_z, f,
+                                  pixel_interval, projection, field_of_view, k1, k2, k3, p1, p2, sky, 0,
+                                  dop_max, neutral_point)
+            self._socket.sendall(_REQUEST.pack(SERVER_OPEN, 0, 0, 0.0, 0.0, 0.0) + camera)
+            data, fds = self._receive_layout()
+            (status, self.slots, rows, cols, scalar, self.warm, self._plane_bytes, self._slot_bytes,
+             map_bytes) = _SERVER_LAYOUT.unpack(data)
+            if status != 0 or not fds:
+                raise ValueError("the server refused the camera configuration")
+            try:
+                self._map = mmap.mmap(fds[0], map_bytes, mmap.MAP_SHARED, mmap.PROT_READ)
+            finally:
+                for fd in fds:
+                    os.close(fd)
+        except Exception:
+            self.close()
+            raise
+        self.dtype = dtype
+        self.shape = (rows, cols)
+        self._scalar = scalar
+
+    def _receive_layout(self):
+        data, ancillary, flags, address = self._socket.recvmsg(_SERVER_LAYOUT.size, socket.CMSG_SPACE(4))
+        fds = []
+        for level, kind, payload in ancillary:
+            if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+                fds += list(struct.unpack("@%di" % (len(payload) // 4), payload[:len(payload) // 4 * 4]))
+        if not data:
+            raise ConnectionError("the server closed the connection")
+        while len(data) < _SERVER_LAYOUT.size:
+            data += self._receive(_SERVER_LAYOUT.size - len(data))
+        return data, fds
+
+    def _receive(self, size):
+        data = b""
+        while len(data) < size:
+            chunk = self._socket.recv(size - len(data))
+            if not chunk:
+                raise ConnectionError("the server closed the connection")
+            data += chunk
+        return data
+
+    def close(self):
+        """Close the connection; views of the slots must not be used afterwards."""
+        if self._map is not None:
+            try:
+                self._map.close()
+            except BufferError:
+                pass                # a view still refers to the slots, they are unmapped with it
+            self._map = None
+        if self._socket is not None:
+            self._socket.close()
+            self._socket = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def submit(self, slot, psa, afa, beta, sequence=0):
+        """Send a frame request without waiting; the slot must not be read until its reply arrived."""
+        self._socket.sendall(_REQUEST.pack(SERVER_FRAME, slot, sequence, psa, afa, beta))
+
+    def receive(self):
+        """Next reply, in the order of the requests, as a dict."""
+        kind, status, sequence, slot, batch, latency, simulation = _REPLY.unpack(self._receive(_REPLY.size))
+        if kind != SERVER_FRAME or status != 0:
+            raise ValueError("frame request %d failed" % sequence)
+        return {"sequence": sequence, "slot": slot, "batch": batch, "latency_ns": latency,
+                "simulation_ns": simulation}
+
+    def planes(self, slot):
+        """DOP and AOP (degree) views of a slot."""
+        if not 0 <= slot < self.slots:
+            raise ValueError("invalid slot")
+        scalar, code = _SCALARS[self._scalar]
+        count = self.shape[0] * self.shape[1]
+        views = []
+        for offset in (slot * self._slot_bytes, slot * self._slot_bytes + self._plane_bytes):
+            view = memoryview(self._map)[offset:offset + count * ctypes.sizeof(scalar)].cast(code, self.shape)
+            views.append(numpy.asarray(view) if numpy is not None else view)
+        return views[0], views[1]
+
+    def frame(self, psa, afa, beta, slot=0):
+        """Simulate a frame into a slot, wait for it and return views of its DOP and AOP planes."""
+        self.submit(slot, psa, afa, beta)
+        self.receive()
+        return self.planes(slot)
+
+    def stats(self):
+        """Latency percentiles of the frame requests of the connection (unit is nanosecond)."""
+        self._socket.sendall(_REQUEST.pack(SERVER_STATS, 0, 0, 0.0, 0.0, 0.0))
+        values = _STATS.unpack(self._receive(_STATS.size))
+        return dict(zip(("requests", "mean_ns", "p50_ns", "p90_ns", "p99_ns", "p999_ns", "max_ns"), values[2:]))
+
+    def shutdown(self):
+        """Ask the server to stop."""
+        self._socket.sendall(_REQUEST.pack(SERVER_SHUTDOWN, 0, 0, 0.0, 0.0, 0.0))
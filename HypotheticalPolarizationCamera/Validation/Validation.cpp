@@ -0,0 +1,808 @@
+/*
+Validation of Hypothetical Polarization Camera
+
+==========================================================================
+
+Copyright (c) 2019 - 2020, Huaju Liang and Hongyang Bai
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * None of the names of the contributors may be used to endorse or promote 
+      products derived from this software without specific prior written 
+      permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+==========================================================================
+
+
+This file is part of an implementation of Hypothetical Polarization Camera
+which is the code of our manuscript
+
+
+     "Limitation of Rayleigh Sky Model for Bio-inspired Polarized Skylight Navigation in Three-dimensional Attitude Determination"
+                                    
+                                   by 
+
+                       Huaju Liang and Hongyang Bai
+              Nanjing University of Science and Technology in Nanjing, China
+
+
+                        Version: 1.1, October 23, 2019
+=========================================================================
+
+
+
+This code is written for checking the accelerated code paths against the reference code of the simulation.
+And this code is written in C++11.
+
+Usage information:
+The CMake build registers the program as a test (ctest); it can also be run on its own from any folder.
+--------------------------
+
+Command line:
+	Validation [--attitudes N]
+	--attitudes N     //attitudes of every comparison (default VALIDATION_ATTITUDES)
+
+
+Checks:
+	"kernel"          //"RayleighKernelValidate()" and "RayleighKernelValidateFloat()" of every kernel type supported by
+	                  //the processor, for every camera and sky below, against the tolerances of RayleighKernel.h.
+	"closedform"      //"RayleighClosedFormReport()" of every camera in the Rayleigh sky, against
+	                  //RAYLEIGH_KERNEL_DOP_TOLERANCE and RAYLEIGH_KERNEL_AOP_TOLERANCE.
+	"solver"          //"AttitudeSolveFrame()" without a hint on noiseless frames of the pinhole camera at
+	                  //VALIDATION_SOLVER_ATTITUDES attitudes, in the Rayleigh sky with DOP_max=0.7 and in the Berry and
+	                  //table skies; the recovered sun vector or its opposite, which these skies cannot tell apart,
+	                  //must be within VALIDATION_SUN_TOLERANCE degrees.
+	"reduce"          //"CameraSimulationReduce()" of every camera in the Rayleigh sky on VALIDATION_REDUCE_THREADS
+	                  //threads against "CameraFrameReduce()" of the simulated frame on the calling thread, which must
+	                  //be bit for bit the same, and a reducer of "CameraSimulationReduceWith()" counting the pixels
+	                  //with DOP of 0.5 and above against a count of the frame.
+	"mosaic"          //"CameraSimulationMosaic()" of every camera in the Rayleigh sky with the noise of
+	                  //"MosaicParametersDefault()", for every kernel type supported by the processor on the calling
+	                  //thread and on VALIDATION_REDUCE_THREADS threads, against the raw frame of RAYLEIGH_KERNEL_SCALAR
+	                  //on the calling thread, which must be bit for bit the same ("MosaicNoiseAVX2()" included).
+	"demosaic"        //"CameraDemosaic()" of every kernel type supported by the processor, with DEMOSAIC_BILINEAR and
+	                  //DEMOSAIC_GRADIENT, of noise-free 16 bit mosaics of a 256x320 pinhole camera with f=4 millimeter
+	                  //(the lens of main.cpp) at VALIDATION_DEMOSAIC_ATTITUDES attitudes in the Rayleigh sky, against
+	                  //"CameraSimulationFrame()"; the pixels 2 or more away from the border, where the mirrored padding
+	                  //does not reach, must be within VALIDATION_DEMOSAIC_DOP and VALIDATION_DEMOSAIC_AOP.
+	"frameio"         //frames of 7x9 pixels written with "FrameWriterWrite()" in double and single precision and
+	                  //mapped back with "FrameFileMap()" must be bit for bit the same with their attitudes, and
+	                  //VALIDATION_BAD_HEADERS damaged copies of a frame file (offsets and sizes near INT64_MAX, a
+	                  //resolution whose plane overflows, overlapping or misaligned planes, a truncated file) must be
+	                  //rejected. It writes VALIDATION_FRAME_FILE in the current folder and removes it.
+	"server"          //(POSIX only) "FrameServerRun()" on a thread of VALIDATION_SERVER_THREADS simulation threads: a
+	                  //32x40 pinhole camera in double precision with VALIDATION_SERVER_SLOTS slots, whose pipelined
+	                  //requests must be answered in order with slots bit for bit the same as "CameraSimulationFrame()";
+	                  //a second connection in single precision, which must find the camera warm; a request for an
+	                  //invalid slot, which must be answered with a status of -1; then FRAME_SERVER_SHUTDOWN. It
+	                  //listens on VALIDATION_SERVER_SOCKET in the current folder.
+	Cameras:
+	"pinhole"         //256x320 pixels of 5.2 micrometer, f=1.2 millimeter, the lens of "CameraSimulation()".
+	"fisheye"         //200x240 pixels of 5.2 micrometer, f=0.6 millimeter, equisolid 180 degree lens with k1=-0.05,
+	                  //whose corners are outside the image circle.
+	Skies:
+	"rayleigh"        //SkyModelDefault(), the sky of "CameraSimulation()".
+	"berry"           //SkyModelBerry() with DOP_max=0.8 and the neutral points 20 degrees from the sun and the anti-sun.
+	"table"           //the Berry sky sampled by "SkyTableSample()" on a 1 degree by 5 degree grid.
+	"dim"             //SkyModelRayleigh() with DOP_max=0.7 (solver only).
+
+
+Output:
+	One line per check: the check, camera, sky, kernel, maximum DOP and AOP errors and "ok" or "FAILED".
+	The "solver" lines print the largest sun vector error instead of the DOP and AOP errors, the "reduce" lines the
+	counted pixels, the "mosaic" lines the differing raw values, the "frameio" line the frames read back and the damaged files rejected and the "server" line the
+	frames that matched and the replies in order.
+	The exit code is 0 if every check is within its tolerance and 1 if not.
+
+--------------------------
+==========================================================================
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "PolarizationCamera.h"
+#include "RayleighKernel.h"
+#include "RayleighClosedForm.h"
+#include "CameraLens.h"
+#include "SkyModel.h"
+#include "AttitudeSolver.h"
+#include "CameraReduce.h"
+#include "CameraMosaic.h"
+#include "CameraDemosaic.h"
+#include "ThreadPool.h"
+#include "FrameIO.h"
+#ifndef _WIN32
+#include <thread>
+#include "FrameServer.h"
+#endif
+
+#define VALIDATION_ATTITUDES    16      //default number of attitudes of every comparison
+#define VALIDATION_SOLVER_ATTITUDES 6   //attitudes of the attitude solver check
+#define VALIDATION_SUN_TOLERANCE    1e-3    //maximum sun vector error of the attitude solver on noiseless frames (unit is degree)
+#define VALIDATION_REDUCE_THREADS   4       //threads of the reduction check
+#define VALIDATION_DEMOSAIC_ATTITUDES   2   //attitudes of the demosaic check
+#define VALIDATION_DEMOSAIC_DOP     2.5e-5  //maximum DOP error of the demosaic of a noise-free mosaic
+#define VALIDATION_DEMOSAIC_AOP     8e-4    //maximum AOP error of the demosaic of a noise-free mosaic (unit is degree)
+#define VALIDATION_FRAME_FILE       "validation.hpcf.tmp"   //frame file of the frame file check
+#define VALIDATION_BAD_HEADERS      9       //damaged frame files of the frame file check
+#define VALIDATION_SERVER_SOCKET    "validation.sock.tmp"   //socket of the frame server check
+#define VALIDATION_SERVER_THREADS   2       //simulation threads of the frame server check
+#define VALIDATION_SERVER_SLOTS     4       //slots of the frame server check, all in flight at once
+
+
+
+//Print the result of a check and count its failure.
+static void ValidationPrint(
+	const char *  check,        //name of the check
+	const char *  camera,       //name of the camera
+	const char *  sky,          //name of the sky
+	const char *  kernel,       //name of the kernel type
+	const int     status,       //0 within the tolerance, 1 not, -1 on failure
+	const double  DOPError,     //maximum absolute DOP difference
+	const double  AOPError,     //maximum AOP difference modulo 180 degrees (unit is degree)
+	int &	failures            //number of failed checks
+	){
+	printf("%-10s %-8s %-8s %-12s DOP %.3e  AOP %.3e  %s\n",check,camera,sky,kernel,DOPError,AOPError,
+		status==0 ? "ok" : "FAILED");
+	if(status!=0){
+		failures++;
+	}
+}
+
+
+
+//Compare every supported kernel type with RAYLEIGH_KERNEL_SCALAR in double and single precision.
+static void ValidateKernels(
+	CameraParameters *	parm,   //camera parameters with the sky
+	const char *  camera,       //name of the camera
+	const char *  sky,          //name of the sky
+	const int     NumAttitudes, //number of attitudes
+	int &	failures            //number of failed checks
+	){
+	for(int type=RAYLEIGH_KERNEL_SCALAR; type<=RAYLEIGH_KERNEL_CLOSED_FORM; type++){
+		if(RayleighKernelResolve(type)!=type){
+			continue;
+		}
+		double DOPError = 0.0, AOPError = 0.0;
+		int status = RayleighKernelValidate(type,parm,NumAttitudes,DOPError,AOPError);
+		ValidationPrint("kernel",camera,sky,RayleighKernelName(type),status,DOPError,AOPError,failures);
+		status = RayleighKernelValidateFloat(type,parm,NumAttitudes,DOPError,AOPError);
+		ValidationPrint("float",camera,sky,RayleighKernelName(type),status,DOPError,AOPError,failures);
+	}
+}
+
+
+
+//Recover the attitude of noiseless frames of the sky of the camera parameters and compare the sun vectors.
+static void ValidateSolver(
+	CameraParameters *	parm,   //camera parameters with the sky
+	const char *  camera,       //name of the camera
+	const char *  sky,          //name of the sky
+	int &	failures            //number of failed checks
+	){
+	const double pi = 3.141592653589793;
+	const double attitude[VALIDATION_SOLVER_ATTITUDES][3] = {	//psa, afa, beta (unit is degree)
+		{78.9,-65.2,278.3},{10.0,20.0,30.0},{-40.0,5.0,100.0},{120.0,-30.0,-60.0},{0.0,70.0,10.0},{200.0,-10.0,170.0}};
+
+	AttitudeSolver * solver = AttitudeSolverInit(parm,0);
+	CameraFrame * frame = CameraFrameInit(parm);
+	int status = solver==NULL || frame==NULL ? -1 : 0;
+	double SunError = 0.0;
+	for(int k=0; k<VALIDATION_SOLVER_ATTITUDES && status==0; k++){
+		double psa = attitude[k][0]*pi/180;
+		double afa = attitude[k][1]*pi/180;
+		double beta = attitude[k][2]*pi/180;
+		CameraSimulationFrame(psa,afa,beta,parm,frame);
+
+		AttitudeSolution solution;
+		if(AttitudeSolveFrame(solver,frame,NULL,&solution)!=0){
+			status = -1;
+			break;
+		}
+
+		//sun vector in body coordinate system, the third column of C_vTb, up to the sign that these skies do not show
+		double Sun[3] = {-sin(beta)*cos(afa),sin(afa),cos(beta)*cos(afa)};
+		double c = fabs(Sun[0]*solution.Sun[0]+Sun[1]*solution.Sun[1]+Sun[2]*solution.Sun[2]);
+		double error = acos(c>1.0 ? 1.0 : c)*180/pi;
+		SunError = error>SunError ? error : SunError;
+	}
+	if(status==0){
+		status = SunError<=VALIDATION_SUN_TOLERANCE ? 0 : 1;
+	}
+	printf("%-10s %-8s %-8s %-12s sun %.3e degree  %s\n","solver",camera,sky,"-",SunError,status==0 ? "ok" : "FAILED");
+	if(status!=0){
+		failures++;
+	}
+
+	CameraFrameFree(frame);
+	AttitudeSolverFree(solver);
+}
+
+
+
+//Reducer counting the pixels with DOP of 0.5 and above: new count.
+static void * CountCreate(
+	void *	context             //not used
+	){
+	(void)context;
+	return calloc(1,sizeof(int64_t));
+}
+
+
+
+//Reducer counting the pixels with DOP of 0.5 and above: clear a count.
+static void CountClear(
+	void *	context,            //not used
+	void *	state               //int64_t count
+	){
+	(void)context;
+	*(int64_t *)state = 0;
+}
+
+
+
+//Reducer counting the pixels with DOP of 0.5 and above: count a block.
+static void CountAccumulate(
+	void *	context,            //not used
+	void *	state,              //int64_t count
+	const CameraBlock *	block,  //block of the frame
+	const double *	DOP,        //DOP of the block
+	const double *	AOP,        //AOP of the block, not used
+	const size_t  pitch         //values from one row to the next
+	){
+	(void)context;
+	(void)AOP;
+	for(int i=0; i<block->n_x; i++){
+		for(int j=0; j<block->n_z; j++){
+			*(int64_t *)state += DOP[(size_t)i*pitch+j]>=0.5;
+		}
+	}
+}
+
+
+
+//Reducer counting the pixels with DOP of 0.5 and above: add the count of a block.
+static void CountMerge(
+	void *	context,            //not used
+	void *	state,              //int64_t count of the frame
+	const void *	from        //int64_t count of a block
+	){
+	(void)context;
+	*(int64_t *)state += *(const int64_t *)from;
+}
+
+
+
+//Reducer counting the pixels with DOP of 0.5 and above: release a count.
+static void CountFree(
+	void *	context,            //not used
+	void *	state               //int64_t count
+	){
+	(void)context;
+	free(state);
+}
+
+
+
+//Compare the fused statistics of the pool with those of the simulated frame, and a reducer of its own with the frame.
+static void ValidateReduce(
+	CameraParameters *	parm,   //camera parameters with the sky
+	const char *  camera,       //name of the camera
+	const char *  sky,          //name of the sky
+	int &	failures            //number of failed checks
+	){
+	const double pi = 3.141592653589793;
+	const double psa = 78.9*pi/180, afa = -65.2*pi/180, beta = 278.3*pi/180;
+	ThreadPool pool(VALIDATION_REDUCE_THREADS);
+	CameraFrame * frame = CameraFrameInit(parm);
+	ReduceResult * fused = (ReduceResult *)malloc(sizeof(ReduceResult));
+	ReduceResult * reference = (ReduceResult *)malloc(sizeof(ReduceResult));
+	int status = frame==NULL || fused==NULL || reference==NULL ? -1 : 0;
+	int64_t count = 0, expected = 0;
+	if(status==0){
+		CameraSimulationFrame(psa,afa,beta,parm,frame);
+		ReduceSettings settings;
+		ReduceSettingsDefault(&settings);
+		settings.Axial = 1;
+		if(CameraSimulationReduce(psa,afa,beta,parm,&settings,&pool,fused)!=0
+			|| CameraFrameReduce(frame,&settings,NULL,reference)!=0){
+			status = -1;
+		}
+		else if(memcmp(fused,reference,sizeof(ReduceResult))!=0){
+			status = 1;
+		}
+
+		CameraReducer reducer = {NULL,CountCreate,CountClear,CountAccumulate,CountMerge,CountFree};
+		if(status==0 && CameraSimulationReduceWith(psa,afa,beta,parm,&reducer,&pool,&count)!=0){
+			status = -1;
+		}
+		for(size_t k=0; k<(size_t)frame->n_x*frame->n_z; k++){
+			expected += frame->DOP[k]>=0.5;
+		}
+		if(status==0 && count!=expected){
+			status = 1;
+		}
+	}
+	printf("%-10s %-8s %-8s %-12s DOP>=0.5 %lld of %lld  %s\n","reduce",camera,sky,"-",(long long)count,
+		(long long)expected,status==0 ? "ok" : "FAILED");
+	if(status!=0){
+		failures++;
+	}
+
+	free(reference);
+	free(fused);
+	CameraFrameFree(frame);
+}
+
+
+//Compare the raw mosaic of every supported kernel type on the calling thread and on a pool with the scalar one.
+static void ValidateMosaic(
+	CameraParameters *	parm,   //camera parameters with the sky
+	const char *  camera,       //name of the camera
+	const char *  sky,          //name of the sky
+	int &	failures            //number of failed checks
+	){
+	const double pi = 3.141592653589793;
+	const double psa = 78.9*pi/180, afa = -65.2*pi/180, beta = 278.3*pi/180;
+	ThreadPool pool(VALIDATION_REDUCE_THREADS);
+	MosaicParameters mosaic;
+	MosaicParametersDefault(&mosaic);
+	mosaic.Seed = 12345;
+	mosaic.FrameIndex = 7;
+	int n_x, n_z;
+	CameraFrameSize(parm,n_x,n_z);
+	const size_t PixelNum = (size_t)n_x*n_z;
+	std::vector<uint16_t> reference(PixelNum), raw(PixelNum);
+	const int kernel = parm->Kernel;
+	parm->Kernel = RAYLEIGH_KERNEL_SCALAR;
+	int status = CameraSimulationMosaic(psa,afa,beta,parm,&mosaic,&reference[0],NULL)!=0 ? -1 : 0;
+	for(int type=RAYLEIGH_KERNEL_SCALAR; type<=RAYLEIGH_KERNEL_CLOSED_FORM; type++){
+		if(RayleighKernelResolve(type)!=type){
+			continue;
+		}
+		parm->Kernel = type;
+		int64_t differ[2] = {0,0};
+		for(int threads=0; threads<2 && status==0; threads++){
+			if(CameraSimulationMosaic(psa,afa,beta,parm,&mosaic,&raw[0],threads ? &pool : NULL)!=0){
+				status = -1;
+				break;
+			}
+			for(size_t k=0; k<PixelNum; k++){
+				differ[threads] += raw[k]!=reference[k];
+			}
+		}
+		int result = status!=0 ? status : (differ[0]!=0 || differ[1]!=0 ? 1 : 0);
+		printf("%-10s %-8s %-8s %-12s %lld and %lld of %lld raw values differ on 1 and %d threads  %s\n","mosaic",
+			camera,sky,RayleighKernelName(type),(long long)differ[0],(long long)differ[1],(long long)PixelNum,
+			VALIDATION_REDUCE_THREADS,result==0 ? "ok" : "FAILED");
+		if(result!=0){
+			failures++;
+		}
+	}
+	parm->Kernel = kernel;
+}
+
+
+
+//Demosaic noise-free mosaics with every supported kernel type and both methods and compare with the simulation.
+static void ValidateDemosaic(
+	int &	failures            //number of failed checks
+	){
+	const double pi = 3.141592653589793;
+	//a sky of DOP above 0.59 in the whole view, off the symmetric attitudes that put pixels on the sun meridian
+	const double attitude[VALIDATION_DEMOSAIC_ATTITUDES][3] = {{78.9,-20.2,278.3},{33.3,-15.7,101.1}};
+	const int Border = 2;
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,256,320,4.0,1);
+	MosaicParameters mosaic;
+	MosaicParametersDefault(&mosaic);
+	mosaic.ReadNoise = 0.0;
+	mosaic.ShotNoise = 0;
+	mosaic.Bits = 16;
+	mosaic.Gain = 10500.0/65536.0;
+	CameraFrame * reference[VALIDATION_DEMOSAIC_ATTITUDES] = {NULL};
+	CameraFrame * frame = parm!=NULL ? CameraFrameInit(parm) : NULL;
+	std::vector<uint16_t> raw[VALIDATION_DEMOSAIC_ATTITUDES];
+	int status = frame==NULL ? -1 : 0;
+	for(int a=0; a<VALIDATION_DEMOSAIC_ATTITUDES && status==0; a++){
+		double psa = attitude[a][0]*pi/180;
+		double afa = attitude[a][1]*pi/180;
+		double beta = attitude[a][2]*pi/180;
+		reference[a] = CameraFrameInit(parm);
+		raw[a].resize((size_t)frame->n_x*frame->n_z);
+		if(reference[a]==NULL || CameraSimulationMosaic(psa,afa,beta,parm,&mosaic,&raw[a][0],NULL)!=0){
+			status = -1;
+			break;
+		}
+		CameraSimulationFrame(psa,afa,beta,parm,reference[a]);
+	}
+
+	for(int type=RAYLEIGH_KERNEL_SCALAR; type<=RAYLEIGH_KERNEL_AVX512; type++){
+		if(RayleighKernelResolve(type)!=type){
+			continue;
+		}
+		double DOPError = 0.0, AOPError = 0.0;
+		int result = status;
+		for(int k=0; k<2*VALIDATION_DEMOSAIC_ATTITUDES && result==0; k++){
+			const int a = k/2;
+			if(CameraDemosaic(&raw[a][0],&mosaic,k%2 ? DEMOSAIC_GRADIENT : DEMOSAIC_BILINEAR,type,frame,NULL,NULL,NULL,
+				NULL)!=0){
+				result = -1;
+				break;
+			}
+			for(int i=Border; i<frame->n_x-Border; i++){
+				for(int j=Border; j<frame->n_z-Border; j++){
+					size_t p = (size_t)i*frame->n_z+j;
+					double DOP = fabs(frame->DOP[p]-reference[a]->DOP[p]);
+					double AOP = fabs(frame->AOP[p]-reference[a]->AOP[p]);
+					AOP = AOP>90.0 ? 180.0-AOP : AOP;
+					DOPError = DOP>DOPError ? DOP : DOPError;
+					AOPError = AOP>AOPError ? AOP : AOPError;
+				}
+			}
+		}
+		if(result==0 && !(DOPError<=VALIDATION_DEMOSAIC_DOP && AOPError<=VALIDATION_DEMOSAIC_AOP)){
+			result = 1;
+		}
+		ValidationPrint("demosaic","256x320","rayleigh",RayleighKernelName(type),result,DOPError,AOPError,failures);
+	}
+
+	for(int a=0; a<VALIDATION_DEMOSAIC_ATTITUDES; a++){
+		CameraFrameFree(reference[a]);
+	}
+	CameraFrameFree(frame);
+	CameraParametersFree(parm);
+}
+
+
+
+
+//Write the bytes of a frame file.
+static int WriteBytes(
+	const char *  path,         //file name
+	const std::vector<char> &	bytes,  //contents
+	const size_t  size          //bytes to write from the start
+	){
+	FILE * file = fopen(path,"wb");
+	if(file==NULL){
+		return -1;
+	}
+	size_t written = size>0 ? fwrite(&bytes[0],1,size,file) : 0;
+	return fclose(file)==0 && written==size ? 0 : -1;
+}
+
+
+
+//Write frames in double and single precision, map them back and compare; map damaged copies and expect a refusal.
+static void ValidateFrameFile(
+	int &	failures            //number of failed checks
+	){
+	const double pi = 3.141592653589793;
+	CameraParameters * parm = CameraParametersInit(5.2,5.2,7,9,1.2,1);    //63 pixels, the AOP float plane 4 bytes off
+	CameraFrame * frame[2] = {NULL,NULL};
+	CameraFrameFloat * FrameFloat[2] = {NULL,NULL};
+	int status = parm==NULL ? -1 : 0;
+	int frames = 0, rejected = 0;
+	for(int k=0; k<2 && status==0; k++){
+		frame[k] = CameraFrameInit(parm);
+		FrameFloat[k] = CameraFrameFloatInit(parm);
+		if(frame[k]==NULL || FrameFloat[k]==NULL){
+			status = -1;
+		}
+	}
+
+	//round trip of two frames per scalar type
+	for(int type=FRAME_SCALAR_DOUBLE; type<=FRAME_SCALAR_FLOAT && status==0; type++){
+		FrameWriter * writer = FrameWriterOpen(VALIDATION_FRAME_FILE,type);
+		status = writer==NULL ? -1 : 0;
+		for(int k=0; k<2 && status==0; k++){
+			parm->psa = (10.0+k)*pi/180;
+			parm->afa = -20.0*pi/180;
+			parm->beta = 30.0*pi/180;
+			if(type==FRAME_SCALAR_DOUBLE){
+				CameraSimulationFrame(parm->psa,parm->afa,parm->beta,parm,frame[k]);
+				status = FrameWriterWrite(writer,frame[k],parm);
+			}
+			else{
+				CameraSimulationFrame(parm->psa,parm->afa,parm->beta,parm,FrameFloat[k]);
+				status = FrameWriterWrite(writer,FrameFloat[k],parm);
+			}
+		}
+		if(writer!=NULL && FrameWriterClose(writer)!=0){
+			status = -1;
+		}
+		FrameFileView * view = status==0 ? FrameFileMap(VALIDATION_FRAME_FILE) : NULL;
+		if(status==0 && (view==NULL || view->FrameCount!=2)){
+			status = 1;
+		}
+		for(int k=0; k<2 && status==0; k++){
+			FrameFileFrame stored;
+			size_t bytes = (size_t)frame[k]->n_x*frame[k]->n_z*(type==FRAME_SCALAR_DOUBLE ? sizeof(double) : sizeof(float));
+			const void * DOP = type==FRAME_SCALAR_DOUBLE ? (const void *)frame[k]->DOP : (const void *)FrameFloat[k]->DOP;
+			const void * AOP = type==FRAME_SCALAR_DOUBLE ? (const void *)frame[k]->AOP : (const void *)FrameFloat[k]->AOP;
+			if(FrameFileGetFrame(view,k,&stored)!=0 || stored.header->ScalarType!=type
+				|| stored.header->psa!=(10.0+k)*pi/180 || memcmp(stored.DOP,DOP,bytes)!=0
+				|| memcmp(stored.AOP,AOP,bytes)!=0){
+				status = 1;
+			}
+			else{
+				frames++;
+			}
+		}
+		FrameFileUnmap(view);
+	}
+
+	//damaged copies of the double frame file, which must not map
+	std::vector<char> bytes;
+	if(status==0){
+		FrameWriter * writer = FrameWriterOpen(VALIDATION_FRAME_FILE,FRAME_SCALAR_DOUBLE);
+		status = writer==NULL || FrameWriterWrite(writer,frame[0],parm)!=0 ? -1 : 0;
+		if(writer!=NULL && FrameWriterClose(writer)!=0){
+			status = -1;
+		}
+		FILE * file = status==0 ? fopen(VALIDATION_FRAME_FILE,"rb") : NULL;
+		char buffer[4096];
+		size_t n;
+		while(file!=NULL && (n = fread(buffer,1,sizeof(buffer),file))>0){
+			bytes.insert(bytes.end(),buffer,buffer+n);
+		}
+		if(file!=NULL){
+			fclose(file);
+		}
+		status = bytes.size()>=sizeof(FrameFileHeader) ? status : -1;
+	}
+	for(int k=0; k<VALIDATION_BAD_HEADERS && status==0; k++){
+		std::vector<char> damaged(bytes);
+		FrameFileHeader header;
+		memcpy(&header,&damaged[0],sizeof(FrameFileHeader));
+		size_t size = damaged.size();
+		switch(k){
+		case 0: header.AOPOffset = INT64_MAX-4; break;                 //wraps when the plane is added
+		case 1: header.AOPOffset = INT64_MAX-7; break;                 //aligned and wrapping
+		case 2: header.DOPOffset = INT64_MAX-7; break;
+		case 3: header.FrameSize = INT64_MAX-7; break;                 //next frame beyond the end
+		case 4: header.n_x = header.n_z = INT32_MAX; break;            //plane of 2^65 bytes
+		case 5: header.AOPOffset = header.DOPOffset; break;            //planes overlap
+		case 6: header.DOPOffset += 4; header.AOPOffset += 4; break;   //misaligned double planes
+		case 7: header.FrameSize -= 4; break;                          //frame size not a multiple of 8
+		default: size -= 8; break;                                     //truncated file
+		}
+		memcpy(&damaged[0],&header,sizeof(FrameFileHeader));
+		if(WriteBytes(VALIDATION_FRAME_FILE,damaged,size)!=0){
+			status = -1;
+			break;
+		}
+		FrameFileView * view = FrameFileMap(VALIDATION_FRAME_FILE);
+		if(view==NULL){
+			rejected++;
+		}
+		else{
+			status = 1;
+			FrameFileUnmap(view);
+		}
+	}
+	remove(VALIDATION_FRAME_FILE);
+
+	printf("%-10s %-8s %-8s %-12s %d of 4 frames, %d of %d damaged files rejected  %s\n","frameio","7x9",
+		"rayleigh","-",frames,rejected,VALIDATION_BAD_HEADERS,status==0 ? "ok" : "FAILED");
+	if(status!=0){
+		failures++;
+	}
+	for(int k=0; k<2; k++){
+		CameraFrameFree(frame[k]);
+		CameraFrameFree(FrameFloat[k]);
+	}
+	CameraParametersFree(parm);
+}
+
+
+#ifndef _WIN32
+//Serve a camera on a thread, compare pipelined frames with the simulation, then reject a slot and shut down.
+static void ValidateServer(
+	int &	failures            //number of failed checks
+	){
+	const double pi = 3.141592653589793;
+	const int Frames = VALIDATION_SERVER_SLOTS+1;
+	FrameServerCamera config;
+	FrameServerCameraDefault(&config);
+	config.Slots = VALIDATION_SERVER_SLOTS;
+	config.n_x = 32;
+	config.n_z = 40;
+	config.f = 1.2;
+	CameraParameters * parm = CameraParametersInit(config.D_x,config.D_z,config.n_x,config.n_z,config.f,1);
+	CameraFrame * frame[VALIDATION_SERVER_SLOTS] = {NULL};
+	CameraFrameFloat * FrameFloat = parm!=NULL ? CameraFrameFloatInit(parm) : NULL;
+	int status = FrameFloat==NULL ? -1 : 0;
+	for(int k=0; k<VALIDATION_SERVER_SLOTS && status==0; k++){
+		frame[k] = CameraFrameInit(parm);
+		if(frame[k]==NULL){
+			status = -1;
+		}
+	}
+	FrameServer * server = status==0 ? FrameServerInit(VALIDATION_SERVER_SOCKET,VALIDATION_SERVER_THREADS) : NULL;
+	if(server==NULL){
+		status = -1;
+	}
+	std::thread run;
+	if(status==0){
+		run = std::thread(FrameServerRun,server);
+	}
+
+	//one request per slot in flight, answered in order
+	int matched = 0, ordered = 0, warm = 0;
+	FrameClient * client = status==0 ? FrameClientConnect(VALIDATION_SERVER_SOCKET,&config) : NULL;
+	if(status==0 && (client==NULL || client->layout.Warm!=0 || client->layout.ScalarType!=FRAME_SCALAR_DOUBLE)){
+		status = 1;
+	}
+	for(int k=0; k<VALIDATION_SERVER_SLOTS && status==0; k++){
+		if(FrameClientSubmit(client,k,100+k,(10.0+20*k)*pi/180,-20.0*pi/180,30.0*pi/180)!=0){
+			status = -1;
+		}
+	}
+	size_t bytes = (size_t)config.n_x*config.n_z*sizeof(double);
+	for(int k=0; k<VALIDATION_SERVER_SLOTS && status==0; k++){
+		FrameServerReply reply;
+		if(FrameClientReceive(client,&reply)!=0){
+			status = 1;
+			break;
+		}
+		ordered += reply.Sequence==(uint64_t)(100+k) && reply.Slot==k;
+		CameraSimulationFrame((10.0+20*k)*pi/180,-20.0*pi/180,30.0*pi/180,parm,frame[k]);
+		matched += memcmp(FrameClientPlane(client,k,0),frame[k]->DOP,bytes)==0
+			&& memcmp(FrameClientPlane(client,k,1),frame[k]->AOP,bytes)==0;
+	}
+
+	//a second connection to the same camera in single precision
+	FrameServerCamera single = config;
+	single.ScalarType = FRAME_SCALAR_FLOAT;
+	single.Slots = 1;
+	FrameClient * second = status==0 ? FrameClientConnect(VALIDATION_SERVER_SOCKET,&single) : NULL;
+	if(second!=NULL){
+		warm = second->layout.Warm;
+		CameraSimulationFrame(50.0*pi/180,-20.0*pi/180,30.0*pi/180,parm,FrameFloat);
+		if(FrameClientFrame(second,0,50.0*pi/180,-20.0*pi/180,30.0*pi/180,NULL)!=0){
+			status = 1;
+		}
+		else{
+			bytes = (size_t)config.n_x*config.n_z*sizeof(float);
+			matched += memcmp(FrameClientPlane(second,0,0),FrameFloat->DOP,bytes)==0
+				&& memcmp(FrameClientPlane(second,0,1),FrameFloat->AOP,bytes)==0;
+		}
+	}
+
+	//a slot beyond the layout is refused, and the connection still answers
+	if(client!=NULL){
+		FrameServerReply reply;
+		memset(&reply,0,sizeof(FrameServerReply));
+		if(FrameClientSubmit(client,VALIDATION_SERVER_SLOTS,7,0.0,0.0,0.0)!=0
+			|| FrameClientReceive(client,&reply)!=-1 || reply.Status!=-1 || reply.Sequence!=7){
+			status = 1;
+		}
+	}
+	if(status==0 && (matched!=Frames || ordered!=VALIDATION_SERVER_SLOTS || warm!=1)){
+		status = 1;
+	}
+
+	if(server!=NULL){
+		if(client==NULL || FrameClientShutdown(client)!=0){
+			FrameServerStop(server);
+		}
+		run.join();
+	}
+	FrameClientClose(second);
+	FrameClientClose(client);
+	FrameServerFree(server);
+
+	printf("%-10s %-8s %-8s %-12s %d of %d frames, %d of %d in order, warm %d  %s\n","server","32x40","rayleigh",
+		"-",matched,Frames,ordered,VALIDATION_SERVER_SLOTS,warm,status==0 ? "ok" : "FAILED");
+	if(status!=0){
+		failures++;
+	}
+	for(int k=0; k<VALIDATION_SERVER_SLOTS; k++){
+		CameraFrameFree(frame[k]);
+	}
+	CameraFrameFree(FrameFloat);
+	CameraParametersFree(parm);
+}
+#endif
+
+
+
+
+int main(int argc, char ** argv){
+	int NumAttitudes = VALIDATION_ATTITUDES;
+	for(int k=1; k<argc; k++){
+		if(strcmp(argv[k],"--attitudes")==0 && k+1<argc){
+			NumAttitudes = atoi(argv[++k]);
+		}
+		else{
+			fprintf(stderr,"usage: %s [--attitudes N]\n",argv[0]);
+			return 1;
+		}
+	}
+	if(NumAttitudes<2){
+		NumAttitudes = 2;
+	}
+
+	CameraParameters * camera[2];
+	const char * CameraName[2] = {"pinhole","fisheye"};
+	camera[0] = CameraParametersInit(5.2,5.2,256,320,1.2,1);
+	camera[1] = CameraParametersInit(5.2,5.2,200,240,0.6,1);
+	if(camera[0]==NULL || camera[1]==NULL){
+		fprintf(stderr,"out of memory\n");
+		return 1;
+	}
+	CameraLens lens;
+	CameraLensDefault(&lens);
+	lens.Projection = CAMERA_PROJECTION_EQUISOLID;
+	lens.FieldOfView = 180.0;
+	lens.k1 = -0.05;
+	CameraParametersSetLens(camera[1],&lens);
+
+	SkyModel sky[3], dim;
+	const char * SkyName[3] = {"rayleigh","berry","table"};
+	SkyModelDefault(&sky[0]);
+	SkyModelBerry(&sky[1],0.8,20.0);
+	SkyTable * table = SkyTableSample(&sky[1],181,72);
+	if(table==NULL){
+		fprintf(stderr,"out of memory\n");
+		return 1;
+	}
+	SkyModelTabulated(&sky[2],table);
+	SkyModelRayleigh(&dim,0.7);
+
+	int failures = 0;
+	for(int c=0; c<2; c++){
+		for(int s=0; s<3; s++){
+			camera[c]->Sky = sky[s];
+			ValidateKernels(camera[c],CameraName[c],SkyName[s],NumAttitudes,failures);
+		}
+		camera[c]->Sky = sky[0];
+
+		RayleighClosedFormAccuracy report;
+		int status = RayleighClosedFormReport(camera[c],NumAttitudes,report);
+		ValidationPrint("closedform",CameraName[c],SkyName[0],RayleighKernelName(RAYLEIGH_KERNEL_CLOSED_FORM),status,
+			report.DOPError,report.AOPError,failures);
+		ValidateReduce(camera[c],CameraName[c],SkyName[0],failures);
+		ValidateMosaic(camera[c],CameraName[c],SkyName[0],failures);
+	}
+
+	camera[0]->Sky = dim;
+	ValidateSolver(camera[0],CameraName[0],"dim",failures);
+	for(int s=1; s<3; s++){
+		camera[0]->Sky = sky[s];
+		ValidateSolver(camera[0],CameraName[0],SkyName[s],failures);
+	}
+
+	ValidateDemosaic(failures);
+	ValidateFrameFile(failures);
+#ifndef _WIN32
+	ValidateServer(failures);
+#endif
+
+	CameraParametersFree(camera[0]);
+	CameraParametersFree(camera[1]);
+	SkyTableFree(table);
+	printf("%d failed checks\n",failures);
+	return failures==0 ? 0 : 1;
+}